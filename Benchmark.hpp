@@ -0,0 +1,306 @@
+/******************************************************************************
+/* @file Contains class Benchmark for statistical micro-benchmarks
+/*       of functions with a return value.
+/*
+/* A benchmark warms the function up, calibrates the number of iterations
+/* per sample so that a sample lasts long enough for the clock, and takes
+/* a number of samples. The durations per invocation are reported in
+/* nanoseconds as min, median, p90, p99 and standard deviation.
+/*
+/*
+/* A simple example:
+###################################################################################################
+
+using namespace unittest;
+
+int fun(int i, int j);          // function to be benchmarked
+
+Benchmark<int, int, int> bench(fun);
+
+auto stats = bench.run("fun small", 3, 4);
+
+// or over a set of argument tuples that are invoked in turn
+
+auto more_stats = bench.run_series("fun mixed", { std::make_tuple(3, 4), std::make_tuple(1000, 7) });
+
+###################################################################################################
+/*
+/*
+/* To let the compiler inline the function, have its type deduced:
+###################################################################################################
+
+auto inlined_bench = create_benchmark<int, int>([](int i, int j) { return fun(i, j); });
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "reporter.hpp"
+#include "run_record.hpp"
+#include "timing.hpp"
+#include "tuple_call.hpp"
+#include "verbosity.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+
+namespace unittest {
+
+    /** BasicBenchmark class which is capable of measuring the invocation duration
+    of arbitrary functions with a return value with statistical means.
+    The results are kept alive with timing::do_not_optimize() so that the compiler cannot
+    elide the invocations. Writes the results to a stream.
+    The function is stored by value with its own type, so that calls to it can be inlined
+    into the timed loop. Benchmark is the variant that stores a std::function object instead.
+    create_benchmark() deduces the function type and the result type.
+    @tparam Function Type of the function.
+    @tparam ResultType Return type of the given function.
+    @tparam ArgTypes Argument types of the given function.
+    */
+    template< typename Function, typename ResultType, typename... ArgTypes>
+    class BasicBenchmark {
+
+    public: // types
+
+        using ArgsTupleType     = std::tuple<ArgTypes...>;
+        using FunctionType      = Function;
+
+    public: // inner classes
+
+        /// The return type of the run() functions. All durations are nanoseconds per invocation.
+        struct BenchmarkReturnType {
+            unsigned long long n_iterations_per_sample = 0;     ///< The calibrated number of invocations per sample.
+            timing::statistics invocation_duration_ns;          ///< Statistics of the samples, in nanoseconds per invocation.
+        };
+
+    private: // vars
+
+        FunctionType fun_;                                      ///< The function.
+        std::shared_ptr<reporter> reporter_;                    ///< The output.
+        std::shared_ptr<run_record::recorder> recorder_;        ///< Receives a record of every run, or nullptr.
+
+    public: // vars
+
+        verbosity verbosity_level = verbosity::NORMAL;          ///< Defines the verbosity of the stream out amount.
+        unsigned int output_line_length = 50;                   ///< The max number of dots that is shown in the printed lines.
+        timing::clock clock = timing::clock::STEADY;            ///< The clock to measure with.
+        unsigned int n_samples = 30;                            ///< The number of samples, i.e. of repeated runs.
+        double warmup_duration_ns = 1e7;                        ///< The duration of the warm-up invocations before the calibration.
+        double min_sample_duration_ns = 1e6;                    ///< The calibration target: minimum duration of one sample.
+        unsigned long long max_iterations_per_sample = 1ull << 30;  ///< Upper bound for the calibrated number of iterations per sample.
+
+    public: // constructors
+
+        /** Constructor for the benchmark.
+        @param function A function that must return a value.
+        @param os An ostream to which the output is streamed. Defaults to std::cout.
+        */
+        BasicBenchmark(
+            FunctionType function,
+            std::ostream& os = std::cout)
+            :
+            fun_(function),
+            reporter_(std::make_shared<ostream_reporter>(os))
+        {}
+
+    public: // methods
+
+        /** Benchmarks the function invoked with the given arguments.
+        @param test_name A human-readable alias of the benchmark that will be written into the stream.
+        @param args The arguments that will be passed to the function on invocation.
+        @return A BasicBenchmark::BenchmarkReturnType object with the statistics of the samples.
+        */
+        BenchmarkReturnType run(const std::string& test_name, const ArgTypes&... args) {
+            return run_series(test_name, std::vector<ArgsTupleType>{ ArgsTupleType(args...) });
+        }
+
+
+        /** Benchmarks the function invoked with the given argument tuples in turn.
+        An invocation counts as one iteration, regardless of the argument tuple.
+        @param test_name A human-readable alias of the benchmark that will be written into the stream.
+        @param arg_tuples The argument tuples. Must not be empty.
+        @return A BasicBenchmark::BenchmarkReturnType object with the statistics of the samples.
+        */
+        BenchmarkReturnType run_series(const std::string& test_name, const std::vector<ArgsTupleType>& arg_tuples) {
+            BenchmarkReturnType ret;
+
+            if (verbosity_level >= verbosity::NORMAL) {
+                log(verbosity::NORMAL, [test_name, n_chars = output_line_length](std::ostream& os) {
+                    std::string output = "Benchmark: " + test_name + ": ";
+                    output.resize(std::max<std::size_t>(output.size(), n_chars), '.');
+                    os << output << " ";
+                });
+            }
+
+            if (arg_tuples.empty()) {
+                log(verbosity::NORMAL, [](std::ostream& os) { os << "NO ARGUMENTS\n"; });
+                return ret;
+            }
+
+            // warm-up
+            {
+                const timing::stopwatch watch(clock);
+                while (watch.elapsed_ns() < warmup_duration_ns) {
+                    run_iterations(arg_tuples, arg_tuples.size());
+                }
+            }
+
+            // calibration
+            unsigned long long n_iterations = 1;
+            while (n_iterations < max_iterations_per_sample && run_iterations(arg_tuples, n_iterations) < min_sample_duration_ns) {
+                n_iterations *= 2;
+            }
+
+            // measurement
+            std::vector<double> samples;
+            samples.reserve(n_samples);
+            for (unsigned int i = 0; i < n_samples; ++i) {
+                samples.push_back(run_iterations(arg_tuples, n_iterations) / n_iterations);
+            }
+
+            ret.n_iterations_per_sample = n_iterations;
+            ret.invocation_duration_ns = timing::compute_statistics(std::move(samples));
+
+            log(verbosity::NORMAL, [s = ret.invocation_duration_ns](std::ostream& os) {
+                std::stringstream ss;
+                ss << std::fixed << std::setprecision(2) <<
+                    s.median << " ns median (min " << s.min << ", p90 " << s.p90 << ", p99 " << s.p99 << ", stddev " << s.stddev << ")\n";
+                os << ss.str();
+            });
+            log(verbosity::VERBOSE, [s = ret.invocation_duration_ns, n_iterations](std::ostream& os) {
+                std::stringstream ss;
+                ss << std::fixed << std::setprecision(2) <<
+                    " SAMPLES:    " << s.n_samples << " x " << n_iterations << " iterations\n" <<
+                    " MEAN:       " << s.mean << " ns\n" <<
+                    " MAX:        " << s.max << " ns\n" <<
+                    ".\n";
+                os << ss.str();
+            });
+
+            if (recorder_) {
+                recorder_->add(run_record::from_benchmark(test_name, ret));
+            }
+            return ret;
+        }
+
+
+        /** Replaces the output stream of the constructor with the given reporter,
+        e.g. with an async_reporter that several testers share.
+        @param r The reporter.
+        */
+        void set_reporter(std::shared_ptr<reporter> r) {
+            reporter_ = std::move(r);
+        }
+
+
+        /** Sets a recorder to which the run() functions add a record of every run, see run_record.
+        @param r The recorder, or nullptr to stop recording.
+        */
+        void set_recorder(std::shared_ptr<run_record::recorder> r) {
+            recorder_ = std::move(r);
+        }
+
+    protected: // helpers
+
+        /** Invokes the function n_iterations times with the given argument tuples in turn.
+        @param arg_tuples The argument tuples. Must not be empty.
+        @param n_iterations The number of invocations.
+        @return The elapsed nanoseconds.
+        */
+        double run_iterations(const std::vector<ArgsTupleType>& arg_tuples, const unsigned long long n_iterations) {
+            const auto n_tuples = arg_tuples.size();
+            std::size_t k = 0;
+
+            const timing::stopwatch watch(clock);
+            for (unsigned long long i = 0; i < n_iterations; ++i) {
+                const auto& args = arg_tuples[k];
+                timing::do_not_optimize(args);
+                timing::do_not_optimize(tuple_call::call(fun_, args));
+                timing::clobber_memory();
+                k = k + 1 < n_tuples ? k + 1 : 0;
+            }
+            return watch.elapsed_ns();
+        }
+
+
+        /** Reports a message if the given verbosity level is equal or smaller than the verbosity_level member value.
+        The message is not formatted otherwise.
+        @param message_verbosity_level The verbosity level of the message.
+        @param format A function void(std::ostream&) that formats the message. The reporter may call it
+        later on another thread, so it must hold copies of everything it refers to.
+        */
+        template <typename F>
+        void log(const verbosity message_verbosity_level, F&& format) const {
+            if (verbosity_level >= message_verbosity_level) {
+                reporter_->report(deferred_message(std::forward<F>(format)));
+            }
+        }
+
+    }; // END class BasicBenchmark
+
+
+    /** Benchmark class which is capable of measuring the invocation duration
+    of arbitrary functions with a return value with statistical means.
+    Stores the function as a std::function object. For functions that can be inlined,
+    see BasicBenchmark and create_benchmark().
+    @tparam ResultType Return type of the given function.
+    @tparam ArgTypes Argument types of the given function.
+    */
+    template< typename ResultType, typename... ArgTypes>
+    class Benchmark : public BasicBenchmark<const std::function<ResultType(ArgTypes...)>, ResultType, ArgTypes...> {
+
+    public: // types
+
+        using BaseType = BasicBenchmark<const std::function<ResultType(ArgTypes...)>, ResultType, ArgTypes...>;
+
+        using typename BaseType::FunctionType;
+
+    public: // constructors
+
+        /** Constructor for the benchmark.
+        @param function A function that must return a value.
+        @param os An ostream to which the output is streamed. Defaults to std::cout.
+        */
+        Benchmark(
+            FunctionType function,
+            std::ostream& os = std::cout)
+            :
+            BaseType(function, os)
+        {}
+
+    }; // END class Benchmark
+
+
+    /** Helper function that creates a BasicBenchmark object without the need
+    to specify the return type of the function. The function is stored by value,
+    so that calls to it can be inlined.
+    @tparam ArgTypes the argument types. Must be specified.
+    @tparam F the function type. auto inferred.
+    @param function The function to be benchmarked.
+    @param os An ostream to which the output is streamed. Defaults to std::cout.
+    @return A BasicBenchmark object on the given function.
+    */
+    template< typename... ArgTypes, typename F>
+    constexpr auto create_benchmark(F function, std::ostream& os = std::cout) {
+        using ResultType = typename std::decay<decltype(function(std::declval<const ArgTypes&>()...))>::type;
+        return BasicBenchmark<F, ResultType, ArgTypes...>(function, os);
+    }
+
+} // END namespace unittest
@@ -42,6 +42,16 @@ FunctionTest<int, int, int> tester( fun);
 
 // ...
 
+###################################################################################################
+/*
+/*
+/* To let the compiler inline the function, have its type deduced:
+###################################################################################################
+
+auto tester = create_function_test<int, int>([&obj = c](int i, int j) { return obj.foo(i, j); });
+
+// ...
+
 ###################################################################################################
 /*
 /*
@@ -50,14 +60,33 @@ FunctionTest<int, int, int> tester( fun);
 /*****************************************************************************/
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <sstream>
-
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "alloc_tracker.hpp"
+#include "case_file.hpp"
+#include "default_functions.hpp"
+#include "perf_counters.hpp"
+#include "process_isolation.hpp"
+#include "reporter.hpp"
+#include "run_record.hpp"
+#include "test_table.hpp"
+#include "tolerance.hpp"
 #include "verbosity.hpp"
+#include "work_stealing.hpp"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -66,22 +95,29 @@ FunctionTest<int, int, int> tester( fun);
 
 namespace unittest {
 
-    /** FunctionTest unit testing class wich is capable of invoking arbitrary
+    /** BasicFunctionTest unit testing class wich is capable of invoking arbitrary
     functions with a return value and comparing them to anticipated values. 
     Measures the run-time of the function and writes unit test results to a stream.
-    For proper functioning, this class relies on copy assignment 
-    of the result types and the argument types.
+    For proper functioning, this class relies on default construction and move assignment
+    of the result types. Results are only copied for last_test_result(), see retain_last_result,
+    so that move-only results like std::unique_ptr can be tested as well.
+    The callables are stored by value with their own types, so that calls to them can be inlined.
+    FunctionTest is the variant that stores std::function objects instead.
+    create_function_test() deduces the callable types and the result type.
+    @tparam Function Type of the function.
+    @tparam Comparator Type of the result comparison function.
+    @tparam ToString Type of the to-string function for ResultType.
     @tparam ResultType Return type of the given function.
     @tparam ArgTypes Argument types of the given function.
     */
-    template< typename ResultType, typename... ArgTypes>
-    class FunctionTest {
+    template< typename Function, typename Comparator, typename ToString, typename ResultType, typename... ArgTypes>
+    class BasicFunctionTest {
 
     public: // types
 
-        using FunctionType              = const std::function<ResultType(ArgTypes...)>;
-        using ComparatorFunctionType    = const std::function<bool(const ResultType&, const ResultType&)>;
-        using ToStringFunctionType      = const std::function<std::string(const ResultType&)>;
+        using FunctionType              = Function;
+        using ComparatorFunctionType    = Comparator;
+        using ToStringFunctionType      = ToString;
         using DurationType              = std::chrono::microseconds;
 
     public: // inner classes
@@ -89,8 +125,63 @@ namespace unittest {
         /// The return type of the test() function.
         struct TestReturnType {
             bool is_passed                      = false;                    ///< Indicates whether the test was correctly passed or not.
-            ResultType result;                                              ///< Copy of the returned result of the function invocation.
+            ResultType result;                                              ///< The returned result of the function invocation, moved into place.
             DurationType invocation_duration    = DurationType(0);          ///< The invocation duration of the function in microseconds.
+            perf_counters::counts counters;                                 ///< The hardware counts of the invocation if measure_hardware_counters is set.
+                                                                            ///< NaN for unavailable counters.
+            alloc_tracker::counts allocations;                              ///< The heap allocations of the invocation if measure_allocations is set.
+            int crash_signal                    = 0;                        ///< The signal with which the invocation crashed if is_isolated is set, 0 otherwise.
+            int exit_status                     = 0;                        ///< The status with which the child process exited early if is_isolated is set,
+                                                                            ///< e.g. if the function called exit(), 0 otherwise.
+            bool is_timed_out                   = false;                    ///< Whether the invocation ran past case_timeout if is_isolated is set.
+        };
+
+    private: // inner classes
+
+        /// The outcome of a single invocation of the function, see invoke().
+        struct InvocationType {
+            bool is_returned                    = false;                    ///< False if the function threw.
+            bool is_passed                      = false;                    ///< Whether the result equals the expected result.
+            DurationType duration               = DurationType(0);          ///< The duration of the invocation.
+            perf_counters::counts counters;                                 ///< The hardware counts if measure_hardware_counters is set.
+            alloc_tracker::counts allocations;                              ///< The heap allocations if measure_allocations is set.
+            ResultType result;                                              ///< The returned result.
+            std::string exception_type;                                     ///< The type of the exception, empty if it is no std::exception.
+            std::string exception_what;                                     ///< The description of the exception.
+            std::string result_string;                                      ///< The result as a string if the test failed at verbosity VERBOSE.
+            std::string expected_string;                                    ///< The expected result as a string, likewise.
+            std::string mismatch_string;                                    ///< The description of the mismatch, likewise.
+        };
+
+        /// The return type of the test_table() function.
+        struct TableReturnType : table_result {
+            DurationType invocation_duration    = DurationType(0);          ///< The duration of the invocations on all rows.
+        };
+
+        /// A row of a test table of the function.
+        using TableRowType = table_row<ResultType, ArgTypes...>;
+
+        /// A case of a case file of the function: the expected result and the arguments.
+        using CaseTupleType = std::tuple<ResultType, ArgTypes...>;
+
+        /// A failed case of a case file, see test_cases().
+        struct FailedCaseType {
+            std::size_t case_id                 = 0;                        ///< The id of the case in its case file.
+            std::string location;                                           ///< Where the case is in its case file, e.g. "line 17".
+            ResultType result;                                              ///< The returned result, unless error is set.
+            ResultType expected;                                            ///< The expected result, unless the case is malformed.
+            std::string error;                                              ///< The exception of the invocation or the error of the malformed case, empty otherwise.
+        };
+
+        /// The return type of the test_cases() function.
+        struct CasesReturnType {
+            std::size_t n_cases                 = 0;                        ///< The number of cases, including malformed ones.
+            std::size_t n_passed_cases          = 0;                        ///< The number of cases whose expected result the function returned.
+            DurationType invocation_duration    = DurationType(0);          ///< The duration of the chunks of cases, summed over the threads. Includes parsing.
+            std::vector<FailedCaseType> failed_cases;                       ///< The max_failed_cases first failed cases, in the order of the case file.
+
+            /// Indicates whether the function returned the expected result of every case.
+            bool is_all_cases_passed() const { return n_passed_cases == n_cases; }
         };
 
     private: // vars
@@ -98,19 +189,39 @@ namespace unittest {
         FunctionType fun_;                                                  ///< The function.
         ComparatorFunctionType comp_;                                       ///< The result comparison function.
         ToStringFunctionType to_string_function_;                           ///< The to-string function for ResultType.
-        std::ostream& os_;                                                  ///< The output stream.
+        std::shared_ptr<reporter> reporter_;                                ///< The output.
+        std::shared_ptr<run_record::recorder> recorder_;                    ///< Receives a record of every test, or nullptr.
+        std::shared_ptr<perf_counters::counter_group> counters_;            ///< The hardware counters of counters_thread_ if measure_hardware_counters is set, opened on first use.
+        std::thread::id counters_thread_;                                   ///< The thread that opened counters_.
 
         unsigned int n_tests_                           = 0;                ///< Number of tests.
         unsigned int n_passed_tests_                    = 0;                ///< Number of passed tests.
         bool is_last_test_passed_                       = true;             ///< Indicates whether the last test passed or not.
         DurationType last_invocation_duration_          = DurationType(0);  ///< The duration of the last function invocation.
         DurationType accumulated_invocation_durations_  = DurationType(0);  ///< The accumulated execution time for all function invocations.
-        ResultType last_test_result_;                                       ///< Assignment copy result of the last test.
+        ResultType last_test_result_;                                       ///< Copy of the result of the last test if retain_last_result is set.
+        alloc_tracker::counts accumulated_allocations_;                     ///< The heap allocations of all function invocations if measure_allocations is set.
 
     public: // vars
 
         verbosity verbosity_level = verbosity::VERBOSE;                     ///< Defines the verbosity of the stream out amount.   
         unsigned int output_line_length = 60;                               ///< The max number of dots that is shown in the printed lines.
+        bool measure_hardware_counters = false;                             ///< Whether test() reads hardware performance counters around the invocation, see perf_counters.
+        bool measure_allocations = false;                                   ///< Whether test() counts the heap allocations of the invocation.
+                                                                            ///< Requires the replacements of new and delete, see alloc_tracker.
+        bool is_isolated = false;                                           ///< Whether test() invokes the function in a forked child process instead of in the calling one,
+                                                                            ///< so that a crash fails the test instead of ending the program. Costs a fork per test.
+                                                                            ///< The function runs once, in the child, so its side effects stay in the child.
+                                                                            ///< The result is sent back if it is trivially copyable or a std::string,
+                                                                            ///< otherwise the result of the test and last_test_result() are default-constructed.
+                                                                            ///< POSIX only, ignored elsewhere. The test fails while process_isolation::is_fork_safe() is false,
+                                                                            ///< e.g. in a test series that was not registered as isolated, see registry.hpp.
+        DurationType case_timeout = DurationType(0);                        ///< The deadline of an invocation in a child process, see is_isolated, after which the child
+                                                                            ///< is ended and the test fails. 0 disables it.
+        bool retain_last_result = std::is_copy_assignable<ResultType>::value;  ///< Whether test() keeps a copy of the result for last_test_result().
+                                                                            ///< Clear it for large results, so that they are never copied. Ignored for move-only results.
+        unsigned int n_threads = 1;                                         ///< The number of worker threads of test_cases(). 0 means one per hardware thread.
+        unsigned int max_failed_cases = 100;                                ///< The number of failed cases that test_cases() keeps and writes.
 
     public: // constructors
 
@@ -120,19 +231,18 @@ namespace unittest {
         with given expected results. The comparison function must have the form
         bool(ResultType, ResultType) or similar.
         @param to_string_function The to-string function for the function's return type.
-        Defaults to { std::stringstream ss; ss << result; ss.str(); }.
         @param os An ostream to which the output is streamed.
         */
-        FunctionTest(
+        BasicFunctionTest(
             FunctionType function, 
-            ComparatorFunctionType comparator = [](const ResultType& a, const ResultType& b) { return a == b; },
-            ToStringFunctionType to_string_function = [](const ResultType& r) { std::stringstream ss; ss << r; return ss.str(); },
+            ComparatorFunctionType comparator,
+            ToStringFunctionType to_string_function,
             std::ostream& os = std::cout)
             : 
             fun_(function),
             comp_(comparator),
             to_string_function_(to_string_function),
-            os_(os)
+            reporter_(std::make_shared<ostream_reporter>(os))
         {}
 
 
@@ -152,95 +262,253 @@ namespace unittest {
         Tests whether the return-value of a given function invoked with given parameters is equal to a given value.
         Also measures the time the function execution takes and writes the results of the test to a given output-stream.
         Checks also for exceptions and reports them to the output stream.
+        If is_isolated is set, the function is invoked once in a child process, which sends back its outcome.
+        The test fails if the child crashes, exits early, or runs past case_timeout.
         In case of error the object's flag .verbose in conjunction with a valid result_to_string_function
         can be used to write more sophisticated output.
         @param test_name A human-readable alias of the test that will be written into the stream.
         @param expected_result The anticipated return value of the tested function.
         @param args The arguments that will be passed to the function on invocation.
-        @return An object of type FunctionTest<A,B...>::TestReturnType.
+        @return An object of type BasicFunctionTest<A,B...>::TestReturnType.
         */
         TestReturnType test( const std::string& test_name, const ResultType& expected_result, const ArgTypes&... args) {
-            using namespace std::chrono;
+            return conduct(&test_name, expected_result, args...);
+        }
 
-            TestReturnType ret;
-            ret.is_passed = false;
 
-            std::string output = "FunctionTest: " + test_name + ": ";
-            output.resize(output_line_length, '.');
-            log(output + " ", verbosity::NORMAL);
+        /** Unit test on the function that is connected to the tester.
+        Tests whether the return-value of a given function invoked with given parameters is equal to a given value.
+        Also measures the time the function execution takes and writes the results of the test to a given output-stream.
+        Checks also for exceptions and reports them to the output stream.
+        In case of error the object's flag .verbose in conjunction with a valid result_to_string_function
+        can be used to write more sophisticated output.
+        The test is named after its index, which is only converted to a string if it is written.
+        @param expected_result The anticipated return value of the tested function.
+        @param args The arguments that will be passed to the function on invocation.
+        @return An object of type BasicFunctionTest<A,B...>::TestReturnType.
+        */
+        TestReturnType test( const ResultType& expected_result, const ArgTypes&... args) {
+            return conduct(nullptr, expected_result, args...);
+        }
 
-            try {
-                const auto clock_start = steady_clock::now();
-                const ResultType result = fun_(args...);
-                const auto dur = duration_cast<DurationType>(steady_clock::now() - clock_start);
-                ret.result = result;
 
-                if (comp_(result, expected_result)) {
-                    // correct case
 
-                    ++n_passed_tests_;
-                    is_last_test_passed_ = true;
-                    ret.is_passed = true;
+        /** Table-driven unit test on the function that is connected to the tester.
+        Invokes the function on the arguments of every row of the given test table and compares the results
+        to the expected results of the rows. The rows are invoked in a loop that reads the clock once before
+        and once after all rows and stores nothing but the indices of failed rows. A single line is written
+        for the table. At verbosity VERBOSE, the function is invoked on the failed rows once more to write
+        their results. Every row counts as a test.
+        For constexpr functions, see check_table(), which checks a table at compile time.
+        @param test_name A human-readable alias of the test that will be written into the stream.
+        @param rows The test table.
+        @return An object of type BasicFunctionTest<A,B...>::TableReturnType.
+        */
+        template <std::size_t N>
+        TableReturnType test_table(const std::string& test_name, const TableRowType (&rows)[N]) {
+            using namespace std::chrono;
+
+            TableReturnType ret;
+            ret.n_rows = N;
+            ret.first_failed_row = N;
 
-                    std::stringstream ss;
-                    ss << "OK (" << dur.count() << " s)\n";
-                    log( ss.str(), verbosity::NORMAL);
+            if (verbosity_level >= verbosity::NORMAL) {
+                log(verbosity::NORMAL, [test_name, n_chars = output_line_length](std::ostream& os) {
+                    std::string output = "FunctionTest: " + test_name + ": ";
+                    output.resize(n_chars, '.');
+                    os << output << " ";
+                });
+            }
+
+            std::vector<std::size_t> failed_rows;
+            const auto clock_start = steady_clock::now();
+            for (std::size_t i = 0; i < N; ++i) {
+                bool is_passed = false;
+                try {
+                    is_passed = comp_(std::apply(fun_, rows[i].args), rows[i].expected);
+                }
+                catch (...) {
+                    // reported with the failed rows
+                }
+                if (is_passed) {
+                    ++ret.n_passed_rows;
                 }
                 else {
-                    // failure case
+                    failed_rows.push_back(i);
+                }
+            }
+            ret.invocation_duration = duration_cast<DurationType>(steady_clock::now() - clock_start);
+            if (!failed_rows.empty()) {
+                ret.first_failed_row = failed_rows.front();
+            }
 
-                    is_last_test_passed_ = false;
+            n_tests_ += static_cast<unsigned int>(N);
+            n_passed_tests_ += static_cast<unsigned int>(ret.n_passed_rows);
+            is_last_test_passed_ = ret.is_all_rows_passed();
+            last_invocation_duration_ = ret.invocation_duration;
+            accumulated_invocation_durations_ += ret.invocation_duration;
+
+            log(verbosity::NORMAL, [is_passed = ret.is_all_rows_passed(), n_passed = ret.n_passed_rows, dur = ret.invocation_duration](std::ostream& os) {
+                os << (is_passed ? "OK (" : "FAILED (") << n_passed << "/" << N << " rows, " << dur.count() << " s)\n";
+            });
+            if (verbosity_level >= verbosity::VERBOSE) {
+                for (const std::size_t i : failed_rows) {
+                    write_failed_row(i, rows[i]);
+                }
+            }
+
+            if (recorder_) {
+                recorder_->add(run_record::from_test_table(test_name, ret));
+            }
+            return ret;
+        }
+
+
+        /** Data-driven unit test on the function that is connected to the tester.
+        Invokes the function on the arguments of every case of the given case file, e.g. a csv_case_file
+        or a binary_case_file, and compares the results to the expected results of the cases.
+        The chunks of the case file are spread over n_threads threads. The cases are parsed one by one while
+        they are tested and only the failed ones are kept, so that case files that are larger than the RAM work.
+        Malformed cases fail. A single line is written for the case file. At verbosity VERBOSE,
+        the max_failed_cases first failed cases are written as well. Every case counts as a test.
+        The function and the comparator must be safe to call concurrently if n_threads is not 1.
+        @param test_name A human-readable alias of the test that will be written into the stream.
+        @param cases The case file.
+        @return An object of type BasicFunctionTest<A,B...>::CasesReturnType.
+        */
+        template <typename CaseFile>
+        CasesReturnType test_cases(const std::string& test_name, const CaseFile& cases) {
+            static_assert(std::is_same<typename CaseFile::CaseTupleType, CaseTupleType>::value,
+                "test_cases(): the case file must hold the result type and the argument types of the function");
+            using namespace std::chrono;
+
+            CasesReturnType ret;
+
+            if (verbosity_level >= verbosity::NORMAL) {
+                log(verbosity::NORMAL, [test_name, n_chars = output_line_length](std::ostream& os) {
+                    std::string output = "FunctionTest: " + test_name + ": ";
+                    output.resize(n_chars, '.');
+                    os << output << " ";
+                });
+            }
 
-                    std::stringstream ss;
-                    ss << "FAILED (" << dur.count() << " s)\n";
-                    log( ss.str(), verbosity::NORMAL);
-                    ss.str("");
-                    ss << 
-                        " RESULT:   " << to_string_function_(result) << "\n" <<
-                        " EXPECTED: " << to_string_function_(expected_result) << "\n" <<
-                        ".\n";
-                    log(ss.str(), verbosity::VERBOSE);
+            struct worker_state {
+                std::size_t n_cases = 0;
+                std::size_t n_passed_cases = 0;
+                DurationType duration = DurationType(0);
+                std::vector<FailedCaseType> failed_cases;
+            };
+            const auto n_workers = work_stealing::resolve_n_workers(n_threads);
+            std::vector<worker_state> workers(n_workers);
+            const std::size_t max_failed = max_failed_cases;
+            const auto by_case_id = [](const FailedCaseType& a, const FailedCaseType& b) { return a.case_id < b.case_id; };
+
+            // keeps the max_failed first failed cases of a worker, trimmed once they are twice as many
+            const auto keep = [&](worker_state& w, FailedCaseType&& failed) {
+                w.failed_cases.push_back(std::move(failed));
+                if (w.failed_cases.size() > 2 * max_failed) {
+                    std::nth_element(w.failed_cases.begin(), w.failed_cases.begin() + max_failed, w.failed_cases.end(), by_case_id);
+                    w.failed_cases.resize(max_failed);
                 }
+            };
 
-                ++n_tests_;
-                last_test_result_ = result;
-                last_invocation_duration_ = dur;
-                accumulated_invocation_durations_ += dur;
-                ret.invocation_duration = dur;
+            work_stealing::parallel_for(cases.n_chunks(), n_workers, 1, [&](const unsigned int worker, const std::size_t begin, const std::size_t end) {
+                auto& w = workers[worker];
+                const auto clock_start = steady_clock::now();
+                for (std::size_t chunk = begin; chunk < end; ++chunk) {
+                    cases.visit_chunk(chunk,
+                        [&](const std::size_t case_id, const CaseTupleType& c) {
+                            ++w.n_cases;
+                            FailedCaseType failed;
+                            try {
+                                failed.result = invoke_case(c, std::index_sequence_for<ArgTypes...>());
+                                if (comp_(failed.result, std::get<0>(c))) {
+                                    ++w.n_passed_cases;
+                                    return;
+                                }
+                            }
+                            catch (std::exception& ex) {
+                                failed.error = std::string(typeid(ex).name()) + ": " + ex.what();
+                            }
+                            catch (...) {
+                                failed.error = "unknown exception";
+                            }
+                            failed.case_id = case_id;
+                            failed.expected = std::get<0>(c);
+                            keep(w, std::move(failed));
+                        },
+                        [&](const std::size_t case_id, const std::string& error) {
+                            ++w.n_cases;
+                            FailedCaseType failed;
+                            failed.case_id = case_id;
+                            failed.error = error;
+                            keep(w, std::move(failed));
+                        });
+                }
+                w.duration += duration_cast<DurationType>(steady_clock::now() - clock_start);
+            });
+
+            for (auto& w : workers) {
+                ret.n_cases += w.n_cases;
+                ret.n_passed_cases += w.n_passed_cases;
+                ret.invocation_duration += w.duration;
+                std::move(w.failed_cases.begin(), w.failed_cases.end(), std::back_inserter(ret.failed_cases));
             }
-            catch (std::exception& ex) {
-                std::stringstream ss;
-                ss << 
-                    "EXCEPTION\n" <<
-                    typeid(ex).name() << ":\n" << 
-                    ex.what() << "\n";
-                log(ss.str(), verbosity::NORMAL);
+            std::sort(ret.failed_cases.begin(), ret.failed_cases.end(), by_case_id);
+            if (ret.failed_cases.size() > max_failed) {
+                ret.failed_cases.resize(max_failed);
             }
-            catch (...) {
-                log("EXCEPTION\nunknown\n", verbosity::NORMAL);
+            for (auto& failed : ret.failed_cases) {
+                failed.location = cases.location(failed.case_id);
             }
 
+            n_tests_ += static_cast<unsigned int>(ret.n_cases);
+            n_passed_tests_ += static_cast<unsigned int>(ret.n_passed_cases);
+            is_last_test_passed_ = ret.is_all_cases_passed();
+            last_invocation_duration_ = ret.invocation_duration;
+            accumulated_invocation_durations_ += ret.invocation_duration;
+
+            log(verbosity::NORMAL, [is_passed = ret.is_all_cases_passed(), n_passed = ret.n_passed_cases, n = ret.n_cases, dur = ret.invocation_duration](std::ostream& os) {
+                os << (is_passed ? "OK (" : "FAILED (") << n_passed << "/" << n << " cases, " << dur.count() << " s)\n";
+            });
+            if (verbosity_level >= verbosity::VERBOSE) {
+                for (const auto& failed : ret.failed_cases) {
+                    write_failed_case(failed);
+                }
+                const std::size_t n_failed = ret.n_cases - ret.n_passed_cases;
+                if (n_failed > ret.failed_cases.size()) {
+                    log(verbosity::VERBOSE, [n_more = n_failed - ret.failed_cases.size()](std::ostream& os) {
+                        os << " ... and " << n_more << " more failed cases, see max_failed_cases\n";
+                    });
+                }
+            }
+
+            if (recorder_) {
+                recorder_->add(run_record::from_test_cases(test_name, ret));
+            }
             return ret;
         }
 
+        
+        /** Replaces the output stream of the constructor with the given reporter,
+        e.g. with an async_reporter that several testers share.
+        @param r The reporter.
+        */
+        void set_reporter(std::shared_ptr<reporter> r) {
+            reporter_ = std::move(r);
+        }
 
-        /** Unit test on the function that is connected to the tester.
-        Tests whether the return-value of a given function invoked with given parameters is equal to a given value.
-        Also measures the time the function execution takes and writes the results of the test to a given output-stream.
-        Checks also for exceptions and reports them to the output stream.
-        In case of error the object's flag .verbose in conjunction with a valid result_to_string_function
-        can be used to write more sophisticated output.
-        @param expected_result The anticipated return value of the tested function.
-        @param args The arguments that will be passed to the function on invocation.
-        @return An object of type FunctionTest<A,B...>::TestReturnType.
+
+        /** Sets a recorder to which test() adds a record of every test, see run_record.
+        @param r The recorder, or nullptr to stop recording.
         */
-        TestReturnType test( const ResultType& expected_result, const ArgTypes&... args) {
-            return test( itos(n_tests()), expected_result, args... );
+        void set_recorder(std::shared_ptr<run_record::recorder> r) {
+            recorder_ = std::move(r);
         }
 
-        
+
         /** After running a series of FunctionTest::test() invocations, this method can be called to write
-        summarized information to the output stream.
+        summarized information to the output stream. Flushes the reporter.
         @return TRUE if all tests until now are passed or no test has been executed.
                 FALSE otherwise.
         */
@@ -248,15 +516,15 @@ namespace unittest {
             const auto is_all_passed = is_all_tests_passed();
             const auto dur = accumulated_invocation_durations().count();
 
-            std::stringstream ss;
-            if (is_all_passed)  ss << "+++ TEST SERIES PASSED +++  :)";
-            else                ss << "--- SOME TESTS FAILED  ---  :(((";
-
-            ss << 
-                "       (" << n_passed_tests() << "/" << n_tests() << ")   (accumulated: " << dur << " s)\n"
-                "\n";
+            log(verbosity::SILENT, [is_all_passed, dur, n_passed = n_passed_tests(), n = n_tests()](std::ostream& os) {
+                if (is_all_passed)  os << "+++ TEST SERIES PASSED +++  :)";
+                else                os << "--- SOME TESTS FAILED  ---  :(((";
 
-            log(ss.str(),  verbosity::SILENT);
+                os <<
+                    "       (" << n_passed << "/" << n << ")   (accumulated: " << dur << " s)\n"
+                    "\n";
+            });
+            reporter_->flush();
 
             return is_all_passed;
         }
@@ -271,50 +539,418 @@ namespace unittest {
         inline unsigned int n_passed_tests() const { return n_passed_tests_; }
 
         /// Returns if the last test whas passed. Also returns TRUE if no test was executed.
-        inline bool is_last_test_passed() const { retun is_last_test_passed_; }
+        inline bool is_last_test_passed() const { return is_last_test_passed_; }
 
         /// The duration of the last function invocation.
         inline DurationType last_invocation_duration() const { return last_invocation_duration_; }
 
-        /// Returns a assignment-copy of the result of the last test.
-        inline ResultType last_test_result() const { return last_test_result_; }                                
+        /// Returns the result of the last test if retain_last_result is set, a default constructed result otherwise.
+        inline const ResultType& last_test_result() const { return last_test_result_; }
 
         /// Indicates whether every test so far passed or not. Also returns TRUE if no test was executed.
         inline bool is_all_tests_passed() const { return n_tests_ == n_passed_tests_; }
 
         /// The accumulated execution time for all function invocations.
         inline DurationType accumulated_invocation_durations() const { return accumulated_invocation_durations_; }
+
+        /// The heap allocations of all function invocations if measure_allocations is set. The peak is the maximum over the invocations.
+        inline const alloc_tracker::counts& accumulated_allocations() const { return accumulated_allocations_; }
         
     protected: // helpers
 
-        /** Writes the given string to the output stream if the given verbosity level.
-        is equal or smaller than the verbosity_level member value.
-        @param str The string to be written to a stream;
-        @param str_verbosity_level The verbosity level of the given string.
+        /** Reports a message if the given verbosity level is equal or smaller than the verbosity_level member value.
+        The message is not formatted otherwise.
+        @param message_verbosity_level The verbosity level of the message.
+        @param format A function void(std::ostream&) that formats the message. The reporter may call it
+        later on another thread, so it must hold copies of everything it refers to.
         */
-        constexpr void log(const std::string& str, const verbosity str_verbosity_level) const {
-            if ( verbosity_level >= str_verbosity_level) {
-                os_ << str;
+        template <typename F>
+        void log(const verbosity message_verbosity_level, F&& format) const {
+            if (verbosity_level >= message_verbosity_level) {
+                reporter_->report(deferred_message(std::forward<F>(format)));
             }
         }
 
+
+        /// Invokes the function on a failed row of a test table once more and writes its result, see test_table().
+        void write_failed_row(const std::size_t index, const TableRowType& row) {
+            try {
+                const ResultType result = std::apply(fun_, row.args);
+                log(verbosity::VERBOSE, [index, result_string = to_string_function_(result), expected_string = to_string_function_(row.expected),
+                                         mismatch_string = default_functions::describe_mismatch(comp_, result, row.expected)](std::ostream& os) {
+                    os <<
+                        " ROW " << index << ":\n"
+                        " RESULT:   " << result_string << "\n" <<
+                        " EXPECTED: " << expected_string << "\n";
+                    if (!mismatch_string.empty()) {
+                        os << " MISMATCH: " << mismatch_string << "\n";
+                    }
+                    os << ".\n";
+                });
+            }
+            catch (std::exception& ex) {
+                log(verbosity::VERBOSE, [index, type_name = std::string(typeid(ex).name()), what = std::string(ex.what())](std::ostream& os) {
+                    os << " ROW " << index << ":\nEXCEPTION\n" << type_name << ":\n" << what << "\n.\n";
+                });
+            }
+            catch (...) {
+                log(verbosity::VERBOSE, [index](std::ostream& os) { os << " ROW " << index << ":\nEXCEPTION\nunknown\n.\n"; });
+            }
+        }
+
+
+        /// Writes a failed case of a case file, see test_cases().
+        void write_failed_case(const FailedCaseType& failed) {
+            if (!failed.error.empty()) {
+                log(verbosity::VERBOSE, [location = failed.location, error = failed.error](std::ostream& os) {
+                    os << " CASE " << location << ":\nERROR\n" << error << "\n.\n";
+                });
+                return;
+            }
+            log(verbosity::VERBOSE, [location = failed.location, result_string = to_string_function_(failed.result), expected_string = to_string_function_(failed.expected),
+                                     mismatch_string = default_functions::describe_mismatch(comp_, failed.result, failed.expected)](std::ostream& os) {
+                os <<
+                    " CASE " << location << ":\n"
+                    " RESULT:   " << result_string << "\n" <<
+                    " EXPECTED: " << expected_string << "\n";
+                if (!mismatch_string.empty()) {
+                    os << " MISMATCH: " << mismatch_string << "\n";
+                }
+                os << ".\n";
+            });
+        }
+
+
+        /// Invokes the function on the arguments of a case of a case file, see test_cases().
+        template <std::size_t... Is>
+        ResultType invoke_case(const CaseTupleType& c, std::index_sequence<Is...>) {
+            return fun_(std::get<Is + 1>(c)...);
+        }
+
+
+        /// Keeps a copy of the given result for last_test_result() if retain_last_result is set, drops the last one otherwise.
+        void retain(const ResultType& result) {
+            if constexpr (std::is_copy_assignable<ResultType>::value) {
+                if (retain_last_result) {
+                    last_test_result_ = result;
+                    return;
+                }
+            }
+            last_test_result_ = ResultType();
+        }
+
+
+        /** Conducts a test, see test().
+        @param test_name The name of the test, or nullptr to name the test after its index.
+        */
+        TestReturnType conduct(const std::string* test_name, const ResultType& expected_result, const ArgTypes&... args) {
+            TestReturnType ret;
+            ret.is_passed = false;
+
+            const unsigned int test_index = n_tests_;
+            const auto name = [test_name, test_index]() { return test_name ? *test_name : std::to_string(test_index); };
+
+            if (verbosity_level >= verbosity::NORMAL) {
+                log(verbosity::NORMAL, [name = name(), n_chars = output_line_length](std::ostream& os) {
+                    std::string output = "FunctionTest: " + name + ": ";
+                    output.resize(n_chars, '.');
+                    os << output << " ";
+                });
+            }
+
+            InvocationType invocation;
+#if defined(UNITTEST_PROCESS_ISOLATION)
+            if (is_isolated) {
+                // the arguments exist only within this call, hence a child process is forked per test
+                const auto probed = process_isolation::probe([&](std::string& reply) {
+                    // the counters of the calling process do not count the child process
+                    counters_.reset();
+                    write_invocation(reply, invoke(expected_result, args...));
+                }, case_timeout);
+                if (!probed.is_completed() || !read_invocation(probed.reply, invocation)) {
+                    ++n_tests_;
+                    is_last_test_passed_ = false;
+                    ret.crash_signal = probed.is_timed_out ? 0 : probed.signal;
+                    ret.exit_status = probed.exit_status;
+                    ret.is_timed_out = probed.is_timed_out;
+                    log(verbosity::NORMAL, [is_started = probed.is_started, is_fork_safe = process_isolation::is_fork_safe(),
+                                             is_timed_out = ret.is_timed_out, signal = ret.crash_signal, status = ret.exit_status](std::ostream& os) {
+                        if (!is_started) {
+                            os << (is_fork_safe ? "NOT ISOLATED (no child process)\n" : "NOT ISOLATED (series run concurrently, see registry.hpp)\n");
+                        }
+                        else if (is_timed_out) {
+                            os << "TIMED OUT\n";
+                        }
+                        else if (signal != 0) {
+                            os << "CRASHED (" << process_isolation::signal_name(signal) << ")\n";
+                        }
+                        else {
+                            os << "EXITED (status " << status << ")\n";
+                        }
+                    });
+                    if (recorder_) {
+                        recorder_->add(run_record::from_function_test(name(), ret, measure_hardware_counters));
+                    }
+                    return ret;
+                }
+            }
+            else {
+                invocation = invoke(expected_result, args...);
+            }
+#else
+            invocation = invoke(expected_result, args...);
+#endif
+
+            if (!invocation.is_returned) {
+                if (invocation.exception_type.empty()) {
+                    log(verbosity::NORMAL, [](std::ostream& os) { os << "EXCEPTION\nunknown\n"; });
+                }
+                else if (verbosity_level >= verbosity::NORMAL) {
+                    log(verbosity::NORMAL, [type_name = std::move(invocation.exception_type), what = std::move(invocation.exception_what)](std::ostream& os) {
+                        os <<
+                            "EXCEPTION\n" <<
+                            type_name << ":\n" <<
+                            what << "\n";
+                    });
+                }
+                if (recorder_) {
+                    recorder_->add(run_record::from_function_test(name(), ret, measure_hardware_counters));
+                }
+                return ret;
+            }
+
+            const auto dur = invocation.duration;
+            if (measure_allocations) {
+                ret.allocations = invocation.allocations;
+                accumulated_allocations_ += ret.allocations;
+                log(verbosity::VERBOSE, [a = ret.allocations](std::ostream& os) {
+                    os << "(" << a.n_allocations << " allocations, " << a.n_bytes_allocated << " bytes, peak " << a.peak_live_bytes << " live bytes) ";
+                });
+            }
+            if (measure_hardware_counters) {
+                ret.counters = invocation.counters;
+                log(verbosity::VERBOSE, [c = ret.counters](std::ostream& os) { os << "(" << c << ") "; });
+            }
+
+            if (invocation.is_passed) {
+                // correct case
+
+                ++n_passed_tests_;
+                is_last_test_passed_ = true;
+                ret.is_passed = true;
+
+                log(verbosity::NORMAL, [dur](std::ostream& os) { os << "OK (" << dur.count() << " s)\n"; });
+            }
+            else {
+                // failure case
+
+                is_last_test_passed_ = false;
+
+                log(verbosity::NORMAL, [dur](std::ostream& os) { os << "FAILED (" << dur.count() << " s)\n"; });
+                if (verbosity_level >= verbosity::VERBOSE) {
+                    log(verbosity::VERBOSE, [result_string = std::move(invocation.result_string), expected_string = std::move(invocation.expected_string),
+                                             mismatch_string = std::move(invocation.mismatch_string)](std::ostream& os) {
+                        os <<
+                            " RESULT:   " << result_string << "\n" <<
+                            " EXPECTED: " << expected_string << "\n";
+                        if (!mismatch_string.empty()) {
+                            os << " MISMATCH: " << mismatch_string << "\n";
+                        }
+                        os << ".\n";
+                    });
+                }
+            }
+
+            ++n_tests_;
+            retain(invocation.result);
+            ret.result = std::move(invocation.result);
+            last_invocation_duration_ = dur;
+            accumulated_invocation_durations_ += dur;
+            ret.invocation_duration = dur;
+
+            if (recorder_) {
+                recorder_->add(run_record::from_function_test(name(), ret, measure_hardware_counters));
+            }
+            return ret;
+        }
+
+
+        /** Invokes the function once, measures the invocation and compares its result to the expected one.
+        Exceptions of the function are caught and described in the outcome.
+        */
+        InvocationType invoke(const ResultType& expected_result, const ArgTypes&... args) {
+            using namespace std::chrono;
+
+            InvocationType ret;
+            const perf_counters::counter_group* counters = measure_hardware_counters ? &thread_counters() : nullptr;
+
+            try {
+                const auto counters_start = counters ? counters->read() : perf_counters::counter_group::snapshot();
+                const auto allocations_start = measure_allocations ? alloc_tracker::start() : alloc_tracker::snapshot();
+                const auto clock_start = steady_clock::now();
+                ret.result = fun_(args...);
+                ret.duration = duration_cast<DurationType>(steady_clock::now() - clock_start);
+                if (measure_allocations) {
+                    ret.allocations = alloc_tracker::stop(allocations_start);
+                }
+                if (counters) {
+                    ret.counters = counters->difference(counters_start, counters->read());
+                }
+                ret.is_returned = true;
+
+                ret.is_passed = comp_(ret.result, expected_result);
+                if (!ret.is_passed && verbosity_level >= verbosity::VERBOSE) {
+                    // the results need not outlive this call, hence they are converted to strings right away
+                    ret.result_string = to_string_function_(ret.result);
+                    ret.expected_string = to_string_function_(expected_result);
+                    ret.mismatch_string = default_functions::describe_mismatch(comp_, ret.result, expected_result);
+                }
+            }
+            catch (std::exception& ex) {
+                ret.is_returned = false;
+                ret.exception_type = typeid(ex).name();
+                ret.exception_what = ex.what();
+            }
+            catch (...) {
+                ret.is_returned = false;
+            }
+            return ret;
+        }
+
+
+        /// Returns the hardware counters of the calling thread. They are opened anew only if the tester is used on another thread than before.
+        const perf_counters::counter_group& thread_counters() {
+            if (!counters_ || counters_thread_ != std::this_thread::get_id()) {
+                counters_ = std::make_shared<perf_counters::counter_group>();
+                counters_thread_ = std::this_thread::get_id();
+            }
+            return *counters_;
+        }
+
+
+#if defined(UNITTEST_PROCESS_ISOLATION)
+
+        /// Writes the outcome of an invocation in a child process into its reply, see is_isolated.
+        static void write_invocation(std::string& reply, const InvocationType& invocation) {
+            process_isolation::message_writer out(reply);
+            out
+                .put(invocation.is_returned).put(invocation.is_passed).put(invocation.duration.count())
+                .put(invocation.counters).put(invocation.allocations)
+                .put_string(invocation.exception_type).put_string(invocation.exception_what)
+                .put_string(invocation.result_string).put_string(invocation.expected_string).put_string(invocation.mismatch_string);
+            if constexpr (std::is_trivially_copyable<ResultType>::value) {
+                out.put(invocation.result);
+            }
+            else if constexpr (std::is_same<ResultType, std::string>::value) {
+                out.put_string(invocation.result);
+            }
+        }
+
+
+        /// Reads the outcome of an invocation in a child process from its reply. False if the reply is incomplete.
+        static bool read_invocation(const std::string& reply, InvocationType& out_invocation) {
+            process_isolation::message_reader in(reply);
+            out_invocation.is_returned = in.get<bool>();
+            out_invocation.is_passed = in.get<bool>();
+            out_invocation.duration = DurationType(in.get<typename DurationType::rep>());
+            out_invocation.counters = in.get<perf_counters::counts>();
+            out_invocation.allocations = in.get<alloc_tracker::counts>();
+            out_invocation.exception_type = in.get_string();
+            out_invocation.exception_what = in.get_string();
+            out_invocation.result_string = in.get_string();
+            out_invocation.expected_string = in.get_string();
+            out_invocation.mismatch_string = in.get_string();
+            if constexpr (std::is_trivially_copyable<ResultType>::value) {
+                out_invocation.result = in.get<ResultType>();
+            }
+            else if constexpr (std::is_same<ResultType, std::string>::value) {
+                out_invocation.result = in.get_string();
+            }
+            return in.is_valid();
+        }
+
+#endif
+
+    }; // END class BasicFunctionTest
+
+
+    /** FunctionTest unit testing class wich is capable of invoking arbitrary
+    functions with a return value and comparing them to anticipated values. 
+    Measures the run-time of the function and writes unit test results to a stream.
+    For proper functioning, this class relies on default construction and move assignment
+    of the result types. Results are only copied for last_test_result(), see retain_last_result,
+    so that move-only results like std::unique_ptr can be tested as well.
+    Stores all callables as std::function objects. For callables that can be inlined,
+    see BasicFunctionTest and create_function_test().
+    @tparam ResultType Return type of the given function.
+    @tparam ArgTypes Argument types of the given function.
+    */
+    template< typename ResultType, typename... ArgTypes>
+    class FunctionTest : public BasicFunctionTest<
+        const std::function<ResultType(ArgTypes...)>,
+        const std::function<bool(const ResultType&, const ResultType&)>,
+        const std::function<std::string(const ResultType&)>,
+        ResultType,
+        ArgTypes...> {
+
+    public: // types
+
+        using BaseType = BasicFunctionTest<
+            const std::function<ResultType(ArgTypes...)>,
+            const std::function<bool(const ResultType&, const ResultType&)>,
+            const std::function<std::string(const ResultType&)>,
+            ResultType,
+            ArgTypes...>;
+
+        using typename BaseType::FunctionType;
+        using typename BaseType::ComparatorFunctionType;
+        using typename BaseType::ToStringFunctionType;
+
+    public: // constructors
+
+        /** Constructor for the function tester.
+        @param function A function that must return a value.
+        @param comparator A comparison function that compares the actual invocation-results
+        with given expected results. The comparison function must have the form
+        bool(ResultType, ResultType) or similar.
+        @param to_string_function The to-string function for the function's return type.
+        Defaults to default_functions::stream_to_string, see formatting::to_string().
+        @param os An ostream to which the output is streamed.
+        */
+        FunctionTest(
+            FunctionType function, 
+            ComparatorFunctionType comparator = default_functions::equal_to(),
+            ToStringFunctionType to_string_function = default_functions::stream_to_string(),
+            std::ostream& os = std::cout)
+            :
+            BaseType(function, comparator, to_string_function, os)
+        {}
+
     }; // END class FunctionTest
 
     
-    /** Helper function that creates a FunctionTest object without the need
-    to specify the return type of the function.
-    It is not better or shorter than the constructors.
-    The constructors are to be preferred.
-    The function's purpose is to prevent you from re-implementing it.
-    @tparam ArgTypes the argument types. auto inferred.
-    @tparam the function type. auto inferred.
+    /** Helper function that creates a BasicFunctionTest object without the need
+    to specify the return type of the function. The callables are stored by value,
+    so that calls to them can be inlined.
+    @tparam ArgTypes the argument types. Must be specified.
+    @tparam F the function type. auto inferred.
+    @tparam C the comparator type. auto inferred.
+    @tparam S the to-string function type. auto inferred.
     @param function The function to be tested.
-    @return A FunctionTest object on the given function.
+    @param comparator A comparison function for the results. Defaults to '='.
+    @param to_string_function The to-string function for the function's return type.
+    Defaults to default_functions::stream_to_string.
     @param os An ostream to which the output is streamed.
+    @return A BasicFunctionTest object on the given function.
     */
-    template< typename... ArgTypes, typename T>
-    constexpr auto create_function_test(T function, std::ostream& os = std::cout) {
-        return FunctionTest< decltype(function(ArgTypes{}...)), ArgTypes...>(function, os);
+    template<
+        typename... ArgTypes,
+        typename F,
+        typename C = default_functions::equal_to,
+        typename S = default_functions::stream_to_string>
+    constexpr auto create_function_test(F function, C comparator = C(), S to_string_function = S(), std::ostream& os = std::cout) {
+        using ResultType = typename std::decay<decltype(function(std::declval<const ArgTypes&>()...))>::type;
+        return BasicFunctionTest<F, C, S, ResultType, ArgTypes...>(function, comparator, to_string_function, os);
     }
 
 } // END namespace unittest
\ No newline at end of file
@@ -0,0 +1,494 @@
+/******************************************************************************
+/* @file Contains class MultiVariantFunctionTest for differential tests of
+/*       several variants of a function against one reference function.
+/*
+/* Each argument tuple is created once and the reference function is invoked
+/* once on it. Every variant, e.g. a scalar, an SSE, an AVX2 and a
+/* multithreaded implementation, is then invoked on the same arguments and
+/* compared to the same reference result. The variants are invoked in an
+/* order that rotates from case to case, so that none of them is always the
+/* first to touch the arguments.
+/*
+/* The variants are ranked: correct variants before incorrect ones, faster
+/* ones before slower ones by their mean invocation duration.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+MultiVariantFunctionTest<float, std::vector<float>> tester(
+    sum_reference,
+    [](unsigned int i) { return std::make_tuple(random_floats(i)); },
+    tolerance::relative(1e-5f));
+
+tester.add_variant("scalar", sum_scalar);
+tester.add_variant("avx2", sum_avx2);
+tester.add_variant("threads", sum_threads);
+
+auto r = tester.test("Sum", 10000);     // r.variants[r.ranking[0]] is the fastest correct variant
+
+// MultiVariantFunctionTest: Sum: ............ 10000 cases, 3 variants
+//  RANK  VARIANT               STATUS                   MEAN ns  SPEEDUP
+//     1  avx2                  OK (10000/10000)           31.20  7.91x (7.80x - 8.02x)
+//     2  threads               OK (10000/10000)          102.75  2.40x (2.31x - 2.50x)
+//     3  scalar                FAILED (9998/10000)       240.10  1.03x (1.01x - 1.05x)
+//        reference                                       246.85
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "default_functions.hpp"
+#include "reporter.hpp"
+#include "run_record.hpp"
+#include "timing.hpp"
+#include "tuple_call.hpp"
+#include "verbosity.hpp"
+#include "work_stealing.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+
+namespace unittest {
+
+    /** MultiVariantFunctionTest unit testing class which invokes several variants of a function
+    and a reference function on the same randomized arguments, compares the results of every variant
+    to the result of the reference function and ranks the variants by their correctness and speed.
+    For proper functioning, this class relies on default construction and move assignment
+    of the result types and the argument types.
+    @tparam ResultType Return type of the functions.
+    @tparam ArgTypes Argument types of the functions.
+    */
+    template< typename ResultType, typename... ArgTypes>
+    class MultiVariantFunctionTest {
+
+    public: // types
+
+        using ArgsTupleType                 = std::tuple<ArgTypes...>;
+        using FunctionType                  = std::function<ResultType(ArgTypes...)>;
+        using ArgsCreatorFunctionType       = std::function<ArgsTupleType(unsigned int)>;
+        using ComparatorFunctionType        = std::function<bool(const ResultType&, const ResultType&)>;
+        using ArgsToStringFunctionType      = std::function<std::string(const ArgsTupleType&)>;
+        using ResultToStringFunctionType    = std::function<std::string(const ResultType&)>;
+
+    public: // inner classes
+
+        /// Stores information on the circumstances which cause a single test of a variant to fail.
+        struct ErrorCaseType {
+            unsigned int case_index = 0;    ///< The index of the test case, i.e. the value that was passed to the argument creator.
+            ResultType erroneous_result;    ///< The errorneous result of the variant, unless it threw an exception.
+            ResultType reference_result;    ///< The supposedly correct return value of the reference function.
+            ArgsTupleType args;             ///< The corresponding function invocation arguments.
+            std::string exception;          ///< The exception that the variant threw, empty otherwise.
+        };
+
+        /// The outcome of the test series of a single variant.
+        struct VariantReturnType {
+            std::string name;                                           ///< The name of the variant.
+            unsigned int n_tests                            = 0;        ///< Number of tests.
+            unsigned int n_passed_tests                     = 0;        ///< Number of passed tests.
+            unsigned int rank                               = 0;        ///< The rank of the variant, 1 for the best one. See TestReturnType::ranking.
+            timing::running_stats invocation_duration_ns_stats;         ///< Running statistics of the invocation durations in ns, one sample per case.
+            timing::log_histogram invocation_duration_ns_histogram;     ///< Histogram of the samples of invocation_duration_ns_stats.
+            timing::running_stats log_speedup_stats;                    ///< Running statistics of the natural logarithms of the per-case speedups over the reference function.
+            double speedup                                  = 0;        ///< Geometric mean of the per-case speedups reference time / variant time.
+            double speedup_ci_lower                         = 0;        ///< Lower bound of the 95% confidence interval of speedup.
+            double speedup_ci_upper                         = 0;        ///< Upper bound of the 95% confidence interval of speedup.
+            std::vector<ErrorCaseType> error_cases;                     ///< The max_error_cases first error cases, in order of their case indices.
+
+            /// Indicates whether the variant returned the reference result in every conducted test.
+            bool is_all_tests_passed() const { return n_tests == n_passed_tests; }
+        };
+
+        /// The return type of the MultiVariantFunctionTest::test() function.
+        struct TestReturnType {
+            unsigned int n_tests                            = 0;        ///< Number of conducted cases. Every variant is tested once per case.
+            timing::running_stats reference_invocation_duration_ns_stats;      ///< Running statistics of the reference function invocation durations in ns.
+            timing::log_histogram reference_invocation_duration_ns_histogram;  ///< Histogram of the samples of reference_invocation_duration_ns_stats.
+            std::vector<VariantReturnType> variants;                    ///< The outcomes of the variants, in the order in which they were added.
+            std::vector<std::size_t> ranking;                           ///< The indices into variants, best first: correct variants before incorrect ones,
+                                                                        ///< then by their mean invocation duration.
+            bool is_aborted                                 = false;    ///< Whether an exception of the argument creator or the reference function stopped the test series.
+            std::string exception_description;                          ///< The description of that exception, if is_aborted.
+
+            /// Indicates whether every variant passed every test and the series was not aborted.
+            bool is_all_tests_passed() const {
+                return !is_aborted && std::all_of(variants.begin(), variants.end(), [](const VariantReturnType& v) { return v.is_all_tests_passed(); });
+            }
+        };
+
+    private: // vars
+
+        FunctionType reference_fun_;                            ///< The (correct) reference function.
+        ArgsCreatorFunctionType args_creator_;                  ///< Creates and returns a tuple of valid function arguments.
+        ComparatorFunctionType comp_;                           ///< The result comparison function. Shall return true when two results are equal.
+        ArgsToStringFunctionType args_to_string_function_;      ///< Converts a given function arguments to a string.
+        ResultToStringFunctionType result_to_string_function_;  ///< Converts a given function invocation result to a string.
+        std::vector<std::string> variant_names_;                ///< The names of the variants.
+        std::vector<FunctionType> variant_funs_;                ///< The variants.
+        std::shared_ptr<reporter> reporter_;                    ///< The output.
+        std::shared_ptr<run_record::recorder> recorder_;        ///< Receives a record of every variant of every test series, or nullptr.
+
+    public: // vars
+
+        verbosity verbosity_level = verbosity::NORMAL;          ///< Defines the verbosity of the stream out amount.
+        unsigned int output_line_length = 50;                   ///< The max number of dots that is shown in the printed lines.
+        timing::clock clock = timing::clock::STEADY;            ///< The clock to measure with.
+        unsigned int max_error_cases = 10;                      ///< The number of error cases that test() keeps per variant.
+        unsigned int n_threads = 1;                             ///< The number of worker threads of test(). 0 means one per hardware thread.
+                                                                ///< Values other than 1 require thread-safe functions and argument creators.
+
+    public: // constructors
+
+        /** Constructor for the multi-variant function tester.
+        @param reference_function The (correct) reference function.
+        @param argument_creator A function of type ArgsTupleType(unsigned int) that creates the arguments
+        of the test case with the given index.
+        @param comparator A comparison function that compares the results of the variants
+        with the results of the reference function.
+        @param args_to_string_function The to-string function for the argument tuples.
+        @param result_to_string_function The to-string function for the results.
+        @param os An ostream to which the output is streamed.
+        */
+        MultiVariantFunctionTest(
+            FunctionType reference_function,
+            ArgsCreatorFunctionType argument_creator,
+            ComparatorFunctionType comparator = default_functions::equal_to(),
+            ArgsToStringFunctionType args_to_string_function = default_functions::tuple_to_string(),
+            ResultToStringFunctionType result_to_string_function = default_functions::stream_to_string(),
+            std::ostream& os = std::cout)
+            :
+            reference_fun_(std::move(reference_function)),
+            args_creator_(std::move(argument_creator)),
+            comp_(std::move(comparator)),
+            args_to_string_function_(std::move(args_to_string_function)),
+            result_to_string_function_(std::move(result_to_string_function)),
+            reporter_(std::make_shared<ostream_reporter>(os))
+        {}
+
+    public: // methods
+
+        /** Adds a variant of the function that test() compares to the reference function.
+        @param name The name of the variant in the output and in the records.
+        @param function The variant.
+        @return This tester.
+        */
+        MultiVariantFunctionTest& add_variant(const std::string& name, FunctionType function) {
+            variant_names_.push_back(name);
+            variant_funs_.push_back(std::move(function));
+            return *this;
+        }
+
+
+        /** Conducts a randomized test series on all variants. For every test case, creates the arguments once,
+        invokes the reference function once and then invokes every variant on the same arguments and compares
+        its result to the reference result. Every invocation is timed on its own.
+        An exception of a variant fails its test, an exception of the argument creator or of the reference
+        function stops the test series. Writes a table of the variants in the order of their ranks and,
+        at verbosity VERBOSE, their error cases.
+        @param test_name A human-readable alias of the test that will be written into the stream.
+        @param n_tests The number of test cases to be conducted.
+        @return A MultiVariantFunctionTest::TestReturnType object with the outcome and the ranking of every variant.
+        */
+        TestReturnType test(const std::string& test_name, const unsigned int n_tests) {
+            if (verbosity_level >= verbosity::NORMAL) {
+                log(verbosity::NORMAL, [test_name, n_chars = output_line_length](std::ostream& os) {
+                    std::string output = "MultiVariantFunctionTest: " + test_name + ": ";
+                    output.resize(std::max<std::size_t>(output.size(), n_chars), '.');
+                    os << output << " ";
+                });
+            }
+
+            const std::size_t n_variants = variant_funs_.size();
+            const auto n_workers = work_stealing::resolve_n_workers(n_threads);
+            std::vector<TestReturnType> partials(n_workers);
+            for (auto& p : partials) {
+                p.variants.resize(n_variants);
+            }
+            std::atomic<bool> is_aborted(false);
+
+            const std::size_t chunk_size = std::min<std::size_t>(std::max<std::size_t>(n_tests / (16 * n_workers), 1), 4096);
+            work_stealing::parallel_for(n_tests, n_workers, chunk_size, [&](const unsigned int worker, const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end && !is_aborted.load(std::memory_order_relaxed); ++i) {
+                    if (!run_case(static_cast<unsigned int>(i), partials[worker])) {
+                        is_aborted.store(true, std::memory_order_relaxed);
+                    }
+                }
+            });
+
+            TestReturnType ret = merge(std::move(partials));
+            rank(ret);
+
+            log(verbosity::NORMAL, [this, &ret](std::ostream& os) { write_table(os, ret); });
+            if (verbosity_level >= verbosity::VERBOSE) {
+                log(verbosity::VERBOSE, [this, &ret](std::ostream& os) { write_error_cases(os, ret); });
+            }
+            reporter_->flush();
+
+            if (recorder_) {
+                for (auto& record : run_record::from_multi_variant_function_test(test_name, ret)) {
+                    recorder_->add(std::move(record));
+                }
+            }
+            return ret;
+        }
+
+
+        /** Replaces the output stream of the constructor with the given reporter.
+        @param r The reporter.
+        */
+        void set_reporter(std::shared_ptr<reporter> r) {
+            reporter_ = std::move(r);
+        }
+
+
+        /** Sets a recorder to which test() adds a record of every variant of every test series, see run_record.
+        @param r The recorder, or nullptr to stop recording.
+        */
+        void set_recorder(std::shared_ptr<run_record::recorder> r) {
+            recorder_ = std::move(r);
+        }
+
+    public: // getters
+
+        /// Returns the number of variants.
+        inline std::size_t n_variants() const { return variant_funs_.size(); }
+
+    protected: // helpers
+
+        /** Reports a message if the given verbosity level is equal or smaller than the verbosity_level member value.
+        @param message_verbosity_level The verbosity level of the message.
+        @param format A function void(std::ostream&) that formats the message.
+        */
+        template <typename F>
+        void log(const verbosity message_verbosity_level, F&& format) const {
+            if (verbosity_level >= message_verbosity_level) {
+                reporter_->report(deferred_message(std::forward<F>(format)));
+            }
+        }
+
+
+        /** Conducts a single test case on all variants and accumulates its outcome.
+        The variants are invoked in an order that starts with the variant i modulo the number of variants.
+        @param i The index of the test case.
+        @param[in,out] ret The outcome of the test cases of the calling thread.
+        @return False if the argument creator or the reference function threw an exception, true otherwise.
+        */
+        bool run_case(const unsigned int i, TestReturnType& ret) const {
+            ArgsTupleType arg_tuple;
+            ResultType reference_result;
+            double reference_ns = 0;
+            try {
+                arg_tuple = args_creator_(i);
+                const timing::stopwatch watch(clock);
+                reference_result = tuple_call::call(reference_fun_, arg_tuple);
+                reference_ns = watch.elapsed_ns();
+            }
+            catch (std::exception& ex) {
+                ret.exception_description = "EXCEPTION\n" + std::string(typeid(ex).name()) + ":\n" + ex.what() + "\nCase index: " + std::to_string(i) + "\n";
+                ret.is_aborted = true;
+                return false;
+            }
+            catch (...) {
+                ret.exception_description = "EXCEPTION\nunknown\nCase index: " + std::to_string(i) + "\n";
+                ret.is_aborted = true;
+                return false;
+            }
+            ret.reference_invocation_duration_ns_stats.add(reference_ns);
+            ret.reference_invocation_duration_ns_histogram.add(reference_ns);
+            ++ret.n_tests;
+
+            const std::size_t n_variants = variant_funs_.size();
+            for (std::size_t k = 0; k < n_variants; ++k) {
+                const std::size_t v = (i + k) % n_variants;
+                VariantReturnType& variant = ret.variants[v];
+                ++variant.n_tests;
+
+                ErrorCaseType error_case;
+                try {
+                    const timing::stopwatch watch(clock);
+                    error_case.erroneous_result = tuple_call::call(variant_funs_[v], arg_tuple);
+                    const double ns = watch.elapsed_ns();
+
+                    variant.invocation_duration_ns_stats.add(ns);
+                    variant.invocation_duration_ns_histogram.add(ns);
+                    variant.log_speedup_stats.add(std::log(std::max(reference_ns, 1.0) / std::max(ns, 1.0)));
+                    if (comp_(error_case.erroneous_result, reference_result)) {
+                        ++variant.n_passed_tests;
+                        continue;
+                    }
+                }
+                catch (std::exception& ex) {
+                    error_case.exception = std::string(typeid(ex).name()) + ": " + ex.what();
+                }
+                catch (...) {
+                    error_case.exception = "unknown";
+                }
+
+                // failure case, a thread steals chunks out of order, so it keeps the error cases with the smallest case indices
+                auto& ecs = variant.error_cases;
+                auto slot = ecs.end();
+                if (ecs.size() >= max_error_cases) {
+                    slot = std::max_element(ecs.begin(), ecs.end(), [](const ErrorCaseType& a, const ErrorCaseType& b) { return a.case_index < b.case_index; });
+                    if (slot == ecs.end() || slot->case_index < i) {
+                        continue;
+                    }
+                }
+                error_case.case_index = i;
+                error_case.reference_result = reference_result;
+                error_case.args = arg_tuple;
+                if (slot == ecs.end()) {
+                    ecs.push_back(std::move(error_case));
+                }
+                else {
+                    *slot = std::move(error_case);
+                }
+            }
+            return true;
+        }
+
+
+        /** Merges the outcomes of the threads and computes the speedups.
+        Keeps the max_error_cases first error cases of every variant and the exception with the smallest case index.
+        */
+        TestReturnType merge(std::vector<TestReturnType>&& partials) const {
+            TestReturnType ret;
+            ret.variants.resize(variant_funs_.size());
+            for (std::size_t v = 0; v < ret.variants.size(); ++v) {
+                ret.variants[v].name = variant_names_[v];
+            }
+
+            for (auto& p : partials) {
+                ret.n_tests += p.n_tests;
+                ret.reference_invocation_duration_ns_stats.merge(p.reference_invocation_duration_ns_stats);
+                ret.reference_invocation_duration_ns_histogram.merge(p.reference_invocation_duration_ns_histogram);
+                if (p.is_aborted && !ret.is_aborted) {
+                    ret.is_aborted = true;
+                    ret.exception_description = std::move(p.exception_description);
+                }
+                for (std::size_t v = 0; v < ret.variants.size(); ++v) {
+                    auto& into = ret.variants[v];
+                    auto& from = p.variants[v];
+                    into.n_tests += from.n_tests;
+                    into.n_passed_tests += from.n_passed_tests;
+                    into.invocation_duration_ns_stats.merge(from.invocation_duration_ns_stats);
+                    into.invocation_duration_ns_histogram.merge(from.invocation_duration_ns_histogram);
+                    into.log_speedup_stats.merge(from.log_speedup_stats);
+                    std::move(from.error_cases.begin(), from.error_cases.end(), std::back_inserter(into.error_cases));
+                }
+            }
+
+            const double z_95 = 1.959964;
+            for (auto& variant : ret.variants) {
+                auto& ecs = variant.error_cases;
+                std::sort(ecs.begin(), ecs.end(), [](const ErrorCaseType& a, const ErrorCaseType& b) { return a.case_index < b.case_index; });
+                if (ecs.size() > max_error_cases) {
+                    ecs.erase(ecs.begin() + max_error_cases, ecs.end());
+                }
+
+                const auto& st = variant.log_speedup_stats;
+                if (st.n > 0) {
+                    variant.speedup = std::exp(st.mean);
+                    variant.speedup_ci_lower = std::exp(st.mean - z_95 * st.standard_error());
+                    variant.speedup_ci_upper = std::exp(st.mean + z_95 * st.standard_error());
+                }
+            }
+            return ret;
+        }
+
+
+        /// Ranks the variants: correct variants before incorrect ones, then by their mean invocation duration.
+        static void rank(TestReturnType& ret) {
+            ret.ranking.resize(ret.variants.size());
+            for (std::size_t v = 0; v < ret.ranking.size(); ++v) {
+                ret.ranking[v] = v;
+            }
+            std::stable_sort(ret.ranking.begin(), ret.ranking.end(), [&ret](const std::size_t a, const std::size_t b) {
+                const auto& va = ret.variants[a];
+                const auto& vb = ret.variants[b];
+                if (va.is_all_tests_passed() != vb.is_all_tests_passed()) {
+                    return va.is_all_tests_passed();
+                }
+                return va.invocation_duration_ns_stats.mean < vb.invocation_duration_ns_stats.mean;
+            });
+            for (std::size_t r = 0; r < ret.ranking.size(); ++r) {
+                ret.variants[ret.ranking[r]].rank = static_cast<unsigned int>(r + 1);
+            }
+        }
+
+
+        /// Writes the table of the variants in the order of their ranks.
+        static void write_table(std::ostream& os, const TestReturnType& ret) {
+            std::stringstream ss;
+            ss << ret.n_tests << " cases, " << ret.variants.size() << " variants\n";
+            if (ret.is_aborted) {
+                ss << ret.exception_description;
+            }
+            ss << std::left <<
+                " " << std::setw(6) << "RANK" << std::setw(22) << "VARIANT" << std::setw(22) << "STATUS" << std::right << std::setw(10) << "MEAN ns" << "  SPEEDUP\n";
+            ss << std::fixed << std::setprecision(2);
+            for (const std::size_t v : ret.ranking) {
+                const auto& variant = ret.variants[v];
+                const std::string status = (variant.is_all_tests_passed() ? "OK (" : "FAILED (") +
+                    std::to_string(variant.n_passed_tests) + "/" + std::to_string(variant.n_tests) + ")";
+                ss << std::right << std::setw(5) << variant.rank << "  " << std::left << std::setw(22) << variant.name << std::setw(22) << status <<
+                    std::right << std::setw(10) << variant.invocation_duration_ns_stats.mean << "  " <<
+                    variant.speedup << "x (" << variant.speedup_ci_lower << "x - " << variant.speedup_ci_upper << "x)\n";
+            }
+            ss << "       " << std::left << std::setw(44) << "reference" << std::right << std::setw(10) << ret.reference_invocation_duration_ns_stats.mean << "\n";
+            os << ss.str();
+        }
+
+
+        /// Writes the error cases of every variant in the order of their ranks.
+        void write_error_cases(std::ostream& os, const TestReturnType& ret) const {
+            for (const std::size_t v : ret.ranking) {
+                const auto& variant = ret.variants[v];
+                unsigned int i = 0;
+                for (const auto& ec : variant.error_cases) {
+                    os << " ERROR CASE " << i++ << " OF " << variant.name << " (case index " << ec.case_index << "):\n";
+                    if (!ec.exception.empty()) {
+                        os << "   exception:           " << ec.exception << "\n";
+                    }
+                    else {
+                        os << "   wrong result:        " << result_to_string_function_(ec.erroneous_result) << "\n";
+                        const auto mismatch = default_functions::describe_mismatch(comp_, ec.erroneous_result, ec.reference_result);
+                        if (!mismatch.empty()) {
+                            os << "   mismatch:            " << mismatch << "\n";
+                        }
+                    }
+                    os <<
+                        "   reference result:    " << result_to_string_function_(ec.reference_result) << "\n"
+                        "   args:                " << args_to_string_function_(ec.args) << "\n"
+                        " .\n";
+                }
+            }
+        }
+
+    }; // END class MultiVariantFunctionTest
+
+} // END namespace unittest
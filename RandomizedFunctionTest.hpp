@@ -17,14 +17,20 @@ string reference_fun(float f, int i);   // reference function
 
 // ...
 
-// argument tuple creation function - aways takes an unsigned int as argument
-auto arg_creator = 
-    [](unsigned int i) { return tuple<float, int>(rand() % 10 *0.1f, rand() % 100); };
+// argument tuple creation function - aways takes the case index as argument
+auto arg_creator = random_args::make_args_creator(42, [](random_args::case_generator& gen) {
+    return tuple<float, int>(gen.uniform_int(0, 9) * 0.1f, gen.uniform_int(0, 99)); });
 
 RandomizedFunctionTest<string, float, int> tester(fun, reference_fun, arg_creator);
 
 auto test_result = tester.test("Test Run 1", 10000);
 
+// every error case can be re-created on its own
+for (const auto& ec : test_result.error_cases) {
+    auto args = tester.create_args(ec.case_index);
+    // ...
+}
+
 // ...
 
 ###################################################################################################
@@ -52,7 +58,7 @@ result_t reference_fun(float f, int* i) {
 
 // ...
 
-auto arg_creator        = [](unsigned int i) { return arg_tuple_t(rand() % 10 * 0.1f, new int(rand() % 10)); };
+auto arg_creator        = [](unsigned int i) { random_args::case_generator gen(42, i); return arg_tuple_t(gen.uniform_int(0, 9) * 0.1f, new int(gen.uniform_int(0, 9))); };
 auto result_comparator  = [](const result_t& a, const result_t& b) { return get<0>(a) == get<0>(b) && *get<1>(a) == *get<1>(b); };
 auto args_to_string     = []( const arg_tuple_t& t) { stringstream s; s << "(" << get<0>(t) << ", " << *get<1>(t) << ")"; return s.str(); };
 auto result_to_string   = []( const result_t& r){ stringstream s; s << "(" << get<0>(r) << ", " << *get<1>(r) << ", " << ")"; return s.str(); };
@@ -71,26 +77,93 @@ RandomizedFunctionTest<result_t, float, int*> tester(
 
 // ...
 
+###################################################################################################
+/*
+/*
+/* With use_arena, the memory comes from an arena that is reset after every case
+/* and that keeps the memory of failed cases alive. No deleters are needed:
+###################################################################################################
+
+result_t fun(float f, int* i) {
+    return result_t(*i, arena::current()->create<int>(2 * (*i) + f));
+}
+
+// reference_fun alike
+
+auto arg_creator = [](unsigned int i) {
+    random_args::case_generator gen(42, i);
+    return arg_tuple_t(gen.uniform_int(0, 9) * 0.1f, arena::current()->create<int>(gen.uniform_int(0, 9))); };
+
+RandomizedFunctionTest<result_t, float, int*> tester(fun, reference_fun, arg_creator, result_comparator, args_to_string, result_to_string);
+tester.use_arena = true;
+
+auto test_result = tester.test("Test Run 3", 10000);   // test_result.error_cases stay valid while test_result lives
+
 ###################################################################################################
 /*
 /* To test a method on an object, I'm afraid you have to wrap the method call into a lambda.
 /*
 /*
+/* To let the compiler inline the callables, have all types deduced:
+###################################################################################################
+
+auto tester = create_randomized_function_test(
+    [](float f, int i) { return fun(f, i); },
+    [](float f, int i) { return reference_fun(f, i); },
+    arg_creator);
+
+auto test_result = tester.test("Test Run 2", 10000);
+
+###################################################################################################
+/*
+/*
 /* @author langenhagen
 /* @version 160218
 /*****************************************************************************/
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
 #include <exception>
+#include <fstream>
 #include <functional>
+#include <iomanip>
+#include <iterator>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "alloc_tracker.hpp"
+#include "arena.hpp"
+#include "complexity.hpp"
+#include "corpus.hpp"
+#include "default_functions.hpp"
+#include "error_case_policy.hpp"
+#include "perf_counters.hpp"
+#include "process_isolation.hpp"
+#include "random_args.hpp"
+#include "reference_cache.hpp"
+#include "reporter.hpp"
+#include "run_record.hpp"
+#include "timing.hpp"
+#include "tolerance.hpp"
+#include "tuple_call.hpp"
+#include "tuple_to_stream.hpp"
 #include "verbosity.hpp"
+#include "watchdog.hpp"
+#include "work_stealing.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
 // NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
@@ -98,28 +171,52 @@ RandomizedFunctionTest<result_t, float, int*> tester(
 
 namespace unittest {
 
-    /** RandomizedFunctionTest unit testing class wich is capable of invoking
+    /** BasicRandomizedFunctionTest unit testing class wich is capable of invoking
     arbitrary functions with a return value and comparing them to results of reference functions.
     Measures the run-time of the function and writes unit test results to a stream.
-    For proper functioning, this class relies on copy assignment 
-    of the result types and the argument types.
+    For proper functioning, this class relies on default construction and move assignment
+    of the result types and the argument types. The results and the arguments of failed cases are
+    moved into their error cases. Only cached reference results and arguments from a corpus are copied,
+    so that move-only results like std::unique_ptr can be tested without a reference cache.
+    The callables are stored by value with their own types, so that calls to them can be inlined.
+    RandomizedFunctionTest is the variant that stores std::function objects instead.
+    create_randomized_function_test() deduces all template arguments.
+    @tparam Function Type of the function.
+    @tparam ReferenceFunction Type of the reference function.
+    @tparam ArgsCreator Type of the argument creator.
+    @tparam Comparator Type of the result comparison function.
+    @tparam ArgsToString Type of the to-string function for argument tuples.
+    @tparam ResultToString Type of the to-string function for results.
+    @tparam ArgsDeleter Type of the deleter for argument tuples.
+    @tparam ResultDeleter Type of the deleter for results.
     @tparam ResultType Return type of the given function.
     @tparam ArgTypes Argument types of the given function.
     */
-    template< typename ResultType, typename... ArgTypes>
-    class RandomizedFunctionTest {
+    template<
+        typename Function,
+        typename ReferenceFunction,
+        typename ArgsCreator,
+        typename Comparator,
+        typename ArgsToString,
+        typename ResultToString,
+        typename ArgsDeleter,
+        typename ResultDeleter,
+        typename ResultType,
+        typename... ArgTypes>
+    class BasicRandomizedFunctionTest {
 
     public: // types
 
         using ArgsTupleType                 = std::tuple<ArgTypes...>;
-        using DurationType                  = std::chrono::microseconds;
-        using FunctionType                  = const std::function<ResultType(ArgTypes...)>;
-        using ComparatorFunctionType        = const std::function<bool(const ResultType&, const ResultType&)>;
-        using ArgsCreatorFunctionType       = const std::function<ArgsTupleType(const unsigned int)>;
-        using ArgsDeleterFunctionType       = const std::function<void(const ArgsTupleType&)>;
-        using ResultDeleterFunctionType     = const std::function<void(const ResultType&)>;
-        using ArgsToStringFunctionType      = const std::function<std::string(const ArgsTupleType&)>;
-        using ResultToStringFunctionType    = const std::function<std::string(const ResultType&)>;
+        using DurationType                  = std::chrono::nanoseconds;
+        using FunctionType                  = Function;
+        using ReferenceFunctionType         = ReferenceFunction;
+        using ComparatorFunctionType        = Comparator;
+        using ArgsCreatorFunctionType       = ArgsCreator;
+        using ArgsDeleterFunctionType       = ArgsDeleter;
+        using ResultDeleterFunctionType     = ResultDeleter;
+        using ArgsToStringFunctionType      = ArgsToString;
+        using ResultToStringFunctionType    = ResultToString;
 
     public: // inner classes
 
@@ -128,46 +225,153 @@ namespace unittest {
             ResultType erroneous_result;    ///< The errorneous function return value.
             ResultType reference_result;    ///< The supposedly correct return value of the reference function.
             ArgsTupleType args;             ///< The corresponding function invocation arguments.
+            unsigned int case_index = 0;    ///< The index of the test case, i.e. the value that was passed to the argument creator.
+        };
+
+        /// Stores information on a test case that crashed the worker process that conducted it, see is_isolated.
+        struct CrashedCaseType {
+            unsigned int case_index = 0;    ///< The index of the test case.
+            int signal = 0;                 ///< The signal that ended the worker process, 0 if it ended otherwise.
+            std::string args;               ///< The arguments of the test case, as converted by the args-to-string function.
+        };
+
+        /// Stores information on a test case that ran past case_timeout.
+        struct TimedOutCaseType {
+            unsigned int case_index = 0;                ///< The index of the test case.
+            DurationType duration = DurationType(0);    ///< The duration of the invocations, or the deadline after which the worker process was ended.
+            std::string args;                           ///< The arguments of the test case, as converted by the args-to-string function.
         };
 
         /// The return type of the RandomizedFunctionTest::test() function.
         struct TestReturnType {
-            unsigned int n_tests                            = 0;                ///< Number of tests.
-            unsigned int n_passed_tests                     = 0;                ///< Number of  passed tests.
-            DurationType average_invocation_duration        = DurationType(0);  ///< Average function invocation time.
-            DurationType accumulated_invocation_durations   = DurationType(0);  ///< Accumulated function invocation time.
-            std::vector<ErrorCaseType> error_cases;                             ///< Vector of error.
+            unsigned int n_tests                                        = 0;                ///< Number of tests.
+            unsigned int n_passed_tests                                 = 0;                ///< Number of  passed tests.
+            DurationType average_invocation_duration                    = DurationType(0);  ///< Average function invocation time.
+            DurationType accumulated_invocation_durations               = DurationType(0);  ///< Accumulated function invocation time.
+            DurationType reference_average_invocation_duration          = DurationType(0);  ///< Average reference function invocation time.
+            DurationType reference_accumulated_invocation_durations     = DurationType(0);  ///< Accumulated reference function invocation time.
+            double speedup                                              = 0;                ///< Geometric mean of the per-case speedups reference time / function time.
+                                                                                            ///< Every case weighs alike, so it can exceed 1 while the function is slower in total.
+            double speedup_ci_lower                                     = 0;                ///< Lower bound of the 95% confidence interval of speedup.
+            double speedup_ci_upper                                     = 0;                ///< Upper bound of the 95% confidence interval of speedup.
+            double total_speedup                                        = 0;                ///< Ratio of the accumulated durations reference time / function time.
+            bool is_speedup_sufficient                                  = true;             ///< False if a required speedup was set and not reached.
+            perf_counters::counts average_counters;                                         ///< Hardware counts per function invocation if measure_hardware_counters is set. NaN for unavailable counters.
+            perf_counters::counts accumulated_counters;                                     ///< Accumulated hardware counts of the function invocations.
+            perf_counters::counts reference_average_counters;                               ///< Hardware counts per reference function invocation if measure_hardware_counters is set.
+            perf_counters::counts reference_accumulated_counters;                           ///< Accumulated hardware counts of the reference function invocations.
+            alloc_tracker::counts allocations;                                              ///< Heap allocations of all function invocations if measure_allocations is set.
+            alloc_tracker::counts reference_allocations;                                    ///< Heap allocations of all reference function invocations if measure_allocations is set.
+            bool is_allocation_within_reference                         = true;             ///< False if is_allocation_parity_required is set and the function
+                                                                                            ///< allocated more often or more bytes than the reference function.
+            timing::running_stats log_speedup_stats;                                        ///< Running statistics of the natural logarithms of the per-case speedups.
+            timing::running_stats invocation_duration_ns_stats;                             ///< Running statistics of the function invocation durations in ns, one sample per case,
+                                                                                            ///< or one per batch with the average duration of its invocations if batch_size > 1.
+            timing::running_stats reference_invocation_duration_ns_stats;                   ///< Running statistics of the reference function invocation durations in ns.
+            timing::log_histogram invocation_duration_ns_histogram;                         ///< Histogram of the samples of invocation_duration_ns_stats.
+            timing::log_histogram reference_invocation_duration_ns_histogram;               ///< Histogram of the samples of reference_invocation_duration_ns_stats.
+            std::vector<float> speedup_ratios;                                              ///< Per-case speedups, or per-batch speedups if batch_size > 1, in case order. Only filled if record_speedup_ratios is set.
+            std::vector<ErrorCaseType> error_cases;                                         ///< The error cases which error_policy keeps, in order of their case indices.
+                                                                                            ///< The number of all failed tests is n_tests - n_passed_tests.
+            std::vector<std::shared_ptr<arena>> arenas;                                     ///< The arenas that hold the memory of the error cases if use_arena is set.
+            bool is_aborted                                             = false;            ///< Whether an exception stopped the test series before all tests were conducted.
+            unsigned int n_cached_reference_results                     = 0;                ///< Number of reference results that were read from the reference cache.
+            std::vector<CrashedCaseType> crashed_cases;                                     ///< The cases that crashed their worker process if is_isolated is set, in order of their case indices.
+                                                                                            ///< Counted as failed tests.
+            std::vector<TimedOutCaseType> timed_out_cases;                                  ///< The cases that ran past case_timeout, in order of their case indices. Counted as failed tests.
+            bool is_budget_exhausted                                    = false;            ///< Whether series_budget ended the test series before all tests were conducted.
 
             /// Indicates, wether or not each conducted test was correct or not.
-            bool is_all_tests_passed() { return n_tests == n_passed_tests; }
+            bool is_all_tests_passed() const { return n_tests == n_passed_tests; }
         };
 
-    private: // inner classes
+        /// The return type of the RandomizedFunctionTest::test_scaling() function.
+        struct ScalingReturnType {
+            std::vector<unsigned int> sizes;                                ///< The problem sizes, i.e. the values that were passed to the argument creator.
+            std::vector<double> invocation_duration_ns;                     ///< The median function invocation duration at each size.
+            std::vector<double> reference_invocation_duration_ns;           ///< The median reference function invocation duration at each size.
+            std::vector<unsigned int> failed_sizes;                         ///< The sizes at which the result differs from the reference result.
+            complexity::fit_result complexity;                              ///< The best fit of the function invocation durations.
+            complexity::fit_result reference_complexity;                    ///< The best fit of the reference function invocation durations.
+            bool is_complexity_within_reference                 = true;     ///< False if the function grows faster than the reference function, see complexity_tolerance.
+            bool is_aborted                                     = false;    ///< Whether an exception stopped the scaling series before all sizes were conducted.
+
+            /// Indicates whether the results are correct at all sizes and the function grows no faster than the reference function.
+            bool is_all_tests_passed() const { return failed_sizes.empty() && !is_aborted && is_complexity_within_reference; }
+        };
+
+        /// The outcome of one thread count of a stress series, see test_stress().
+        struct StressLevelType {
+            unsigned int n_threads                              = 0;                ///< The number of threads that invoked the function at the same time.
+            unsigned int n_tests                                = 0;                ///< Number of tests, over all threads.
+            unsigned int n_passed_tests                         = 0;                ///< Number of passed tests, over all threads.
+            DurationType duration                               = DurationType(0);  ///< The wall-clock time from the start of the first thread to the end of the last one.
+            double throughput                                   = 0;                ///< Invocations per second, over all threads.
+            double efficiency                                   = 0;                ///< The throughput divided by n_threads times the throughput of a single thread.
+            std::vector<ErrorCaseType> error_cases;                                 ///< The max_error_cases first error cases, in order of their case indices.
+            bool is_aborted                                     = false;            ///< Whether an exception stopped a thread.
+            std::string exception_description;                                      ///< The description of the first such exception, if is_aborted.
+        };
 
-        /// Recursive implementation of the call structure which is used to unpack tuples into function parameters.
-        template <typename F, typename Tuple, bool Done, int Total, int... N>
-        struct call_impl {
+        /// The return type of the RandomizedFunctionTest::test_stress() function.
+        struct StressReturnType {
+            std::vector<StressLevelType> levels;                                    ///< The outcomes of the thread counts, in increasing order.
+            std::vector<std::shared_ptr<arena>> arenas;                             ///< The arenas that hold the memory of the error cases if use_arena is set.
+            bool is_efficiency_sufficient                       = true;             ///< False if the efficiency at the largest thread count is below required_parallel_efficiency.
 
-            /// Recursively calls the recursive call_impl::call function until The the last tuple element was unpacked.
-            constexpr static auto call(F f, Tuple&& t, DurationType& out_duration) {
-                return call_impl<F, Tuple, Total == 1 + sizeof...(N), Total, N..., sizeof...(N)>::call(f, std::forward<Tuple>(t), out_duration);
+            /// Indicates whether every result at every thread count was correct and the efficiency was sufficient.
+            bool is_all_tests_passed() const {
+                return is_efficiency_sufficient && std::all_of(levels.begin(), levels.end(), [](const StressLevelType& l) { return !l.is_aborted && l.n_tests == l.n_passed_tests; });
             }
         };
 
-        /// Final recursive implementation of the call structure.
-        template <typename F, typename Tuple, int Total, int... N>
-        struct call_impl<F, Tuple, true, Total, N...> {
+    private: // inner classes
+
+        /// The cases, results and outcome of a single thread of a stress series, see test_stress().
+        /// On cache lines of its own, so that the threads of the tester do not share any.
+        struct alignas(64) StressThreadType {
+            std::vector<ArgsTupleType> args;                        ///< The arguments of the cases of the thread.
+            std::vector<ResultType> reference_results;              ///< The results of the reference function.
+            std::vector<ResultType> results;                        ///< The results of the function.
+            std::chrono::steady_clock::time_point start;            ///< The time at which the thread began to invoke the function.
+            std::chrono::steady_clock::time_point end;              ///< The time at which the thread finished to invoke the function.
+            std::shared_ptr<arena> cases_arena;                     ///< The arena of the cases if use_arena is set.
+            StressLevelType outcome;                                ///< The outcome of the cases of the thread.
+        };
+
+        /// The outcome of a contiguous range of test cases [begin, end), as conducted by a single worker.
+        struct RangeResultType {
+            TestReturnType result;                  ///< Counters and error cases of the range.
+            unsigned int begin = 0;                 ///< The index of the first case of the range.
+            unsigned int end = 0;                   ///< One past the index of the last conducted case of the range.
+            bool is_aborted = false;                ///< Indicates whether the case at index end threw an exception.
+            std::string exception_description;      ///< The description of the exception, if is_aborted.
+        };
 
-            /// Final recursive call to the actual function with all arguments unpacked.
-            static auto call(F f, Tuple&& t, DurationType& out_duration) {
-                using namespace std::chrono;
+        /// The file to which error cases are written under error_case_policy::STREAM.
+        struct ErrorCaseFileType {
+            std::ofstream file;                     ///< The file.
+            std::mutex mutex;                       ///< Serializes the writes of the workers.
+        };
 
-                const auto clock_start = steady_clock::now();
-                auto ret = f(std::get<N>(std::forward<Tuple>(t))...);
-                out_duration = duration_cast<DurationType>(steady_clock::now() - clock_start);
+        /// The instruments with which the invocations on a thread are measured besides the clock.
+        struct InstrumentsType {
+            std::unique_ptr<perf_counters::counter_group> counters;    ///< The hardware counters of the thread, or nullptr unless measure_hardware_counters is set.
+            bool is_tracking_allocations = false;                      ///< Whether the allocations are counted, see measure_allocations.
+        };
 
-                return ret;
-            }
+        /// The measurements of an invocation, or of the invocations of a batch.
+        struct SampleType {
+            DurationType duration = DurationType(0);        ///< The invocation duration.
+            perf_counters::counts counts;                   ///< The hardware counts.
+            alloc_tracker::counts allocations;              ///< The heap allocations.
+        };
+
+        /// The buffers for a batch of test cases, see batch_size.
+        struct BatchType {
+            std::vector<ArgsTupleType> args;                ///< The argument tuples of the cases.
+            std::vector<ResultType> reference_results;      ///< The results of the reference function.
+            std::vector<ResultType> results;                ///< The results of the function.
         };
 
     public: // static vars
@@ -177,24 +381,70 @@ namespace unittest {
     private: // vars
 
         FunctionType fun_;                                      ///< The function.
-        FunctionType reference_fun_;                            ///< The (correct) reference function.
+        ReferenceFunctionType reference_fun_;                   ///< The (correct) reference function.
         ArgsCreatorFunctionType args_creator_;                  ///< Creates and returns a tuple of valid function arguments.
         ComparatorFunctionType comp_;                           ///< The result comparison function. Shall return true when two results are equal.
         ArgsToStringFunctionType args_to_string_function_;      ///< Converts a given function arguments to a string.
         ResultToStringFunctionType result_to_string_function_;  ///< Converts a given function invocation result to a string.
         ArgsDeleterFunctionType args_deleter_;                  ///< A custom deleter function in case some arguments must be manually destoryed.
         ResultDeleterFunctionType result_deleter_;              ///< A custom deleter function in case the function results must be manually destroyed.
-        std::ostream& os_;                                      ///< The output stream.
+        std::shared_ptr<reporter> reporter_;                    ///< The output.
+        std::shared_ptr<run_record::recorder> recorder_;        ///< Receives a record of every test series, or nullptr.
+        std::shared_ptr<reference_cache<ResultType>> reference_cache_;  ///< Provides and stores the reference results, or nullptr.
+        std::shared_ptr<const corpus<ArgsTupleType>> corpus_;  ///< Provides the arguments instead of the argument creator, or nullptr.
+        std::shared_ptr<ErrorCaseFileType> error_case_file_;    ///< The open error case file during test() under error_case_policy::STREAM.
+        const watchdog* watchdog_ = nullptr;                    ///< The watchdog of the running test() if it conducts the cases in-process, or nullptr.
+        std::vector<unsigned int>* isolation_error_indices_ = nullptr;  ///< In a worker process of is_isolated: receives the indices of the failed cases instead of error_cases.
 
     public: // vars
 
         verbosity verbosity_level = verbosity::NORMAL;          ///< Defines the verbosity of the stream out amount.
         unsigned int output_line_length = 50;                   ///< The max number of dots that is shown in the printed lines.
+        error_case_policy error_policy = error_case_policy::KEEP_ALL;  ///< Defines which error cases test() keeps in TestReturnType::error_cases.
+        unsigned int max_error_cases = 100;                     ///< The number of error cases that test() keeps unless error_policy is KEEP_ALL.
+                                                                ///< The deleters are called on the error cases that are not kept.
+        std::uint64_t reservoir_seed = 0;                       ///< The seed of the sample of error cases under error_case_policy::RESERVOIR.
+        std::string error_case_file_path = "error_cases.txt";   ///< The file to which test() writes every error case under error_case_policy::STREAM.
+        unsigned int n_threads = 1;                             ///< The number of worker threads of test(). 0 means one per hardware thread.
+                                                                ///< Values other than 1 require thread-safe functions, argument creators and deleters.
+        unsigned int batch_size = 1;                            ///< The number of cases that test() conducts as one batch, see run_batch(). 1 disables batching.
+                                                                ///< Batching amortizes the clock reads, but speedups are then per batch rather than per case.
+        bool record_speedup_ratios = false;                     ///< Whether test() keeps the speedup of every single case in TestReturnType::speedup_ratios.
+        bool is_speedup_required = false;                       ///< Whether test() fails if the function is not at least required_speedup_percent faster than the reference.
+        double required_speedup_percent = 0;                    ///< The speedup of the function over the reference function which is_speedup_required demands, in percent.
+                                                                ///< Both the lower bound of the confidence interval and total_speedup must reach it,
+                                                                ///< e.g. 10 requires speedup_ci_lower >= 1.1 and total_speedup >= 1.1.
+        bool measure_hardware_counters = false;                 ///< Whether test() reads hardware performance counters around every invocation, or batch, see perf_counters.
+                                                                ///< Costs a system call per read. If counters are not available, their counts are NaN.
+        bool measure_allocations = false;                       ///< Whether test() counts the heap allocations of every invocation, or batch, on the calling thread.
+                                                                ///< Requires the replacements of new and delete, see alloc_tracker.
+        bool is_allocation_parity_required = false;             ///< Whether test() fails if the function allocates more often or more bytes than the reference function.
+                                                                ///< Requires measure_allocations.
+        bool use_arena = false;                                 ///< Whether test() provides an arena via arena::current() to the argument creator and the functions.
+                                                                ///< The arena is reset after every case, or every batch, and the deleters are not called.
+                                                                ///< The memory of failed cases stays alive as long as TestReturnType::arenas.
+        std::size_t arena_block_size = 64 * 1024;               ///< The size of the blocks of memory which the arenas allocate if use_arena is set.
+        bool is_isolated = false;                               ///< Whether test() conducts the cases in worker processes, so that a crashing case fails instead of ending the program.
+                                                                ///< Spawns one worker process per thread, see n_threads, and reuses it until it crashes. POSIX only, ignored elsewhere.
+                                                                ///< Error cases are re-created in the calling process. Reference results computed by the workers are not cached.
+                                                                ///< While process_isolation::is_fork_safe() is false, e.g. in a test series that was not registered
+                                                                ///< as isolated, see registry.hpp, the cases are conducted in-process.
+        DurationType case_timeout = DurationType(0);            ///< The deadline of a test case, i.e. of its reference function and function invocations. 0 disables it.
+                                                                ///< A case that runs past it fails, see TestReturnType::timed_out_cases. A case that hangs is reported
+                                                                ///< by a watchdog thread, and, if is_isolated is set, its worker process is ended.
+        DurationType series_budget = DurationType(0);           ///< The time budget of test(). Once exhausted, no further cases are started. 0 disables it.
+        double required_parallel_efficiency = 0;                ///< The parallel efficiency at the largest thread count below which test_stress() fails, e.g. 0.8. 0 disables it.
+        double complexity_tolerance = 0.1;                      ///< How much worse, in normalized rms, the model of the reference function may fit the durations
+                                                                ///< of the function in test_scaling(), for a faster growing best fit of the function to count as noise.
+
+    public: // static vars
+
+        static const unsigned int max_n_tests = std::numeric_limits<unsigned int>::max();     ///< The number of tests of test_for(), i.e. no bound.
 
     public: // constructors
         
         /** Constructor for the randomized function tester.
-        Note that the logic of the class relies on proper copy-assignment
+        Note that the logic of the class relies on proper move-assignment
         of the ResultType values and the individual function invocation arguments.
         @param function A function that must return a value.
         The interface must comply with the template-parametrization
@@ -204,41 +454,38 @@ namespace unittest {
         with regard to the parameter list and the return type.
         The reference function should, given the same arguments,
         should produce the same output as the given function.
-        @param argument_creator A function of type RandomizedFunctionTest::ArgsTupleType(unsigned int)
+        @param argument_creator A function of type BasicRandomizedFunctionTest::ArgsTupleType(unsigned int)
         that produces a tuple of function invocation arguments for
         the given function and reference_function. The unsigned int parameter
-        can be used to control the argument creation process.
-        @param result_comparator A comparison function for the result types. Defaults to '='.
+        is the index of the test case and can be used to control the argument creation process.
+        An argument creator that depends on nothing but the case index makes every test case reproducible,
+        also when the test cases are conducted in parallel.
+        @param result_comparator A comparison function for the result types.
         @param args_to_string_function A to-string function for the argument-tuples.
-        Defaults to a standard tuple unpacking and stream-out-created
-        string for each tuple element. This may not work for arguments
-        for which no stream out operation << can be found.
         @param result_to_string_function A to-string function for the return values
         of function and reference_function.
-        Defaults to { std::stringstream ss; ss << result; ss.str(); }.
-        This may not work for return types for which no stream out operation << can be found.
         @param argument_deleter Custom deleter for argument tuples. Can be used to free
         memory which has been previously allocated in the given argument_creator,
         e.g. values that are instantiated with new.
         The deleter will be called on each argument tuple for which
-        a test has passed, but not on arguments on which the test failed.
-        Defaults to a null operation, i.e. { return; }.
+        a test has passed, but not on arguments on which the test failed,
+        unless error_policy does not keep the error case. Not called if use_arena is set.
         @param result_deleter Custom deleter for the given function and reference_function return values
         Can be used to free memory wich has been previously allocated in the given function and reference_function,
         e.g. values that are instantiated with new. The deleter will be called on each result value
-        for which a test has passed, but not on return values on which the test failed.
-        Defaults to a null operation, i.e. { return; }.
+        for which a test has passed, but not on return values on which the test failed,
+        unless error_policy does not keep the error case. Not called if use_arena is set.
         @param os An ostream to which the output is streamed. Defaults to std::cout.
         */
-        RandomizedFunctionTest(
+        BasicRandomizedFunctionTest(
             FunctionType function,
-            FunctionType reference_function,
+            ReferenceFunctionType reference_function,
             ArgsCreatorFunctionType argument_creator,
-            ComparatorFunctionType result_comparator = [](const ResultType& a, const ResultType& b) { return a == b; },
-            ArgsToStringFunctionType args_to_string_function = [](const ArgsTupleType& t) { std::stringstream ss; tuple_to_stream::to_stream(ss, t); return ss.str(); },
-            ResultToStringFunctionType result_to_string_function = [](const ResultType& r) { std::stringstream ss; ss << r; return ss.str(); },
-            ArgsDeleterFunctionType argument_deleter = [](const ArgsTupleType&) {},
-            ResultDeleterFunctionType result_deleter = [](const ResultType&) {},
+            ComparatorFunctionType result_comparator,
+            ArgsToStringFunctionType args_to_string_function,
+            ResultToStringFunctionType result_to_string_function,
+            ArgsDeleterFunctionType argument_deleter,
+            ResultDeleterFunctionType result_deleter,
             std::ostream& os = std::cout)
             :
             fun_(function),
@@ -249,7 +496,7 @@ namespace unittest {
             result_to_string_function_(result_to_string_function),
             args_deleter_(argument_deleter),
             result_deleter_(result_deleter),
-            os_(os)
+            reporter_(std::make_shared<ostream_reporter>(os))
         {}
 
     public: // methods
@@ -261,109 +508,205 @@ namespace unittest {
         Also measures the time the function execution takes and writes the results of the test to a given output-stream.
         Checks also for exceptions and reports them to the output stream. If an exception occurs,
         the test series will be stopped.
+        If n_threads is not 1, the test cases are spread over several threads. Given an argument creator
+        that depends on nothing but the case index, the counters and error cases are the same as
+        the ones of a serial test series.
+        If is_isolated is set, the test cases are conducted in worker processes and a case that crashes
+        its worker counts as a failed test, see TestReturnType::crashed_cases.
+        If case_timeout or series_budget is set, a watchdog observes the cases. Once series_budget is exhausted,
+        the remaining cases are skipped and, if several workers were involved, the conducted cases need not be contiguous.
         In case of error the object's flag .verbose in conjunction with a valid result_to_string_function
         can be used to write more sophisticated output.
         @param test_name A human-readable alias of the test that will be written into the stream.
-        @param n_tests The number of tests to be conducted.
-        @return A RandomizedFunctionTest::TestReturnType object that provides general information about the tests and the error cases.
+        @param n_tests The number of tests to be conducted. At most the size of the corpus, if one is set.
+        @return A BasicRandomizedFunctionTest::TestReturnType object that provides general information about the tests and the error cases.
         */
         TestReturnType test(const std::string& test_name, const unsigned int n_tests) {
-            TestReturnType ret;
+            if (corpus_ && n_tests > corpus_->size()) {
+                return test(test_name, static_cast<unsigned int>(corpus_->size()));
+            }
 
-            std::string output = "RandomizedFunctionTest: " + test_name + ": ";
-            const auto dots_total = output_line_length - output.size();
-            const float dots_to_add_per_step = static_cast<float>(dots_total) / n_tests;
-            float dots_to_add_float = 0;
+            const std::size_t header_length = sizeof("RandomizedFunctionTest: ") - 1 + test_name.size() + sizeof(": ") - 1;
+            const std::size_t dots_total = header_length < output_line_length ? output_line_length - header_length : 0;
 
-            log(output, verbosity::NORMAL);
+            if (verbosity_level >= verbosity::NORMAL) {
+                log(verbosity::NORMAL, [test_name](std::ostream& os) { os << "RandomizedFunctionTest: " << test_name << ": "; });
+            }
 
-            for (unsigned int i = 0; i < n_tests; ++i) {
-                const auto arg_tuple = args_creator_(n_tests);
+            if (error_policy == error_case_policy::STREAM) {
+                error_case_file_ = std::make_shared<ErrorCaseFileType>();
+                error_case_file_->file.open(error_case_file_path, std::ios::out | std::ios::trunc);
+            }
 
-                dots_to_add_float += dots_to_add_per_step;
-                const unsigned int dots_to_add_int = static_cast<unsigned int>(dots_to_add_float);
-                log(std::string(dots_to_add_int, '.'), verbosity::NORMAL);
-                dots_to_add_float -= dots_to_add_int;
+            if (active_reference_cache()) {
+                reference_cache_->prepare(n_tests == max_n_tests ? reference_cache_->n_cases() : n_tests);
+            }
 
-                try {
-                    DurationType dur;
+            const auto n_workers = work_stealing::resolve_n_workers(n_threads);
+            const bool is_isolated_series = is_isolated && process_isolation::is_supported() && process_isolation::is_fork_safe() && n_tests > 0;
+            if (is_isolated && process_isolation::is_supported() && !process_isolation::is_fork_safe()) {
+                log(verbosity::NORMAL, [](std::ostream& os) { os << "(not isolated: series run concurrently, see registry.hpp) "; });
+            }
 
-                    const auto reference_result = call(reference_fun_, arg_tuple, dur);
-                    const auto result = call(fun_, arg_tuple, dur);
+            std::unique_ptr<watchdog> dog;
+            if (!is_isolated_series && (case_timeout.count() > 0 || series_budget.count() > 0)) {
+                dog.reset(new watchdog(n_workers, case_timeout, series_budget));
+                dog->start([this](const unsigned int, const unsigned int case_index) {
+                    // the case cannot be interrupted. Only its index is reported, since the argument creator must not run on the
+                    // watchdog thread; the arguments are described with the timed-out cases once the case has ended
+                    log(verbosity::NORMAL, [case_index](std::ostream& os) {
+                        os << "\n TIMEOUT: case index " << case_index << ", or its batch, runs past its deadline\n";
+                    });
+                }, nullptr);
+                watchdog_ = dog.get();
+            }
 
-                    if (comp_(result, reference_result)) {
-                        // correct case
-                        ++ret.n_passed_tests;
+            RangeResultType range = is_isolated_series
+                ? run_cases_isolated(n_tests, n_workers)
+                : n_workers > 1 && n_tests > 1
+                ? run_cases_parallel(n_tests, n_workers)
+                : run_cases_serial(n_tests, dots_total);
 
-                        result_deleter_(result);
-                        result_deleter_(reference_result);
-                    }
-                    else {
-                        // failure case
-                        ErrorCaseType error_case{ result, reference_result, arg_tuple };
-                        ret.error_cases.push_back(error_case);
-                    }
+            if (dog) {
+                dog->stop();
+                range.result.is_budget_exhausted = dog->is_budget_exhausted();
+                watchdog_ = nullptr;
+            }
+            error_case_file_.reset();
+            if (active_reference_cache()) {
+                reference_cache_->commit();
+            }
 
-                    ret.accumulated_invocation_durations += dur;
-                }
-                catch (std::exception& ex) {
-                    std::stringstream ss;
-                    ss <<
-                        "EXCEPTION\n" <<
-                        typeid(ex).name() << ":\n" <<
-                        ex.what() << "\n" <<
-                        "Arguments: " << args_to_string_function_(arg_tuple) << "\n";
-                    log(ss.str(), verbosity::NORMAL);
-                    break;
-                }
-                catch (...) {
-                    std::stringstream ss;
-                    ss <<
-                        "EXCEPTION\n" <<
-                        "unknown\n" <<
-                        "Arguments: " << args_to_string_function_(arg_tuple) << "\n";
-                    log(ss.str(), verbosity::NORMAL);
-                    break;
-                }
+            if (is_isolated_series || (n_workers > 1 && n_tests > 1)) {
+                log(verbosity::NORMAL, [n_dots = dots_total * range.end / n_tests](std::ostream& os) { os << std::string(n_dots, '.'); });
+            }
+            if (range.is_aborted) {
+                log(verbosity::NORMAL, [&range](std::ostream& os) { os << range.exception_description; });
+            }
 
-                ++ret.n_tests;
-                args_deleter_(arg_tuple);
+            TestReturnType& ret = range.result;
+            ret.is_aborted = range.is_aborted;
 
-            } // END for
+            if (error_policy == error_case_policy::RESERVOIR) {
+                std::sort(ret.error_cases.begin(), ret.error_cases.end(), [](const ErrorCaseType& a, const ErrorCaseType& b) { return a.case_index < b.case_index; });
+            }
 
-            if (n_tests > 0) {
-                assert(ret.n_tests > 0 && "RandomizedFunctionTest::test().n_test is supposed to be greater 0");
+            if (ret.n_tests > 0) {
                 ret.average_invocation_duration = ret.accumulated_invocation_durations / ret.n_tests;
+                ret.reference_average_invocation_duration = ret.reference_accumulated_invocation_durations / ret.n_tests;
+                ret.average_counters = ret.accumulated_counters / ret.n_tests;
+                ret.reference_average_counters = ret.reference_accumulated_counters / ret.n_tests;
             }
 
-            const auto avg_dur = ret.average_invocation_duration.count();
-            const auto acc_dur = ret.accumulated_invocation_durations.count();
-
-            std::stringstream ss;
-
-            if (n_tests == ret.n_tests && n_tests == ret.n_passed_tests) {
-                ss << " OK (";
+            if (ret.log_speedup_stats.n > 0) {
+                const double z_95 = 1.959964;
+                const auto& st = ret.log_speedup_stats;
+                ret.speedup = std::exp(st.mean);
+                ret.speedup_ci_lower = std::exp(st.mean - z_95 * st.standard_error());
+                ret.speedup_ci_upper = std::exp(st.mean + z_95 * st.standard_error());
+                ret.total_speedup =
+                    std::max<double>(ret.reference_accumulated_invocation_durations.count(), 1.0) / std::max<double>(ret.accumulated_invocation_durations.count(), 1.0);
             }
-            else {
-                ss << " FAILURE (";
+            if (is_speedup_required) {
+                const double required_speedup = 1 + required_speedup_percent / 100;
+                ret.is_speedup_sufficient = ret.log_speedup_stats.n > 0 && ret.speedup_ci_lower >= required_speedup && ret.total_speedup >= required_speedup;
+            }
+            if (is_allocation_parity_required) {
+                ret.is_allocation_within_reference = measure_allocations && alloc_tracker::is_installed() && ret.n_cached_reference_results == 0 &&
+                    ret.allocations.n_allocations <= ret.reference_allocations.n_allocations &&
+                    ret.allocations.n_bytes_allocated <= ret.reference_allocations.n_bytes_allocated;
             }
 
-            ss << ret.n_passed_tests << "/" << ret.n_tests << ") (" << avg_dur << " s avg, " << acc_dur << " s total)\n";
-            log(ss.str(), verbosity::NORMAL);
-
-            unsigned int i = 0;
-            for (const auto ec : ret.error_cases) {
-                ss.str("");
-                ss <<
-                    " ERROR CASE " << i++ << ":\n"
-                    "   wrong result:        " << result_to_string_function_(ec.erroneous_result) << "\n"
-                    "   reference result:    " << result_to_string_function_(ec.reference_result) << "\n"
-                    "   args:                " << args_to_string_function_(ec.args) << "\n"
-                    " .\n";
-                log(ss.str(), verbosity::VERBOSE);
+            if (recorder_) {
+                recorder_->add(run_record::from_randomized_function_test(test_name, ret, measure_hardware_counters));
             }
 
-            return ret;
+            // the messages refer to ret, which lives until the flush below
+            log(verbosity::NORMAL, [this, &ret, n_tests](std::ostream& os) {
+                const auto to_us = [](const DurationType d) { return d.count() / 1000.0; };
+
+                std::stringstream ss;
+                ss << std::fixed << std::setprecision(3);
+
+                if ((n_tests == ret.n_tests || ret.is_budget_exhausted) && ret.n_tests == ret.n_passed_tests && ret.is_speedup_sufficient && ret.is_allocation_within_reference) {
+                    ss << " OK (";
+                }
+                else {
+                    ss << " FAILURE (";
+                }
+
+                ss << ret.n_passed_tests << "/" << ret.n_tests << ") (" <<
+                    to_us(ret.average_invocation_duration) << " s avg, " << to_us(ret.accumulated_invocation_durations) << " s total)\n";
+
+                if (ret.n_tests > 0) {
+                    ss <<
+                        " SPEEDUP: " << ret.speedup << "x per-case geometric mean (95% CI " << ret.speedup_ci_lower << "x - " << ret.speedup_ci_upper << "x), " <<
+                        ret.total_speedup << "x in total over reference (" <<
+                        to_us(ret.reference_average_invocation_duration) << " s avg, " << to_us(ret.reference_accumulated_invocation_durations) << " s total)\n";
+                    if (!ret.is_speedup_sufficient) {
+                        ss << " SPEEDUP INSUFFICIENT: required " << 1 + required_speedup_percent / 100 << "x\n";
+                    }
+                    if (active_reference_cache()) {
+                        ss << " REFERENCE CACHE: " << ret.n_cached_reference_results << "/" << ret.n_tests << " reference results from cache\n";
+                    }
+                    if (measure_hardware_counters && ret.average_counters.is_available()) {
+                        ss <<
+                            " COUNTERS:  " << ret.average_counters << " per invocation\n" <<
+                            " REFERENCE: " << ret.reference_average_counters << " per invocation\n";
+                    }
+                    else if (measure_hardware_counters) {
+                        ss << " COUNTERS: not available\n";
+                    }
+                    if (measure_allocations && alloc_tracker::is_installed()) {
+                        const auto per_invocation = [&ss, n = static_cast<double>(ret.n_tests)](const alloc_tracker::counts& a) {
+                            ss << std::setprecision(2) <<
+                                a.n_allocations / n << " allocations, " << a.n_bytes_allocated / n << " bytes per invocation, " <<
+                                a.n_allocations << " allocations, " << a.n_bytes_allocated << " bytes total, peak " << a.peak_live_bytes << " live bytes";
+                        };
+                        ss << " ALLOCATIONS: ";
+                        per_invocation(ret.allocations);
+                        ss << "\n REFERENCE:   ";
+                        per_invocation(ret.reference_allocations);
+                        ss << "\n";
+                    }
+                    else if (measure_allocations) {
+                        ss << " ALLOCATIONS: not tracked, see alloc_tracker.hpp\n";
+                    }
+                }
+                if (!ret.is_allocation_within_reference && measure_allocations && alloc_tracker::is_installed() && ret.n_cached_reference_results == 0) {
+                    ss << " ALLOCATIONS EXCEED REFERENCE\n";
+                }
+                else if (!ret.is_allocation_within_reference) {
+                    ss << " ALLOCATIONS NOT VERIFIABLE: requires measure_allocations, alloc_tracker and no cached reference results\n";
+                }
+                for (const auto& cc : ret.crashed_cases) {
+                    ss << " CRASHED CASE (case index " << cc.case_index << "): " << process_isolation::signal_name(cc.signal) << ", args: " << cc.args << "\n";
+                }
+                for (const auto& tc : ret.timed_out_cases) {
+                    ss << " TIMED OUT CASE (case index " << tc.case_index << "): " << to_us(tc.duration) << " s, args: " << tc.args << "\n";
+                }
+                if (ret.is_budget_exhausted) {
+                    ss << " BUDGET EXHAUSTED: " << ret.n_tests << " tests within " << to_us(series_budget) / 1e6 << " s\n";
+                }
+                os << ss.str();
+            });
+
+            log(verbosity::VERBOSE, [this, &ret](std::ostream& os) {
+                unsigned int i = 0;
+                for (const auto& ec : ret.error_cases) {
+                    os <<
+                        " ERROR CASE " << i++ << " (case index " << ec.case_index << "):\n"
+                        "   wrong result:        " << result_to_string_function_(ec.erroneous_result) << "\n"
+                        "   reference result:    " << result_to_string_function_(ec.reference_result) << "\n";
+                    write_mismatch(os, ec);
+                    os <<
+                        "   args:                " << args_to_string_function_(ec.args) << "\n"
+                        " .\n";
+                }
+            });
+
+            reporter_->flush();
+            return std::move(ret);      // ret refers into range, hence it would be copied otherwise
         }
 
 
@@ -377,43 +720,1738 @@ namespace unittest {
         In case of error the object's flag .verbose in conjunction with a valid result_to_string_function
         can be used to write more sophisticated output.
         @param n_tests The number of tests to be conducted.
-        @return A RandomizedFunctionTest::TestReturnType object that provides general information about the tests and the error cases.
+        @return A BasicRandomizedFunctionTest::TestReturnType object that provides general information about the tests and the error cases.
         */
         TestReturnType test( const unsigned int n_tests) {
             return test( "", n_tests);
         }
 
 
+        /** Conducts test cases until the given time budget is exhausted, see test().
+        The cases are the ones of test() with max_n_tests cases, or of the corpus, if one is set.
+        The reference cache, if set, only provides its present cases.
+        @param test_name A human-readable alias of the test that will be written into the stream.
+        @param budget The time budget. Replaces series_budget for this test series.
+        @return A BasicRandomizedFunctionTest::TestReturnType object that provides general information about the tests and the error cases.
+        */
+        TestReturnType test_for(const std::string& test_name, const DurationType budget) {
+            const auto original_budget = series_budget;
+            series_budget = budget;
+            auto ret = test(test_name, max_n_tests);
+            series_budget = original_budget;
+            return ret;
+        }
+
+
+        /** Conducts a scaling series: passes a geometric series of problem sizes to the argument creator
+        instead of case indices, compares the results at each size and times the function and the reference function
+        at each size. Then fits the durations of both against the growth models of complexity and fails
+        if the function grows faster than the reference function.
+        Each function is timed in n_repetitions samples per size, each of which is long enough for the clock,
+        and the median is taken. The functions are invoked repeatedly on the same arguments.
+        The argument creator has to create arguments of the given problem size. The corpus is not used.
+        @param test_name A human-readable alias of the test that will be written into the stream.
+        @param min_size The smallest problem size, at least 1.
+        @param max_size The upper bound of the problem sizes.
+        @param growth_factor The factor between two consecutive problem sizes, greater than 1.
+        @param n_repetitions The number of samples per function and size.
+        @return A BasicRandomizedFunctionTest::ScalingReturnType object with the durations and the fits.
+        */
+        ScalingReturnType test_scaling(
+            const std::string& test_name,
+            const unsigned int min_size,
+            const unsigned int max_size,
+            const double growth_factor = 2,
+            const unsigned int n_repetitions = 5)
+        {
+            ScalingReturnType ret;
+            if (verbosity_level >= verbosity::NORMAL) {
+                log(verbosity::NORMAL, [test_name](std::ostream& os) { os << "RandomizedFunctionTest: " << test_name << ": scaling "; });
+            }
+
+            const InstrumentsType instruments;
+            for (const auto size : complexity::geometric_sizes(min_size, max_size, growth_factor)) {
+                std::shared_ptr<arena> size_arena;
+                if (use_arena) {
+                    size_arena = std::make_shared<arena>(arena_block_size);
+                }
+                const arena::scope arena_scope(size_arena.get());
+
+                try {
+                    const ArgsTupleType arg_tuple = args_creator_(size);
+
+                    SampleType reference_sample;
+                    SampleType sample;
+                    const auto reference_result = measure([&]() { return tuple_call::call(reference_fun_, arg_tuple); }, instruments, reference_sample);
+                    const auto result = measure([&]() { return tuple_call::call(fun_, arg_tuple); }, instruments, sample);
+                    if (!comp_(result, reference_result)) {
+                        ret.failed_sizes.push_back(size);
+                        if (verbosity_level >= verbosity::VERBOSE) {
+                            log(verbosity::VERBOSE, [size, result_string = result_to_string_function_(result), reference_string = result_to_string_function_(reference_result)](std::ostream& os) {
+                                os <<
+                                    "\n ERROR AT SIZE " << size << ":\n"
+                                    "   wrong result:        " << result_string << "\n"
+                                    "   reference result:    " << reference_string << "\n";
+                            });
+                        }
+                    }
+                    delete_result(result);
+                    delete_result(reference_result);
+
+                    const double reference_ns = median_invocation_ns(reference_fun_, arg_tuple, reference_sample.duration, n_repetitions);
+                    const double ns = median_invocation_ns(fun_, arg_tuple, sample.duration, n_repetitions);
+                    delete_args(arg_tuple);
+
+                    ret.sizes.push_back(size);
+                    ret.reference_invocation_duration_ns.push_back(reference_ns);
+                    ret.invocation_duration_ns.push_back(ns);
+                    log(verbosity::NORMAL, [](std::ostream& os) { os << "."; });
+                }
+                catch (std::exception& ex) {
+                    log(verbosity::NORMAL, [size, type_name = std::string(typeid(ex).name()), what = std::string(ex.what())](std::ostream& os) {
+                        os << "EXCEPTION AT SIZE " << size << "\n" << type_name << ":\n" << what << "\n";
+                    });
+                    ret.is_aborted = true;
+                    break;
+                }
+                catch (...) {
+                    log(verbosity::NORMAL, [size](std::ostream& os) { os << "EXCEPTION AT SIZE " << size << "\nunknown\n"; });
+                    ret.is_aborted = true;
+                    break;
+                }
+            }
+
+            const std::vector<double> sizes(ret.sizes.begin(), ret.sizes.end());
+            ret.complexity = complexity::best_fit(sizes, ret.invocation_duration_ns);
+            ret.reference_complexity = complexity::best_fit(sizes, ret.reference_invocation_duration_ns);
+            ret.is_complexity_within_reference = ret.complexity.growth <= ret.reference_complexity.growth ||
+                complexity::fit(ret.reference_complexity.growth, sizes, ret.invocation_duration_ns).rms <= ret.complexity.rms + complexity_tolerance;
+
+            // the messages refer to ret, which lives until the flush below
+            log(verbosity::NORMAL, [&ret](std::ostream& os) {
+                std::stringstream ss;
+                ss << std::fixed << std::setprecision(3);
+                const auto write_fit = [&ss](const complexity::fit_result& f) {
+                    ss << complexity::name(f.growth) << ", " << f.coefficient << " ns * " << complexity::term(f.growth) << " (rms " << 100 * f.rms << "%)\n";
+                };
+                ss << (ret.is_all_tests_passed() ? " OK (" : " FAILURE (") << ret.sizes.size() - ret.failed_sizes.size() << "/" << ret.sizes.size() << " sizes)\n";
+                if (!ret.sizes.empty()) {
+                    ss << " COMPLEXITY: ";
+                    write_fit(ret.complexity);
+                    ss << " REFERENCE:  ";
+                    write_fit(ret.reference_complexity);
+                }
+                if (!ret.is_complexity_within_reference) {
+                    ss << " COMPLEXITY EXCEEDS REFERENCE\n";
+                }
+                os << ss.str();
+            });
+            log(verbosity::VERBOSE, [&ret](std::ostream& os) {
+                for (std::size_t i = 0; i < ret.sizes.size(); ++i) {
+                    os << "   size " << ret.sizes[i] << ": " << ret.invocation_duration_ns[i] << " ns, reference " << ret.reference_invocation_duration_ns[i] << " ns\n";
+                }
+            });
+
+            reporter_->flush();
+            return ret;
+        }
+
+
+        /** Conducts a stress series: invokes the function from 1, 2, 4, ... and max_threads threads at the same time
+        and compares every result to the result of the reference function, so that races show up as error cases
+        and lock contention and false sharing as a loss of throughput.
+        Each thread has its own cases: thread w of n_tests_per_thread cases conducts the case indices
+        [w * n_tests_per_thread, (w + 1) * n_tests_per_thread). Each thread first creates its arguments and
+        the reference results, then waits for the other threads, then invokes the function on all its cases in a row
+        and only then compares the results. Hence only the invocations of the function overlap and are timed.
+        The throughput is the number of invocations per second of wall-clock time of all threads,
+        the efficiency the throughput relative to n_threads times the throughput of a single thread.
+        Requires a thread-safe argument creator and reference function. The corpus and the reference cache are not used.
+        The arguments and results of all cases of a thread count are held in memory at the same time.
+        @param test_name A human-readable alias of the test that will be written into the stream.
+        @param n_tests_per_thread The number of test cases per thread.
+        @param max_threads The largest number of threads. 0 means one per hardware thread.
+        @return A BasicRandomizedFunctionTest::StressReturnType object with the outcome of every thread count.
+        */
+        StressReturnType test_stress(const std::string& test_name, const unsigned int n_tests_per_thread, const unsigned int max_threads = 0) {
+            StressReturnType ret;
+            if (verbosity_level >= verbosity::NORMAL) {
+                log(verbosity::NORMAL, [test_name](std::ostream& os) { os << "RandomizedFunctionTest: " << test_name << ": stress "; });
+            }
+
+            const unsigned int n_max = work_stealing::resolve_n_workers(max_threads);
+            for (unsigned int n = 1; ; n = n * 2 < n_max ? n * 2 : n_max) {
+                std::vector<StressThreadType> threads(n);
+                std::atomic<unsigned int> n_ready(0);
+                {
+                    std::vector<std::thread> workers;
+                    for (unsigned int w = 0; w < n; ++w) {
+                        workers.emplace_back([&, w]() { run_stress_thread(w * n_tests_per_thread, n_tests_per_thread, n, n_ready, threads[w]); });
+                    }
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+                }
+
+                StressLevelType level;
+                level.n_threads = n;
+                auto start = threads.front().start;
+                auto end = threads.front().end;
+                for (auto& t : threads) {
+                    start = std::min(start, t.start);
+                    end = std::max(end, t.end);
+                    level.n_tests += t.outcome.n_tests;
+                    level.n_passed_tests += t.outcome.n_passed_tests;
+                    std::move(t.outcome.error_cases.begin(), t.outcome.error_cases.end(), std::back_inserter(level.error_cases));
+                    if (t.outcome.is_aborted && !level.is_aborted) {
+                        level.is_aborted = true;
+                        level.exception_description = std::move(t.outcome.exception_description);
+                    }
+                    if (t.cases_arena && t.cases_arena->is_pinned()) {
+                        ret.arenas.push_back(std::move(t.cases_arena));
+                    }
+                }
+                // the error cases of a thread are in order, the threads are in order of their case indices
+                if (level.error_cases.size() > max_error_cases) {
+                    for (auto it = level.error_cases.begin() + max_error_cases; it != level.error_cases.end(); ++it) {
+                        delete_error_case(*it);
+                    }
+                    level.error_cases.erase(level.error_cases.begin() + max_error_cases, level.error_cases.end());
+                }
+                level.duration = std::chrono::duration_cast<DurationType>(end - start);
+                level.throughput = level.duration.count() > 0 ? level.n_tests / (level.duration.count() * 1e-9) : 0;
+                level.efficiency = ret.levels.empty() || ret.levels.front().throughput == 0 ? 1 : level.throughput / (n * ret.levels.front().throughput);
+                ret.levels.push_back(std::move(level));
+                log(verbosity::NORMAL, [](std::ostream& os) { os << "."; });
+
+                if (ret.levels.back().is_aborted || n == n_max) {
+                    break;
+                }
+            }
+            ret.is_efficiency_sufficient = ret.levels.back().efficiency >= required_parallel_efficiency;
+
+            // the messages refer to ret, which lives until the flush below
+            log(verbosity::NORMAL, [&ret, required = required_parallel_efficiency](std::ostream& os) {
+                unsigned int n_tests = 0;
+                unsigned int n_passed_tests = 0;
+                for (const auto& l : ret.levels) {
+                    n_tests += l.n_tests;
+                    n_passed_tests += l.n_passed_tests;
+                }
+                std::stringstream ss;
+                ss << std::fixed << std::setprecision(1);
+                ss << (ret.is_all_tests_passed() ? " OK (" : " FAILURE (") << n_passed_tests << "/" << n_tests << ")\n";
+                ss << " THREADS   THROUGHPUT/s   EFFICIENCY   PASSED\n";
+                for (const auto& l : ret.levels) {
+                    ss << std::setw(8) << l.n_threads << std::setw(15) << l.throughput << std::setw(12) << 100 * l.efficiency << "%   " <<
+                        l.n_passed_tests << "/" << l.n_tests << "\n";
+                    if (l.is_aborted) {
+                        ss << l.exception_description;
+                    }
+                }
+                if (!ret.is_efficiency_sufficient) {
+                    ss << " EFFICIENCY BELOW " << 100 * required << "%\n";
+                }
+                os << ss.str();
+            });
+            log(verbosity::VERBOSE, [this, &ret](std::ostream& os) {
+                for (const auto& l : ret.levels) {
+                    unsigned int i = 0;
+                    for (const auto& ec : l.error_cases) {
+                        os <<
+                            " ERROR CASE " << i++ << " AT " << l.n_threads << " THREADS (case index " << ec.case_index << "):\n"
+                            "   wrong result:        " << result_to_string_function_(ec.erroneous_result) << "\n"
+                            "   reference result:    " << result_to_string_function_(ec.reference_result) << "\n";
+                        write_mismatch(os, ec);
+                        os <<
+                            "   args:                " << args_to_string_function_(ec.args) << "\n"
+                            " .\n";
+                    }
+                }
+            });
+
+            reporter_->flush();
+            if (recorder_) {
+                for (auto& record : run_record::from_stress_test(test_name, ret)) {
+                    recorder_->add(std::move(record));
+                }
+            }
+            return ret;
+        }
+
+
+        /** Replaces the output stream of the constructor with the given reporter,
+        e.g. with an async_reporter that several testers share.
+        @param r The reporter.
+        */
+        void set_reporter(std::shared_ptr<reporter> r) {
+            reporter_ = std::move(r);
+        }
+
+
+        /** Sets a recorder to which test() adds a record of every test series, see run_record.
+        @param r The recorder, or nullptr to stop recording.
+        */
+        void set_recorder(std::shared_ptr<run_record::recorder> r) {
+            recorder_ = std::move(r);
+        }
+
+
+        /** Sets a cache from which test() reads the reference results and their invocation durations
+        instead of invoking the reference function, and to which it adds the ones that it computes.
+        Requires an argument creator that depends on nothing but the case index.
+        The reference hardware counters and allocations are not measured for cached results.
+        The cache is neither read nor filled while a corpus is set, since it holds the results by case index.
+        Requires copyable results, since the cached ones are copied.
+        @param cache The cache, or nullptr to invoke the reference function for every case.
+        */
+        void set_reference_cache(std::shared_ptr<reference_cache<ResultType>> cache) {
+            static_assert(std::is_copy_constructible<ResultType>::value, "set_reference_cache(): move-only results cannot be cached");
+            reference_cache_ = std::move(cache);
+        }
+
+
+        /** Sets a corpus from which test() takes the arguments of the test cases, in the order of the corpus,
+        instead of creating them with the argument creator. Trivially copyable arguments are passed
+        to the functions in place from the memory mapping of the corpus.
+        The argument deleter is not called on the arguments of a corpus.
+        While a corpus is set, test() invokes the reference function on every case and bypasses the reference cache,
+        whose results belong to the case indices of the argument creator.
+        @param c The corpus, or nullptr to create the arguments with the argument creator again.
+        */
+        void set_corpus(std::shared_ptr<const corpus<ArgsTupleType>> c) {
+            corpus_ = std::move(c);
+        }
+
+
+        /** Re-creates the arguments of a single test case, e.g. the one of an error case.
+        Yields the arguments of the original test case if the argument creator
+        depends on nothing but the case index, like the ones of random_args::make_args_creator(),
+        or if a corpus is set.
+        If the argument creator allocates from arena::current(), the caller has to set an arena::scope.
+        @param case_index The index of the test case.
+        @return The argument tuple for the given test case.
+        */
+        ArgsTupleType create_args(const unsigned int case_index) const {
+            if (corpus_) {
+                return corpus_->visit(case_index, [](const ArgsTupleType& arg_tuple) { return arg_tuple; });
+            }
+            return args_creator_(case_index);
+        }
+
+
     protected: // helpers
 
-        /** Calls the given function f with the parameters found in the given tuple and,
-        if f returns a value, also returns this value.
-        @param f A function.
-        @param t A tuple containing the parameters for the invocation of f.
-        If f takes no arguments, pass std::tuple<>().
-        @param[out] out_duration A reference to a duration object to which the execution time
-        of the function will be written.
-        @return Returns the return value of f.
-        If f's result type would be void, the return type of this function would also be void.
+        /** Conducts the test cases [begin, end) on the calling thread and accumulates their outcome.
+        Stops early at the first case whose index is not smaller than stop_index
+        or at the first case that throws an exception.
+        If batch_size is greater than 1, the cases are conducted in batches.
+        A batch in which an exception occurs is conducted once more case by case.
+        If use_arena is set, the cases allocate from an arena of their own, which is kept in
+        the outcome if it holds the memory of error cases.
+        @param begin The index of the first test case.
+        @param end One past the index of the last test case.
+        @param stop_index Cases from this index on are not conducted anymore.
+        Can be lowered concurrently by other workers. Checked before every batch.
+        @param[out] out_range The outcome of the conducted test cases.
+        @param on_case_begin A function void() that is invoked after the arguments of each case are created.
+        @param progress Receives the index of every case, or batch, before it is conducted,
+        and watchdog::idle at the end, or nullptr. See watchdog.
         */
-        template <typename F, typename Tuple>
-        constexpr auto call(F f, Tuple&& t, DurationType& out_duration) const {
-            using ttype = std::decay<Tuple>::type;
-            return call_impl<F, Tuple, 0 == std::tuple_size<ttype>::value, std::tuple_size<ttype>::value>::call(f, std::forward<Tuple>(t), out_duration);
+        template <typename F>
+        void run_cases(
+            const unsigned int begin,
+            const unsigned int end,
+            const std::atomic<unsigned int>& stop_index,
+            RangeResultType& out_range,
+            F&& on_case_begin,
+            std::atomic<unsigned int>* progress = nullptr)
+        {
+            out_range.begin = begin;
+            out_range.end = begin;
+
+            std::shared_ptr<arena> cases_arena;
+            if (use_arena) {
+                cases_arena = std::make_shared<arena>(arena_block_size);
+            }
+            const arena::scope arena_scope(cases_arena.get());
+
+            InstrumentsType instruments;
+            if (measure_hardware_counters) {
+                instruments.counters.reset(new perf_counters::counter_group());
+            }
+            instruments.is_tracking_allocations = measure_allocations;
+
+            const unsigned int n_batch = batch_size > 1 ? batch_size : 1;
+            BatchType batch;
+            for (unsigned int i = begin; i < end && !out_range.is_aborted && i < stop_index.load(std::memory_order_relaxed); ) {
+                if (watchdog_ && watchdog_->is_budget_exhausted()) {
+                    break;
+                }
+                const unsigned int batch_end = end - i > n_batch ? i + n_batch : end;
+
+                if (progress) {
+                    progress->store(i, std::memory_order_relaxed);
+                }
+                if (batch_end - i > 1 && run_batch(i, batch_end, batch, instruments, out_range, on_case_begin)) {
+                    i = batch_end;
+                    continue;
+                }
+
+                for (; i < batch_end; ++i) {
+                    if (progress) {
+                        progress->store(i, std::memory_order_relaxed);
+                    }
+                    if (!run_case(i, instruments, out_range, on_case_begin)) {
+                        break;
+                    }
+                }
+            }
+
+            if (progress) {
+                progress->store(watchdog::idle, std::memory_order_relaxed);
+            }
+            if (cases_arena && cases_arena->is_pinned()) {
+                out_range.result.arenas.push_back(std::move(cases_arena));
+            }
         }
 
 
-        /** Writes the given string to the output stream if the given verbosity level.
-        is equal or smaller than the verbosity_level member value.
-        @param str The string to be written to a stream;
-        @param str_verbosity_level The verbosity level of the given string.
+        /** Conducts a single test case and accumulates its outcome.
+        @param i The index of the test case.
+        @param instruments The instruments of the calling thread.
+        @param[in,out] out_range The outcome of the conducted test cases. Its end is set behind the case,
+        or is_aborted is set if the case throws an exception.
+        @param on_case_begin A function void() that is invoked after the arguments are created.
+        @return False if an exception occurred, true otherwise.
         */
-        constexpr void log(const std::string& str, const verbosity str_verbosity_level) const {
-            if (verbosity_level >= str_verbosity_level) {
-                os_ << str;
+        template <typename F>
+        bool run_case(const unsigned int i, const InstrumentsType& instruments, RangeResultType& out_range, F&& on_case_begin) {
+            if (corpus_) {
+                return corpus_->visit(i, [&](const ArgsTupleType& arg_tuple) { return run_case(i, arg_tuple, instruments, out_range, on_case_begin); });
             }
+            return run_case(i, args_creator_(i), instruments, out_range, on_case_begin);
         }
 
-    }; // END class RandomizedFunctionTest
 
-} // END namespace unittest
\ No newline at end of file
+        /** Conducts a single test case with the given arguments and accumulates its outcome.
+        @param i The index of the test case.
+        @param arg_tuple The arguments of the test case. Moved into the error case if the case fails and they are an rvalue.
+        @param instruments The instruments of the calling thread.
+        @param[in,out] out_range The outcome of the conducted test cases. Its end is set behind the case,
+        or is_aborted is set if the case throws an exception.
+        @param on_case_begin A function void() that is invoked before the case is conducted.
+        @return False if an exception occurred, true otherwise.
+        */
+        template <typename Args, typename F>
+        bool run_case(const unsigned int i, Args&& arg_tuple, const InstrumentsType& instruments, RangeResultType& out_range, F&& on_case_begin) {
+            TestReturnType& ret = out_range.result;
+
+            on_case_begin();
+
+            try {
+                auto* const cache = active_reference_cache();
+                if (cache && cache->contains(i)) {
+                    cache->visit(i, [&](const ResultType& reference_result) {
+                        ++ret.n_cached_reference_results;
+                        check_case(i, std::forward<Args>(arg_tuple), reference_result, cached_reference_sample(i, 1, instruments), true, instruments, ret);
+                    });
+                }
+                else {
+                    SampleType reference_sample;
+                    auto reference_result = measure([&]() { return tuple_call::call(reference_fun_, arg_tuple); }, instruments, reference_sample);
+                    if (cache) {
+                        cache->store(i, reference_result, static_cast<double>(reference_sample.duration.count()));
+                    }
+                    check_case(i, std::forward<Args>(arg_tuple), std::move(reference_result), reference_sample, false, instruments, ret);
+                }
+            }
+            catch (std::exception& ex) {
+                std::stringstream ss;
+                ss <<
+                    "EXCEPTION\n" <<
+                    typeid(ex).name() << ":\n" <<
+                    ex.what() << "\n" <<
+                    "Arguments: " << args_to_string_function_(arg_tuple) << "\n";
+                out_range.exception_description = ss.str();
+                out_range.is_aborted = true;
+                return false;
+            }
+            catch (...) {
+                std::stringstream ss;
+                ss <<
+                    "EXCEPTION\n" <<
+                    "unknown\n" <<
+                    "Arguments: " << args_to_string_function_(arg_tuple) << "\n";
+                out_range.exception_description = ss.str();
+                out_range.is_aborted = true;
+                return false;
+            }
+
+            ++ret.n_tests;
+            out_range.end = i + 1;
+            return true;
+        }
+
+
+        /** Invokes the function on the arguments of a single test case, compares its result
+        to the reference result and accumulates the outcome.
+        The result is moved into the error case if the case fails, as are the arguments and the reference result if they are rvalues.
+        @param i The index of the test case.
+        @param arg_tuple The arguments of the test case.
+        @param reference_result The result of the reference function.
+        @param reference_sample The measurements of the reference function.
+        @param is_reference_cached Whether the reference result comes from the reference cache,
+        in which case it is not deleted.
+        @param instruments The instruments of the calling thread.
+        @param[in,out] ret The outcome of the conducted test cases.
+        */
+        template <typename Args, typename Result>
+        void check_case(
+            const unsigned int i,
+            Args&& arg_tuple,
+            Result&& reference_result,
+            const SampleType& reference_sample,
+            const bool is_reference_cached,
+            const InstrumentsType& instruments,
+            TestReturnType& ret)
+        {
+            SampleType sample;
+            auto result = measure([&]() { return tuple_call::call(fun_, arg_tuple); }, instruments, sample);
+
+            if (case_timeout.count() > 0 && reference_sample.duration + sample.duration > case_timeout) {
+                // timed out case
+                ret.timed_out_cases.push_back(TimedOutCaseType{ i, reference_sample.duration + sample.duration, args_to_string_function_(arg_tuple) });
+
+                delete_result(result);
+                if (!is_reference_cached) {
+                    delete_result(reference_result);
+                }
+                delete_args(arg_tuple);
+                release_arena(false);
+            }
+            else if (comp_(result, reference_result)) {
+                // correct case
+                ++ret.n_passed_tests;
+
+                delete_result(result);
+                if (!is_reference_cached) {
+                    delete_result(reference_result);
+                }
+                delete_args(arg_tuple);
+                release_arena(false);
+            }
+            else {
+                // failure case
+                release_arena(add_error_case(ret, ErrorCaseType{ std::move(result), take_result(std::forward<Result>(reference_result)), std::forward<Args>(arg_tuple), i }));
+            }
+
+            add_samples(ret, reference_sample, sample);
+        }
+
+
+        /// Returns the reference cache that test() reads and fills, i.e. none while a corpus is set, see set_corpus().
+        reference_cache<ResultType>* active_reference_cache() const {
+            return corpus_ ? nullptr : reference_cache_.get();
+        }
+
+
+        /** Returns the measurements of the reference function for the cached test cases [begin, begin + n):
+        the sum of their cached durations. The hardware counts are NaN if counters are measured.
+        */
+        SampleType cached_reference_sample(const unsigned int begin, const unsigned int n, const InstrumentsType& instruments) const {
+            double ns = 0;
+            for (unsigned int i = begin; i < begin + n; ++i) {
+                ns += reference_cache_->duration_ns(i);
+            }
+            SampleType ret;
+            ret.duration = DurationType(static_cast<typename DurationType::rep>(ns));
+            if (instruments.counters) {
+                ret.counts = perf_counters::unavailable();
+            }
+            return ret;
+        }
+
+
+        /** Conducts the test cases [begin, end) as one batch and accumulates their outcome.
+        First creates all argument tuples, then invokes the reference function on all of them,
+        then invokes the function on all of them and finally compares the results.
+        Each of the two invocation loops is timed with a single pair of clock reads
+        and measured with a single pair of reads of the other instruments.
+        If the reference cache holds all cases of the batch, the reference results are copied from it instead.
+        A batch that runs past case_timeout, as every batch with a case that does, is conducted once more
+        case by case to find the cases that time out.
+        @param begin The index of the first test case of the batch.
+        @param end One past the index of the last test case of the batch.
+        @param batch The buffers for the batch. Reused from batch to batch.
+        @param instruments The instruments of the calling thread.
+        @param[in,out] out_range The outcome of the conducted test cases. Its end is set behind the batch.
+        @param on_case_begin A function void() that is invoked once per case after the batch was conducted.
+        @return False if an exception occurred or the batch ran past its deadline, in which case nothing is accumulated, true otherwise.
+        */
+        template <typename F>
+        bool run_batch(
+            const unsigned int begin,
+            const unsigned int end,
+            BatchType& batch,
+            const InstrumentsType& instruments,
+            RangeResultType& out_range,
+            F&& on_case_begin)
+        {
+            TestReturnType& ret = out_range.result;
+            const unsigned int n = end - begin;
+            auto* const cache = active_reference_cache();
+            const bool is_reference_cached = cache && cache->contains(end - 1);
+            bool is_error_case_kept = false;
+
+            batch.args.clear();
+            batch.reference_results.clear();
+            batch.results.clear();
+            batch.reference_results.reserve(n);     // no reallocations within the measurements
+            batch.results.reserve(n);
+            // the arguments of a corpus that is read in place are used in place
+            const ArgsTupleType* args = corpus_ ? corpus_->data(begin) : nullptr;
+            if (!args) {
+                for (unsigned int i = begin; i < end; ++i) {
+                    batch.args.push_back(corpus_ ? create_args(i) : args_creator_(i));
+                }
+                args = batch.args.data();
+            }
+
+            SampleType reference_sample;
+            SampleType sample;
+            bool is_discarded = false;
+            try {
+                if (is_reference_cached) {
+                    for (unsigned int i = begin; i < end; ++i) {
+                        batch.reference_results.push_back(cache->visit(i, [](const ResultType& r) { return take_result(r); }));
+                    }
+                    reference_sample = cached_reference_sample(begin, n, instruments);
+                }
+                else {
+                    measure([&]() {
+                        for (unsigned int j = 0; j < n; ++j) {
+                            batch.reference_results.push_back(tuple_call::call(reference_fun_, args[j]));
+                        }
+                    }, instruments, reference_sample);
+                }
+
+                measure([&]() {
+                    for (unsigned int j = 0; j < n; ++j) {
+                        batch.results.push_back(tuple_call::call(fun_, args[j]));
+                    }
+                }, instruments, sample);
+                is_discarded = case_timeout.count() > 0 && reference_sample.duration + sample.duration > case_timeout;
+            }
+            catch (...) {
+                is_discarded = true;
+            }
+            if (is_discarded) {
+                for (const auto& r : batch.reference_results) {
+                    if (!is_reference_cached) {
+                        delete_result(r);
+                    }
+                }
+                for (const auto& r : batch.results) {
+                    delete_result(r);
+                }
+                for (const auto& arg_tuple : batch.args) {
+                    delete_args(arg_tuple);
+                }
+                release_arena(false);
+                return false;
+            }
+
+            if (is_reference_cached) {
+                ret.n_cached_reference_results += n;
+            }
+            else if (cache) {
+                const double ns = static_cast<double>(reference_sample.duration.count()) / n;
+                for (unsigned int j = 0; j < n; ++j) {
+                    cache->store(begin + j, batch.reference_results[j], ns);
+                }
+            }
+
+            for (unsigned int j = 0; j < n; ++j) {
+                on_case_begin();
+
+                if (comp_(batch.results[j], batch.reference_results[j])) {
+                    // correct case
+                    ++ret.n_passed_tests;
+
+                    delete_result(batch.results[j]);
+                    if (!is_reference_cached) {
+                        delete_result(batch.reference_results[j]);
+                    }
+                    delete_args(args[j]);
+                }
+                else {
+                    // failure case, the batch owns its results and the arguments that it created
+                    is_error_case_kept |= add_error_case(ret, args == batch.args.data()
+                        ? ErrorCaseType{ std::move(batch.results[j]), std::move(batch.reference_results[j]), std::move(batch.args[j]), begin + j }
+                        : ErrorCaseType{ std::move(batch.results[j]), std::move(batch.reference_results[j]), args[j], begin + j });
+                }
+            }
+
+            release_arena(is_error_case_kept);
+
+            ret.n_tests += n;
+            add_samples(ret, reference_sample, sample, n);
+            out_range.end = end;
+            return true;
+        }
+
+
+        /** Conducts the test cases [0, n_tests) on the calling thread and streams out the progress dots.
+        @param n_tests The number of tests to be conducted.
+        @param dots_total The number of dots that indicate the progress of the whole test series.
+        @return The outcome of the conducted test cases.
+        */
+        RangeResultType run_cases_serial(const unsigned int n_tests, const std::size_t dots_total) {
+            const float dots_to_add_per_step = static_cast<float>(dots_total) / n_tests;
+            float dots_to_add_float = 0;
+
+            const std::atomic<unsigned int> stop_index(n_tests);
+            RangeResultType range;
+            std::atomic<unsigned int>* progress = watchdog_ ? &watchdog_->slot(0) : nullptr;
+            run_cases(0, n_tests, stop_index, range, [&]() {
+                if (verbosity_level < verbosity::NORMAL) {
+                    return;
+                }
+                dots_to_add_float += dots_to_add_per_step;
+                const unsigned int dots_to_add_int = static_cast<unsigned int>(dots_to_add_float);
+                if (dots_to_add_int > 0) {
+                    log(verbosity::NORMAL, [dots_to_add_int](std::ostream& os) { os << std::string(dots_to_add_int, '.'); });
+                    dots_to_add_float -= dots_to_add_int;
+                }
+            }, progress);
+            return range;
+        }
+
+
+        /** Conducts the test cases [0, n_tests) on several worker threads and merges their outcomes
+        in the order of the case indices. If a case throws, all cases with a smaller index are still
+        taken into account, while all cases with a greater index are discarded, just like in a serial test series.
+        Cases below the throwing case that belong to a chunk which a worker continued past it are conducted
+        once more on the calling thread.
+        @param n_tests The number of tests to be conducted.
+        @param n_workers The number of worker threads.
+        @return The merged outcome of the conducted test cases.
+        */
+        RangeResultType run_cases_parallel(const unsigned int n_tests, const unsigned int n_workers) {
+            const std::size_t chunk_size = std::min<std::size_t>(std::max<std::size_t>(n_tests / (16 * n_workers), 1), 4096);
+
+            std::atomic<unsigned int> stop_index(n_tests);
+            std::vector<std::vector<RangeResultType>> worker_ranges(n_workers);
+
+            work_stealing::parallel_for(n_tests, n_workers, chunk_size,
+                [&](const unsigned int worker, const std::size_t begin, const std::size_t end) {
+                    if (watchdog_ && watchdog_->is_budget_exhausted()) {
+                        return;
+                    }
+                    RangeResultType range;
+                    run_cases(static_cast<unsigned int>(begin), static_cast<unsigned int>(end), stop_index, range, []() {}, watchdog_ ? &watchdog_->slot(worker) : nullptr);
+
+                    if (range.is_aborted) {
+                        auto stop = stop_index.load();
+                        while (range.end < stop && !stop_index.compare_exchange_weak(stop, range.end)) {}
+                    }
+                    worker_ranges[worker].push_back(std::move(range));
+                });
+
+            std::vector<RangeResultType> ranges;
+            for (auto& wr : worker_ranges) {
+                std::move(wr.begin(), wr.end(), std::back_inserter(ranges));
+            }
+            std::sort(ranges.begin(), ranges.end(), [](const RangeResultType& a, const RangeResultType& b) { return a.begin < b.begin; });
+
+            const auto stop = stop_index.load();
+            RangeResultType merged;
+            for (auto& range : ranges) {
+                if (range.begin > stop) {
+                    // the range lies behind the throwing case
+                    for (const auto& ec : range.result.error_cases) {
+                        delete_error_case(ec);
+                    }
+                    continue;
+                }
+                if (range.end > stop) {
+                    // the worker continued past the throwing case before it noticed. The error cases
+                    // of the range were streamed already, hence they are not streamed once more
+                    for (const auto& ec : range.result.error_cases) {
+                        delete_error_case(ec);
+                    }
+                    const std::atomic<unsigned int> rerun_stop_index(stop);
+                    const auto begin = range.begin;
+                    const auto streamed_file = std::move(error_case_file_);
+                    range = RangeResultType();
+                    run_cases(begin, stop, rerun_stop_index, range, []() {});
+                    error_case_file_ = streamed_file;
+                }
+
+                merge_into(merged.result, std::move(range.result));
+                merged.end = std::max(merged.end, range.end);
+
+                if (range.is_aborted && range.end == stop) {
+                    merged.is_aborted = true;
+                    merged.exception_description = std::move(range.exception_description);
+                }
+            }
+            return merged;
+        }
+
+
+        /** Conducts the test cases [0, n_tests) in worker processes, see is_isolated, and merges their outcomes
+        in the order of the case indices like run_cases_parallel().
+        Each worker conducts one chunk of cases after the other and reports its counters and the indices of the failed cases.
+        If a worker crashes, the case that it was conducting is recorded as crashed case, the worker is respawned
+        and the other cases of the chunk are conducted again. If the crash happened within a batch, the batch
+        is conducted once more case by case to find the crashing case.
+        The calling process acts as watchdog: it ends a worker whose case runs past case_timeout, which is then
+        handled like a crash but recorded as timed out case, and it stops handing out chunks once series_budget is exhausted.
+        The error cases that error_policy keeps are re-created by conducting their cases once more in the calling process.
+        Only the indices of these are collected, except under error_case_policy::KEEP_ALL, which keeps every error case.
+        Under error_case_policy::STREAM, the worker processes write the error cases to the file as they occur.
+        @param n_tests The number of tests to be conducted.
+        @param n_workers The number of worker processes.
+        @return The merged outcome of the conducted test cases.
+        */
+        RangeResultType run_cases_isolated(const unsigned int n_tests, const unsigned int n_workers) {
+#if defined(UNITTEST_PROCESS_ISOLATION)
+            /// A chunk of cases [begin, end), conducted in batches or case by case.
+            struct TaskType {
+                unsigned int begin = 0;
+                unsigned int end = 0;
+                bool is_batching = true;
+            };
+
+            const unsigned int chunk_size = static_cast<unsigned int>(std::min<std::size_t>(std::max<std::size_t>(n_tests / (16 * n_workers), 1), 4096));
+            std::deque<TaskType> tasks;         // chunks that are conducted once more
+            unsigned int next_begin = 0;        // the begin of the next fresh chunk
+
+            process_isolation::shared_progress progress(n_workers);
+            if (!progress.is_valid()) {
+                return n_workers > 1 && n_tests > 1 ? run_cases_parallel(n_tests, n_workers) : run_cases_serial(n_tests, 0);
+            }
+            watchdog dog(&progress[0], n_workers, case_timeout, series_budget);
+            const bool is_watched = case_timeout.count() > 0 || series_budget.count() > 0;
+
+            std::vector<process_isolation::worker> workers(n_workers);
+            std::vector<TaskType> assigned(n_workers);
+            std::vector<bool> is_busy(n_workers, false);
+            std::vector<bool> is_ended_by_watchdog(n_workers, false);
+            std::vector<RangeResultType> ranges;
+            std::vector<unsigned int> error_indices;
+            std::vector<CrashedCaseType> crashed_cases;
+            std::vector<TimedOutCaseType> timed_out_cases;
+            unsigned int stop = n_tests;
+
+            const auto add_outcome = [&](RangeResultType&& range, std::vector<unsigned int>&& indices) {
+                if (range.is_aborted) {
+                    stop = std::min(stop, range.end);
+                }
+                error_indices.insert(error_indices.end(), indices.begin(), indices.end());
+                if (error_policy != error_case_policy::RESERVOIR && error_indices.size() > 2 * max_error_cases) {
+                    // the first indices stay the first ones whatever the throwing case, unlike a sample
+                    select_error_indices(error_indices);
+                }
+                ranges.push_back(std::move(range));
+            };
+
+            std::string request;
+            std::string reply;
+            std::vector<pollfd> fds;
+            std::vector<unsigned int> fd_workers;
+            for (;;) {
+                for (unsigned int w = 0; w < n_workers && !dog.is_budget_exhausted(); ++w) {
+                    while (!is_busy[w] && (!tasks.empty() || next_begin < std::min(n_tests, stop))) {
+                        TaskType task;
+                        if (!tasks.empty()) {
+                            task = tasks.front();
+                            tasks.pop_front();
+                        }
+                        else {
+                            task = TaskType{ next_begin, next_begin + std::min(chunk_size, n_tests - next_begin), true };
+                            next_begin = task.end;
+                        }
+                        if (task.begin >= stop) {
+                            continue;
+                        }
+
+                        if (!workers[w].is_running() && !workers[w].start([this, &progress, w](const std::string& req, std::string& rep) { serve_isolated(req, rep, progress[w]); })) {
+                            // no worker process available, the chunk is conducted in-process
+                            RangeResultType range;
+                            std::vector<unsigned int> indices;
+                            run_isolated_task(task.begin, task.end, task.is_batching, range, indices, nullptr);
+                            add_outcome(std::move(range), std::move(indices));
+                            continue;
+                        }
+
+                        request.clear();
+                        process_isolation::message_writer(request).put(task.begin).put(task.end).put(task.is_batching);
+                        progress[w].store(task.begin, std::memory_order_relaxed);
+                        dog.reset(w);
+                        assigned[w] = task;
+                        is_busy[w] = true;
+                        if (!workers[w].send(request)) {
+                            // the worker ended while idle, the chunk is assigned anew
+                            int signal = 0;
+                            workers[w].receive(reply, signal);
+                            tasks.push_front(task);
+                            is_busy[w] = false;
+                        }
+                    }
+                }
+
+                fds.clear();
+                fd_workers.clear();
+                for (unsigned int w = 0; w < n_workers; ++w) {
+                    if (is_busy[w]) {
+                        fds.push_back(pollfd{ workers[w].native_handle(), POLLIN, 0 });
+                        fd_workers.push_back(w);
+                    }
+                }
+                if (fds.empty()) {
+                    break;
+                }
+                const int poll_timeout_ms = is_watched ? static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(dog.period()).count()) : -1;
+                const int n_ready = poll(fds.data(), static_cast<nfds_t>(fds.size()), poll_timeout_ms);
+                if (is_watched) {
+                    dog.check([&](const unsigned int w, const unsigned int) {
+                        if (is_busy[w]) {
+                            workers[w].kill();
+                            is_ended_by_watchdog[w] = true;
+                        }
+                    });
+                }
+                if (n_ready <= 0) {
+                    continue;
+                }
+
+                for (std::size_t f = 0; f < fds.size(); ++f) {
+                    if (fds[f].revents == 0) {
+                        continue;
+                    }
+                    const unsigned int w = fd_workers[f];
+                    const TaskType task = assigned[w];
+                    is_busy[w] = false;
+
+                    int signal = 0;
+                    RangeResultType range;
+                    std::vector<unsigned int> indices;
+                    if (workers[w].receive(reply, signal) && decode_isolated_outcome(reply, range, indices)) {
+                        add_outcome(std::move(range), std::move(indices));
+                        continue;
+                    }
+
+                    // the worker crashed, or was ended by the watchdog, while it conducted case i, or the batch that begins with case i
+                    workers[w].stop();
+                    const bool is_timed_out = is_ended_by_watchdog[w];
+                    is_ended_by_watchdog[w] = false;
+                    const unsigned int i = std::min(std::max(progress[w].load(std::memory_order_relaxed), task.begin), task.end - 1);
+                    const unsigned int n_batch = task.is_batching && batch_size > 1 ? batch_size : 1;
+                    const unsigned int batch_end = task.end - i > n_batch ? i + n_batch : task.end;
+                    if (task.begin < i) {
+                        tasks.push_back(TaskType{ task.begin, i, task.is_batching });
+                    }
+                    if (batch_end - i > 1) {
+                        tasks.push_back(TaskType{ i, batch_end, false });
+                    }
+                    else if (is_timed_out) {
+                        timed_out_cases.push_back(TimedOutCaseType{ i, case_timeout, describe_args(i) });
+                    }
+                    else {
+                        crashed_cases.push_back(CrashedCaseType{ i, signal, describe_args(i) });
+                    }
+                    if (batch_end < task.end) {
+                        tasks.push_back(TaskType{ batch_end, task.end, task.is_batching });
+                    }
+                }
+            }
+            workers.clear();
+
+            // merge the outcomes up to the first throwing case
+            std::sort(ranges.begin(), ranges.end(), [](const RangeResultType& a, const RangeResultType& b) { return a.begin < b.begin; });
+            RangeResultType merged;
+            for (auto& range : ranges) {
+                if (range.begin > stop) {
+                    continue;
+                }
+                merge_into(merged.result, std::move(range.result));
+                merged.end = std::max(merged.end, range.end);
+                if (range.is_aborted && range.end == stop) {
+                    merged.is_aborted = true;
+                    merged.exception_description = std::move(range.exception_description);
+                }
+            }
+
+            std::sort(crashed_cases.begin(), crashed_cases.end(), [](const CrashedCaseType& a, const CrashedCaseType& b) { return a.case_index < b.case_index; });
+            for (auto& cc : crashed_cases) {
+                if (cc.case_index < stop) {
+                    ++merged.result.n_tests;
+                    merged.end = std::max(merged.end, cc.case_index + 1);
+                    merged.result.crashed_cases.push_back(std::move(cc));
+                }
+            }
+            for (auto& tc : timed_out_cases) {
+                if (tc.case_index < stop) {
+                    ++merged.result.n_tests;
+                    merged.end = std::max(merged.end, tc.case_index + 1);
+                    merged.result.timed_out_cases.push_back(std::move(tc));
+                }
+            }
+            std::sort(merged.result.timed_out_cases.begin(), merged.result.timed_out_cases.end(), [](const TimedOutCaseType& a, const TimedOutCaseType& b) { return a.case_index < b.case_index; });
+            merged.result.is_budget_exhausted = dog.is_budget_exhausted();
+
+            // re-create the error cases that error_policy keeps. The worker processes streamed them already
+            std::sort(error_indices.begin(), error_indices.end());
+            error_indices.erase(std::lower_bound(error_indices.begin(), error_indices.end(), stop), error_indices.end());
+            select_error_indices(error_indices);
+            const auto streamed_file = std::move(error_case_file_);
+            for (const auto i : error_indices) {
+                const std::atomic<unsigned int> stop_index(i + 1);
+                RangeResultType range;
+                run_cases(i, i + 1, stop_index, range, []() {});
+
+                TestReturnType error_cases;
+                error_cases.error_cases = std::move(range.result.error_cases);
+                error_cases.arenas = std::move(range.result.arenas);
+                merge_into(merged.result, std::move(error_cases));
+            }
+            error_case_file_ = streamed_file;
+            return merged;
+#else
+            return n_workers > 1 && n_tests > 1 ? run_cases_parallel(n_tests, n_workers) : run_cases_serial(n_tests, 0);
+#endif
+        }
+
+
+        /** Conducts the test cases [begin, end) for run_cases_isolated() and collects the indices of the failed cases
+        instead of their error cases.
+        @param begin The index of the first test case.
+        @param end One past the index of the last test case.
+        @param is_batching Whether the cases are conducted in batches of batch_size, or case by case.
+        @param[out] out_range The outcome of the conducted test cases, without error cases.
+        @param[out] out_error_indices The indices of the failed cases.
+        @param progress Receives the index of every case, or batch, before it is conducted, or nullptr.
+        */
+        void run_isolated_task(
+            const unsigned int begin,
+            const unsigned int end,
+            const bool is_batching,
+            RangeResultType& out_range,
+            std::vector<unsigned int>& out_error_indices,
+            std::atomic<unsigned int>* progress)
+        {
+            const unsigned int original_batch_size = batch_size;
+            if (!is_batching) {
+                batch_size = 1;
+            }
+            isolation_error_indices_ = &out_error_indices;
+
+            const std::atomic<unsigned int> stop_index(end);
+            run_cases(begin, end, stop_index, out_range, []() {}, progress);
+
+            isolation_error_indices_ = nullptr;
+            batch_size = original_batch_size;
+            select_error_indices(out_error_indices);
+        }
+
+
+        /** Reduces the given indices of failed cases to the ones whose error cases error_policy keeps, see run_cases_isolated().
+        Keeps every index under error_case_policy::KEEP_ALL.
+        @param[in,out] indices The indices of failed cases. In ascending order afterwards if they were reduced.
+        */
+        void select_error_indices(std::vector<unsigned int>& indices) const {
+            if (error_policy == error_case_policy::KEEP_ALL || indices.size() <= max_error_cases) {
+                return;
+            }
+            if (error_policy == error_case_policy::RESERVOIR) {
+                const auto order = [seed = reservoir_seed](const unsigned int a, const unsigned int b) {
+                    return random_args::case_generator(seed, a).next_u64() < random_args::case_generator(seed, b).next_u64();
+                };
+                std::nth_element(indices.begin(), indices.begin() + max_error_cases, indices.end(), order);
+            }
+            else {
+                std::nth_element(indices.begin(), indices.begin() + max_error_cases, indices.end());
+            }
+            indices.resize(max_error_cases);
+            std::sort(indices.begin(), indices.end());
+        }
+
+
+        /** Serves a request of run_cases_isolated() in a worker process: conducts the requested chunk of cases
+        and encodes their outcome. The other members of the outcome are plain values.
+        @param request The encoded chunk: its begin, its end and whether it is conducted in batches.
+        @param[out] out_reply The encoded outcome.
+        @param progress Receives the index of the case that is about to be conducted.
+        */
+        void serve_isolated(const std::string& request, std::string& out_reply, std::atomic<unsigned int>& progress) {
+            process_isolation::message_reader in(request);
+            const auto begin = in.get<unsigned int>();
+            const auto end = in.get<unsigned int>();
+            const auto is_batching = in.get<bool>();
+
+            RangeResultType range;
+            std::vector<unsigned int> error_indices;
+            run_isolated_task(begin, end, is_batching, range, error_indices, &progress);
+
+            const TestReturnType& r = range.result;
+            process_isolation::message_writer(out_reply)
+                .put(range.begin).put(range.end).put(range.is_aborted).put_string(range.exception_description)
+                .put(r.n_tests).put(r.n_passed_tests).put(r.n_cached_reference_results)
+                .put(r.accumulated_invocation_durations.count()).put(r.reference_accumulated_invocation_durations.count())
+                .put(r.accumulated_counters).put(r.reference_accumulated_counters)
+                .put(r.allocations).put(r.reference_allocations)
+                .put(r.log_speedup_stats).put(r.invocation_duration_ns_stats).put(r.reference_invocation_duration_ns_stats)
+                .put(r.invocation_duration_ns_histogram).put(r.reference_invocation_duration_ns_histogram)
+                .put_array(r.speedup_ratios.data(), r.speedup_ratios.size())
+                .put_array(error_indices.data(), error_indices.size())
+                .put(static_cast<std::uint64_t>(r.timed_out_cases.size()));
+            for (const auto& tc : r.timed_out_cases) {
+                process_isolation::message_writer(out_reply).put(tc.case_index).put(tc.duration.count()).put_string(tc.args);
+            }
+        }
+
+
+        /** Decodes the outcome of a chunk of cases from serve_isolated().
+        @param reply The encoded outcome.
+        @param[out] out_range The outcome of the conducted test cases, without error cases.
+        @param[out] out_error_indices The indices of the failed cases.
+        @return False if the reply is malformed.
+        */
+        static bool decode_isolated_outcome(const std::string& reply, RangeResultType& out_range, std::vector<unsigned int>& out_error_indices) {
+            process_isolation::message_reader in(reply);
+            TestReturnType& r = out_range.result;
+            out_range.begin = in.get<unsigned int>();
+            out_range.end = in.get<unsigned int>();
+            out_range.is_aborted = in.get<bool>();
+            out_range.exception_description = in.get_string();
+            r.n_tests = in.get<unsigned int>();
+            r.n_passed_tests = in.get<unsigned int>();
+            r.n_cached_reference_results = in.get<unsigned int>();
+            r.accumulated_invocation_durations = DurationType(in.get<typename DurationType::rep>());
+            r.reference_accumulated_invocation_durations = DurationType(in.get<typename DurationType::rep>());
+            r.accumulated_counters = in.get<perf_counters::counts>();
+            r.reference_accumulated_counters = in.get<perf_counters::counts>();
+            r.allocations = in.get<alloc_tracker::counts>();
+            r.reference_allocations = in.get<alloc_tracker::counts>();
+            r.log_speedup_stats = in.get<timing::running_stats>();
+            r.invocation_duration_ns_stats = in.get<timing::running_stats>();
+            r.reference_invocation_duration_ns_stats = in.get<timing::running_stats>();
+            r.invocation_duration_ns_histogram = in.get<timing::log_histogram>();
+            r.reference_invocation_duration_ns_histogram = in.get<timing::log_histogram>();
+            in.get_array(r.speedup_ratios);
+            in.get_array(out_error_indices);
+            const auto n_timed_out_cases = in.get<std::uint64_t>();
+            for (std::uint64_t i = 0; i < n_timed_out_cases && in.is_valid(); ++i) {
+                TimedOutCaseType tc;
+                tc.case_index = in.get<unsigned int>();
+                tc.duration = DurationType(in.get<typename DurationType::rep>());
+                tc.args = in.get_string();
+                r.timed_out_cases.push_back(std::move(tc));
+            }
+            return in.is_valid();
+        }
+
+
+        /// Returns the arguments of the given test case, as converted by the args-to-string function.
+        std::string describe_args(const unsigned int case_index) const {
+            std::shared_ptr<arena> args_arena;
+            if (use_arena) {
+                args_arena = std::make_shared<arena>(arena_block_size);
+            }
+            const arena::scope arena_scope(args_arena.get());
+
+            const ArgsTupleType arg_tuple = create_args(case_index);
+            const std::string ret = args_to_string_function_(arg_tuple);
+            delete_args(arg_tuple);
+            return ret;
+        }
+
+
+        /** Adds the measurements of a single case, or batch, to the given test result.
+        @param[in,out] ret The test result.
+        @param reference_sample The measurements of the reference function.
+        @param sample The measurements of the function.
+        @param n_invocations The number of invocations of each function within the samples.
+        */
+        void add_samples(TestReturnType& ret, const SampleType& reference_sample, const SampleType& sample, const unsigned int n_invocations = 1) const {
+            const double ns = static_cast<double>(sample.duration.count()) / n_invocations;
+            const double reference_ns = static_cast<double>(reference_sample.duration.count()) / n_invocations;
+            ret.invocation_duration_ns_stats.add(ns);
+            ret.reference_invocation_duration_ns_stats.add(reference_ns);
+            ret.invocation_duration_ns_histogram.add(ns);
+            ret.reference_invocation_duration_ns_histogram.add(reference_ns);
+
+            ret.accumulated_invocation_durations += sample.duration;
+            ret.reference_accumulated_invocation_durations += reference_sample.duration;
+            ret.accumulated_counters += sample.counts;
+            ret.reference_accumulated_counters += reference_sample.counts;
+            ret.allocations += sample.allocations;
+            ret.reference_allocations += reference_sample.allocations;
+            add_speedup(ret, reference_sample.duration, sample.duration);
+        }
+
+
+        /** Adds the speedup of a single case to the speedup statistics of the given test result.
+        Durations below the clock resolution are counted as 1 ns.
+        @param[in,out] ret The test result.
+        @param reference_dur The invocation duration of the reference function.
+        @param dur The invocation duration of the function.
+        */
+        void add_speedup(TestReturnType& ret, const DurationType reference_dur, const DurationType dur) const {
+            const double ratio = std::max<double>(reference_dur.count(), 1.0) / std::max<double>(dur.count(), 1.0);
+            ret.log_speedup_stats.add(std::log(ratio));
+            if (record_speedup_ratios) {
+                ret.speedup_ratios.push_back(static_cast<float>(ratio));
+            }
+        }
+
+
+        /** Adds an error case to the given test result if error_policy keeps it and writes it
+        to the error case file under error_case_policy::STREAM.
+        The test result owns the error cases that it keeps, the others are deleted.
+        @param[in,out] ret The test result.
+        @param error_case The error case.
+        @return Whether the error case was kept.
+        */
+        bool add_error_case(TestReturnType& ret, ErrorCaseType&& error_case) {
+            if (isolation_error_indices_) {
+                // in a worker process, the calling process re-creates the error case if error_policy keeps it.
+                // The file is flushed right away, since the worker may crash before it ends
+                if (error_case_file_) {
+                    write_error_case(error_case, true);
+                }
+                isolation_error_indices_->push_back(error_case.case_index);
+                delete_error_case(error_case);
+                return false;
+            }
+            if (error_case_file_) {
+                write_error_case(error_case);
+            }
+
+            auto& ecs = ret.error_cases;
+            if (error_policy == error_case_policy::KEEP_ALL || ecs.size() < max_error_cases) {
+                ecs.push_back(std::move(error_case));
+                if (error_policy == error_case_policy::RESERVOIR) {
+                    std::push_heap(ecs.begin(), ecs.end(), reservoir_order());
+                }
+                return true;
+            }
+            if (error_policy == error_case_policy::RESERVOIR && !ecs.empty() && reservoir_order()(error_case, ecs.front())) {
+                std::pop_heap(ecs.begin(), ecs.end(), reservoir_order());
+                delete_error_case(ecs.back());
+                ecs.back() = std::move(error_case);
+                std::push_heap(ecs.begin(), ecs.end(), reservoir_order());
+                return true;
+            }
+            delete_error_case(error_case);
+            return false;
+        }
+
+
+        /** Returns the order of the error cases under error_case_policy::RESERVOIR:
+        by a hash of the case index, so that keeping the max_error_cases first ones yields a uniform sample.
+        */
+        auto reservoir_order() const {
+            return [seed = reservoir_seed](const ErrorCaseType& a, const ErrorCaseType& b) {
+                return random_args::case_generator(seed, a.case_index).next_u64() < random_args::case_generator(seed, b.case_index).next_u64();
+            };
+        }
+
+
+        /// Calls the deleters on the results and the arguments of the given error case.
+        void delete_error_case(const ErrorCaseType& error_case) const {
+            delete_result(error_case.erroneous_result);
+            delete_result(error_case.reference_result);
+            delete_args(error_case.args);
+        }
+
+
+        /// Writes the description of the comparator of how the results of the given error case differ, if it has one.
+        void write_mismatch(std::ostream& os, const ErrorCaseType& error_case) const {
+            const std::string mismatch = default_functions::describe_mismatch(comp_, error_case.erroneous_result, error_case.reference_result);
+            if (!mismatch.empty()) {
+                os << "   mismatch:            " << mismatch << "\n";
+            }
+        }
+
+
+        /** Writes the given error case to the error case file.
+        @param error_case The error case.
+        @param is_flushed Whether the file is flushed right after the error case.
+        */
+        void write_error_case(const ErrorCaseType& error_case, const bool is_flushed = false) const {
+            std::stringstream ss;
+            ss <<
+                " ERROR CASE (case index " << error_case.case_index << "):\n"
+                "   wrong result:        " << result_to_string_function_(error_case.erroneous_result) << "\n"
+                "   reference result:    " << result_to_string_function_(error_case.reference_result) << "\n";
+            write_mismatch(ss, error_case);
+            ss <<
+                "   args:                " << args_to_string_function_(error_case.args) << "\n"
+                " .\n";
+
+            const std::lock_guard<std::mutex> lock(error_case_file_->mutex);
+            error_case_file_->file << ss.str();
+            if (is_flushed) {
+                error_case_file_->file.flush();
+            }
+        }
+
+
+        /** Adds the counters, durations and error cases of a test result of later cases to another test result.
+        Error cases which error_policy does not keep in the merged test result are deleted.
+        @param[in,out] into The test result of the earlier cases.
+        @param from The test result of the later cases.
+        */
+        void merge_into(TestReturnType& into, TestReturnType&& from) const {
+            into.n_tests += from.n_tests;
+            into.n_passed_tests += from.n_passed_tests;
+            into.n_cached_reference_results += from.n_cached_reference_results;
+            into.accumulated_invocation_durations += from.accumulated_invocation_durations;
+            into.reference_accumulated_invocation_durations += from.reference_accumulated_invocation_durations;
+            into.accumulated_counters += from.accumulated_counters;
+            into.reference_accumulated_counters += from.reference_accumulated_counters;
+            into.allocations += from.allocations;
+            into.reference_allocations += from.reference_allocations;
+            into.log_speedup_stats.merge(from.log_speedup_stats);
+            into.invocation_duration_ns_stats.merge(from.invocation_duration_ns_stats);
+            into.reference_invocation_duration_ns_stats.merge(from.reference_invocation_duration_ns_stats);
+            into.invocation_duration_ns_histogram.merge(from.invocation_duration_ns_histogram);
+            into.reference_invocation_duration_ns_histogram.merge(from.reference_invocation_duration_ns_histogram);
+            std::move(from.speedup_ratios.begin(), from.speedup_ratios.end(), std::back_inserter(into.speedup_ratios));
+            std::move(from.error_cases.begin(), from.error_cases.end(), std::back_inserter(into.error_cases));
+            std::move(from.arenas.begin(), from.arenas.end(), std::back_inserter(into.arenas));
+            std::move(from.crashed_cases.begin(), from.crashed_cases.end(), std::back_inserter(into.crashed_cases));
+            std::move(from.timed_out_cases.begin(), from.timed_out_cases.end(), std::back_inserter(into.timed_out_cases));
+
+            auto& ecs = into.error_cases;
+            if (error_policy == error_case_policy::KEEP_ALL || ecs.size() <= max_error_cases) {
+                if (error_policy == error_case_policy::RESERVOIR) {
+                    std::make_heap(ecs.begin(), ecs.end(), reservoir_order());
+                }
+                return;
+            }
+            if (error_policy == error_case_policy::RESERVOIR) {
+                std::nth_element(ecs.begin(), ecs.begin() + max_error_cases, ecs.end(), reservoir_order());
+            }
+            for (auto it = ecs.begin() + max_error_cases; it != ecs.end(); ++it) {
+                delete_error_case(*it);
+            }
+            ecs.erase(ecs.begin() + max_error_cases, ecs.end());
+            if (error_policy == error_case_policy::RESERVOIR) {
+                std::make_heap(ecs.begin(), ecs.end(), reservoir_order());
+            }
+        }
+
+
+        /// Calls the argument deleter on the given argument tuple unless use_arena or a corpus is set.
+        void delete_args(const ArgsTupleType& arg_tuple) const {
+            if (!use_arena && !corpus_) {
+                args_deleter_(arg_tuple);
+            }
+        }
+
+
+        /** Conducts the cases [begin, begin + n) of a single thread of a stress series, see test_stress().
+        Creates the arguments and the reference results, waits until all threads are ready,
+        invokes the function on all cases and then compares the results.
+        @param begin The index of the first case of the thread.
+        @param n The number of cases of the thread.
+        @param n_threads The number of threads that invoke the function at the same time.
+        @param n_ready The number of threads that are ready to invoke the function.
+        @param[out] out_thread The cases, results and outcome of the thread.
+        */
+        void run_stress_thread(const unsigned int begin, const unsigned int n, const unsigned int n_threads, std::atomic<unsigned int>& n_ready, StressThreadType& out_thread) const {
+            auto& t = out_thread;
+            if (use_arena) {
+                t.cases_arena = std::make_shared<arena>(arena_block_size);
+            }
+            const arena::scope arena_scope(t.cases_arena.get());
+
+            unsigned int i = begin;
+            const auto describe_exception = [&t, &i]() {
+                std::stringstream ss;
+                try {
+                    throw;
+                }
+                catch (std::exception& ex) {
+                    ss << "EXCEPTION\n" << typeid(ex).name() << ":\n" << ex.what() << "\n";
+                }
+                catch (...) {
+                    ss << "EXCEPTION\nunknown\n";
+                }
+                ss << "Case index: " << i << "\n";
+                t.outcome.exception_description = ss.str();
+                t.outcome.is_aborted = true;
+            };
+
+            try {
+                t.args.reserve(n);
+                t.reference_results.reserve(n);
+                t.results.reserve(n);     // no reallocations while the function is invoked
+                for (; i < begin + n; ++i) {
+                    t.args.push_back(args_creator_(i));
+                    t.reference_results.push_back(tuple_call::call(reference_fun_, t.args.back()));
+                }
+            }
+            catch (...) {
+                describe_exception();
+            }
+
+            // all threads begin to invoke the function at the same time
+            n_ready.fetch_add(1);
+            while (n_ready.load() < n_threads) {
+                std::this_thread::yield();
+            }
+
+            t.start = std::chrono::steady_clock::now();
+            if (!t.outcome.is_aborted) {
+                try {
+                    for (i = begin; i < begin + n; ++i) {
+                        t.results.push_back(tuple_call::call(fun_, t.args[i - begin]));
+                    }
+                }
+                catch (...) {
+                    describe_exception();
+                }
+            }
+            t.end = std::chrono::steady_clock::now();
+
+            bool is_error_case_kept = false;
+            t.outcome.n_tests = static_cast<unsigned int>(t.results.size());
+            for (std::size_t j = 0; j < t.results.size(); ++j) {
+                if (comp_(t.results[j], t.reference_results[j])) {
+                    ++t.outcome.n_passed_tests;
+                    delete_result(t.results[j]);
+                    delete_result(t.reference_results[j]);
+                    delete_args(t.args[j]);
+                }
+                else if (t.outcome.error_cases.size() < max_error_cases) {
+                    t.outcome.error_cases.push_back(ErrorCaseType{ std::move(t.results[j]), std::move(t.reference_results[j]), std::move(t.args[j]), begin + static_cast<unsigned int>(j) });
+                    is_error_case_kept = true;
+                }
+                else {
+                    delete_result(t.results[j]);
+                    delete_result(t.reference_results[j]);
+                    delete_args(t.args[j]);
+                }
+            }
+            // the cases after an exception
+            for (std::size_t j = t.results.size(); j < t.reference_results.size(); ++j) {
+                delete_result(t.reference_results[j]);
+            }
+            for (std::size_t j = t.results.size(); j < t.args.size(); ++j) {
+                delete_args(t.args[j]);
+            }
+            release_arena(is_error_case_kept);
+        }
+
+
+        /** Returns the given result, moved if it is an rvalue and copied otherwise.
+        Move-only results are never lvalues here, since they are never cached, see set_reference_cache().
+        */
+        template <typename R>
+        static ResultType take_result(R&& result) {
+            if constexpr (!std::is_lvalue_reference<R>::value || std::is_copy_constructible<ResultType>::value) {
+                return std::forward<R>(result);
+            }
+            else {
+                return ResultType();
+            }
+        }
+
+
+        /// Calls the result deleter on the given result unless use_arena is set.
+        void delete_result(const ResultType& result) const {
+            if (!use_arena) {
+                result_deleter_(result);
+            }
+        }
+
+
+        /** Ends the lifetime of the memory that the current case or batch allocated
+        from the current arena, unless it belongs to error cases. Does nothing unless use_arena is set.
+        @param has_error_cases Whether the current case or batch has error cases.
+        If so, the memory is pinned instead of rewound.
+        */
+        void release_arena(const bool has_error_cases) const {
+            if (!use_arena) {
+                return;
+            }
+            if (has_error_cases) {
+                arena::current()->pin();
+            }
+            else {
+                arena::current()->reset();
+            }
+        }
+
+
+        /** Calls the given function f with the parameters found in the given tuple and,
+        if f returns a value, also returns this value.
+        @param f A function.
+        @param t A tuple containing the parameters for the invocation of f.
+        If f takes no arguments, pass std::tuple<>().
+        @param[out] out_duration A reference to a duration object to which the execution time
+        of the function will be written.
+        @return Returns the return value of f.
+        If f's result type would be void, the return type of this function would also be void.
+        */
+        template <typename F, typename Tuple>
+        constexpr auto call(F&& f, Tuple&& t, DurationType& out_duration) const {
+            return tuple_call::call(std::forward<F>(f), std::forward<Tuple>(t), out_duration);
+        }
+
+
+        /** Invokes the given function and measures the invocation with the clock and the given instruments.
+        The hardware counters and the allocation tracker enclose the timed region.
+        @param invoke A function without parameters, e.g. a lambda that calls the function under test.
+        @param instruments The instruments of the calling thread.
+        @param[out] out_sample The measurements.
+        @return Returns the return value of invoke.
+        */
+        template <typename F>
+        auto measure(F&& invoke, const InstrumentsType& instruments, SampleType& out_sample) const {
+            using namespace std::chrono;
+
+            const auto counters_start = instruments.counters ? instruments.counters->read() : perf_counters::counter_group::snapshot();
+            const auto allocations_start = instruments.is_tracking_allocations ? alloc_tracker::start() : alloc_tracker::snapshot();
+            const auto clock_start = steady_clock::now();
+
+            const auto finish = [&]() {
+                out_sample.duration = duration_cast<DurationType>(steady_clock::now() - clock_start);
+                if (instruments.is_tracking_allocations) {
+                    out_sample.allocations = alloc_tracker::stop(allocations_start);
+                }
+                if (instruments.counters) {
+                    out_sample.counts = instruments.counters->difference(counters_start, instruments.counters->read());
+                }
+            };
+
+            if constexpr (std::is_void<decltype(invoke())>::value) {
+                invoke();
+                finish();
+            }
+            else {
+                auto ret = invoke();
+                finish();
+                return ret;
+            }
+        }
+
+
+        /** Returns the median invocation duration of a function on the given arguments over n_repetitions samples.
+        Each sample times as many invocations as take about 10 us, estimated from the given duration of a single one.
+        The results are deleted right away.
+        @param f The function.
+        @param arg_tuple The arguments.
+        @param single_duration The duration of a single invocation.
+        @param n_repetitions The number of samples.
+        @return The median duration per invocation in ns.
+        */
+        template <typename F>
+        double median_invocation_ns(F& f, const ArgsTupleType& arg_tuple, const DurationType single_duration, const unsigned int n_repetitions) const {
+            using namespace std::chrono;
+
+            const double single_ns = std::max<double>(static_cast<double>(single_duration.count()), 1.0);
+            const auto n_invocations = static_cast<unsigned int>(std::min(std::ceil(10000.0 / single_ns), 1e6));
+
+            std::vector<double> samples;
+            for (unsigned int r = 0; r < std::max(n_repetitions, 1u); ++r) {
+                const auto clock_start = steady_clock::now();
+                for (unsigned int k = 0; k < n_invocations; ++k) {
+                    const auto result = tuple_call::call(f, arg_tuple);
+                    timing::do_not_optimize(result);
+                    delete_result(result);
+                }
+                samples.push_back(static_cast<double>(duration_cast<DurationType>(steady_clock::now() - clock_start).count()) / n_invocations);
+            }
+            std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            return samples[samples.size() / 2];
+        }
+
+
+        /** Reports a message if the given verbosity level is equal or smaller than the verbosity_level member value.
+        The message is not formatted otherwise.
+        @param message_verbosity_level The verbosity level of the message.
+        @param format A function void(std::ostream&) that formats the message.
+        The reporter may call it later on another thread, but not after the next reporter flush.
+        */
+        template <typename F>
+        void log(const verbosity message_verbosity_level, F&& format) const {
+            if (verbosity_level >= message_verbosity_level) {
+                reporter_->report(deferred_message(std::forward<F>(format)));
+            }
+        }
+
+    }; // END class BasicRandomizedFunctionTest
+
+
+    /** RandomizedFunctionTest unit testing class wich is capable of invoking
+    arbitrary functions with a return value and comparing them to results of reference functions.
+    Measures the run-time of the function and writes unit test results to a stream.
+    For proper functioning, this class relies on default construction and move assignment
+    of the result types and the argument types. The results and the arguments of failed cases are
+    moved into their error cases. Only cached reference results and arguments from a corpus are copied,
+    so that move-only results like std::unique_ptr can be tested without a reference cache.
+    Stores all callables as std::function objects. For callables that can be inlined,
+    see BasicRandomizedFunctionTest and create_randomized_function_test().
+    @tparam ResultType Return type of the given function.
+    @tparam ArgTypes Argument types of the given function.
+    */
+    template< typename ResultType, typename... ArgTypes>
+    class RandomizedFunctionTest : public BasicRandomizedFunctionTest<
+        const std::function<ResultType(ArgTypes...)>,
+        const std::function<ResultType(ArgTypes...)>,
+        const std::function<std::tuple<ArgTypes...>(const unsigned int)>,
+        const std::function<bool(const ResultType&, const ResultType&)>,
+        const std::function<std::string(const std::tuple<ArgTypes...>&)>,
+        const std::function<std::string(const ResultType&)>,
+        const std::function<void(const std::tuple<ArgTypes...>&)>,
+        const std::function<void(const ResultType&)>,
+        ResultType,
+        ArgTypes...> {
+
+    public: // types
+
+        using BaseType = BasicRandomizedFunctionTest<
+            const std::function<ResultType(ArgTypes...)>,
+            const std::function<ResultType(ArgTypes...)>,
+            const std::function<std::tuple<ArgTypes...>(const unsigned int)>,
+            const std::function<bool(const ResultType&, const ResultType&)>,
+            const std::function<std::string(const std::tuple<ArgTypes...>&)>,
+            const std::function<std::string(const ResultType&)>,
+            const std::function<void(const std::tuple<ArgTypes...>&)>,
+            const std::function<void(const ResultType&)>,
+            ResultType,
+            ArgTypes...>;
+
+        using typename BaseType::ArgsTupleType;
+        using typename BaseType::FunctionType;
+        using typename BaseType::ComparatorFunctionType;
+        using typename BaseType::ArgsCreatorFunctionType;
+        using typename BaseType::ArgsDeleterFunctionType;
+        using typename BaseType::ResultDeleterFunctionType;
+        using typename BaseType::ArgsToStringFunctionType;
+        using typename BaseType::ResultToStringFunctionType;
+
+    public: // constructors
+
+        /** Constructor for the randomized function tester.
+        See BasicRandomizedFunctionTest::BasicRandomizedFunctionTest() for details.
+        @param function A function that must return a value.
+        @param reference_function A reference function with the same interface as the given function.
+        @param argument_creator A function of type RandomizedFunctionTest::ArgsTupleType(unsigned int)
+        that produces a tuple of function invocation arguments for the case with the given index.
+        @param result_comparator A comparison function for the result types. Defaults to '='.
+        @param args_to_string_function A to-string function for the argument-tuples.
+        Defaults to a standard tuple unpacking and stream-out-created
+        string for each tuple element. This may not work for arguments
+        for which no stream out operation << can be found.
+        @param result_to_string_function A to-string function for the return values
+        of function and reference_function.
+        Defaults to default_functions::stream_to_string, see formatting::to_string().
+        This may not work for return types for which no stream out operation << can be found.
+        @param argument_deleter Custom deleter for argument tuples. Defaults to a null operation, i.e. { return; }.
+        @param result_deleter Custom deleter for return values. Defaults to a null operation, i.e. { return; }.
+        @param os An ostream to which the output is streamed. Defaults to std::cout.
+        */
+        RandomizedFunctionTest(
+            FunctionType function,
+            FunctionType reference_function,
+            ArgsCreatorFunctionType argument_creator,
+            ComparatorFunctionType result_comparator = default_functions::equal_to(),
+            ArgsToStringFunctionType args_to_string_function = default_functions::tuple_to_string(),
+            ResultToStringFunctionType result_to_string_function = default_functions::stream_to_string(),
+            ArgsDeleterFunctionType argument_deleter = default_functions::no_op(),
+            ResultDeleterFunctionType result_deleter = default_functions::no_op(),
+            std::ostream& os = std::cout)
+            :
+            BaseType(
+                function,
+                reference_function,
+                argument_creator,
+                result_comparator,
+                args_to_string_function,
+                result_to_string_function,
+                argument_deleter,
+                result_deleter,
+                os)
+        {}
+
+    }; // END class RandomizedFunctionTest
+
+
+    /// Implementation details, clients never use these directly.
+    namespace detail {
+
+        /// Unpacks the argument tuple type into the argument types of BasicRandomizedFunctionTest.
+        template <typename ResultType, typename ArgsTuple, typename... Callables>
+        struct basic_randomized_function_test_for;
+
+        /// Unpacks the argument tuple type into the argument types of BasicRandomizedFunctionTest.
+        template <typename ResultType, typename... ArgTypes, typename... Callables>
+        struct basic_randomized_function_test_for<ResultType, std::tuple<ArgTypes...>, Callables...> {
+            using type = BasicRandomizedFunctionTest<Callables..., ResultType, ArgTypes...>;
+        };
+
+    } // END namespace detail
+
+
+    /** Helper function that creates a BasicRandomizedFunctionTest object which stores
+    the given callables by value, so that calls to them can be inlined.
+    The argument types are deduced from the return type of the argument creator,
+    the result type is deduced from the return type of the function.
+    @param function The function to be tested.
+    @param reference_function The reference function.
+    @param argument_creator A function of the form std::tuple<ArgTypes...>(unsigned int).
+    @param result_comparator A comparison function for the result types. Defaults to '='.
+    @param args_to_string_function A to-string function for the argument-tuples.
+    Defaults to default_functions::tuple_to_string.
+    @param result_to_string_function A to-string function for the return values.
+    Defaults to default_functions::stream_to_string.
+    @param argument_deleter Custom deleter for argument tuples. Defaults to a null operation.
+    @param result_deleter Custom deleter for return values. Defaults to a null operation.
+    @param os An ostream to which the output is streamed. Defaults to std::cout.
+    @return A BasicRandomizedFunctionTest object on the given callables.
+    */
+    template<
+        typename F,
+        typename RF,
+        typename AC,
+        typename C = default_functions::equal_to,
+        typename ATS = default_functions::tuple_to_string,
+        typename RTS = default_functions::stream_to_string,
+        typename AD = default_functions::no_op,
+        typename RD = default_functions::no_op>
+    auto create_randomized_function_test(
+        F function,
+        RF reference_function,
+        AC argument_creator,
+        C result_comparator = C(),
+        ATS args_to_string_function = ATS(),
+        RTS result_to_string_function = RTS(),
+        AD argument_deleter = AD(),
+        RD result_deleter = RD(),
+        std::ostream& os = std::cout)
+    {
+        using ArgsTupleType = typename std::decay<decltype(argument_creator(0u))>::type;
+        using ResultType = typename std::decay<decltype(tuple_call::call(function, std::declval<const ArgsTupleType&>()))>::type;
+        using TesterType = typename detail::basic_randomized_function_test_for<ResultType, ArgsTupleType, F, RF, AC, C, ATS, RTS, AD, RD>::type;
+
+        return TesterType(
+            function,
+            reference_function,
+            argument_creator,
+            result_comparator,
+            args_to_string_function,
+            result_to_string_function,
+            argument_deleter,
+            result_deleter,
+            os);
+    }
+
+} // END namespace unittest
@@ -0,0 +1,246 @@
+/******************************************************************************
+/* @file Contains tools to count the heap allocations of the calling thread:
+/*       allocations, deallocations, allocated and deallocated bytes and the
+/*       peak of the live bytes within a measurement.
+/*
+/* The counting happens in replacements of the global operators new and delete.
+/* Since a program may replace them only once, they are only defined if
+/* UNITTEST_ALLOC_TRACKER_IMPLEMENTATION is defined. Define it in exactly one
+/* translation unit, before any header of this package is included:
+###################################################################################################
+
+#define UNITTEST_ALLOC_TRACKER_IMPLEMENTATION
+#include <barn_test/RandomizedFunctionTest.hpp>
+
+using namespace unittest;
+
+const auto start = alloc_tracker::start();
+fun(3, 4);
+const auto allocations = alloc_tracker::stop(start);
+// allocations.n_allocations, allocations.n_bytes_allocated, allocations.peak_live_bytes, ...
+
+###################################################################################################
+/*
+/* Without the replacements, is_installed() returns false and all counts are 0.
+/* Memory that is allocated with malloc() directly is not counted.
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace alloc_tracker {
+
+        /// Heap allocation counts of a measurement, or accumulated over several measurements.
+        struct counts {
+            unsigned long long n_allocations        = 0;    ///< The number of allocations.
+            unsigned long long n_deallocations      = 0;    ///< The number of deallocations.
+            unsigned long long n_bytes_allocated    = 0;    ///< The number of allocated bytes.
+            unsigned long long n_bytes_deallocated  = 0;    ///< The number of deallocated bytes.
+            unsigned long long peak_live_bytes      = 0;    ///< The maximum of the allocated but not yet deallocated bytes,
+                                                            ///< relative to the start of the measurement. The maximum over all measurements if accumulated.
+
+            /// Adds the counts of another measurement. Takes the maximum of the peaks.
+            counts& operator+=(const counts& other) {
+                n_allocations += other.n_allocations;
+                n_deallocations += other.n_deallocations;
+                n_bytes_allocated += other.n_bytes_allocated;
+                n_bytes_deallocated += other.n_bytes_deallocated;
+                if (other.peak_live_bytes > peak_live_bytes) {
+                    peak_live_bytes = other.peak_live_bytes;
+                }
+                return *this;
+            }
+        };
+
+
+        /// The state of the calling thread at the start of a measurement.
+        struct snapshot {
+            counts at_start;                    ///< The counters of the thread.
+            long long live_bytes = 0;           ///< The live bytes of the thread.
+            long long peak_live_bytes = 0;      ///< The peak of the live bytes of an enclosing measurement.
+        };
+
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// The counters of a thread.
+            struct thread_state {
+                counts totals;                  ///< The counters since the start of the thread. peak_live_bytes is not used.
+                long long live_bytes;           ///< The bytes allocated minus the bytes deallocated by the thread.
+                long long peak_live_bytes;      ///< The maximum of live_bytes since the start of the current measurement.
+            };
+
+            /// The bookkeeping in front of each allocated block of memory.
+            struct header {
+                void* raw;                      ///< The pointer returned by malloc().
+                std::size_t size;               ///< The requested size.
+            };
+
+            /// Returns the counters of the calling thread.
+            inline thread_state& state() {
+                static thread_local thread_state s = { counts(), 0, 0 };
+                return s;
+            }
+
+            /// Returns the flag which tells whether the replacements of new and delete are installed.
+            inline bool& is_installed_flag() {
+                static bool is_installed = false;
+                return is_installed;
+            }
+
+            /** Allocates memory and counts it for the calling thread.
+            @param size The number of bytes.
+            @param alignment The alignment. Must be a power of two.
+            @return The memory, or nullptr if malloc() fails.
+            */
+            inline void* allocate(const std::size_t size, std::size_t alignment) noexcept {
+                if (alignment < alignof(std::max_align_t)) {
+                    alignment = alignof(std::max_align_t);
+                }
+                void* raw = std::malloc(size + sizeof(header) + alignment);
+                if (!raw) {
+                    return nullptr;
+                }
+                const auto user = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(header) + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+                header* h = reinterpret_cast<header*>(user) - 1;
+                h->raw = raw;
+                h->size = size;
+
+                auto& s = state();
+                ++s.totals.n_allocations;
+                s.totals.n_bytes_allocated += size;
+                s.live_bytes += static_cast<long long>(size);
+                if (s.live_bytes > s.peak_live_bytes) {
+                    s.peak_live_bytes = s.live_bytes;
+                }
+                return reinterpret_cast<void*>(user);
+            }
+
+            /// Deallocates memory of allocate() and counts it for the calling thread.
+            inline void deallocate(void* p) noexcept {
+                if (!p) {
+                    return;
+                }
+                const header* h = static_cast<header*>(p) - 1;
+
+                auto& s = state();
+                ++s.totals.n_deallocations;
+                s.totals.n_bytes_deallocated += h->size;
+                s.live_bytes -= static_cast<long long>(h->size);
+
+                std::free(h->raw);
+            }
+
+            /// Allocates memory like the global operator new: calls the new handler until it succeeds or throws std::bad_alloc.
+            inline void* allocate_or_throw(const std::size_t size, const std::size_t alignment) {
+                for (;;) {
+                    if (void* p = allocate(size, alignment)) {
+                        return p;
+                    }
+                    const auto handler = std::get_new_handler();
+                    if (!handler) {
+                        throw std::bad_alloc();
+                    }
+                    handler();
+                }
+            }
+
+        } // END namespace detail
+
+
+        /// Indicates whether the counting replacements of new and delete are installed, see UNITTEST_ALLOC_TRACKER_IMPLEMENTATION.
+        inline bool is_installed() {
+            return detail::is_installed_flag();
+        }
+
+
+        /** Starts a measurement of the allocations of the calling thread.
+        Measurements can be nested.
+        @return The state at the start, to be passed to stop().
+        */
+        inline snapshot start() {
+            auto& s = detail::state();
+            snapshot ret;
+            ret.at_start = s.totals;
+            ret.live_bytes = s.live_bytes;
+            ret.peak_live_bytes = s.peak_live_bytes;
+            s.peak_live_bytes = s.live_bytes;
+            return ret;
+        }
+
+
+        /** Ends a measurement of the allocations of the calling thread.
+        @param start The state at the start of the measurement.
+        @return The allocation counts since start().
+        */
+        inline counts stop(const snapshot& start) {
+            auto& s = detail::state();
+            counts ret;
+            ret.n_allocations = s.totals.n_allocations - start.at_start.n_allocations;
+            ret.n_deallocations = s.totals.n_deallocations - start.at_start.n_deallocations;
+            ret.n_bytes_allocated = s.totals.n_bytes_allocated - start.at_start.n_bytes_allocated;
+            ret.n_bytes_deallocated = s.totals.n_bytes_deallocated - start.at_start.n_bytes_deallocated;
+            ret.peak_live_bytes = s.peak_live_bytes > start.live_bytes ? static_cast<unsigned long long>(s.peak_live_bytes - start.live_bytes) : 0;
+
+            // continue the peak of an enclosing measurement
+            if (start.peak_live_bytes > s.peak_live_bytes) {
+                s.peak_live_bytes = start.peak_live_bytes;
+            }
+            return ret;
+        }
+
+    } // END namespace alloc_tracker
+
+} // END namespace unittest
+
+
+#if defined(UNITTEST_ALLOC_TRACKER_IMPLEMENTATION)
+
+///////////////////////////////////////////////////////////////////////////////
+// REPLACEMENTS OF THE GLOBAL OPERATORS NEW AND DELETE
+
+namespace {
+
+    /// Sets the installed flag during static initialization.
+    struct alloc_tracker_installer {
+        alloc_tracker_installer() { unittest::alloc_tracker::detail::is_installed_flag() = true; }
+    } alloc_tracker_installer_instance;
+
+} // END namespace
+
+void* operator new(std::size_t size) { return unittest::alloc_tracker::detail::allocate_or_throw(size, 0); }
+void* operator new[](std::size_t size) { return unittest::alloc_tracker::detail::allocate_or_throw(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return unittest::alloc_tracker::detail::allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return unittest::alloc_tracker::detail::allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al) { return unittest::alloc_tracker::detail::allocate_or_throw(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return unittest::alloc_tracker::detail::allocate_or_throw(size, static_cast<std::size_t>(al)); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return unittest::alloc_tracker::detail::allocate(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return unittest::alloc_tracker::detail::allocate(size, static_cast<std::size_t>(al)); }
+
+void operator delete(void* p) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete[](void* p) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { unittest::alloc_tracker::detail::deallocate(p); }
+
+#endif
@@ -0,0 +1,230 @@
+/******************************************************************************
+/* @file Contains class arena, a monotonic allocator for the arguments and
+/*       results of randomized tests.
+/*
+/* Allocation is a pointer bump in a list of blocks. Resetting rewinds the
+/* pointer in O(1) and reuses the blocks; only objects with non-trivial
+/* destructors cost extra, since their destructors are run on reset.
+/* Pinning keeps everything that has been allocated so far, e.g. the
+/* memory of failed test cases, alive across later resets.
+/*
+/* Functions under test and argument creators reach the arena of the current
+/* thread through arena::current(), which the testers set when use_arena is on:
+###################################################################################################
+
+using namespace unittest;
+
+auto arg_creator = [](unsigned int i) { return std::make_tuple(arena::current()->create<int>(i)); };
+
+int* fun(int* i) { return arena::current()->create<int>(2 * *i); }
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    /** Monotonic allocator with O(1) reset.
+    Not thread-safe; use one arena per thread.
+    */
+    class arena {
+
+    private: // inner classes
+
+        /// A chunk of memory from which allocations are served.
+        struct block {
+            std::unique_ptr<char[]> data;           ///< The memory.
+            std::size_t size;                       ///< The size of the memory in bytes.
+        };
+
+        /// A node of the intrusive list of objects whose destructors are to be run on reset.
+        struct destructor_node {
+            void (*destroy)(void*);                 ///< Calls the destructor of object.
+            void* object;                           ///< The object.
+            destructor_node* next;                  ///< The node of the previously created object.
+        };
+
+        /// A position in the arena.
+        struct position {
+            std::size_t block_index = 0;            ///< The index of the current block.
+            std::size_t offset = 0;                 ///< The number of used bytes in the current block.
+            destructor_node* destructors = nullptr; ///< The most recently created object with a non-trivial destructor.
+        };
+
+    private: // vars
+
+        std::vector<block> blocks_;                 ///< The blocks, in order of use.
+        std::size_t block_size_;                    ///< The size of new blocks, unless an allocation requires more.
+        position top_;                              ///< The position of the next allocation.
+        position pinned_;                           ///< Resets rewind to this position.
+
+    public: // constructors
+
+        /** Constructor for the arena. Does not allocate.
+        @param block_size The size of the blocks of memory which the arena allocates.
+        */
+        explicit arena(const std::size_t block_size = 64 * 1024)
+            :
+            block_size_(block_size)
+        {}
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        /// Destructor. Runs the destructors of all objects that are still alive.
+        ~arena() {
+            destroy_until(nullptr);
+        }
+
+    public: // methods
+
+        /** Allocates uninitialized memory.
+        @param size The number of bytes.
+        @param alignment The alignment of the memory. Must be a power of two.
+        @return A pointer to the memory. Valid until the next reset() that is not preceded by a pin() after this call.
+        */
+        void* allocate(const std::size_t size, const std::size_t alignment = alignof(std::max_align_t)) {
+            for (;;) {
+                if (top_.block_index < blocks_.size()) {
+                    const auto& b = blocks_[top_.block_index];
+                    const auto base = reinterpret_cast<std::uintptr_t>(b.data.get());
+                    const auto aligned = ((base + top_.offset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1)) - base;
+                    if (aligned + size <= b.size) {
+                        top_.offset = aligned + size;
+                        return b.data.get() + aligned;
+                    }
+                    if (top_.block_index + 1 == blocks_.size()) {
+                        add_block(size + alignment);
+                    }
+                    ++top_.block_index;
+                    top_.offset = 0;
+                }
+                else {
+                    add_block(size + alignment);
+                }
+            }
+        }
+
+
+        /** Creates an object in the arena. Its destructor is run on the next reset() or on the destruction of the arena.
+        @param args The constructor arguments.
+        @return A pointer to the new object.
+        */
+        template <typename T, typename... Args>
+        T* create(Args&&... args) {
+            T* ret = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if (!std::is_trivially_destructible<T>::value) {
+                auto node = static_cast<destructor_node*>(allocate(sizeof(destructor_node), alignof(destructor_node)));
+                node->destroy = [](void* object) { static_cast<T*>(object)->~T(); };
+                node->object = ret;
+                node->next = top_.destructors;
+                top_.destructors = node;
+            }
+            return ret;
+        }
+
+
+        /// Rewinds the arena to the last pin() and runs the destructors of the objects created since then. Keeps the blocks.
+        void reset() {
+            destroy_until(pinned_.destructors);
+            top_ = pinned_;
+        }
+
+
+        /// Keeps everything that has been allocated so far alive across subsequent reset() calls.
+        void pin() {
+            pinned_ = top_;
+        }
+
+
+        /// Indicates whether anything has been pinned.
+        bool is_pinned() const {
+            return pinned_.block_index != 0 || pinned_.offset != 0;
+        }
+
+
+        /// Returns the number of bytes in all blocks.
+        std::size_t capacity() const {
+            std::size_t ret = 0;
+            for (const auto& b : blocks_) {
+                ret += b.size;
+            }
+            return ret;
+        }
+
+    public: // static methods
+
+        /// Returns the arena of the calling thread that is set by an arena::scope, or nullptr if there is none.
+        static arena* current() {
+            return current_ref();
+        }
+
+    public: // inner classes
+
+        /// Makes an arena the current arena of the calling thread for the lifetime of the scope object.
+        class scope {
+
+        private: // vars
+
+            arena* previous_;                       ///< The current arena before the scope.
+
+        public: // constructors
+
+            /// Constructor. Makes the given arena, which may be nullptr, the current arena of the calling thread.
+            explicit scope(arena* a)
+                :
+                previous_(current_ref())
+            {
+                current_ref() = a;
+            }
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+            /// Destructor. Restores the previous current arena.
+            ~scope() {
+                current_ref() = previous_;
+            }
+
+        }; // END class scope
+
+    private: // helpers
+
+        /// Returns a reference to the thread-local current arena.
+        static arena*& current_ref() {
+            static thread_local arena* current = nullptr;
+            return current;
+        }
+
+        /// Appends a block of at least the given size.
+        void add_block(const std::size_t min_size) {
+            const auto size = min_size > block_size_ ? min_size : block_size_;
+            blocks_.push_back(block{ std::unique_ptr<char[]>(new char[size]), size });
+        }
+
+        /// Runs the destructors of the objects from the most recently created one down to, but excluding, end.
+        void destroy_until(destructor_node* end) {
+            for (auto node = top_.destructors; node != end; node = node->next) {
+                node->destroy(node->object);
+            }
+            top_.destructors = end;
+        }
+
+    }; // END class arena
+
+} // END namespace unittest
@@ -0,0 +1,15 @@
+/******************************************************************************
+@file The main() of a suite runner: compile and link it together with the
+      translation units that register test series, see registry.hpp.
+
+@author: langenhagen
+@version: 261015
+
+******************************************************************************/
+
+#include <registry.hpp>
+
+
+int main(int argc, char** argv) {
+    return unittest::registry::run_main(argc, argv);
+}
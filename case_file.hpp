@@ -0,0 +1,365 @@
+/******************************************************************************
+/* @file Contains the case files of data-driven function tests: rows of an
+/*       expected result and the arguments that produce it, read from a CSV
+/*       file for editing or from a compact binary file.
+/*
+/* Both are memory-mapped and parsed lazily, case by case, so that files that
+/* are larger than the RAM work as well: the pages of cases that were tested
+/* can be dropped by the operating system. Both are split into chunks that
+/* BasicFunctionTest::test_cases() tests in parallel.
+/*
+/* A CSV row holds the expected result and then the arguments, separated by
+/* commas. Fields may be quoted with "", in which "" stands for ". Quoted
+/* fields must not contain line breaks. Empty lines and lines that begin with
+/* # are skipped. Numbers are parsed with std::from_chars, so that they read
+/* back exactly as they were written with std::to_chars.
+/*
+/* The binary file is a corpus of std::tuple<ResultType, ArgTypes...>, see
+/* corpus.hpp. Cases of trivially copyable types are read in place.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+// golden.csv:
+// expected,x,y
+// 5,2,3
+// -1,2,-3
+
+csv_case_file<int, int, int> golden("golden.csv");
+
+FunctionTest<int, int, int> tester(add);
+tester.n_threads = 8;
+auto r = tester.test_cases("Golden", golden);        // r.n_cases, r.n_passed_cases, r.failed_cases[0].location, ...
+
+// convert once for faster runs
+binary_case_writer<int, int, int> writer("golden.cases");
+convert_case_file(golden, writer);
+writer.close();
+tester.test_cases("Golden binary", binary_case_file<int, int, int>("golden.cases"));
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "corpus.hpp"
+#include "mapped_file.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    /// Writes the cases of a binary_case_file: tuples of the expected result and the arguments.
+    template <typename ResultType, typename... ArgTypes>
+    using binary_case_writer = corpus_writer<std::tuple<ResultType, ArgTypes...>>;
+
+
+    /** The cases of a data-driven function test in a binary file of binary_case_writer.
+    The file is memory-mapped, a case is read, or decoded, only when it is tested. Thread-safe.
+    @tparam ResultType Return type of the function.
+    @tparam ArgTypes Argument types of the function.
+    */
+    template <typename ResultType, typename... ArgTypes>
+    class binary_case_file {
+
+    public: // types
+
+        using CaseTupleType = std::tuple<ResultType, ArgTypes...>;                          ///< The expected result and the arguments.
+        using DecoderType   = typename corpus<CaseTupleType>::DecoderType;                  ///< Re-creates a case from its bytes.
+
+    public: // static vars
+
+        static constexpr std::size_t chunk_size = 4096;     ///< The number of cases per chunk.
+
+    private: // vars
+
+        corpus<CaseTupleType> cases_;                       ///< The cases.
+
+    public: // constructors
+
+        /** Constructor for cases whose types are trivially copyable, which are read in place.
+        The file has no cases if it does not exist or was written for other types.
+        @param path The path of the file.
+        */
+        explicit binary_case_file(const std::string& path) : cases_(path) {}
+
+        /** Constructor for cases that are stored encoded.
+        @param path The path of the file.
+        @param decoder Re-creates a case from the bytes of the encoder of the binary_case_writer.
+        */
+        binary_case_file(const std::string& path, DecoderType decoder) : cases_(path, std::move(decoder)) {}
+
+    public: // methods
+
+        /** Calls on_case(case_id, const CaseTupleType&) for every case of the given chunk, in order.
+        The case id is the index of the case. The cases are never malformed, so on_error is not called.
+        */
+        template <typename F, typename E>
+        void visit_chunk(const std::size_t chunk, F&& on_case, E&&) const {
+            const std::size_t end = std::min(cases_.size(), (chunk + 1) * chunk_size);
+            for (std::size_t i = chunk * chunk_size; i < end; ++i) {
+                cases_.visit(i, [&](const CaseTupleType& c) { on_case(i, c); });
+            }
+        }
+
+
+        /// Describes where the case with the given id is, e.g. "case 17".
+        std::string location(const std::size_t case_id) const {
+            return "case " + std::to_string(case_id);
+        }
+
+    public: // getters
+
+        /// Returns the number of cases.
+        inline std::size_t size() const { return cases_.size(); }
+
+        /// Returns the number of chunks.
+        inline std::size_t n_chunks() const { return (cases_.size() + chunk_size - 1) / chunk_size; }
+
+    }; // END class binary_case_file
+
+
+    /** The cases of a data-driven function test in a CSV file.
+    The file is memory-mapped and split into chunks of bytes; the rows are parsed only when they are tested,
+    so that the number of rows is not known in advance. Thread-safe.
+    The default parser supports numbers, bool as 0, 1, false or true, char and std::string.
+    @tparam ResultType Return type of the function.
+    @tparam ArgTypes Argument types of the function.
+    */
+    template <typename ResultType, typename... ArgTypes>
+    class csv_case_file {
+
+    public: // types
+
+        using CaseTupleType = std::tuple<ResultType, ArgTypes...>;      ///< The expected result and the arguments.
+
+        /** Parses the fields of a row into a case and returns false if they are malformed.
+        Quoted fields come without their enclosing quotes, but with their doubled quotes.
+        */
+        using ParserType = std::function<bool(const std::string_view* fields, std::size_t n_fields, CaseTupleType& out_case)>;
+
+    public: // static vars
+
+        static constexpr std::size_t n_fields = 1 + sizeof...(ArgTypes);   ///< The number of fields of a row.
+        static constexpr std::size_t chunk_size = 256 * 1024;               ///< The number of bytes per chunk.
+
+    private: // vars
+
+        mapped_file file_;                  ///< The mapping of the file.
+        ParserType parser_;                 ///< The parser, or empty for the default one.
+        bool has_header_;                   ///< Whether the first line is a header.
+
+    public: // constructors
+
+        /** Constructor with the default parser. The file has no cases if it does not exist.
+        @param path The path of the file.
+        @param has_header Whether the first line names the columns instead of holding a case.
+        */
+        explicit csv_case_file(const std::string& path, const bool has_header = true)
+            :
+            file_(path),
+            has_header_(has_header)
+        {
+            static_assert(std::conjunction<is_parsable<ResultType>, is_parsable<ArgTypes>...>::value,
+                "csv_case_file: the default parser supports numbers, bool, char and std::string, give it a parser");
+        }
+
+        /** Constructor with a parser for types that the default parser does not support.
+        @param path The path of the file.
+        @param parser Parses the fields of a row into a case.
+        @param has_header Whether the first line names the columns instead of holding a case.
+        */
+        csv_case_file(const std::string& path, ParserType parser, const bool has_header = true)
+            :
+            file_(path),
+            parser_(std::move(parser)),
+            has_header_(has_header)
+        {}
+
+    public: // methods
+
+        /** Calls on_case(case_id, const CaseTupleType&) for every row that begins in the given chunk, in order,
+        and on_error(case_id, const char* message) for every malformed one.
+        The case id is the position of the first byte of the row in the file.
+        */
+        template <typename F, typename E>
+        void visit_chunk(const std::size_t chunk, F&& on_case, E&& on_error) const {
+            const char* const data = file_.data();
+            const std::size_t size = file_.size();
+            const std::size_t end = std::min(size, (chunk + 1) * chunk_size);
+
+            // a row belongs to the chunk in which it begins
+            std::size_t begin = chunk * chunk_size;
+            if (begin > 0) {
+                const void* newline = std::memchr(data + begin - 1, '\n', size - (begin - 1));
+                begin = newline ? static_cast<std::size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+            }
+
+            std::string_view fields[n_fields];
+            for (std::size_t line_begin = begin; line_begin < end; ) {
+                const void* newline = std::memchr(data + line_begin, '\n', size - line_begin);
+                const std::size_t line_end = newline ? static_cast<std::size_t>(static_cast<const char*>(newline) - data) : size;
+                std::string_view line(data + line_begin, line_end - line_begin);
+                if (!line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+
+                if (!line.empty() && line.front() != '#' && !(line_begin == 0 && has_header_)) {
+                    CaseTupleType c;
+                    if (!split(line, fields)) {
+                        on_error(line_begin, "malformed row: expected " + std::to_string(n_fields) + " fields");
+                    }
+                    else if (parser_ ? !parser_(fields, n_fields, c) : !parse(fields, c, std::make_index_sequence<n_fields>())) {
+                        on_error(line_begin, "malformed row: a field cannot be parsed");
+                    }
+                    else {
+                        on_case(line_begin, static_cast<const CaseTupleType&>(c));
+                    }
+                }
+                line_begin = line_end + 1;
+            }
+        }
+
+
+        /// Describes where the case with the given id is, e.g. "line 17". Counts the lines before it.
+        std::string location(const std::size_t case_id) const {
+            const std::size_t end = std::min(case_id, file_.size());
+            return "line " + std::to_string(1 + std::count(file_.data(), file_.data() + end, '\n'));
+        }
+
+    public: // getters
+
+        /// Returns the number of chunks.
+        inline std::size_t n_chunks() const { return (file_.size() + chunk_size - 1) / chunk_size; }
+
+    private: // helpers
+
+        template <typename T>
+        using is_parsable = std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_same<T, std::string>::value>;
+
+
+        /** Splits a row into n_fields fields. Quoted fields lose their enclosing quotes.
+        @return False if the row has another number of fields or an unterminated quote.
+        */
+        static bool split(std::string_view line, std::string_view (&fields)[n_fields]) {
+            std::size_t i = 0;
+            for (;;) {
+                if (i == n_fields) {
+                    return false;
+                }
+                std::size_t next;
+                if (!line.empty() && line.front() == '"') {
+                    std::size_t close = 1;
+                    for (;;) {
+                        close = line.find('"', close);
+                        if (close == std::string_view::npos) {
+                            return false;
+                        }
+                        if (close + 1 < line.size() && line[close + 1] == '"') {
+                            close += 2;
+                            continue;
+                        }
+                        break;
+                    }
+                    fields[i++] = line.substr(1, close - 1);
+                    next = close + 1;
+                    if (next < line.size() && line[next] != ',') {
+                        return false;
+                    }
+                }
+                else {
+                    next = std::min(line.find(','), line.size());
+                    fields[i++] = line.substr(0, next);
+                }
+                if (next >= line.size()) {
+                    return i == n_fields;
+                }
+                line.remove_prefix(next + 1);
+            }
+        }
+
+
+        /// Parses the fields into the elements of a case.
+        template <std::size_t... Is>
+        static bool parse(const std::string_view (&fields)[n_fields], CaseTupleType& c, std::index_sequence<Is...>) {
+            return (parse_field(fields[Is], std::get<Is>(c)) && ...);
+        }
+
+
+        /// Parses a field into a value of one of the types that the default parser supports.
+        template <typename T>
+        static bool parse_field(std::string_view field, T& out_value) {
+            if constexpr (std::is_same<T, std::string>::value) {
+                out_value.clear();
+                for (std::size_t i = 0; i < field.size(); ++i) {
+                    out_value += field[i];
+                    if (field[i] == '"' && i + 1 < field.size() && field[i + 1] == '"') {
+                        ++i;
+                    }
+                }
+                return true;
+            }
+            else {
+                while (!field.empty() && field.front() == ' ')  field.remove_prefix(1);
+                while (!field.empty() && field.back() == ' ')   field.remove_suffix(1);
+
+                if constexpr (std::is_same<T, bool>::value) {
+                    out_value = field == "1" || field == "true";
+                    return out_value || field == "0" || field == "false";
+                }
+                else if constexpr (std::is_same<T, char>::value) {
+                    out_value = field.size() == 1 ? field.front() : '\0';
+                    return field.size() == 1;
+                }
+                else if constexpr (std::is_arithmetic<T>::value) {
+                    if (!field.empty() && field.front() == '+') {
+                        field.remove_prefix(1);
+                    }
+                    const auto r = std::from_chars(field.data(), field.data() + field.size(), out_value);
+                    return r.ec == std::errc() && r.ptr == field.data() + field.size();
+                }
+                else {
+                    return false;
+                }
+            }
+        }
+
+    }; // END class csv_case_file
+
+
+    /** Writes every case of a case file into a binary_case_writer, e.g. to convert a CSV file
+    into a binary file. Malformed cases are skipped.
+    @param source The case file.
+    @param writer The writer.
+    @return The number of written cases.
+    */
+    template <typename Source, typename Writer>
+    std::size_t convert_case_file(const Source& source, Writer& writer) {
+        std::size_t ret = 0;
+        for (std::size_t chunk = 0; chunk < source.n_chunks(); ++chunk) {
+            source.visit_chunk(chunk,
+                [&](std::size_t, const typename Source::CaseTupleType& c) { writer.add(c); ++ret; },
+                [](std::size_t, const std::string&) {});
+        }
+        return ret;
+    }
+
+} // END namespace unittest
@@ -0,0 +1,63 @@
+/******************************************************************************
+@file Command line tool that compares two binary run records, see run_record.hpp,
+      and flags the tests that became significantly slower.
+
+usage: compare_runs <baseline.bin> <candidate.bin> [alpha] [min_change_percent]
+
+Exits with 0 if no test is significantly slower, 1 if one is, 2 on invalid input.
+
+@author: langenhagen
+@version: 261015
+
+******************************************************************************/
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <run_record.hpp>
+
+
+// reads a binary run record from the given file, reports failures to std::cerr
+bool read_run_record(const std::string& path, std::vector<unittest::run_record::test_record>& out_records) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        std::cerr << "compare_runs: cannot open " << path << "\n";
+        return false;
+    }
+    if (!unittest::run_record::read_binary(file, out_records)) {
+        std::cerr << "compare_runs: " << path << " is not a valid run record\n";
+        return false;
+    }
+    return true;
+}
+
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 5) {
+        std::cerr << "usage: compare_runs <baseline.bin> <candidate.bin> [alpha] [min_change_percent]\n";
+        return 2;
+    }
+
+    const double alpha = argc > 3 ? std::atof(argv[3]) : 0.01;
+    const double min_change_percent = argc > 4 ? std::atof(argv[4]) : 5;
+
+    std::vector<unittest::run_record::test_record> baseline;
+    std::vector<unittest::run_record::test_record> candidate;
+    if (!read_run_record(argv[1], baseline) || !read_run_record(argv[2], candidate)) {
+        return 2;
+    }
+
+    const auto comparisons = unittest::run_record::compare(baseline, candidate, alpha, min_change_percent);
+    unittest::run_record::write_comparison(std::cout, comparisons);
+
+    unsigned int n_slowdowns = 0;
+    for (const auto& cmp : comparisons) {
+        n_slowdowns += cmp.is_slowdown ? 1 : 0;
+    }
+    std::cout << comparisons.size() << " tests compared, " << n_slowdowns << " significantly slower\n";
+
+    return n_slowdowns > 0 ? 1 : 0;
+}
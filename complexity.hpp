@@ -0,0 +1,183 @@
+/******************************************************************************
+/* @file Contains tools for the empirical analysis of the time complexity
+/*       of functions: the common growth models and least squares fits
+/*       of measured durations against them.
+/*
+/* A model g(n) is fitted as t(n) = c * g(n) by least squares. The fits are
+/* compared by their root mean square error, normalized by the mean duration.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+std::vector<double> sizes = { 1000, 2000, 4000, 8000 };
+std::vector<double> ns = { 10100, 19900, 40500, 79800 };
+
+auto f = complexity::best_fit(sizes, ns);
+cout << complexity::name(f.growth) << ", " << f.coefficient << " ns * " << complexity::term(f.growth) << "\n";   // O(n), 9.98 ns * n
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace complexity {
+
+        /// The growth models, ordered by their growth.
+        enum class model {
+            O_1 = 0,            ///< Constant.
+            O_LOG_N = 1,        ///< Logarithmic.
+            O_N = 2,            ///< Linear.
+            O_N_LOG_N = 3,      ///< Linearithmic.
+            O_N_SQUARED = 4,    ///< Quadratic.
+        };
+
+
+        /// All growth models, ordered by their growth.
+        constexpr model all_models[] = { model::O_1, model::O_LOG_N, model::O_N, model::O_N_LOG_N, model::O_N_SQUARED };
+
+
+        /// The result of a fit of durations against a growth model.
+        struct fit_result {
+            model growth = model::O_1;      ///< The growth model.
+            double coefficient = 0;         ///< The constant c of t(n) = c * g(n), in the unit of the durations.
+            double rms = 0;                 ///< The root mean square error of the fit, normalized by the mean duration.
+        };
+
+
+        /// Returns the value g(n) of the given growth model. Logarithms are to base 2.
+        inline double evaluate(const model m, const double n) {
+            switch (m) {
+                case model::O_1:            return 1;
+                case model::O_LOG_N:        return std::log2(n);
+                case model::O_N:            return n;
+                case model::O_N_LOG_N:      return n * std::log2(n);
+                case model::O_N_SQUARED:    return n * n;
+            }
+            return 1;
+        }
+
+
+        /// Returns the name of the given growth model, e.g. "O(n log n)".
+        inline const char* name(const model m) {
+            switch (m) {
+                case model::O_1:            return "O(1)";
+                case model::O_LOG_N:        return "O(log n)";
+                case model::O_N:            return "O(n)";
+                case model::O_N_LOG_N:      return "O(n log n)";
+                case model::O_N_SQUARED:    return "O(n^2)";
+            }
+            return "O(?)";
+        }
+
+
+        /// Returns the term g(n) of the given growth model, e.g. "n log n".
+        inline const char* term(const model m) {
+            switch (m) {
+                case model::O_1:            return "1";
+                case model::O_LOG_N:        return "log n";
+                case model::O_N:            return "n";
+                case model::O_N_LOG_N:      return "n log n";
+                case model::O_N_SQUARED:    return "n^2";
+            }
+            return "?";
+        }
+
+
+        /** Fits durations against the given growth model by least squares.
+        @param m The growth model.
+        @param sizes The problem sizes, at least 1.
+        @param durations The durations at the sizes, in any unit.
+        @return The fit. Its rms is infinite if the model is 0 at all sizes.
+        */
+        inline fit_result fit(const model m, const std::vector<double>& sizes, const std::vector<double>& durations) {
+            fit_result ret;
+            ret.growth = m;
+            const std::size_t n = std::min(sizes.size(), durations.size());
+            if (n == 0) {
+                return ret;
+            }
+
+            double sum_gt = 0;
+            double sum_gg = 0;
+            double sum_t = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const double g = evaluate(m, sizes[i]);
+                sum_gt += g * durations[i];
+                sum_gg += g * g;
+                sum_t += durations[i];
+            }
+            if (sum_gg <= 0) {
+                ret.rms = INFINITY;
+                return ret;
+            }
+            ret.coefficient = sum_gt / sum_gg;
+
+            double sum_squared_error = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const double error = durations[i] - ret.coefficient * evaluate(m, sizes[i]);
+                sum_squared_error += error * error;
+            }
+            const double mean = sum_t / n;
+            ret.rms = mean > 0 ? std::sqrt(sum_squared_error / n) / mean : 0;
+            return ret;
+        }
+
+
+        /** Fits durations against all growth models and returns the best fit.
+        A faster growing model only wins if it lowers the normalized rms by more than the given margin,
+        so that noise does not promote a slower growing function to a faster growing model.
+        @param sizes The problem sizes, at least 1.
+        @param durations The durations at the sizes, in any unit.
+        @param margin The margin of the normalized rms.
+        @return The best fit.
+        */
+        inline fit_result best_fit(const std::vector<double>& sizes, const std::vector<double>& durations, const double margin = 0.01) {
+            fit_result ret = fit(model::O_1, sizes, durations);
+            for (const auto m : all_models) {
+                const auto f = fit(m, sizes, durations);
+                if (f.rms < ret.rms - margin) {
+                    ret = f;
+                }
+            }
+            return ret;
+        }
+
+
+        /** Returns the geometric series of problem sizes min_size, min_size * factor, ... up to max_size.
+        Every size is greater than the one before it.
+        @param min_size The first size, at least 1.
+        @param max_size The upper bound of the sizes.
+        @param factor The growth factor, greater than 1.
+        */
+        inline std::vector<unsigned int> geometric_sizes(const unsigned int min_size, const unsigned int max_size, const double factor) {
+            std::vector<unsigned int> ret;
+            double size = std::max(min_size, 1u);
+            while (size <= max_size) {
+                const auto s = static_cast<unsigned int>(std::llround(size));
+                if (ret.empty() || s > ret.back()) {
+                    ret.push_back(s);
+                }
+                size = std::max(size * factor, size + 1);
+            }
+            return ret;
+        }
+
+    } // END namespace complexity
+
+} // END namespace unittest
@@ -0,0 +1,302 @@
+/******************************************************************************
+/* @file Contains class corpus_writer, which writes argument tuples into a
+/*       binary file, and class corpus, which replays them from a memory
+/*       mapping of the file.
+/*
+/* Tuples whose elements are all trivially copyable and no pointers are
+/* stored as their object representation and read in place, without a copy.
+/* Other tuples, e.g. ones with a pointer or a member pointer, whose values
+/* would not survive the run, need an encoder and a decoder. The file format
+/* depends on the platform.
+/*
+/* A RandomizedFunctionTest with a corpus takes the arguments of case i from
+/* the corpus instead of from the argument creator.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+RandomizedFunctionTest<string, float, int> tester(fun, reference_fun, arg_creator);
+auto test_result = tester.test("Test Run 1", 10000);
+
+// save the failing arguments
+corpus_writer<tuple<float, int>> writer("failing.corpus");
+for (const auto& ec : test_result.error_cases) {
+    writer.add(ec.args);
+}
+writer.close();
+
+// ... and replay them, e.g. in CI
+auto failing = std::make_shared<corpus<tuple<float, int>>>("failing.corpus");
+tester.set_corpus(failing);
+tester.test("Replay", failing->size());
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    /** Indicates whether the argument tuple type can be stored as its object representation and read in place.
+    Pointers and member pointers are trivially copyable, but refer to memory of the recording run, hence they are excluded.
+    */
+    template <typename ArgsTupleType>
+    struct is_flat_tuple : std::false_type {};
+
+    template <typename... ArgTypes>
+    struct is_flat_tuple<std::tuple<ArgTypes...>> : std::integral_constant<bool,
+        std::conjunction<std::is_trivially_copyable<ArgTypes>...>::value &&
+        !std::disjunction<std::is_pointer<ArgTypes>..., std::is_member_pointer<ArgTypes>...>::value &&
+        std::is_trivially_copy_constructible<std::tuple<ArgTypes...>>::value &&
+        std::is_trivially_destructible<std::tuple<ArgTypes...>>::value> {};
+
+
+    /** Writes argument tuples into a corpus file.
+    File layout: "BARNCRP1", the record size (0 if encoded), the number of tuples, the position of the offsets,
+    then from byte 64 on the tuples, and if encoded, the offsets of the encoded tuples behind them.
+    @tparam ArgsTupleType The argument tuple type.
+    */
+    template <typename ArgsTupleType>
+    class corpus_writer {
+
+    public: // types
+
+        using EncoderType = std::function<void(const ArgsTupleType&, std::string&)>;   ///< Appends the bytes of a tuple to a string.
+
+    private: // vars
+
+        std::ofstream file_;                    ///< The file.
+        EncoderType encoder_;                   ///< The encoder, or empty if the tuples are stored as their object representation.
+        std::vector<std::uint64_t> offsets_;    ///< The offsets of the encoded tuples behind the header, and the end of the last one.
+        std::size_t n_tuples_ = 0;              ///< The number of written tuples.
+        std::string buffer_;                    ///< Holds an encoded tuple.
+        std::mutex mutex_;                      ///< Serializes add().
+
+    public: // static vars
+
+        static constexpr std::size_t header_size = 64;      ///< The size of the header. The tuples begin behind it.
+
+    public: // constructors
+
+        /** Constructor for tuples whose elements are trivially copyable and no pointers. Creates or truncates the file.
+        @param path The path of the file.
+        */
+        explicit corpus_writer(const std::string& path) {
+            static_assert(is_flat_tuple<ArgsTupleType>::value, "corpus_writer: tuples with pointers or with elements that are not trivially copyable require an encoder");
+            open(path);
+        }
+
+        /** Constructor for tuples that are stored encoded. Creates or truncates the file.
+        @param path The path of the file.
+        @param encoder Appends the bytes of a tuple to a string.
+        */
+        corpus_writer(const std::string& path, EncoderType encoder)
+            :
+            encoder_(std::move(encoder))
+        {
+            open(path);
+            offsets_.push_back(0);
+        }
+
+        corpus_writer(const corpus_writer&) = delete;
+        corpus_writer& operator=(const corpus_writer&) = delete;
+
+        /// Destructor. Closes the file.
+        ~corpus_writer() {
+            close();
+        }
+
+    public: // methods
+
+        /// Appends a tuple. Thread-safe.
+        void add(const ArgsTupleType& arg_tuple) {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            if (encoder_) {
+                buffer_.clear();
+                encoder_(arg_tuple, buffer_);
+                file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+                offsets_.push_back(offsets_.back() + buffer_.size());
+            }
+            else {
+                file_.write(reinterpret_cast<const char*>(&arg_tuple), sizeof(ArgsTupleType));
+            }
+            ++n_tuples_;
+        }
+
+
+        /** Completes the header and closes the file. Further tuples are ignored.
+        @return False if the file could not be written.
+        */
+        bool close() {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            if (!file_.is_open()) {
+                return true;
+            }
+
+            std::uint64_t offsets_position = 0;
+            if (encoder_) {
+                const std::uint64_t end = header_size + offsets_.back();
+                const char zeros[8] = {};
+                file_.write(zeros, static_cast<std::streamsize>((8 - end % 8) % 8));
+                offsets_position = (end + 7) / 8 * 8;
+                file_.write(reinterpret_cast<const char*>(offsets_.data()), static_cast<std::streamsize>(offsets_.size() * sizeof(std::uint64_t)));
+            }
+
+            const std::uint64_t fields[3] = { encoder_ ? 0 : sizeof(ArgsTupleType), n_tuples_, offsets_position };
+            file_.seekp(8);
+            file_.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+            file_.close();
+            return static_cast<bool>(file_);
+        }
+
+    public: // getters
+
+        /// Returns the number of written tuples.
+        inline std::size_t size() const { return n_tuples_; }
+
+    private: // helpers
+
+        /// Opens the file and writes a preliminary header.
+        void open(const std::string& path) {
+            file_.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+            char header[header_size] = {};
+            std::memcpy(header, "BARNCRP1", 8);
+            file_.write(header, header_size);
+        }
+
+    }; // END class corpus_writer
+
+
+    /** A corpus of argument tuples, read from a memory mapping of a file of corpus_writer. Thread-safe.
+    @tparam ArgsTupleType The argument tuple type.
+    */
+    template <typename ArgsTupleType>
+    class corpus {
+
+    public: // types
+
+        using DecoderType = std::function<ArgsTupleType(const char*, std::size_t)>;    ///< Re-creates a tuple from its bytes.
+
+    private: // vars
+
+        mapped_file file_;                      ///< The mapping of the file.
+        DecoderType decoder_;                   ///< The decoder, or empty if the tuples are read in place.
+        std::size_t n_tuples_ = 0;              ///< The number of tuples.
+        const char* tuples_ = nullptr;          ///< The first tuple.
+        const char* offsets_ = nullptr;         ///< The n_tuples_ + 1 offsets of the encoded tuples, if there is a decoder.
+
+    public: // constructors
+
+        /** Constructor for tuples whose elements are trivially copyable and no pointers, which are read in place.
+        The corpus is empty if the file does not exist or was written for another tuple type.
+        @param path The path of the file.
+        */
+        explicit corpus(const std::string& path) {
+            static_assert(is_flat_tuple<ArgsTupleType>::value, "corpus: tuples with pointers or with elements that are not trivially copyable require a decoder");
+            static_assert(alignof(ArgsTupleType) <= corpus_writer<ArgsTupleType>::header_size, "corpus: the alignment of the tuples is too large");
+            load(path);
+        }
+
+        /** Constructor for tuples that are stored encoded.
+        The corpus is empty if the file does not exist or was written without an encoder.
+        @param path The path of the file.
+        @param decoder Re-creates a tuple from the bytes of the encoder.
+        */
+        corpus(const std::string& path, DecoderType decoder)
+            :
+            decoder_(std::move(decoder))
+        {
+            load(path);
+        }
+
+        corpus(const corpus&) = delete;
+        corpus& operator=(const corpus&) = delete;
+
+    public: // methods
+
+        /** Calls the given function with the tuple of the given index.
+        @param i The index of the tuple. Must be smaller than size().
+        @param f A function that takes a const ArgsTupleType&. For tuples that are read in place,
+        the reference refers to the memory mapping.
+        @return The return value of f.
+        */
+        template <typename F>
+        auto visit(const std::size_t i, F&& f) const {
+            if (decoder_) {
+                std::uint64_t begin, end;
+                std::memcpy(&begin, offsets_ + i * sizeof(std::uint64_t), sizeof(begin));
+                std::memcpy(&end, offsets_ + (i + 1) * sizeof(std::uint64_t), sizeof(end));
+                return f(static_cast<const ArgsTupleType&>(decoder_(tuples_ + begin, static_cast<std::size_t>(end - begin))));
+            }
+            return f(*reinterpret_cast<const ArgsTupleType*>(tuples_ + i * sizeof(ArgsTupleType)));
+        }
+
+
+        /** Returns the tuples [i, size()) as an array in the memory mapping, or nullptr if the tuples are encoded.
+        @param i The index of the first tuple.
+        */
+        const ArgsTupleType* data(const std::size_t i = 0) const {
+            return decoder_ ? nullptr : reinterpret_cast<const ArgsTupleType*>(tuples_) + i;
+        }
+
+    public: // getters
+
+        /// Returns the number of tuples.
+        inline std::size_t size() const { return n_tuples_; }
+
+    private: // helpers
+
+        /// Maps the file and checks its header.
+        void load(const std::string& path) {
+            const std::size_t header_size = corpus_writer<ArgsTupleType>::header_size;
+            if (!file_.open(path) || file_.size() < header_size || std::memcmp(file_.data(), "BARNCRP1", 8) != 0) {
+                file_.close();
+                return;
+            }
+            std::uint64_t fields[3];
+            std::memcpy(fields, file_.data() + 8, sizeof(fields));
+            const std::uint64_t record_size = fields[0];
+            const std::uint64_t n_tuples = fields[1];
+            const std::uint64_t offsets_position = fields[2];
+
+            if (record_size != (decoder_ ? 0 : sizeof(ArgsTupleType)) ||
+                (!decoder_ && header_size + n_tuples * record_size > file_.size()) ||
+                (decoder_ && offsets_position + (n_tuples + 1) * sizeof(std::uint64_t) > file_.size()))
+            {
+                file_.close();
+                return;
+            }
+
+            tuples_ = file_.data() + header_size;
+            if (decoder_) {
+                offsets_ = file_.data() + offsets_position;
+            }
+            n_tuples_ = static_cast<std::size_t>(n_tuples);
+        }
+
+    }; // END class corpus
+
+} // END namespace unittest
@@ -0,0 +1,87 @@
+/******************************************************************************
+/* @file Contains the default comparison, to-string and deleter functions
+/*       of the testers as function objects, and describe_mismatch().
+/*
+/* Being plain function objects instead of std::function objects, they can be
+/* stored by value and inlined by the testers that take their callable types
+/* as template parameters.
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <string>
+#include <tuple>
+
+#include "formatting.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace default_functions {
+
+        /// Compares two values with the equality operator ==.
+        struct equal_to {
+            template <typename T>
+            bool operator()(const T& a, const T& b) const {
+                return a == b;
+            }
+        };
+
+        /** Converts a value to a string with formatting::to_string(), i.e. with std::to_chars for numbers
+        and with the stream out operator << for types that are neither numbers, strings nor tuples.
+        */
+        struct stream_to_string {
+            template <typename T>
+            std::string operator()(const T& value) const {
+                return formatting::to_string(value);
+            }
+        };
+
+        /// Converts a tuple to a string like "( 1, 2.5, abc )" with formatting::to_string().
+        struct tuple_to_string {
+            template <typename... Ts>
+            std::string operator()(const std::tuple<Ts...>& t) const {
+                return formatting::to_string(t);
+            }
+        };
+
+        /// Does nothing. The default deleter for arguments and results.
+        struct no_op {
+            template <typename T>
+            void operator()(const T&) const {}
+        };
+
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            template <typename Comparator, typename T>
+            auto describe_mismatch(const Comparator& comparator, const T& a, const T& b, int) -> decltype(std::string(comparator.describe(a, b))) {
+                return comparator.describe(a, b);
+            }
+
+            template <typename Comparator, typename T>
+            std::string describe_mismatch(const Comparator&, const T&, const T&, long) {
+                return std::string();
+            }
+
+        } // END namespace detail
+
+
+        /** Describes how two results differ with the member function describe(a, b) of a comparator,
+        like the ones of tolerance.hpp.
+        @return The description, or an empty string if the comparator has no member function describe().
+        */
+        template <typename Comparator, typename T>
+        std::string describe_mismatch(const Comparator& comparator, const T& a, const T& b) {
+            return detail::describe_mismatch(comparator, a, b, 0);
+        }
+
+    } // END namespace default_functions
+
+} // END namespace unittest
@@ -0,0 +1,28 @@
+/******************************************************************************
+* @file The enum class error_case_policy that specifies which error cases
+*       of a randomized test series are kept.
+*
+*
+* @author langenhagen
+* @version 261015
+******************************************************************************/
+#pragma once
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+
+namespace unittest {
+
+    /// Defines which error cases are kept in memory.
+    enum class error_case_policy {
+        KEEP_ALL = 0,       ///< Keeps every error case.
+        KEEP_FIRST = 1,     ///< Keeps the error cases with the smallest case indices, up to a maximum number.
+        RESERVOIR = 2,      ///< Keeps a uniform random sample of the error cases, up to a maximum number.
+                            ///< The sample depends on nothing but the case indices, also in parallel test series.
+        STREAM = 3,         ///< Writes every error case to a file as it occurs and keeps the same ones as KEEP_FIRST.
+                            ///< If a case throws in a parallel test series, error cases behind it may be written as well.
+    };
+
+} // END namespace unittest
@@ -0,0 +1,322 @@
+/******************************************************************************
+/* @file Contains the formatting of arguments and results into text, which
+/*       the default to-string functions of the testers use.
+/*
+/* Values are appended to a buffer that keeps its capacity, so that
+/* formatting allocates only while the buffer grows. The formatting of each
+/* type is chosen at compile time: numbers are written with std::to_chars,
+/* strings are copied, tuples and pairs are written element by element as
+/* "( a, b )" and everything else goes through its stream out operator <<,
+/* via a stream that writes into the buffer as well.
+/*
+/* Floating point numbers are written in their shortest form that reads
+/* back to the same value, so that results that differ in their last digits
+/* do not print alike.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+formatting::buffer b;
+formatting::append(b, std::make_tuple(3, 0.1, "abc"));
+cout << b.view() << "\n";                                   // ( 3, 0.1, abc )
+
+std::string s = formatting::to_string(std::make_pair(2.5f, 'x'));  // ( 2.5, x )
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace formatting {
+
+        /// A character buffer that keeps its capacity when it is cleared.
+        class buffer {
+
+        private: // vars
+
+            std::vector<char> chars_;       ///< The storage. Its size is the capacity of the buffer.
+            std::size_t size_ = 0;          ///< The number of characters in the buffer.
+
+        public: // methods
+
+            /// Empties the buffer. Keeps the capacity.
+            void clear() {
+                size_ = 0;
+            }
+
+            /** Returns a pointer to at least n writable characters behind the end of the buffer.
+            Call commit() with the number of characters that were written.
+            */
+            char* reserve(const std::size_t n) {
+                if (chars_.size() < size_ + n) {
+                    chars_.resize(std::max<std::size_t>(2 * chars_.size(), size_ + n));
+                }
+                return chars_.data() + size_;
+            }
+
+            /// Adds n characters that were written behind the end of the buffer, see reserve().
+            void commit(const std::size_t n) {
+                size_ += n;
+            }
+
+            /// Appends the given characters.
+            void append(const char* s, const std::size_t n) {
+                std::memcpy(reserve(n), s, n);
+                commit(n);
+            }
+
+            /// Appends the given characters.
+            void append(const std::string_view s) {
+                append(s.data(), s.size());
+            }
+
+            /// Appends the given character.
+            void append(const char c) {
+                *reserve(1) = c;
+                commit(1);
+            }
+
+        public: // getters
+
+            /// Returns the characters in the buffer. Valid until the buffer changes.
+            inline std::string_view view() const { return std::string_view(chars_.data(), size_); }
+
+            /// Returns a copy of the characters in the buffer.
+            inline std::string str() const { return std::string(chars_.data(), size_); }
+
+            /// Returns the number of characters in the buffer.
+            inline std::size_t size() const { return size_; }
+
+        }; // END class buffer
+
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            template <typename T, typename = void>
+            struct is_streamable : std::false_type {};
+
+            template <typename T>
+            struct is_streamable<T, decltype(void(std::declval<std::ostream&>() << std::declval<const T&>()))> : std::true_type {};
+
+            template <typename T>
+            struct is_tuple_like : std::false_type {};
+
+            template <typename... Ts>
+            struct is_tuple_like<std::tuple<Ts...>> : std::true_type {};
+
+            template <typename T1, typename T2>
+            struct is_tuple_like<std::pair<T1, T2>> : std::true_type {};
+
+            template <typename T>
+            struct is_smart_pointer : std::false_type {};
+
+            template <typename T, typename D>
+            struct is_smart_pointer<std::unique_ptr<T, D>> : std::true_type {};
+
+            template <typename T>
+            struct is_smart_pointer<std::shared_ptr<T>> : std::true_type {};
+
+            template <typename T>
+            struct dependent_false : std::false_type {};
+
+
+            /// A stream buffer that appends everything to a formatting::buffer.
+            class buffer_streambuf : public std::streambuf {
+
+            public: // vars
+
+                buffer* target = nullptr;       ///< The buffer to append to.
+
+            protected: // methods
+
+                int_type overflow(const int_type c) override {
+                    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                        target->append(traits_type::to_char_type(c));
+                    }
+                    return traits_type::not_eof(c);
+                }
+
+                std::streamsize xsputn(const char* s, const std::streamsize n) override {
+                    target->append(s, static_cast<std::size_t>(n));
+                    return n;
+                }
+
+            }; // END class buffer_streambuf
+
+
+            /// A stream that writes into a buffer. Cheap to use again, unlike a std::stringstream.
+            class buffer_stream {
+
+            private: // vars
+
+                buffer_streambuf streambuf_;        ///< Appends to the buffer.
+                std::ostream stream_;               ///< Writes into streambuf_.
+
+            public: // constructors
+
+                /// Constructor.
+                buffer_stream() : stream_(&streambuf_) {}
+
+            public: // methods
+
+                /// Returns the stream with its default format flags, writing into the given buffer.
+                std::ostream& open(buffer& b) {
+                    streambuf_.target = &b;
+                    stream_.clear();
+                    stream_.flags(std::ios_base::skipws | std::ios_base::dec);
+                    stream_.precision(6);
+                    stream_.width(0);
+                    stream_.fill(' ');
+                    return stream_;
+                }
+
+            }; // END class buffer_stream
+
+
+            /// The buffer and the stream of the calling thread and whether they are in use, e.g. by an outer call.
+            struct thread_state {
+                buffer text;                    ///< The buffer of to_string().
+                buffer_stream stream;           ///< The stream for types with a stream out operator.
+                bool is_text_in_use = false;    ///< Whether text is in use.
+                bool is_stream_in_use = false;  ///< Whether stream is in use.
+            };
+
+            /// Returns the state of the calling thread.
+            inline thread_state& state() {
+                static thread_local thread_state ret;
+                return ret;
+            }
+
+
+            /// Marks a part of the state of the calling thread as in use for its lifetime.
+            class use_guard {
+            private: // vars
+                bool& flag_;
+            public: // constructors
+                explicit use_guard(bool& flag) : flag_(flag) { flag_ = true; }
+                ~use_guard() { flag_ = false; }
+                use_guard(const use_guard&) = delete;
+                use_guard& operator=(const use_guard&) = delete;
+            };
+
+        } // END namespace detail
+
+
+        /** Appends the text of the given value to the given buffer.
+        Supports numbers, characters, strings, pointers and smart pointers by their address, tuples and pairs, enums and all types with a stream out operator <<.
+        @param b The buffer.
+        @param value The value.
+        */
+        template <typename T>
+        void append(buffer& b, const T& value) {
+            using ValueType = typename std::decay<T>::type;
+
+            if constexpr (std::is_same<ValueType, bool>::value) {
+                b.append(value ? '1' : '0');    // as by the stream out operator
+            }
+            else if constexpr (std::is_same<ValueType, char>::value || std::is_same<ValueType, signed char>::value || std::is_same<ValueType, unsigned char>::value) {
+                b.append(static_cast<char>(value));
+            }
+            else if constexpr (std::is_integral<ValueType>::value || std::is_floating_point<ValueType>::value) {
+                constexpr std::size_t max_length = 64;
+                char* first = b.reserve(max_length);
+                const auto r = std::to_chars(first, first + max_length, value);
+                b.commit(static_cast<std::size_t>(r.ptr - first));
+            }
+            else if constexpr (std::is_same<ValueType, std::nullptr_t>::value) {
+                b.append("nullptr");
+            }
+            else if constexpr (std::is_same<ValueType, const char*>::value || std::is_same<ValueType, char*>::value) {
+                if (value)  b.append(std::string_view(value));
+                else        b.append("nullptr");
+            }
+            else if constexpr (std::is_convertible<const T&, std::string_view>::value) {
+                b.append(std::string_view(value));
+            }
+            else if constexpr (detail::is_tuple_like<ValueType>::value) {
+                b.append("( ");
+                std::apply([&b](const auto&... elements) {
+                    bool is_first = true;
+                    ((is_first ? void() : b.append(", "), is_first = false, append(b, elements)), ...);
+                    (void)is_first;
+                }, value);
+                b.append(" )");
+            }
+            else if constexpr (detail::is_smart_pointer<ValueType>::value) {
+                append(b, static_cast<const void*>(value.get()));
+            }
+            else if constexpr (std::is_pointer<ValueType>::value) {
+                b.append("0x");
+                constexpr std::size_t max_length = 2 * sizeof(std::uintptr_t);
+                char* first = b.reserve(max_length);
+                const auto r = std::to_chars(first, first + max_length, reinterpret_cast<std::uintptr_t>(value), 16);
+                b.commit(static_cast<std::size_t>(r.ptr - first));
+            }
+            else if constexpr (detail::is_streamable<ValueType>::value) {
+                auto& state = detail::state();
+                if (state.is_stream_in_use) {
+                    // an outer stream out operator formats one of its members through this function
+                    detail::buffer_stream nested;
+                    nested.open(b) << value;
+                    return;
+                }
+                const detail::use_guard guard(state.is_stream_in_use);
+                state.stream.open(b) << value;
+            }
+            else if constexpr (std::is_enum<ValueType>::value) {
+                append(b, static_cast<typename std::underlying_type<ValueType>::type>(value));
+            }
+            else {
+                static_assert(detail::dependent_false<ValueType>::value, "formatting::append() cannot format this type, give the tester a to-string function");
+            }
+        }
+
+
+        /** Returns the text of the given value, see append().
+        Formats into a buffer of the calling thread, so that only the returned string is allocated, if it is longer
+        than the small string buffer.
+        */
+        template <typename T>
+        std::string to_string(const T& value) {
+            auto& state = detail::state();
+            if (state.is_text_in_use) {
+                buffer b;
+                append(b, value);
+                return b.str();
+            }
+            const detail::use_guard guard(state.is_text_in_use);
+            state.text.clear();
+            append(state.text, value);
+            return state.text.str();
+        }
+
+    } // END namespace formatting
+
+} // END namespace unittest
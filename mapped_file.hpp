@@ -0,0 +1,174 @@
+/******************************************************************************
+/* @file Contains class mapped_file, a read-only memory mapping of a whole file.
+/*
+/* Uses mmap on POSIX systems and file mappings on Windows.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+mapped_file file("data.bin");
+if (file.is_open()) {
+    const char* p = file.data();    // file.size() bytes, valid until the file is closed
+    // ...
+}
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    /** A read-only memory mapping of a file. Move-only.
+    The mapping stays valid if the file is replaced by a rename, but not if it is truncated.
+    */
+    class mapped_file {
+
+    private: // vars
+
+        const char* data_ = nullptr;        ///< The first byte of the mapping, or nullptr if no file is mapped.
+        std::size_t size_ = 0;              ///< The size of the file.
+
+    public: // constructors
+
+        /// Constructs an object without a mapping.
+        mapped_file() = default;
+
+        /// Constructor. Maps the given file, see open().
+        explicit mapped_file(const std::string& path) {
+            open(path);
+        }
+
+        /// Move constructor. Leaves the other object without a mapping.
+        mapped_file(mapped_file&& other)
+            :
+            data_(other.data_),
+            size_(other.size_)
+        {
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+
+        /// Move assignment. Leaves the other object without a mapping.
+        mapped_file& operator=(mapped_file&& other) {
+            if (this != &other) {
+                close();
+                std::swap(data_, other.data_);
+                std::swap(size_, other.size_);
+            }
+            return *this;
+        }
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        /// Destructor. Unmaps the file.
+        ~mapped_file() {
+            close();
+        }
+
+    public: // methods
+
+        /** Maps the given file read-only. Unmaps the previous file first.
+        @param path The path of the file.
+        @return False if the file does not exist, is empty or cannot be mapped.
+        */
+        bool open(const std::string& path) {
+            close();
+#if defined(_WIN32)
+            const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+                CloseHandle(file);
+                return false;
+            }
+            const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (!mapping) {
+                return false;
+            }
+            void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);   // the view keeps the mapping alive
+            if (!p) {
+                return false;
+            }
+            data_ = static_cast<const char*>(p);
+            size_ = static_cast<std::size_t>(size.QuadPart);
+#else
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                ::close(fd);
+                return false;
+            }
+            void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);            // the mapping keeps the file alive
+            if (p == MAP_FAILED) {
+                return false;
+            }
+            data_ = static_cast<const char*>(p);
+            size_ = static_cast<std::size_t>(st.st_size);
+#endif
+            return true;
+        }
+
+
+        /// Unmaps the file, if any.
+        void close() {
+            if (!data_) {
+                return;
+            }
+#if defined(_WIN32)
+            UnmapViewOfFile(data_);
+#else
+            munmap(const_cast<char*>(data_), size_);
+#endif
+            data_ = nullptr;
+            size_ = 0;
+        }
+
+    public: // getters
+
+        /// Indicates whether a file is mapped.
+        inline bool is_open() const { return data_ != nullptr; }
+
+        /// Returns the first byte of the mapping, or nullptr. Aligned to the page size.
+        inline const char* data() const { return data_; }
+
+        /// Returns the size of the mapped file in bytes.
+        inline std::size_t size() const { return size_; }
+
+    }; // END class mapped_file
+
+} // END namespace unittest
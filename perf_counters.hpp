@@ -0,0 +1,270 @@
+/******************************************************************************
+/* @file Contains tools to read hardware performance counters of the calling
+/*       thread: cycles, instructions, L1 data cache read misses, last level
+/*       cache misses and branch misses.
+/*
+/* The counters are read via perf_event_open on Linux. Where they are not
+/* available, e.g. on other platforms, in virtual machines without a PMU or if
+/* /proc/sys/kernel/perf_event_paranoid forbids it, the counts are NaN.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+perf_counters::counter_group counters;
+
+const auto before = counters.read();
+fun(3, 4);
+const auto c = counters.difference(before, counters.read());
+// c.cycles, c.instructions, ...
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <cstring>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace perf_counters {
+
+        /// Counts of hardware events. NaN if a counter is not available.
+        struct counts {
+            double cycles           = 0;    ///< CPU cycles.
+            double instructions     = 0;    ///< Retired instructions.
+            double l1d_read_misses  = 0;    ///< Level 1 data cache read misses.
+            double llc_misses       = 0;    ///< Last level cache misses.
+            double branch_misses    = 0;    ///< Mispredicted branches.
+
+            /// Adds the counts of another measurement.
+            counts& operator+=(const counts& other) {
+                cycles += other.cycles;
+                instructions += other.instructions;
+                l1d_read_misses += other.l1d_read_misses;
+                llc_misses += other.llc_misses;
+                branch_misses += other.branch_misses;
+                return *this;
+            }
+
+            /// Returns the counts divided by n, e.g. the number of invocations.
+            counts operator/(const double n) const {
+                counts ret;
+                ret.cycles = cycles / n;
+                ret.instructions = instructions / n;
+                ret.l1d_read_misses = l1d_read_misses / n;
+                ret.llc_misses = llc_misses / n;
+                ret.branch_misses = branch_misses / n;
+                return ret;
+            }
+
+            /// Indicates whether at least one counter is available.
+            bool is_available() const {
+                return !std::isnan(cycles) || !std::isnan(instructions) || !std::isnan(l1d_read_misses) || !std::isnan(llc_misses) || !std::isnan(branch_misses);
+            }
+        };
+
+
+        /// Writes the counts with one decimal, or n/a for unavailable counters.
+        inline std::ostream& operator<<(std::ostream& os, const counts& c) {
+            const auto value = [&os](const double v, const char* name) -> std::ostream& {
+                if (std::isnan(v)) {
+                    return os << "n/a " << name;
+                }
+                return os << std::fixed << std::setprecision(1) << v << " " << name;
+            };
+            value(c.cycles, "cycles") << ", ";
+            value(c.instructions, "instructions") << ", ";
+            value(c.l1d_read_misses, "L1D read misses") << ", ";
+            value(c.llc_misses, "LLC misses") << ", ";
+            return value(c.branch_misses, "branch misses");
+        }
+
+
+        /** A group of hardware counters of the calling thread that are scheduled together.
+        Counts the events in user space only. Open and read it on the same thread.
+        */
+        class counter_group {
+
+        public: // types
+
+            static constexpr unsigned int n_events = 5;             ///< The number of counters, in the order of the fields of counts.
+
+            /// The raw values of the counters at a point in time.
+            struct snapshot {
+                std::uint64_t values[n_events] = {};                ///< The counter values.
+                std::uint64_t time_enabled = 0;                     ///< The nanoseconds during which the group was enabled.
+                std::uint64_t time_running = 0;                     ///< The nanoseconds during which the group was counting.
+            };
+
+        private: // vars
+
+            int fds_[n_events];                                     ///< The file descriptors of the counters, -1 for unavailable ones.
+            int read_indices_[n_events];                            ///< The positions of the counters in a group read, -1 for unavailable ones.
+            unsigned int n_open_ = 0;                               ///< The number of available counters.
+
+        public: // constructors
+
+            /// Constructor. Opens and enables the counters. Counters that cannot be opened stay unavailable.
+            counter_group() {
+                for (unsigned int i = 0; i < n_events; ++i) {
+                    fds_[i] = -1;
+                    read_indices_[i] = -1;
+                }
+#if defined(__linux__)
+                const std::uint64_t l1d_read_miss =
+                    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                const std::uint32_t types[n_events] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE };
+                const std::uint64_t configs[n_events] = {
+                    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, l1d_read_miss, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+                int leader = -1;
+                for (unsigned int i = 0; i < n_events; ++i) {
+                    perf_event_attr attr;
+                    std::memset(&attr, 0, sizeof(attr));
+                    attr.size = sizeof(attr);
+                    attr.type = types[i];
+                    attr.config = configs[i];
+                    attr.disabled = leader < 0 ? 1 : 0;
+                    attr.exclude_kernel = 1;
+                    attr.exclude_hv = 1;
+                    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                    const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+                    if (fd < 0) {
+                        continue;
+                    }
+                    if (leader < 0) {
+                        leader = fd;
+                    }
+                    fds_[i] = fd;
+                    read_indices_[i] = static_cast<int>(n_open_++);
+                }
+                if (leader >= 0) {
+                    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+                }
+#endif
+            }
+
+            counter_group(const counter_group&) = delete;
+            counter_group& operator=(const counter_group&) = delete;
+
+            /// Destructor. Closes the counters.
+            ~counter_group() {
+#if defined(__linux__)
+                for (unsigned int i = n_events; i > 0; --i) {
+                    if (fds_[i - 1] >= 0) {
+                        close(fds_[i - 1]);
+                    }
+                }
+#endif
+            }
+
+        public: // methods
+
+            /// Indicates whether at least one counter could be opened.
+            bool is_available() const {
+                return n_open_ > 0;
+            }
+
+
+            /// Reads all counters with a single system call.
+            snapshot read() const {
+                snapshot ret;
+#if defined(__linux__)
+                if (n_open_ == 0) {
+                    return ret;
+                }
+                std::uint64_t buffer[3 + n_events] = {};
+                const int leader = leader_fd();
+                if (::read(leader, buffer, sizeof(buffer)) < static_cast<long>((3 + n_open_) * sizeof(std::uint64_t))) {
+                    return ret;
+                }
+                ret.time_enabled = buffer[1];
+                ret.time_running = buffer[2];
+                for (unsigned int i = 0; i < n_events; ++i) {
+                    if (read_indices_[i] >= 0) {
+                        ret.values[i] = buffer[3 + read_indices_[i]];
+                    }
+                }
+#endif
+                return ret;
+            }
+
+
+            /** Returns the counts between two snapshots of this group.
+            If the kernel multiplexed the counters, the counts are scaled to the enabled time.
+            @param begin The earlier snapshot.
+            @param end The later snapshot.
+            @return The counts. NaN for unavailable counters.
+            */
+            counts difference(const snapshot& begin, const snapshot& end) const {
+                const double nan = std::numeric_limits<double>::quiet_NaN();
+                const auto running = end.time_running - begin.time_running;
+                const double scale = running > 0 ? static_cast<double>(end.time_enabled - begin.time_enabled) / running : 1.0;
+
+                double values[n_events];
+                for (unsigned int i = 0; i < n_events; ++i) {
+                    values[i] = read_indices_[i] >= 0 ? static_cast<double>(end.values[i] - begin.values[i]) * scale : nan;
+                }
+
+                counts ret;
+                ret.cycles = values[0];
+                ret.instructions = values[1];
+                ret.l1d_read_misses = values[2];
+                ret.llc_misses = values[3];
+                ret.branch_misses = values[4];
+                return ret;
+            }
+
+        private: // helpers
+
+            /// Returns the file descriptor of the group leader, i.e. of the first available counter.
+            int leader_fd() const {
+                for (unsigned int i = 0; i < n_events; ++i) {
+                    if (fds_[i] >= 0) {
+                        return fds_[i];
+                    }
+                }
+                return -1;
+            }
+
+        }; // END class counter_group
+
+
+        /// Returns counts that are all NaN, i.e. the counts of a measurement without available counters.
+        inline counts unavailable() {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            counts ret;
+            ret.cycles = nan;
+            ret.instructions = nan;
+            ret.l1d_read_misses = nan;
+            ret.llc_misses = nan;
+            ret.branch_misses = nan;
+            return ret;
+        }
+
+    } // END namespace perf_counters
+
+} // END namespace unittest
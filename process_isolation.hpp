@@ -0,0 +1,637 @@
+/******************************************************************************
+/* @file Contains the tools with which the testers conduct test cases in
+/*       child processes, so that crashes of the function under test, like
+/*       segmentation faults or aborts, do not end the test run.
+/*
+/* A worker is a child process that is forked once and then conducts one
+/* range of test cases after the other, until it crashes or is told to exit.
+/* Parent and worker talk via a socket pair. The worker writes the index of
+/* the case that it is about to conduct into shared memory, so that the
+/* parent knows which case crashed.
+/*
+/* Available on POSIX systems. Elsewhere is_supported() is false and the
+/* testers conduct the cases in-process.
+/*
+/* A child process forked while other threads hold locks, e.g. of the allocator,
+/* can deadlock. Hence nothing is forked while a fork_guard exists, which the
+/* suite runner holds while it runs test series concurrently, see registry.hpp.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+RandomizedFunctionTest<string, float, int> tester(fun, reference_fun, arg_creator);
+tester.is_isolated = true;      // a segmentation fault in fun fails its case instead of ending the run
+tester.n_threads = 4;           // with four worker processes
+
+auto test_result = tester.test("Test Run 1", 10000);
+for (const auto& cc : test_result.crashed_cases) {
+    cout << cc.case_index << ": " << process_isolation::signal_name(cc.signal) << " " << cc.args << "\n";
+}
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define UNITTEST_PROCESS_ISOLATION 1
+    #include <csignal>
+    #include <cerrno>
+    #include <poll.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace process_isolation {
+
+        /// Indicates whether test cases can be conducted in child processes on this platform.
+        inline constexpr bool is_supported() {
+#if defined(UNITTEST_PROCESS_ISOLATION)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+
+        /// Returns a name for the given signal number, e.g. "SIGSEGV", for 0 a note that the process ended without a signal.
+        inline std::string signal_name(const int signal) {
+            if (signal == 0) {
+                return "exited without signal";
+            }
+#if defined(UNITTEST_PROCESS_ISOLATION)
+            switch (signal) {
+                case SIGSEGV: return "SIGSEGV";
+                case SIGABRT: return "SIGABRT";
+                case SIGFPE:  return "SIGFPE";
+                case SIGILL:  return "SIGILL";
+                case SIGBUS:  return "SIGBUS";
+                case SIGKILL: return "SIGKILL";
+                case SIGTERM: return "SIGTERM";
+                case SIGTRAP: return "SIGTRAP";
+                default: break;
+            }
+#endif
+            return "signal " + std::to_string(signal);
+        }
+
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// Returns the number of fork_guard objects that exist.
+            inline std::atomic<unsigned int>& n_fork_guards() {
+                static std::atomic<unsigned int> n(0);
+                return n;
+            }
+
+        } // END namespace detail
+
+
+        /** Marks a section in which several threads run code that may fork, e.g. concurrent test series.
+        Child processes are not forked while a guard exists, see is_fork_safe().
+        */
+        class fork_guard {
+
+        public: // constructors
+
+            /// Constructor. Begins the section.
+            fork_guard() { ++detail::n_fork_guards(); }
+
+            fork_guard(const fork_guard&) = delete;
+            fork_guard& operator=(const fork_guard&) = delete;
+
+            /// Destructor. Ends the section.
+            ~fork_guard() { --detail::n_fork_guards(); }
+
+        }; // END class fork_guard
+
+
+        /** Indicates whether no fork_guard exists, so that the testers may fork child processes.
+        Otherwise probe() and worker::start() fail and the testers conduct their cases in-process or fail them.
+        */
+        inline bool is_fork_safe() {
+            return detail::n_fork_guards().load() == 0;
+        }
+
+
+        /// Appends plain values and strings to a message.
+        class message_writer {
+
+        private: // vars
+
+            std::string& bytes_;        ///< The message.
+
+        public: // constructors
+
+            /// Constructor. Appends to the given message.
+            explicit message_writer(std::string& bytes) : bytes_(bytes) {}
+
+        public: // methods
+
+            /// Appends a trivially copyable value.
+            template <typename T>
+            message_writer& put(const T& value) {
+                static_assert(std::is_trivially_copyable<T>::value, "message_writer: only trivially copyable values");
+                bytes_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+                return *this;
+            }
+
+            /// Appends a string with its length.
+            message_writer& put_string(const std::string& s) {
+                put<std::uint64_t>(s.size());
+                bytes_.append(s);
+                return *this;
+            }
+
+            /// Appends an array of trivially copyable values with its length.
+            template <typename T>
+            message_writer& put_array(const T* values, const std::size_t n) {
+                put<std::uint64_t>(n);
+                bytes_.append(reinterpret_cast<const char*>(values), n * sizeof(T));
+                return *this;
+            }
+
+        }; // END class message_writer
+
+
+        /// Reads the values of a message_writer in the same order.
+        class message_reader {
+
+        private: // vars
+
+            const std::string& bytes_;  ///< The message.
+            std::size_t position_ = 0;  ///< The read position.
+            bool is_valid_ = true;      ///< False if a read went past the end of the message.
+
+        public: // constructors
+
+            /// Constructor.
+            explicit message_reader(const std::string& bytes) : bytes_(bytes) {}
+
+        public: // methods
+
+            /// Reads a trivially copyable value.
+            template <typename T>
+            T get() {
+                T ret{};
+                if (position_ + sizeof(T) > bytes_.size()) {
+                    is_valid_ = false;
+                    return ret;
+                }
+                std::memcpy(&ret, bytes_.data() + position_, sizeof(T));
+                position_ += sizeof(T);
+                return ret;
+            }
+
+            /// Reads a string.
+            std::string get_string() {
+                const auto n = static_cast<std::size_t>(get<std::uint64_t>());
+                if (!is_valid_ || position_ + n > bytes_.size()) {
+                    is_valid_ = false;
+                    return std::string();
+                }
+                position_ += n;
+                return bytes_.substr(position_ - n, n);
+            }
+
+            /// Reads an array into the given container, which must offer resize() and data().
+            template <typename Container>
+            void get_array(Container& out) {
+                using T = typename Container::value_type;
+                const auto n = static_cast<std::size_t>(get<std::uint64_t>());
+                if (!is_valid_ || position_ + n * sizeof(T) > bytes_.size()) {
+                    is_valid_ = false;
+                    return;
+                }
+                out.resize(n);
+                if (n > 0) {
+                    // an empty container may have no data()
+                    std::memcpy(out.data(), bytes_.data() + position_, n * sizeof(T));
+                }
+                position_ += n * sizeof(T);
+            }
+
+            /// Indicates whether all reads stayed within the message.
+            inline bool is_valid() const { return is_valid_; }
+
+        }; // END class message_reader
+
+
+#if defined(UNITTEST_PROCESS_ISOLATION)
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// Writes all bytes to a socket. Does not raise SIGPIPE if the peer is gone.
+            inline bool write_all(const int fd, const char* p, std::size_t n) {
+                while (n > 0) {
+#if defined(MSG_NOSIGNAL)
+                    const auto written = ::send(fd, p, n, MSG_NOSIGNAL);
+#else
+                    const auto written = ::send(fd, p, n, 0);
+#endif
+                    if (written < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (written <= 0) {
+                        return false;
+                    }
+                    p += written;
+                    n -= static_cast<std::size_t>(written);
+                }
+                return true;
+            }
+
+            /** Returns the parent's ends of the socket pairs of all running workers, which a new child process closes,
+            so that closing them in the parent tells every child to exit.
+            */
+            inline std::pair<std::vector<int>, std::mutex>& parent_fds() {
+                static std::pair<std::vector<int>, std::mutex> fds;
+                return fds;
+            }
+
+            /// Reads exactly n bytes from a socket. False at the end of the stream or on errors.
+            inline bool read_all(const int fd, char* p, std::size_t n) {
+                while (n > 0) {
+                    const auto read = ::recv(fd, p, n, 0);
+                    if (read < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (read <= 0) {
+                        return false;
+                    }
+                    p += read;
+                    n -= static_cast<std::size_t>(read);
+                }
+                return true;
+            }
+
+        } // END namespace detail
+
+
+        /** Indices in memory that is shared with the child processes, one per worker.
+        A worker stores the index of the case that it is about to conduct.
+        */
+        class shared_progress {
+
+        private: // vars
+
+            std::atomic<unsigned int>* slots_ = nullptr;    ///< The indices.
+            std::size_t n_slots_ = 0;                       ///< The number of indices.
+
+        public: // constructors
+
+            /// Constructor. Maps shared memory for the given number of workers.
+            explicit shared_progress(const std::size_t n_slots) {
+                void* p = mmap(nullptr, n_slots * sizeof(std::atomic<unsigned int>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+                if (p != MAP_FAILED) {
+                    slots_ = static_cast<std::atomic<unsigned int>*>(p);
+                    n_slots_ = n_slots;
+                    for (std::size_t i = 0; i < n_slots; ++i) {
+                        new (&slots_[i]) std::atomic<unsigned int>(0);
+                    }
+                }
+            }
+
+            shared_progress(const shared_progress&) = delete;
+            shared_progress& operator=(const shared_progress&) = delete;
+
+            /// Destructor. Unmaps the shared memory.
+            ~shared_progress() {
+                if (slots_) {
+                    munmap(slots_, n_slots_ * sizeof(std::atomic<unsigned int>));
+                }
+            }
+
+        public: // methods
+
+            /// Indicates whether the shared memory could be mapped.
+            inline bool is_valid() const { return slots_ != nullptr; }
+
+            /// Returns the index of the given worker.
+            inline std::atomic<unsigned int>& operator[](const std::size_t worker) const { return slots_[worker]; }
+
+        }; // END class shared_progress
+
+
+        /** A child process that conducts the work that the parent sends it.
+        Messages are a 64 bit length followed by the bytes.
+        */
+        class worker {
+
+        private: // vars
+
+            pid_t pid_ = -1;        ///< The process id of the child, -1 if there is none.
+            int fd_ = -1;           ///< The parent's end of the socket pair.
+
+        public: // constructors
+
+            /// Constructs a worker without a child process.
+            worker() = default;
+
+            worker(const worker&) = delete;
+            worker& operator=(const worker&) = delete;
+
+            /// Move constructor.
+            worker(worker&& other) : pid_(other.pid_), fd_(other.fd_) {
+                other.pid_ = -1;
+                other.fd_ = -1;
+            }
+
+            /// Destructor. Tells the child to exit and waits for it.
+            ~worker() {
+                stop();
+            }
+
+        public: // methods
+
+            /** Forks the child process. The child calls serve(request, reply) for every request
+            until the parent closes the connection, and then exits without running any destructors.
+            @param serve A function void(const std::string& request, std::string& reply).
+            @return False if the child could not be created or is_fork_safe() is false.
+            */
+            template <typename F>
+            bool start(F&& serve) {
+                stop();
+                if (!is_fork_safe()) {
+                    return false;
+                }
+                int fds[2];
+                if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+                    return false;
+                }
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+                const int on = 1;
+                setsockopt(fds[0], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+                setsockopt(fds[1], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+                auto& parent_fds = detail::parent_fds();
+                std::unique_lock<std::mutex> lock(parent_fds.second);
+                const pid_t pid = fork();
+                if (pid < 0) {
+                    ::close(fds[0]);
+                    ::close(fds[1]);
+                    return false;
+                }
+                if (pid == 0) {
+                    // child
+                    ::close(fds[0]);
+                    for (const int fd : parent_fds.first) {
+                        ::close(fd);
+                    }
+                    parent_fds.first.clear();
+                    lock.unlock();
+                    std::string request;
+                    std::string reply;
+                    while (receive(fds[1], request)) {
+                        reply.clear();
+                        serve(request, reply);
+                        if (!send(fds[1], reply)) {
+                            break;
+                        }
+                    }
+                    _exit(0);
+                }
+                ::close(fds[1]);
+                parent_fds.first.push_back(fds[0]);
+                pid_ = pid;
+                fd_ = fds[0];
+                return true;
+            }
+
+
+            /// Sends a request to the child.
+            bool send(const std::string& request) const {
+                return send(fd_, request);
+            }
+
+
+            /** Receives the reply to the last request.
+            @param[out] out_reply The reply.
+            @param[out] out_signal The signal that ended the child if it crashed, 0 if it exited otherwise.
+            @return False if the child ended before it replied. The worker then has no child process anymore.
+            */
+            bool receive(std::string& out_reply, int& out_signal) {
+                out_signal = 0;
+                if (receive(fd_, out_reply)) {
+                    return true;
+                }
+                close_fd();
+                int status = 0;
+                while (waitpid(pid_, &status, 0) < 0 && errno == EINTR) {}
+                if (WIFSIGNALED(status)) {
+                    out_signal = WTERMSIG(status);
+                }
+                pid_ = -1;
+                return false;
+            }
+
+
+            /// Ends the child immediately with SIGKILL, e.g. if it hangs. receive() then reports the end of the child.
+            void kill() const {
+                if (pid_ > 0) {
+                    ::kill(pid_, SIGKILL);
+                }
+            }
+
+
+            /// Tells the child to exit and waits for it.
+            void stop() {
+                close_fd();
+                if (pid_ > 0) {
+                    int status = 0;
+                    while (waitpid(pid_, &status, 0) < 0 && errno == EINTR) {}
+                    pid_ = -1;
+                }
+            }
+
+        public: // getters
+
+            /// Indicates whether the worker has a child process.
+            inline bool is_running() const { return pid_ > 0; }
+
+            /// Returns the parent's end of the socket pair, e.g. for poll(), or -1 if there is no child process.
+            inline int native_handle() const { return fd_; }
+
+        private: // helpers
+
+            /// Closes the parent's end of the socket pair.
+            void close_fd() {
+                if (fd_ < 0) {
+                    return;
+                }
+                auto& parent_fds = detail::parent_fds();
+                {
+                    const std::lock_guard<std::mutex> lock(parent_fds.second);
+                    parent_fds.first.erase(std::remove(parent_fds.first.begin(), parent_fds.first.end(), fd_), parent_fds.first.end());
+                }
+                ::close(fd_);
+                fd_ = -1;
+            }
+
+            /// Sends a message.
+            static bool send(const int fd, const std::string& message) {
+                const std::uint64_t size = message.size();
+                return detail::write_all(fd, reinterpret_cast<const char*>(&size), sizeof(size)) && detail::write_all(fd, message.data(), message.size());
+            }
+
+            /// Receives a message.
+            static bool receive(const int fd, std::string& out_message) {
+                std::uint64_t size = 0;
+                if (!detail::read_all(fd, reinterpret_cast<char*>(&size), sizeof(size))) {
+                    return false;
+                }
+                out_message.resize(static_cast<std::size_t>(size));
+                return size == 0 || detail::read_all(fd, &out_message[0], out_message.size());
+            }
+
+        }; // END class worker
+
+
+        /// The exit status of a child process of probe() whose function let an exception escape or whose reply could not be sent.
+        constexpr int probe_failure_exit_status = 125;
+
+
+        /// The outcome of probe().
+        struct probe_result {
+            bool is_started = false;        ///< Whether the child process could be forked.
+            int signal = 0;                 ///< The signal that ended the child, 0 if it exited.
+            int exit_status = 0;            ///< The exit status of the child if it exited, see probe_failure_exit_status.
+            bool is_timed_out = false;      ///< Whether the child ran past the timeout and was ended with SIGKILL.
+            std::string reply;              ///< What the function of the child wrote, complete only if is_completed().
+
+            /// Indicates whether the child ran its function to the end and sent its reply within the timeout.
+            bool is_completed() const { return is_started && !is_timed_out && signal == 0 && exit_status == 0; }
+        };
+
+
+        /** Calls the given function once in a forked child process, receives its reply and waits for the child.
+        A child that crashes, calls exit() with a status other than 0, lets an exception escape,
+        or runs past the timeout, which ends it with SIGKILL, is not completed, nor is a child that could not be forked,
+        e.g. because is_fork_safe() is false.
+        @param f A function void(std::string& reply) to probe, which writes its outcome into the reply.
+        @param timeout The time after which the child is ended. 0 waits for the child forever.
+        @return The outcome, with the reply of the child.
+        */
+        template <typename F>
+        probe_result probe(F&& f, const std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0)) {
+            using namespace std::chrono;
+
+            probe_result ret;
+            if (!is_fork_safe()) {
+                return ret;
+            }
+            auto& parent_fds = detail::parent_fds();
+            std::unique_lock<std::mutex> lock(parent_fds.second);
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+                return ret;
+            }
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+            const int on = 1;
+            setsockopt(fds[1], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+            // a child that calls exit() flushes its copies of the stdio buffers, which must not repeat the output of the parent
+            std::fflush(nullptr);
+            const auto deadline = steady_clock::now() + timeout;
+            const pid_t pid = fork();
+            if (pid < 0) {
+                ::close(fds[0]);
+                ::close(fds[1]);
+                return ret;
+            }
+            if (pid == 0) {
+                // child
+                ::close(fds[0]);
+                for (const int fd : parent_fds.first) {
+                    ::close(fd);
+                }
+                parent_fds.first.clear();
+                lock.unlock();
+                std::string reply;
+                try {
+                    f(reply);
+                }
+                catch (...) {
+                    _exit(probe_failure_exit_status);
+                }
+                _exit(detail::write_all(fds[1], reply.data(), reply.size()) ? 0 : probe_failure_exit_status);
+            }
+            // the child's end is closed before another thread can fork, so that the end of the stream is the end of the child
+            ::close(fds[1]);
+            lock.unlock();
+            ret.is_started = true;
+
+            char buffer[4096];
+            for (;;) {
+                int timeout_ms = -1;
+                if (timeout.count() > 0) {
+                    const auto left = duration_cast<milliseconds>(deadline - steady_clock::now()).count() + 1;
+                    timeout_ms = static_cast<int>(std::min<long long>(std::max<long long>(left, 0), INT_MAX));
+                }
+                pollfd pfd{ fds[0], POLLIN, 0 };
+                const int n_ready = poll(&pfd, 1, timeout_ms);
+                if (n_ready < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n_ready <= 0) {
+                    // past the timeout, or poll() failed
+                    ret.is_timed_out = n_ready == 0;
+                    ::kill(pid, SIGKILL);
+                    break;
+                }
+                const auto read = ::recv(fds[0], buffer, sizeof(buffer), 0);
+                if (read < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (read <= 0) {
+                    break;
+                }
+                ret.reply.append(buffer, static_cast<std::size_t>(read));
+            }
+            ::close(fds[0]);
+
+            int status = 0;
+            while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+            if (WIFSIGNALED(status)) {
+                ret.signal = WTERMSIG(status);
+            }
+            else if (WIFEXITED(status)) {
+                ret.exit_status = WEXITSTATUS(status);
+            }
+            return ret;
+        }
+
+#endif
+
+    } // END namespace process_isolation
+
+} // END namespace unittest
@@ -0,0 +1,288 @@
+/******************************************************************************
+/* @file Contains a seeded, counter-based random generator for the creation
+/*       of function arguments in randomized tests.
+/*
+/* The random numbers are a pure function of (seed, case index, draw number),
+/* computed with the Philox4x32-10 counter-based generator. Thus, every test
+/* case can be re-created on its own in O(1), the cases can be created in
+/* any order and on any thread, and no global state like rand() is involved.
+/*
+/*
+/* Use it as follows:
+###################################################################################################
+
+using namespace unittest;
+
+auto arg_creator = random_args::make_args_creator(42, [](random_args::case_generator& gen) {
+    return std::make_tuple(
+        gen.uniform_real(0.0f, 1.0f),
+        gen.uniform_int(0, 99),
+        gen.string(0, 16),
+        gen.vector<int>(1, 100, [](random_args::case_generator& g) { return g.uniform_int(-5, 5); }));
+});
+
+RandomizedFunctionTest<int, float, int, std::string, std::vector<int>> tester(fun, reference_fun, arg_creator);
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace random_args {
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// The 4x32 bit block of a Philox counter or output.
+            struct block {
+                std::uint32_t v[4];
+            };
+
+            /// Philox4x32-10 as described by Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3".
+            inline block philox4x32_10(block ctr, std::uint32_t key0, std::uint32_t key1) {
+                for (int round = 0; round < 10; ++round) {
+                    const std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * ctr.v[0];
+                    const std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * ctr.v[2];
+                    ctr = block{ {
+                        static_cast<std::uint32_t>(p1 >> 32) ^ ctr.v[1] ^ key0,
+                        static_cast<std::uint32_t>(p1),
+                        static_cast<std::uint32_t>(p0 >> 32) ^ ctr.v[3] ^ key1,
+                        static_cast<std::uint32_t>(p0) } };
+                    key0 += 0x9E3779B9u;
+                    key1 += 0xBB67AE85u;
+                }
+                return ctr;
+            }
+
+            /// The random block number draw_block of the given case.
+            inline block random_block(const std::uint64_t seed, const std::uint64_t case_index, const std::uint64_t draw_block) {
+                const block ctr{ {
+                    static_cast<std::uint32_t>(case_index),
+                    static_cast<std::uint32_t>(case_index >> 32),
+                    static_cast<std::uint32_t>(draw_block),
+                    static_cast<std::uint32_t>(draw_block >> 32) } };
+                return philox4x32_10(ctr, static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32));
+            }
+
+            /// The upper 64 bits of the 128 bit product a * b.
+            inline std::uint64_t mul_hi(const std::uint64_t a, const std::uint64_t b) {
+                const std::uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+                const std::uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+                const std::uint64_t mid = (a_lo * b_lo >> 32) + (a_hi * b_lo & 0xFFFFFFFFu) + a_lo * b_hi;
+                return a_hi * b_hi + (a_hi * b_lo >> 32) + (mid >> 32);
+            }
+
+            /// Maps 32 random bits onto [lo, hi] by fixed-point multiplication. Requires hi - lo < 2^32.
+            template <typename T>
+            inline T map_int32(const std::uint32_t bits, const T lo, const T hi) {
+                using U = typename std::make_unsigned<T>::type;
+                const std::uint64_t range = static_cast<std::uint64_t>(static_cast<U>(hi) - static_cast<U>(lo)) + 1;
+                return static_cast<T>(static_cast<U>(lo) + static_cast<U>((bits * range) >> 32));
+            }
+
+            /// Maps 32 random bits onto [lo, hi).
+            template <typename T>
+            inline T map_real32(const std::uint32_t bits, const T lo, const T hi) {
+                return lo + (hi - lo) * static_cast<T>(bits >> 8) * static_cast<T>(1.0 / 16777216.0);
+            }
+
+        } // END namespace detail
+
+
+        /// Lowercase letters, the default alphabet of case_generator::string().
+        constexpr const char* lowercase = "abcdefghijklmnopqrstuvwxyz";
+
+
+        /** Random generator for the arguments of one test case.
+        All values are a pure function of the seed, the case index and the number of values drawn before.
+        Drawing a value costs one Philox evaluation per 128 random bits.
+        */
+        class case_generator {
+
+        private: // vars
+
+            std::uint64_t seed_;                    ///< The seed of the test series.
+            std::uint64_t case_index_;              ///< The index of the test case.
+            std::uint64_t next_block_ = 0;          ///< The number of the next Philox block.
+            detail::block buffer_ = {};             ///< The current block of random bits.
+            unsigned int n_buffered_ = 0;           ///< The number of unused 32 bit words in buffer_.
+
+        public: // constructors
+
+            /** Constructor for the generator of a single test case.
+            @param seed The seed of the test series.
+            @param case_index The index of the test case.
+            */
+            case_generator(const std::uint64_t seed, const std::uint64_t case_index)
+                :
+                seed_(seed),
+                case_index_(case_index)
+            {}
+
+        public: // methods
+
+            /// Returns 32 random bits.
+            std::uint32_t next_u32() {
+                if (n_buffered_ == 0) {
+                    buffer_ = detail::random_block(seed_, case_index_, next_block_++);
+                    n_buffered_ = 4;
+                }
+                return buffer_.v[4 - n_buffered_--];
+            }
+
+            /// Returns 64 random bits.
+            std::uint64_t next_u64() {
+                const std::uint64_t lo = next_u32();
+                return static_cast<std::uint64_t>(next_u32()) << 32 | lo;
+            }
+
+            /** Returns a uniformly distributed integer in the closed interval [lo, hi].
+            The mapping is a fixed-point multiplication without rejection, so the bias is at most
+            (hi - lo + 1) / 2^32, or (hi - lo + 1) / 2^64 for ranges of 2^32 and more.
+            */
+            template <typename T>
+            T uniform_int(const T lo, const T hi) {
+                static_assert(std::is_integral<T>::value, "case_generator::uniform_int() requires an integral type");
+                using U = typename std::make_unsigned<T>::type;
+                const std::uint64_t span = static_cast<std::uint64_t>(static_cast<U>(hi) - static_cast<U>(lo));
+                if (span <= 0xFFFFFFFFu) {
+                    return detail::map_int32(next_u32(), lo, hi);
+                }
+                const std::uint64_t bits = next_u64();
+                const std::uint64_t offset = span == ~std::uint64_t(0) ? bits : detail::mul_hi(bits, span + 1);
+                return static_cast<T>(static_cast<U>(lo) + static_cast<U>(offset));
+            }
+
+            /// Returns a uniformly distributed floating point value in the half-open interval [lo, hi).
+            template <typename T>
+            T uniform_real(const T lo, const T hi) {
+                static_assert(std::is_floating_point<T>::value, "case_generator::uniform_real() requires a floating point type");
+                if (sizeof(T) <= sizeof(float)) {
+                    return detail::map_real32(next_u32(), lo, hi);
+                }
+                return lo + (hi - lo) * static_cast<T>(next_u64() >> 11) * static_cast<T>(1.0 / 9007199254740992.0);
+            }
+
+            /// Returns true or false with a probability of 0.5 each.
+            bool boolean() {
+                return (next_u32() & 1) != 0;
+            }
+
+            /** Returns a string of random characters.
+            @param min_length The minimum length of the string.
+            @param max_length The maximum length of the string.
+            @param alphabet The characters to choose from. Must not be empty.
+            */
+            std::string string(const std::size_t min_length, const std::size_t max_length, const std::string& alphabet = lowercase) {
+                std::string ret(uniform_int(min_length, max_length), '\0');
+                for (auto& c : ret) {
+                    c = alphabet[uniform_int<std::size_t>(0, alphabet.size() - 1)];
+                }
+                return ret;
+            }
+
+            /** Returns a vector of random elements.
+            @param min_size The minimum number of elements.
+            @param max_size The maximum number of elements.
+            @param make_element A function of the form T(case_generator&) that creates one element.
+            */
+            template <typename T, typename F>
+            std::vector<T> vector(const std::size_t min_size, const std::size_t max_size, F&& make_element) {
+                const auto size = uniform_int(min_size, max_size);
+                std::vector<T> ret;
+                ret.reserve(size);
+                for (std::size_t i = 0; i < size; ++i) {
+                    ret.push_back(make_element(*this));
+                }
+                return ret;
+            }
+
+        public: // getters
+
+            /// Returns the seed of the test series.
+            inline std::uint64_t seed() const { return seed_; }
+
+            /// Returns the index of the test case.
+            inline std::uint64_t case_index() const { return case_index_; }
+
+        }; // END class case_generator
+
+
+        /** Creates an argument creator for RandomizedFunctionTest which hands
+        a case_generator for (seed, case index) to the given function.
+        @param seed The seed of the test series.
+        @param make_args A function of the form ArgsTupleType(case_generator&).
+        @return A function of the form ArgsTupleType(unsigned int).
+        */
+        template <typename F>
+        auto make_args_creator(const std::uint64_t seed, F make_args) {
+            return [seed, make_args](const unsigned int case_index) {
+                case_generator gen(seed, case_index);
+                return make_args(gen);
+            };
+        }
+
+
+        /** Creates the argument tuples of the consecutive test cases [first_case_index, first_case_index + n).
+        @param seed The seed of the test series.
+        @param first_case_index The index of the first test case.
+        @param n The number of test cases.
+        @param make_args A function of the form ArgsTupleType(case_generator&).
+        @return A vector whose element j equals the arguments of the case first_case_index + j.
+        */
+        template <typename F>
+        auto make_args_batch(const std::uint64_t seed, const std::uint64_t first_case_index, const std::size_t n, F&& make_args) {
+            std::vector<decltype(make_args(std::declval<case_generator&>()))> ret;
+            ret.reserve(n);
+            for (std::size_t j = 0; j < n; ++j) {
+                case_generator gen(seed, first_case_index + j);
+                ret.push_back(make_args(gen));
+            }
+            return ret;
+        }
+
+
+        /** Fills out[0 .. n) with uniformly distributed integers in [lo, hi], where
+        out[j] equals the first value drawn by case_generator(seed, first_case_index + j).uniform_int(lo, hi).
+        The loop has no branches and no dependencies between the elements so that the compiler
+        can vectorize it with whatever instruction set it targets. Requires hi - lo < 2^32.
+        */
+        template <typename T>
+        void fill_uniform_int(const std::uint64_t seed, const std::uint64_t first_case_index, T* out, const std::size_t n, const T lo, const T hi) {
+            for (std::size_t j = 0; j < n; ++j) {
+                const auto bits = detail::random_block(seed, first_case_index + j, 0).v[0];
+                out[j] = detail::map_int32(bits, lo, hi);
+            }
+        }
+
+
+        /** Fills out[0 .. n) with uniformly distributed floats in [lo, hi), where
+        out[j] equals the first value drawn by case_generator(seed, first_case_index + j).uniform_real(lo, hi).
+        The loop has no branches and no dependencies between the elements so that the compiler
+        can vectorize it with whatever instruction set it targets.
+        */
+        inline void fill_uniform_real(const std::uint64_t seed, const std::uint64_t first_case_index, float* out, const std::size_t n, const float lo, const float hi) {
+            for (std::size_t j = 0; j < n; ++j) {
+                const auto bits = detail::random_block(seed, first_case_index + j, 0).v[0];
+                out[j] = detail::map_real32(bits, lo, hi);
+            }
+        }
+
+    } // END namespace random_args
+
+} // END namespace unittest
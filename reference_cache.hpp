@@ -0,0 +1,394 @@
+/******************************************************************************
+/* @file Contains class reference_cache, a persistent cache of the results of
+/*       a reference function per test case index.
+/*
+/* With an argument creator that depends on nothing but the case index, the
+/* reference results of a test series are the same in every run. A
+/* RandomizedFunctionTest with a reference_cache computes them once, stores
+/* them together with their invocation durations in a file and afterwards
+/* reads them from a memory mapping of the file instead of calling the
+/* reference function. Speedups are then computed from the stored durations.
+/*
+/* The version tag identifies the reference function and the argument
+/* creator, e.g. their version and the seed. A file with another tag is
+/* ignored and overwritten.
+/*
+/* Trivially copyable results without pointers are read in place, without a
+/* copy. Other results need an encoder and a decoder. The file format
+/* depends on the platform.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+RandomizedFunctionTest<double, double> tester(fun, slow_reference_fun, arg_creator);
+tester.set_reference_cache(std::make_shared<reference_cache<double>>("reference.cache", "slow_reference_fun v2, seed 42"));
+
+auto test_result = tester.test("Test Run 1", 1000000);     // the first run fills the cache, later runs read it
+
+// results that are not trivially copyable
+auto cache = std::make_shared<reference_cache<std::string>>("reference.cache", "v1",
+    [](const std::string& s, std::string& out) { out.append(s); },
+    [](const char* p, std::size_t n) { return std::string(p, n); });
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    /** A persistent cache of reference results and their invocation durations, per case index.
+    The cache holds the results of the cases [0, n_cases()). Lookups are thread-safe.
+    store() is thread-safe for distinct case indices.
+    @tparam ResultType The result type of the reference function.
+    */
+    template <typename ResultType>
+    class reference_cache {
+
+    public: // types
+
+        using EncoderType = std::function<void(const ResultType&, std::string&)>;      ///< Appends the bytes of a result to a string.
+        using DecoderType = std::function<ResultType(const char*, std::size_t)>;       ///< Re-creates a result from its bytes.
+
+    private: // vars
+
+        std::string path_;                              ///< The path of the file.
+        std::string version_tag_;                       ///< Identifies the reference function and the argument creator.
+        EncoderType encoder_;                           ///< The encoder, or empty if results are stored as their object representation.
+        DecoderType decoder_;                           ///< The decoder, or empty if results are read in place.
+
+        mapped_file file_;                              ///< The mapping of the file.
+        std::size_t n_cases_ = 0;                       ///< The number of cases in the file.
+        const char* durations_ = nullptr;               ///< The reference invocation durations in the file, doubles in nanoseconds.
+        const char* records_ = nullptr;                 ///< The results in the file.
+        const char* offsets_ = nullptr;                 ///< The n_cases_ + 1 offsets of the encoded results into records_, if there is a decoder.
+
+        std::vector<char> pending_records_;             ///< The results that were stored since the last commit(), one record per case index, if there is no encoder.
+        std::vector<std::string> pending_encoded_;      ///< The encoded results that were stored since the last commit(), if there is an encoder.
+        std::vector<double> pending_durations_;         ///< The durations of the results that were stored since the last commit().
+        std::vector<char> is_pending_;                  ///< Whether a result was stored for a case index.
+
+    public: // static vars
+
+        static constexpr std::size_t alignment = 64;    ///< The alignment of the sections of the file.
+
+    public: // constructors
+
+        /** Constructor for trivially copyable results, which are read in place.
+        Opens the file if it exists and has the given version tag.
+        @param path The path of the file.
+        @param version_tag Identifies the reference function and the argument creator.
+        */
+        reference_cache(std::string path, std::string version_tag)
+            :
+            path_(std::move(path)),
+            version_tag_(std::move(version_tag))
+        {
+            static_assert(std::is_trivially_copyable<ResultType>::value, "reference_cache: results that are not trivially copyable require an encoder and a decoder");
+            static_assert(alignof(ResultType) <= alignment, "reference_cache: the alignment of the results is too large");
+            load();
+        }
+
+        /** Constructor for results that are stored encoded.
+        Opens the file if it exists and has the given version tag.
+        @param path The path of the file.
+        @param version_tag Identifies the reference function and the argument creator.
+        @param encoder Appends the bytes of a result to a string.
+        @param decoder Re-creates a result from the bytes of the encoder.
+        */
+        reference_cache(std::string path, std::string version_tag, EncoderType encoder, DecoderType decoder)
+            :
+            path_(std::move(path)),
+            version_tag_(std::move(version_tag)),
+            encoder_(std::move(encoder)),
+            decoder_(std::move(decoder))
+        {
+            load();
+        }
+
+        reference_cache(const reference_cache&) = delete;
+        reference_cache& operator=(const reference_cache&) = delete;
+
+    public: // methods
+
+        /// Indicates whether the result of the given case index is in the file.
+        bool contains(const unsigned int case_index) const {
+            return case_index < n_cases_;
+        }
+
+
+        /** Calls the given function with the cached result of the given case index. Requires contains(case_index).
+        @param case_index The case index.
+        @param f A function that takes a const ResultType&. For trivially copyable results,
+        the reference refers to the memory mapping and is only valid during the call.
+        @return The return value of f.
+        */
+        template <typename F>
+        auto visit(const unsigned int case_index, F&& f) const {
+            if (decoder_) {
+                std::uint64_t begin, end;
+                std::memcpy(&begin, offsets_ + case_index * sizeof(std::uint64_t), sizeof(begin));
+                std::memcpy(&end, offsets_ + (case_index + 1) * sizeof(std::uint64_t), sizeof(end));
+                return f(static_cast<const ResultType&>(decoder_(records_ + begin, static_cast<std::size_t>(end - begin))));
+            }
+            return f(*reinterpret_cast<const ResultType*>(records_ + case_index * sizeof(ResultType)));
+        }
+
+
+        /// Returns the cached reference invocation duration of the given case index in nanoseconds. Requires contains(case_index).
+        double duration_ns(const unsigned int case_index) const {
+            double ret;
+            std::memcpy(&ret, durations_ + case_index * sizeof(double), sizeof(ret));
+            return ret;
+        }
+
+
+        /** Prepares store() for the case indices [0, n_cases). Not thread-safe.
+        Results without an encoder take sizeof(ResultType) bytes per case index in a single buffer.
+        */
+        void prepare(const std::size_t n_cases) {
+            if (is_pending_.size() < n_cases) {
+                if (encoder_) {
+                    pending_encoded_.resize(n_cases);
+                }
+                else {
+                    pending_records_.resize(n_cases * sizeof(ResultType));
+                }
+                pending_durations_.resize(n_cases);
+                is_pending_.resize(n_cases, 0);
+            }
+        }
+
+
+        /** Stores a reference result until the next commit(). Thread-safe for distinct case indices.
+        Does nothing if the case index was not prepared.
+        @param case_index The case index.
+        @param result The reference result.
+        @param duration_ns The reference invocation duration in nanoseconds.
+        */
+        void store(const unsigned int case_index, const ResultType& result, const double duration_ns) {
+            if (case_index >= is_pending_.size()) {
+                return;
+            }
+            if (encoder_) {
+                std::string& bytes = pending_encoded_[case_index];
+                bytes.clear();
+                encoder_(result, bytes);
+            }
+            else {
+                std::memcpy(pending_records_.data() + case_index * sizeof(ResultType), static_cast<const void*>(&result), sizeof(ResultType));
+            }
+            pending_durations_[case_index] = duration_ns;
+            is_pending_[case_index] = 1;
+        }
+
+
+        /** Writes the cached and the stored results of the longest gapless range of case indices [0, n) to the file,
+        if that range is longer than the one in the file, and maps the new file. Not thread-safe.
+        The file is replaced atomically by a rename.
+        @return False if the file could not be written.
+        */
+        bool commit() {
+            std::size_t n = n_cases_;
+            while (n < is_pending_.size() && is_pending_[n]) {
+                ++n;
+            }
+            if (n == n_cases_) {
+                clear_pending();
+                return true;
+            }
+
+            const std::string tmp_path = path_ + ".tmp";
+            if (!write(tmp_path, n)) {
+                std::remove(tmp_path.c_str());
+                return false;
+            }
+
+            file_.close();
+#if defined(_WIN32)
+            std::remove(path_.c_str());
+#endif
+            const bool is_renamed = std::rename(tmp_path.c_str(), path_.c_str()) == 0;
+            clear_pending();
+            load();
+            return is_renamed;
+        }
+
+    public: // getters
+
+        /// Returns the number of cases in the file.
+        inline std::size_t n_cases() const { return n_cases_; }
+
+        /// Returns the version tag.
+        inline const std::string& version_tag() const { return version_tag_; }
+
+    private: // helpers
+
+        /// Returns the given offset rounded up to the alignment.
+        static std::size_t align(const std::size_t offset) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+
+        /// Reads an unsigned integer from the given position of the mapping.
+        std::uint64_t read_u64(const std::size_t offset) const {
+            std::uint64_t ret;
+            std::memcpy(&ret, file_.data() + offset, sizeof(ret));
+            return ret;
+        }
+
+
+        /** Maps the file and checks its header. The file is treated as empty if it does not exist,
+        has another version tag or another format.
+        File layout: "BARNREF1", the length and bytes of the version tag, the record size (0 if encoded),
+        the number of cases, then the durations, the offsets if encoded, and the results, each aligned.
+        */
+        void load() {
+            n_cases_ = 0;
+            if (!file_.open(path_)) {
+                return;
+            }
+
+            const std::size_t size = file_.size();
+            const std::size_t tag_offset = 16;
+            if (size < tag_offset || std::memcmp(file_.data(), "BARNREF1", 8) != 0) {
+                file_.close();
+                return;
+            }
+            const std::uint64_t tag_size = read_u64(8);
+            if (tag_size != version_tag_.size() || size < tag_offset + tag_size + 16 ||
+                std::memcmp(file_.data() + tag_offset, version_tag_.data(), version_tag_.size()) != 0)
+            {
+                file_.close();
+                return;
+            }
+
+            const std::size_t fields_offset = tag_offset + static_cast<std::size_t>(tag_size);
+            const std::uint64_t record_size = read_u64(fields_offset);
+            const std::uint64_t n_cases = read_u64(fields_offset + 8);
+            if (record_size != (decoder_ ? 0 : sizeof(ResultType))) {
+                file_.close();
+                return;
+            }
+
+            const std::size_t durations_offset = align(fields_offset + 16);
+            std::size_t records_offset = align(durations_offset + n_cases * sizeof(double));
+            std::size_t records_end = records_offset + n_cases * record_size;
+            if (decoder_) {
+                const std::size_t offsets_offset = records_offset;
+                records_offset = align(offsets_offset + (n_cases + 1) * sizeof(std::uint64_t));
+                if (records_offset > size) {
+                    file_.close();
+                    return;
+                }
+                offsets_ = file_.data() + offsets_offset;
+                records_end = records_offset + static_cast<std::size_t>(read_u64(offsets_offset + n_cases * sizeof(std::uint64_t)));
+            }
+            if (records_end > size) {
+                file_.close();
+                return;
+            }
+
+            durations_ = file_.data() + durations_offset;
+            records_ = file_.data() + records_offset;
+            n_cases_ = static_cast<std::size_t>(n_cases);
+        }
+
+
+        /** Writes the results of the case indices [0, n) from the file and the pending results to the given path.
+        @return False if the file could not be written.
+        */
+        bool write(const std::string& path, const std::size_t n) const {
+            std::ofstream os(path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!os) {
+                return false;
+            }
+            std::size_t position = 0;
+            const auto put = [&os, &position](const void* p, const std::size_t size) {
+                os.write(static_cast<const char*>(p), static_cast<std::streamsize>(size));
+                position += size;
+            };
+            const auto put_u64 = [&put](const std::uint64_t v) { put(&v, sizeof(v)); };
+            const auto pad = [&put, &position]() {
+                static const char zeros[alignment] = {};
+                put(zeros, align(position) - position);
+            };
+            const auto bytes = [this](const std::size_t i) {
+                if (is_pending_.size() > i && is_pending_[i]) {
+                    return encoder_
+                        ? std::make_pair(static_cast<const char*>(pending_encoded_[i].data()), pending_encoded_[i].size())
+                        : std::make_pair(static_cast<const char*>(pending_records_.data() + i * sizeof(ResultType)), sizeof(ResultType));
+                }
+                if (!decoder_) {
+                    return std::make_pair(records_ + i * sizeof(ResultType), sizeof(ResultType));
+                }
+                const auto begin = read_u64(static_cast<std::size_t>(offsets_ - file_.data()) + i * sizeof(std::uint64_t));
+                const auto end = read_u64(static_cast<std::size_t>(offsets_ - file_.data()) + (i + 1) * sizeof(std::uint64_t));
+                return std::make_pair(records_ + begin, static_cast<std::size_t>(end - begin));
+            };
+
+            put("BARNREF1", 8);
+            put_u64(version_tag_.size());
+            put(version_tag_.data(), version_tag_.size());
+            put_u64(decoder_ ? 0 : sizeof(ResultType));
+            put_u64(n);
+            pad();
+
+            for (std::size_t i = 0; i < n; ++i) {
+                const double d = is_pending_.size() > i && is_pending_[i] ? pending_durations_[i] : duration_ns(static_cast<unsigned int>(i));
+                put(&d, sizeof(d));
+            }
+            pad();
+
+            if (decoder_) {
+                std::uint64_t offset = 0;
+                put_u64(offset);
+                for (std::size_t i = 0; i < n; ++i) {
+                    offset += bytes(i).second;
+                    put_u64(offset);
+                }
+                pad();
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                const auto b = bytes(i);
+                put(b.first, b.second);
+            }
+
+            os.close();
+            return static_cast<bool>(os);
+        }
+
+
+        /// Forgets the pending results.
+        void clear_pending() {
+            pending_records_.clear();
+            pending_encoded_.clear();
+            pending_durations_.clear();
+            is_pending_.clear();
+        }
+
+    }; // END class reference_cache
+
+} // END namespace unittest
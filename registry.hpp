@@ -0,0 +1,438 @@
+/******************************************************************************
+/* @file Contains the test registry and the suite runner.
+/*
+/* Test series register themselves with a static registration object.
+/* run_main() runs the registered series concurrently, writes the output of
+/* each series as a whole, in the order of the names, and ends with a
+/* combined summary. barn_test_main.cpp contains a main() that calls it.
+/*
+/* Command line options of run_main():
+/*     --filter=PATTERNS   run the series whose names match a comma separated list of
+/*                         patterns with * and ?. Patterns with a leading - exclude.
+/*     --shard=I/N         run the I-th of N disjoint shards, counted from 0
+/*     --jobs=N            run N series at once, 0 for one per hardware thread (default)
+/*     --list              list the selected series instead of running them
+/*     --json=PATH, --csv=PATH, --junit=PATH, --binary=PATH
+/*                         write the run records of the testers, see run_record.hpp
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+static registry::registration add_test("math/add", [](registry::context& ctx) {
+    RandomizedFunctionTest<int, int, int> tester(add, reference_add, arg_creator);
+    tester.set_reporter(ctx.out);
+    tester.set_recorder(ctx.recorder);
+    return tester.test(ctx.name, 100000).is_all_tests_passed();
+});
+
+// compile and link with barn_test_main.cpp, then e.g.
+// ./tests --filter=math/*,-math/slow* --shard=0/4
+
+###################################################################################################
+/*
+/* Testers within a series that use several threads, e.g. with
+/* RandomizedFunctionTest::n_threads, compete with the concurrent series.
+/*
+/* Forking while other threads run is unsafe, hence testers with is_isolated
+/* do not fork in the concurrent series, see process_isolation::fork_guard.
+/* Register series with isolated testers as isolated; they run one after
+/* another once the concurrent series are done:
+
+static registry::registration div_test("math/div", [](registry::context& ctx) {
+    RandomizedFunctionTest<int, int, int> tester(div, reference_div, arg_creator);
+    tester.is_isolated = true;
+    tester.set_reporter(ctx.out);
+    return tester.test(ctx.name, 100000).is_all_tests_passed();
+}, true);
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "process_isolation.hpp"
+#include "reporter.hpp"
+#include "run_record.hpp"
+#include "work_stealing.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace registry {
+
+        /// What a test series gets from the runner.
+        struct context {
+            std::string name;                                   ///< The name of the series.
+            std::shared_ptr<reporter> out;                      ///< The output of the series. Pass it to the testers with set_reporter().
+            std::shared_ptr<run_record::recorder> recorder;     ///< The recorder of the run. Pass it to the testers with set_recorder().
+        };
+
+
+        /// A test series: a function that conducts tests and returns whether they all passed.
+        using SeriesFunctionType = std::function<bool(context&)>;
+
+
+        /// A registered test series.
+        struct series {
+            std::string name;                   ///< The name.
+            SeriesFunctionType function;        ///< The function.
+            bool is_isolated = false;           ///< Whether the series forks child processes and hence runs while no other series does.
+        };
+
+
+        /// The outcome of a test series.
+        struct series_result {
+            std::string name;                   ///< The name of the series.
+            bool is_passed = false;             ///< Whether the series returned true.
+            std::string output;                 ///< The output of the series.
+            std::chrono::nanoseconds duration = std::chrono::nanoseconds(0);   ///< The wall-clock duration of the series.
+        };
+
+
+        /// The options of a run, see run_main().
+        struct options {
+            std::vector<std::string> filters;   ///< Name patterns with * and ?. Patterns with a leading - exclude. All series if there are none.
+            unsigned int shard_index = 0;       ///< The shard to run.
+            unsigned int n_shards = 1;          ///< The number of shards.
+            unsigned int n_jobs = 0;            ///< The number of concurrent series. 0 means one per hardware thread.
+            bool is_list_only = false;          ///< Whether the selected series are listed instead of run.
+            std::string json_path;              ///< Where the run records are written as JSON, if not empty.
+            std::string csv_path;               ///< Where the run records are written as CSV, if not empty.
+            std::string junit_path;             ///< Where the run records are written as JUnit XML, if not empty.
+            std::string binary_path;            ///< Where the run records are written in the binary format, if not empty.
+        };
+
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// Returns the registered series.
+            inline std::vector<series>& all_series() {
+                static std::vector<series> s;
+                return s;
+            }
+
+            /// Indicates whether the text matches the pattern with the wildcards * and ?.
+            inline bool matches(const char* pattern, const char* text) {
+                for (; *pattern; ++pattern, ++text) {
+                    if (*pattern == '*') {
+                        for (; ; ++text) {
+                            if (matches(pattern + 1, text)) {
+                                return true;
+                            }
+                            if (!*text) {
+                                return false;
+                            }
+                        }
+                    }
+                    if (!*text || (*pattern != '?' && *pattern != *text)) {
+                        return false;
+                    }
+                }
+                return !*text;
+            }
+
+            /// Indicates whether the name passes the filters.
+            inline bool is_selected(const std::string& name, const std::vector<std::string>& filters) {
+                bool has_includes = false;
+                bool is_included = false;
+                for (const auto& f : filters) {
+                    if (!f.empty() && f[0] == '-') {
+                        if (matches(f.c_str() + 1, name.c_str())) {
+                            return false;
+                        }
+                    }
+                    else {
+                        has_includes = true;
+                        is_included |= matches(f.c_str(), name.c_str());
+                    }
+                }
+                return !has_includes || is_included;
+            }
+
+            /// Writes the run records to the files of the options.
+            inline bool write_records(const options& opts, const std::vector<run_record::test_record>& records) {
+                bool ret = true;
+                const auto write = [&ret](const std::string& path, const std::ios::openmode mode, const std::function<void(std::ostream&)>& writer) {
+                    if (path.empty()) {
+                        return;
+                    }
+                    std::ofstream file(path, mode);
+                    writer(file);
+                    file.close();
+                    if (!file) {
+                        std::cerr << "cannot write " << path << "\n";
+                        ret = false;
+                    }
+                };
+                write(opts.json_path, std::ios::out, [&records](std::ostream& os) { run_record::write_json(os, records); });
+                write(opts.csv_path, std::ios::out, [&records](std::ostream& os) { run_record::write_csv(os, records); });
+                write(opts.junit_path, std::ios::out, [&records](std::ostream& os) { run_record::write_junit_xml(os, records); });
+                write(opts.binary_path, std::ios::out | std::ios::binary, [&records](std::ostream& os) { run_record::write_binary(os, records); });
+                return ret;
+            }
+
+        } // END namespace detail
+
+
+        /// Registers a test series during static initialization. Define registrations as static objects.
+        class registration {
+
+        public: // constructors
+
+            /** Constructor. Registers the series.
+            @param name The unique name of the series, e.g. "module/function".
+            @param function A function bool(registry::context&) that conducts the tests and returns whether they all passed.
+            @param is_isolated Whether the series has testers with is_isolated, which fork child processes.
+            Such series run one after another after the concurrent series, so that they fork while no other series runs.
+            */
+            registration(std::string name, SeriesFunctionType function, const bool is_isolated = false) {
+                detail::all_series().push_back(series{ std::move(name), std::move(function), is_isolated });
+            }
+
+        }; // END class registration
+
+
+        /** Returns the registered series that the options select, ordered by name.
+        Shards are formed by the position within the filtered series, so that the shards of a run are disjoint and complete.
+        */
+        inline std::vector<const series*> select(const options& opts) {
+            std::vector<const series*> filtered;
+            for (const auto& s : detail::all_series()) {
+                if (detail::is_selected(s.name, opts.filters)) {
+                    filtered.push_back(&s);
+                }
+            }
+            std::stable_sort(filtered.begin(), filtered.end(), [](const series* a, const series* b) { return a->name < b->name; });
+
+            std::vector<const series*> ret;
+            for (std::size_t i = 0; i < filtered.size(); ++i) {
+                if (opts.n_shards <= 1 || i % opts.n_shards == opts.shard_index) {
+                    ret.push_back(filtered[i]);
+                }
+            }
+            return ret;
+        }
+
+
+        /** Runs the given series concurrently. The output of each series is written as a whole,
+        as soon as it and all series before it are done. A series that throws counts as failed.
+        The isolated series run afterwards on the calling thread, one after another. While several series run
+        at once, a process_isolation::fork_guard keeps the testers from forking.
+        @param selected The series.
+        @param n_jobs The number of concurrent series. 0 means one per hardware thread.
+        @param recorder The recorder that the series get.
+        @param os The output stream.
+        @return The outcomes, in the order of the given series.
+        */
+        inline std::vector<series_result> run(
+            const std::vector<const series*>& selected,
+            const unsigned int n_jobs,
+            const std::shared_ptr<run_record::recorder>& recorder,
+            std::ostream& os = std::cout)
+        {
+            std::vector<series_result> results(selected.size());
+            std::vector<char> is_done(selected.size(), 0);
+            std::size_t n_written = 0;
+            std::mutex output_mutex;
+
+            const auto run_series = [&](const std::size_t i) {
+                series_result& result = results[i];
+                std::stringstream out;
+                context ctx{ selected[i]->name, std::make_shared<ostream_reporter>(out), recorder };
+
+                const auto start = std::chrono::steady_clock::now();
+                try {
+                    result.is_passed = selected[i]->function(ctx);
+                }
+                catch (std::exception& ex) {
+                    out << "\nEXCEPTION in series " << ctx.name << "\n" << typeid(ex).name() << ":\n" << ex.what() << "\n";
+                }
+                catch (...) {
+                    out << "\nEXCEPTION in series " << ctx.name << "\nunknown\n";
+                }
+                ctx.out->flush();
+                result.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                result.name = ctx.name;
+                result.output = out.str();
+
+                const std::lock_guard<std::mutex> lock(output_mutex);
+                is_done[i] = 1;
+                for (; n_written < results.size() && is_done[n_written]; ++n_written) {
+                    os << results[n_written].output;
+                }
+                os.flush();
+            };
+
+            std::vector<std::size_t> concurrent;
+            std::vector<std::size_t> isolated;
+            for (std::size_t i = 0; i < selected.size(); ++i) {
+                (selected[i]->is_isolated ? isolated : concurrent).push_back(i);
+            }
+
+            {
+                std::unique_ptr<process_isolation::fork_guard> guard;
+                if (work_stealing::resolve_n_workers(n_jobs) > 1) {
+                    guard.reset(new process_isolation::fork_guard());
+                }
+                work_stealing::parallel_for(concurrent.size(), n_jobs, 1, [&](const unsigned int, const std::size_t begin, const std::size_t end) {
+                    for (std::size_t k = begin; k < end; ++k) {
+                        run_series(concurrent[k]);
+                    }
+                });
+            }
+            // the worker threads of the concurrent series have ended
+            for (const auto i : isolated) {
+                run_series(i);
+            }
+            return results;
+        }
+
+
+        /** Writes the combined summary of a run.
+        @param os The output stream.
+        @param results The outcomes of the series.
+        @param duration The wall-clock duration of the run.
+        */
+        inline void write_summary(std::ostream& os, const std::vector<series_result>& results, const std::chrono::nanoseconds duration) {
+            std::size_t n_passed = 0;
+            for (const auto& r : results) {
+                n_passed += r.is_passed ? 1 : 0;
+            }
+
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(3) <<
+                "\nSUMMARY: " << n_passed << "/" << results.size() << " series passed (" << duration.count() / 1e9 << " s)\n";
+            for (const auto& r : results) {
+                if (!r.is_passed) {
+                    ss << " FAILED: " << r.name << " (" << r.duration.count() / 1e9 << " s)\n";
+                }
+            }
+            os << ss.str();
+        }
+
+
+        /** Parses the command line options of run_main().
+        @param argc The number of arguments.
+        @param argv The arguments. The first one is the program name.
+        @param[out] out_options The options.
+        @return False if an argument is invalid. The error was written to std::cerr.
+        */
+        inline bool parse_options(const int argc, const char* const* argv, options& out_options) {
+            for (int i = 1; i < argc; ++i) {
+                const std::string arg = argv[i];
+                const auto value = [&arg](const std::string& key) { return arg.compare(0, key.size(), key) == 0 ? arg.substr(key.size()) : std::string(); };
+
+                if (arg.compare(0, 9, "--filter=") == 0) {
+                    std::stringstream ss(value("--filter="));
+                    for (std::string f; std::getline(ss, f, ','); ) {
+                        if (!f.empty()) {
+                            out_options.filters.push_back(f);
+                        }
+                    }
+                }
+                else if (arg.compare(0, 8, "--shard=") == 0) {
+                    const std::string shard = value("--shard=");
+                    const auto slash = shard.find('/');
+                    if (slash == std::string::npos) {
+                        std::cerr << "invalid shard " << shard << ", expected I/N\n";
+                        return false;
+                    }
+                    out_options.shard_index = static_cast<unsigned int>(std::strtoul(shard.substr(0, slash).c_str(), nullptr, 10));
+                    out_options.n_shards = static_cast<unsigned int>(std::strtoul(shard.substr(slash + 1).c_str(), nullptr, 10));
+                    if (out_options.n_shards == 0 || out_options.shard_index >= out_options.n_shards) {
+                        std::cerr << "invalid shard " << shard << ", expected I/N with I < N\n";
+                        return false;
+                    }
+                }
+                else if (arg.compare(0, 7, "--jobs=") == 0) {
+                    out_options.n_jobs = static_cast<unsigned int>(std::strtoul(value("--jobs=").c_str(), nullptr, 10));
+                }
+                else if (arg == "--list") {
+                    out_options.is_list_only = true;
+                }
+                else if (arg.compare(0, 7, "--json=") == 0) {
+                    out_options.json_path = value("--json=");
+                }
+                else if (arg.compare(0, 6, "--csv=") == 0) {
+                    out_options.csv_path = value("--csv=");
+                }
+                else if (arg.compare(0, 8, "--junit=") == 0) {
+                    out_options.junit_path = value("--junit=");
+                }
+                else if (arg.compare(0, 9, "--binary=") == 0) {
+                    out_options.binary_path = value("--binary=");
+                }
+                else {
+                    std::cerr <<
+                        "unknown argument " << arg << "\n"
+                        "usage: " << argv[0] << " [--filter=PATTERNS] [--shard=I/N] [--jobs=N] [--list]"
+                        " [--json=PATH] [--csv=PATH] [--junit=PATH] [--binary=PATH]\n";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+
+        /** Runs the registered series that the command line selects and writes a combined summary.
+        @param argc The number of arguments, as passed to main().
+        @param argv The arguments, as passed to main().
+        @return The exit code: 0 if all series passed, 1 if a series failed, 2 if the arguments are invalid
+        or a run record could not be written.
+        */
+        inline int run_main(const int argc, const char* const* argv) {
+            options opts;
+            if (!parse_options(argc, argv, opts)) {
+                return 2;
+            }
+
+            const auto selected = select(opts);
+            if (opts.is_list_only) {
+                for (const auto* s : selected) {
+                    std::cout << s->name << "\n";
+                }
+                return 0;
+            }
+
+            const auto recorder = std::make_shared<run_record::recorder>();
+            const auto start = std::chrono::steady_clock::now();
+            const auto results = run(selected, opts.n_jobs, recorder);
+            write_summary(std::cout, results, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+
+            if (!detail::write_records(opts, recorder->records())) {
+                return 2;
+            }
+            for (const auto& r : results) {
+                if (!r.is_passed) {
+                    return 1;
+                }
+            }
+            return 0;
+        }
+
+    } // END namespace registry
+
+} // END namespace unittest
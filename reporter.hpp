@@ -0,0 +1,355 @@
+/******************************************************************************
+/* @file Contains the reporters through which the testers write their output.
+/*
+/* A message is a formatting function void(std::ostream&), so that a reporter
+/* can defer the formatting. ostream_reporter formats and writes immediately.
+/* async_reporter puts the messages into a lock-free ring buffer which a
+/* background thread drains, so that the testing threads never wait for the
+/* output stream. Several testers can share one reporter; each message is
+/* written as a whole.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+auto out = std::make_shared<async_reporter>(std::cout);
+
+RandomizedFunctionTest<string, float, int> tester(fun, reference_fun, arg_creator);
+tester.set_reporter(out);
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    /** A move-only, type-erased formatting function void(std::ostream&).
+    Functions with small captures are stored inline, larger ones on the heap.
+    */
+    class deferred_message {
+
+    public: // static vars
+
+        static constexpr std::size_t inline_capacity = 64;     ///< The size of captures up to which no memory is allocated.
+
+    private: // vars
+
+        alignas(std::max_align_t) unsigned char storage_[inline_capacity];     ///< The function, or a pointer to it.
+        void (*invoke_)(void*, std::ostream&) = nullptr;                        ///< Calls the function.
+        void (*relocate_)(void*, void*) = nullptr;                              ///< Moves the function from the first storage to the second one.
+        void (*destroy_)(void*) = nullptr;                                      ///< Destroys the function.
+
+    public: // constructors
+
+        /// Constructs an empty message.
+        deferred_message() = default;
+
+        /// Constructs a message from a function void(std::ostream&).
+        template <typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, deferred_message>::value>::type>
+        deferred_message(F&& format) {
+            using FunctionType = typename std::decay<F>::type;
+            if constexpr (sizeof(FunctionType) <= inline_capacity && alignof(FunctionType) <= alignof(std::max_align_t)) {
+                new (storage_) FunctionType(std::forward<F>(format));
+                invoke_ = [](void* p, std::ostream& os) { (*static_cast<FunctionType*>(p))(os); };
+                relocate_ = [](void* from, void* to) {
+                    new (to) FunctionType(std::move(*static_cast<FunctionType*>(from)));
+                    static_cast<FunctionType*>(from)->~FunctionType();
+                };
+                destroy_ = [](void* p) { static_cast<FunctionType*>(p)->~FunctionType(); };
+            }
+            else {
+                new (storage_) FunctionType*(new FunctionType(std::forward<F>(format)));
+                invoke_ = [](void* p, std::ostream& os) { (**static_cast<FunctionType**>(p))(os); };
+                relocate_ = [](void* from, void* to) { new (to) FunctionType*(*static_cast<FunctionType**>(from)); };
+                destroy_ = [](void* p) { delete *static_cast<FunctionType**>(p); };
+            }
+        }
+
+        /// Move constructor. Leaves the other message empty.
+        deferred_message(deferred_message&& other) {
+            take(other);
+        }
+
+        /// Move assignment. Leaves the other message empty.
+        deferred_message& operator=(deferred_message&& other) {
+            if (this != &other) {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+
+        deferred_message(const deferred_message&) = delete;
+        deferred_message& operator=(const deferred_message&) = delete;
+
+        /// Destructor.
+        ~deferred_message() {
+            reset();
+        }
+
+    public: // methods
+
+        /// Formats the message onto the given stream. Does nothing if the message is empty.
+        void operator()(std::ostream& os) {
+            if (invoke_) {
+                invoke_(storage_, os);
+            }
+        }
+
+        /// Destroys the function and leaves the message empty.
+        void reset() {
+            if (destroy_) {
+                destroy_(storage_);
+            }
+            invoke_ = nullptr;
+            relocate_ = nullptr;
+            destroy_ = nullptr;
+        }
+
+    private: // helpers
+
+        /// Moves the function of the other, empty, message into this one.
+        void take(deferred_message& other) {
+            if (other.relocate_) {
+                other.relocate_(other.storage_, storage_);
+            }
+            invoke_ = other.invoke_;
+            relocate_ = other.relocate_;
+            destroy_ = other.destroy_;
+            other.invoke_ = nullptr;
+            other.relocate_ = nullptr;
+            other.destroy_ = nullptr;
+        }
+
+    }; // END class deferred_message
+
+
+    /// Interface of the output of the testers.
+    class reporter {
+
+    public: // constructors
+
+        virtual ~reporter() = default;
+
+    public: // methods
+
+        /** Writes a message. The reporter may call the formatting function later and on another thread,
+        so it must not refer to anything that may not live until then.
+        Thread-safe.
+        @param message The formatting function of the message.
+        */
+        virtual void report(deferred_message&& message) = 0;
+
+        /// Waits until all messages that were reported before the call are written and flushes the output.
+        virtual void flush() = 0;
+
+    }; // END class reporter
+
+
+    /// A reporter that formats the messages immediately onto an ostream.
+    class ostream_reporter : public reporter {
+
+    private: // vars
+
+        std::ostream& os_;          ///< The output stream.
+        std::mutex mutex_;          ///< Keeps concurrent messages from interleaving.
+
+    public: // constructors
+
+        /// Constructor.
+        explicit ostream_reporter(std::ostream& os = std::cout)
+            :
+            os_(os)
+        {}
+
+    public: // methods
+
+        /// Formats the message onto the output stream.
+        void report(deferred_message&& message) override {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            message(os_);
+        }
+
+        /// Flushes the output stream.
+        void flush() override {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            os_.flush();
+        }
+
+    }; // END class ostream_reporter
+
+
+    /** A reporter that queues the messages in a bounded lock-free ring buffer
+    for multiple producers and drains them on a background thread, which formats them onto an ostream.
+    If the ring buffer is full, report() waits until the background thread has made room.
+    flush() returns once the background thread has reached the messages that were queued before it,
+    even if other threads keep reporting.
+    */
+    class async_reporter : public reporter {
+
+    private: // inner classes
+
+        /// A slot of the ring buffer.
+        struct cell {
+            std::atomic<std::size_t> sequence;          ///< The ticket of the message for which the cell is ready.
+            deferred_message message;                   ///< The message.
+        };
+
+    private: // vars
+
+        std::ostream& os_;                              ///< The output stream.
+        std::unique_ptr<cell[]> cells_;                 ///< The ring buffer.
+        std::size_t mask_;                              ///< The capacity of the ring buffer minus one.
+        alignas(64) std::atomic<std::size_t> n_enqueued_{ 0 };  ///< The ticket of the next message.
+        alignas(64) std::atomic<std::size_t> n_written_{ 0 };   ///< The number of messages that are written and flushed.
+        std::atomic<std::size_t> n_flush_requested_{ 0 };       ///< The largest number of messages for which flush() waits.
+        std::atomic<bool> is_stopping_{ false };        ///< Tells the background thread to drain and exit.
+        std::mutex wake_mutex_;                         ///< The mutex of wake_.
+        std::condition_variable wake_;                  ///< Wakes the background thread up early.
+        std::mutex written_mutex_;                      ///< The mutex of written_.
+        std::condition_variable written_;               ///< Wakes the waiting flush() calls up when n_written_ advances.
+        std::thread drainer_;                           ///< The background thread.
+
+    public: // constructors
+
+        /** Constructor. Starts the background thread.
+        @param os The output stream.
+        @param capacity The number of messages that the ring buffer holds. Rounded up to a power of two.
+        */
+        explicit async_reporter(std::ostream& os = std::cout, const std::size_t capacity = 4096)
+            :
+            os_(os)
+        {
+            std::size_t n = 2;
+            while (n < capacity) {
+                n *= 2;
+            }
+            cells_.reset(new cell[n]);
+            mask_ = n - 1;
+            for (std::size_t i = 0; i < n; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            drainer_ = std::thread([this]() { drain(); });
+        }
+
+        async_reporter(const async_reporter&) = delete;
+        async_reporter& operator=(const async_reporter&) = delete;
+
+        /// Destructor. Writes all pending messages and stops the background thread.
+        ~async_reporter() {
+            is_stopping_.store(true);
+            wake_.notify_one();
+            drainer_.join();
+        }
+
+    public: // methods
+
+        /// Queues the message.
+        void report(deferred_message&& message) override {
+            std::size_t pos = n_enqueued_.load(std::memory_order_relaxed);
+            for (;;) {
+                cell& c = cells_[pos & mask_];
+                const std::size_t seq = c.sequence.load(std::memory_order_acquire);
+                if (seq == pos) {
+                    if (n_enqueued_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        c.message = std::move(message);
+                        c.sequence.store(pos + 1, std::memory_order_release);
+                        return;
+                    }
+                }
+                else if (seq < pos) {
+                    // full
+                    wake_.notify_one();
+                    std::this_thread::yield();
+                    pos = n_enqueued_.load(std::memory_order_relaxed);
+                }
+                else {
+                    pos = n_enqueued_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// Waits until the background thread has written and flushed all messages that were queued before the call.
+        void flush() override {
+            const std::size_t ticket = n_enqueued_.load();
+            if (n_written_.load(std::memory_order_acquire) >= ticket) {
+                return;
+            }
+            std::size_t requested = n_flush_requested_.load();
+            while (requested < ticket && !n_flush_requested_.compare_exchange_weak(requested, ticket)) {}
+            wake_.notify_one();
+
+            std::unique_lock<std::mutex> lock(written_mutex_);
+            written_.wait(lock, [this, ticket]() { return n_written_.load(std::memory_order_acquire) >= ticket; });
+        }
+
+    private: // helpers
+
+        /** The loop of the background thread. While a flush() waits, the written messages are published
+        once the background thread reaches its ticket and every 64 messages, so that flush() returns
+        although the ring buffer may never run empty.
+        */
+        void drain() {
+            std::size_t pos = 0;
+            for (;;) {
+                cell& c = cells_[pos & mask_];
+                if (c.sequence.load(std::memory_order_acquire) == pos + 1) {
+                    deferred_message message = std::move(c.message);
+                    c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    message(os_);
+                    ++pos;
+
+                    const std::size_t requested = n_flush_requested_.load(std::memory_order_relaxed);
+                    if (n_written_.load(std::memory_order_relaxed) < requested && (pos >= requested || pos % 64 == 0)) {
+                        publish(pos);
+                    }
+                    continue;
+                }
+
+                // empty
+                if (n_written_.load(std::memory_order_relaxed) != pos) {
+                    publish(pos);
+                }
+                if (is_stopping_.load() && n_enqueued_.load() == pos) {
+                    return;
+                }
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+
+        /// Flushes the output stream, then marks the given number of messages as written and wakes the waiting flush() calls up.
+        void publish(const std::size_t n_written) {
+            os_.flush();
+            {
+                // a flush() between its check and its wait does not miss the notification
+                const std::lock_guard<std::mutex> lock(written_mutex_);
+                n_written_.store(n_written, std::memory_order_release);
+            }
+            written_.notify_all();
+        }
+
+    }; // END class async_reporter
+
+} // END namespace unittest
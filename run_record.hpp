@@ -0,0 +1,930 @@
+/******************************************************************************
+/* @file Contains the machine-readable records of test runs: a recorder which
+/*       the testers add a record per test to, writers for JSON, CSV,
+/*       JUnit XML and a compact binary format, and the comparison of two
+/*       binary run records, which flags significant slowdowns per test.
+/*
+/* A record holds the counters, timing distributions, speedups, hardware
+/* counts, allocations and error case indices of a test, but not the error
+/* cases themselves, which can be re-created from their case indices.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+auto recorder = std::make_shared<run_record::recorder>();
+
+RandomizedFunctionTest<string, float, int> tester(fun, reference_fun, arg_creator);
+tester.set_recorder(recorder);
+tester.test("Test Run 1", 10000);
+
+std::ofstream json("run.json");
+run_record::write_json(json, recorder->records());     // or write_csv(), write_junit_xml()
+
+std::ofstream bin("run.bin", std::ios::binary);
+run_record::write_binary(bin, recorder->records());
+
+// later, against a baseline run record, see also compare_runs.cpp
+std::ifstream baseline_file("baseline.bin", std::ios::binary);
+std::vector<run_record::test_record> baseline;
+run_record::read_binary(baseline_file, baseline);
+auto comparisons = run_record::compare(baseline, recorder->records());
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "alloc_tracker.hpp"
+#include "perf_counters.hpp"
+#include "timing.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace run_record {
+
+        /// The distribution of the invocation durations of a function within a test, in nanoseconds.
+        struct distribution {
+            unsigned long long n_samples = 0;           ///< The number of samples. 0 if the function was not measured.
+            double mean_ns = 0;                         ///< The arithmetic mean.
+            double stddev_ns = 0;                       ///< The sample standard deviation.
+            double median_ns = 0;                       ///< The 50th percentile.
+            double p90_ns = 0;                          ///< The 90th percentile.
+            double p99_ns = 0;                          ///< The 99th percentile.
+            std::vector<unsigned long long> histogram;  ///< The bucket counts of a timing::log_histogram without the trailing empty buckets.
+                                                        ///< Empty if the test keeps no histogram.
+        };
+
+
+        /// The record of a single test, benchmark or randomized test series.
+        struct test_record {
+            std::string name;                                   ///< The name of the test.
+            std::string kind;                                   ///< The tester, e.g. "RandomizedFunctionTest".
+            unsigned long long n_tests = 0;                     ///< The number of conducted tests.
+            unsigned long long n_passed_tests = 0;              ///< The number of passed tests.
+            bool is_passed = false;                             ///< Whether the test passed as a whole.
+            distribution duration;                              ///< The invocation durations of the function.
+            distribution reference_duration;                    ///< The invocation durations of the reference function, if any.
+            double speedup = 0;                                 ///< The speedup over the reference function. 0 if there is none.
+            double speedup_ci_lower = 0;                        ///< The lower bound of the 95% confidence interval of speedup.
+            double speedup_ci_upper = 0;                        ///< The upper bound of the 95% confidence interval of speedup.
+            perf_counters::counts counters;                     ///< The hardware counts per invocation. NaN if not measured.
+            perf_counters::counts reference_counters;           ///< The hardware counts per reference function invocation.
+            alloc_tracker::counts allocations;                  ///< The heap allocations of all invocations.
+            alloc_tracker::counts reference_allocations;        ///< The heap allocations of all reference function invocations.
+            std::vector<unsigned int> error_case_indices;       ///< The case indices of the kept error cases.
+        };
+
+
+        /** Returns the distribution of the samples of the given statistics and histogram.
+        @param stats The running statistics of the samples.
+        @param histogram The histogram of the same samples.
+        */
+        inline distribution make_distribution(const timing::running_stats& stats, const timing::log_histogram& histogram) {
+            distribution ret;
+            ret.n_samples = stats.n;
+            ret.mean_ns = stats.mean;
+            ret.stddev_ns = stats.stddev();
+            ret.median_ns = histogram.percentile(50);
+            ret.p90_ns = histogram.percentile(90);
+            ret.p99_ns = histogram.percentile(99);
+
+            unsigned int n_buckets = timing::log_histogram::n_buckets;
+            while (n_buckets > 0 && histogram.counts[n_buckets - 1] == 0) {
+                --n_buckets;
+            }
+            ret.histogram.assign(histogram.counts.begin(), histogram.counts.begin() + n_buckets);
+            return ret;
+        }
+
+
+        /// Returns the distribution of the samples of the given statistics, which have no histogram.
+        inline distribution make_distribution(const timing::statistics& stats) {
+            distribution ret;
+            ret.n_samples = stats.n_samples;
+            ret.mean_ns = stats.mean;
+            ret.stddev_ns = stats.stddev;
+            ret.median_ns = stats.median;
+            ret.p90_ns = stats.p90;
+            ret.p99_ns = stats.p99;
+            return ret;
+        }
+
+
+        /** Returns the record of a test series of a RandomizedFunctionTest.
+        @param name The name of the test.
+        @param result The return value of RandomizedFunctionTest::test().
+        @param is_counted Whether hardware counters were measured. Otherwise the counts are NaN.
+        */
+        template <typename TestReturnType>
+        test_record from_randomized_function_test(const std::string& name, const TestReturnType& result, const bool is_counted) {
+            test_record ret;
+            ret.name = name;
+            ret.kind = "RandomizedFunctionTest";
+            ret.n_tests = result.n_tests;
+            ret.n_passed_tests = result.n_passed_tests;
+            ret.is_passed = !result.is_aborted && result.is_all_tests_passed() && result.is_speedup_sufficient && result.is_allocation_within_reference;
+            ret.duration = make_distribution(result.invocation_duration_ns_stats, result.invocation_duration_ns_histogram);
+            ret.reference_duration = make_distribution(result.reference_invocation_duration_ns_stats, result.reference_invocation_duration_ns_histogram);
+            ret.speedup = result.speedup;
+            ret.speedup_ci_lower = result.speedup_ci_lower;
+            ret.speedup_ci_upper = result.speedup_ci_upper;
+            ret.counters = is_counted ? result.average_counters : perf_counters::unavailable();
+            ret.reference_counters = is_counted ? result.reference_average_counters : perf_counters::unavailable();
+            ret.allocations = result.allocations;
+            ret.reference_allocations = result.reference_allocations;
+            for (const auto& ec : result.error_cases) {
+                ret.error_case_indices.push_back(ec.case_index);
+            }
+            return ret;
+        }
+
+
+        /** Returns the record of a single test of a FunctionTest.
+        @param name The name of the test.
+        @param result The return value of FunctionTest::test().
+        @param is_counted Whether hardware counters were measured. Otherwise the counts are NaN.
+        */
+        template <typename TestReturnType>
+        test_record from_function_test(const std::string& name, const TestReturnType& result, const bool is_counted) {
+            test_record ret;
+            ret.name = name;
+            ret.kind = "FunctionTest";
+            ret.n_tests = 1;
+            ret.n_passed_tests = result.is_passed ? 1 : 0;
+            ret.is_passed = result.is_passed;
+
+            const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(result.invocation_duration).count());
+            timing::running_stats stats;
+            timing::log_histogram histogram;
+            stats.add(ns);
+            histogram.add(ns);
+            ret.duration = make_distribution(stats, histogram);
+
+            ret.counters = is_counted ? result.counters : perf_counters::unavailable();
+            ret.reference_counters = perf_counters::unavailable();
+            ret.allocations = result.allocations;
+            return ret;
+        }
+
+
+        /** Returns the record of a group of tests of a FunctionTest that were timed as a whole.
+        @param name The name of the test.
+        @param n_tests The number of tests in the group.
+        @param n_passed_tests The number of passed tests in the group.
+        @param invocation_duration The duration of all invocations of the group.
+        */
+        template <typename DurationType>
+        test_record from_test_group(const std::string& name, const std::size_t n_tests, const std::size_t n_passed_tests, const DurationType invocation_duration) {
+            test_record ret;
+            ret.name = name;
+            ret.kind = "FunctionTest";
+            ret.n_tests = static_cast<unsigned int>(n_tests);
+            ret.n_passed_tests = static_cast<unsigned int>(n_passed_tests);
+            ret.is_passed = n_tests == n_passed_tests;
+
+            // the tests are timed as a whole, hence the distribution holds their mean
+            const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(invocation_duration).count());
+            timing::running_stats stats;
+            timing::log_histogram histogram;
+            if (n_tests > 0) {
+                stats.add(ns / n_tests);
+                histogram.add(ns / n_tests);
+            }
+            ret.duration = make_distribution(stats, histogram);
+
+            ret.counters = perf_counters::unavailable();
+            ret.reference_counters = perf_counters::unavailable();
+            return ret;
+        }
+
+
+        /** Returns the record of a test table of a FunctionTest, with one test per row.
+        @param name The name of the test.
+        @param result The return value of FunctionTest::test_table().
+        */
+        template <typename TableReturnType>
+        test_record from_test_table(const std::string& name, const TableReturnType& result) {
+            return from_test_group(name, result.n_rows, result.n_passed_rows, result.invocation_duration);
+        }
+
+
+        /** Returns the record of the cases of a case file of a FunctionTest, with one test per case.
+        @param name The name of the test.
+        @param result The return value of FunctionTest::test_cases().
+        */
+        template <typename CasesReturnType>
+        test_record from_test_cases(const std::string& name, const CasesReturnType& result) {
+            return from_test_group(name, result.n_cases, result.n_passed_cases, result.invocation_duration);
+        }
+
+
+        /** Returns the records of a MultiVariantFunctionTest series, one per variant, named "name: variant".
+        @param name The name of the test series.
+        @param result The return value of MultiVariantFunctionTest::test().
+        */
+        template <typename TestReturnType>
+        std::vector<test_record> from_multi_variant_function_test(const std::string& name, const TestReturnType& result) {
+            std::vector<test_record> ret;
+            for (const auto& variant : result.variants) {
+                test_record r;
+                r.name = name + ": " + variant.name;
+                r.kind = "MultiVariantFunctionTest";
+                r.n_tests = variant.n_tests;
+                r.n_passed_tests = variant.n_passed_tests;
+                r.is_passed = !result.is_aborted && variant.is_all_tests_passed();
+                r.duration = make_distribution(variant.invocation_duration_ns_stats, variant.invocation_duration_ns_histogram);
+                r.reference_duration = make_distribution(result.reference_invocation_duration_ns_stats, result.reference_invocation_duration_ns_histogram);
+                r.speedup = variant.speedup;
+                r.speedup_ci_lower = variant.speedup_ci_lower;
+                r.speedup_ci_upper = variant.speedup_ci_upper;
+                r.counters = perf_counters::unavailable();
+                r.reference_counters = perf_counters::unavailable();
+                for (const auto& ec : variant.error_cases) {
+                    r.error_case_indices.push_back(ec.case_index);
+                }
+                ret.push_back(std::move(r));
+            }
+            return ret;
+        }
+
+
+        /** Returns the records of a stress series of a RandomizedFunctionTest, one per thread count, named "name: n threads".
+        Their durations hold the wall-clock time per invocation and thread, so that contention shows up as a slowdown.
+        @param name The name of the stress series.
+        @param result The return value of RandomizedFunctionTest::test_stress().
+        */
+        template <typename StressReturnType>
+        std::vector<test_record> from_stress_test(const std::string& name, const StressReturnType& result) {
+            std::vector<test_record> ret;
+            for (const auto& level : result.levels) {
+                test_record r = from_test_group(name + ": " + std::to_string(level.n_threads) + " threads", level.n_tests, level.n_passed_tests, level.duration * level.n_threads);
+                r.kind = "RandomizedFunctionTest";
+                r.is_passed = r.is_passed && !level.is_aborted && result.is_efficiency_sufficient;
+                for (const auto& ec : level.error_cases) {
+                    r.error_case_indices.push_back(ec.case_index);
+                }
+                ret.push_back(std::move(r));
+            }
+            return ret;
+        }
+
+
+        /** Returns the record of a Benchmark run.
+        @param name The name of the benchmark.
+        @param result The return value of Benchmark::run() or Benchmark::run_series().
+        */
+        template <typename BenchmarkReturnType>
+        test_record from_benchmark(const std::string& name, const BenchmarkReturnType& result) {
+            test_record ret;
+            ret.name = name;
+            ret.kind = "Benchmark";
+            ret.n_tests = result.invocation_duration_ns.n_samples > 0 ? 1 : 0;
+            ret.n_passed_tests = ret.n_tests;
+            ret.is_passed = ret.n_tests > 0;
+            ret.duration = make_distribution(result.invocation_duration_ns);
+            ret.counters = perf_counters::unavailable();
+            ret.reference_counters = perf_counters::unavailable();
+            return ret;
+        }
+
+
+        /// Collects the records of the tests of a run. Several testers can share one recorder. Thread-safe.
+        class recorder {
+
+        private: // vars
+
+            std::vector<test_record> records_;      ///< The records in the order in which they were added.
+            mutable std::mutex mutex_;              ///< Guards records_.
+
+        public: // methods
+
+            /// Adds a record.
+            void add(test_record record) {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                records_.push_back(std::move(record));
+            }
+
+            /// Returns a copy of the records.
+            std::vector<test_record> records() const {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                return records_;
+            }
+
+            /// Removes all records.
+            void clear() {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                records_.clear();
+            }
+
+        }; // END class recorder
+
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// Writes a JSON string literal.
+            inline void write_json_string(std::ostream& os, const std::string& s) {
+                os << '"';
+                for (const char c : s) {
+                    switch (c) {
+                        case '"':  os << "\\\""; break;
+                        case '\\': os << "\\\\"; break;
+                        case '\n': os << "\\n"; break;
+                        case '\r': os << "\\r"; break;
+                        case '\t': os << "\\t"; break;
+                        default:
+                            if (static_cast<unsigned char>(c) < 0x20) {
+                                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+                            }
+                            else {
+                                os << c;
+                            }
+                    }
+                }
+                os << '"';
+            }
+
+            /// Writes a JSON number, or null if it is not finite.
+            inline void write_json_number(std::ostream& os, const double v) {
+                if (std::isfinite(v)) {
+                    os << v;
+                }
+                else {
+                    os << "null";
+                }
+            }
+
+            /// Writes a distribution as a JSON object.
+            inline void write_json(std::ostream& os, const distribution& d) {
+                os << "{\"n_samples\": " << d.n_samples << ", \"mean\": ";
+                write_json_number(os, d.mean_ns);
+                os << ", \"stddev\": ";
+                write_json_number(os, d.stddev_ns);
+                os << ", \"median\": ";
+                write_json_number(os, d.median_ns);
+                os << ", \"p90\": ";
+                write_json_number(os, d.p90_ns);
+                os << ", \"p99\": ";
+                write_json_number(os, d.p99_ns);
+                os << ", \"histogram\": [";
+                for (std::size_t i = 0; i < d.histogram.size(); ++i) {
+                    os << (i > 0 ? ", " : "") << d.histogram[i];
+                }
+                os << "]}";
+            }
+
+            /// Writes hardware counts as a JSON object.
+            inline void write_json(std::ostream& os, const perf_counters::counts& c) {
+                os << "{\"cycles\": ";
+                write_json_number(os, c.cycles);
+                os << ", \"instructions\": ";
+                write_json_number(os, c.instructions);
+                os << ", \"l1d_read_misses\": ";
+                write_json_number(os, c.l1d_read_misses);
+                os << ", \"llc_misses\": ";
+                write_json_number(os, c.llc_misses);
+                os << ", \"branch_misses\": ";
+                write_json_number(os, c.branch_misses);
+                os << "}";
+            }
+
+            /// Writes allocation counts as a JSON object.
+            inline void write_json(std::ostream& os, const alloc_tracker::counts& a) {
+                os <<
+                    "{\"n_allocations\": " << a.n_allocations <<
+                    ", \"n_deallocations\": " << a.n_deallocations <<
+                    ", \"n_bytes_allocated\": " << a.n_bytes_allocated <<
+                    ", \"n_bytes_deallocated\": " << a.n_bytes_deallocated <<
+                    ", \"peak_live_bytes\": " << a.peak_live_bytes << "}";
+            }
+
+            /// Writes a CSV field, quoted if necessary.
+            inline void write_csv_field(std::ostream& os, const std::string& s) {
+                if (s.find_first_of(",\"\n\r") == std::string::npos) {
+                    os << s;
+                    return;
+                }
+                os << '"';
+                for (const char c : s) {
+                    os << (c == '"' ? "\"\"" : std::string(1, c));
+                }
+                os << '"';
+            }
+
+            /// Writes a CSV number, or an empty field if it is not finite.
+            inline void write_csv_number(std::ostream& os, const double v) {
+                if (std::isfinite(v)) {
+                    os << v;
+                }
+            }
+
+            /// Writes XML character data or an attribute value with the special characters escaped.
+            inline void write_xml_text(std::ostream& os, const std::string& s) {
+                for (const char c : s) {
+                    switch (c) {
+                        case '&':  os << "&amp;"; break;
+                        case '<':  os << "&lt;"; break;
+                        case '>':  os << "&gt;"; break;
+                        case '"':  os << "&quot;"; break;
+                        case '\'': os << "&apos;"; break;
+                        default:   os << c;
+                    }
+                }
+            }
+
+            /// Writes an unsigned integer in little-endian byte order.
+            inline void write_u64(std::ostream& os, const std::uint64_t v) {
+                char bytes[8];
+                for (int i = 0; i < 8; ++i) {
+                    bytes[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+                }
+                os.write(bytes, 8);
+            }
+
+            /// Writes a double by its IEEE 754 representation in little-endian byte order.
+            inline void write_f64(std::ostream& os, const double v) {
+                std::uint64_t bits;
+                std::memcpy(&bits, &v, sizeof(bits));
+                write_u64(os, bits);
+            }
+
+            /// Writes a string with its length.
+            inline void write_string(std::ostream& os, const std::string& s) {
+                write_u64(os, s.size());
+                os.write(s.data(), static_cast<std::streamsize>(s.size()));
+            }
+
+            /// Reads an unsigned integer in little-endian byte order. Leaves the stream failed at the end of the input.
+            inline std::uint64_t read_u64(std::istream& is) {
+                unsigned char bytes[8] = {};
+                is.read(reinterpret_cast<char*>(bytes), 8);
+                std::uint64_t ret = 0;
+                for (int i = 0; i < 8; ++i) {
+                    ret |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+                }
+                return ret;
+            }
+
+            /// Reads a double that write_f64() wrote.
+            inline double read_f64(std::istream& is) {
+                const std::uint64_t bits = read_u64(is);
+                double ret;
+                std::memcpy(&ret, &bits, sizeof(ret));
+                return ret;
+            }
+
+            /** Reads a string that write_string() wrote.
+            @param max_size Strings longer than this are treated as corrupt input.
+            */
+            inline std::string read_string(std::istream& is, const std::uint64_t max_size = 1 << 20) {
+                const std::uint64_t size = read_u64(is);
+                if (!is || size > max_size) {
+                    is.setstate(std::ios::failbit);
+                    return std::string();
+                }
+                std::string ret(static_cast<std::size_t>(size), '\0');
+                is.read(&ret[0], static_cast<std::streamsize>(size));
+                return ret;
+            }
+
+            /// Writes a distribution in the binary format.
+            inline void write_binary(std::ostream& os, const distribution& d) {
+                write_u64(os, d.n_samples);
+                write_f64(os, d.mean_ns);
+                write_f64(os, d.stddev_ns);
+                write_f64(os, d.median_ns);
+                write_f64(os, d.p90_ns);
+                write_f64(os, d.p99_ns);
+                write_u64(os, d.histogram.size());
+                for (const auto count : d.histogram) {
+                    write_u64(os, count);
+                }
+            }
+
+            /// Reads a distribution in the binary format.
+            inline distribution read_distribution(std::istream& is) {
+                distribution ret;
+                ret.n_samples = read_u64(is);
+                ret.mean_ns = read_f64(is);
+                ret.stddev_ns = read_f64(is);
+                ret.median_ns = read_f64(is);
+                ret.p90_ns = read_f64(is);
+                ret.p99_ns = read_f64(is);
+                const std::uint64_t n_buckets = read_u64(is);
+                if (!is || n_buckets > timing::log_histogram::n_buckets) {
+                    is.setstate(std::ios::failbit);
+                    return ret;
+                }
+                for (std::uint64_t i = 0; i < n_buckets; ++i) {
+                    ret.histogram.push_back(read_u64(is));
+                }
+                return ret;
+            }
+
+            /// Writes hardware counts in the binary format.
+            inline void write_binary(std::ostream& os, const perf_counters::counts& c) {
+                write_f64(os, c.cycles);
+                write_f64(os, c.instructions);
+                write_f64(os, c.l1d_read_misses);
+                write_f64(os, c.llc_misses);
+                write_f64(os, c.branch_misses);
+            }
+
+            /// Reads hardware counts in the binary format.
+            inline perf_counters::counts read_counts(std::istream& is) {
+                perf_counters::counts ret;
+                ret.cycles = read_f64(is);
+                ret.instructions = read_f64(is);
+                ret.l1d_read_misses = read_f64(is);
+                ret.llc_misses = read_f64(is);
+                ret.branch_misses = read_f64(is);
+                return ret;
+            }
+
+            /// Writes allocation counts in the binary format.
+            inline void write_binary(std::ostream& os, const alloc_tracker::counts& a) {
+                write_u64(os, a.n_allocations);
+                write_u64(os, a.n_deallocations);
+                write_u64(os, a.n_bytes_allocated);
+                write_u64(os, a.n_bytes_deallocated);
+                write_u64(os, a.peak_live_bytes);
+            }
+
+            /// Reads allocation counts in the binary format.
+            inline alloc_tracker::counts read_allocations(std::istream& is) {
+                alloc_tracker::counts ret;
+                ret.n_allocations = read_u64(is);
+                ret.n_deallocations = read_u64(is);
+                ret.n_bytes_allocated = read_u64(is);
+                ret.n_bytes_deallocated = read_u64(is);
+                ret.peak_live_bytes = read_u64(is);
+                return ret;
+            }
+
+            /// Returns the regularized incomplete beta function I_x(a, b), evaluated with the continued fraction after Lentz.
+            inline double incomplete_beta(const double a, const double b, const double x) {
+                if (x <= 0) {
+                    return 0;
+                }
+                if (x >= 1) {
+                    return 1;
+                }
+                // the continued fraction converges fast for x < (a + 1) / (a + b + 2), else use the symmetry
+                if (x > (a + 1) / (a + b + 2)) {
+                    return 1 - incomplete_beta(b, a, 1 - x);
+                }
+                const double tiny = 1e-300;
+                const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1 - x)) / a;
+
+                double c = 1;
+                double d = 1 - (a + b) * x / (a + 1);
+                d = 1 / (std::fabs(d) < tiny ? tiny : d);
+                double f = d;
+                for (int m = 1; m <= 300; ++m) {
+                    for (int k = 0; k < 2; ++k) {
+                        const double numerator = k == 0
+                            ? m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m))
+                            : -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+                        d = 1 + numerator * d;
+                        d = 1 / (std::fabs(d) < tiny ? tiny : d);
+                        c = 1 + numerator / c;
+                        c = std::fabs(c) < tiny ? tiny : c;
+                        f *= c * d;
+                        if (k == 1 && std::fabs(c * d - 1) < 1e-12) {
+                            return front * f;
+                        }
+                    }
+                }
+                return front * f;
+            }
+
+            /// Returns the probability that a Student-t distributed variable with df degrees of freedom exceeds t.
+            inline double student_t_upper_tail(const double t, const double df) {
+                const double tail = 0.5 * incomplete_beta(df / 2, 0.5, df / (df + t * t));
+                return t >= 0 ? tail : 1 - tail;
+            }
+
+        } // END namespace detail
+
+
+        /// Writes the records as a JSON document.
+        inline void write_json(std::ostream& os, const std::vector<test_record>& records) {
+            const auto precision = os.precision(17);
+            os << "{\n  \"records\": [";
+            for (std::size_t i = 0; i < records.size(); ++i) {
+                const auto& r = records[i];
+                os << (i > 0 ? ",\n" : "\n") << "    {\"name\": ";
+                detail::write_json_string(os, r.name);
+                os << ", \"kind\": ";
+                detail::write_json_string(os, r.kind);
+                os << ", \"n_tests\": " << r.n_tests << ", \"n_passed_tests\": " << r.n_passed_tests << ", \"is_passed\": " << (r.is_passed ? "true" : "false");
+                os << ",\n     \"duration_ns\": ";
+                detail::write_json(os, r.duration);
+                os << ",\n     \"reference_duration_ns\": ";
+                detail::write_json(os, r.reference_duration);
+                os << ",\n     \"speedup\": ";
+                detail::write_json_number(os, r.speedup);
+                os << ", \"speedup_ci_lower\": ";
+                detail::write_json_number(os, r.speedup_ci_lower);
+                os << ", \"speedup_ci_upper\": ";
+                detail::write_json_number(os, r.speedup_ci_upper);
+                os << ",\n     \"counters\": ";
+                detail::write_json(os, r.counters);
+                os << ",\n     \"reference_counters\": ";
+                detail::write_json(os, r.reference_counters);
+                os << ",\n     \"allocations\": ";
+                detail::write_json(os, r.allocations);
+                os << ",\n     \"reference_allocations\": ";
+                detail::write_json(os, r.reference_allocations);
+                os << ",\n     \"error_case_indices\": [";
+                for (std::size_t j = 0; j < r.error_case_indices.size(); ++j) {
+                    os << (j > 0 ? ", " : "") << r.error_case_indices[j];
+                }
+                os << "]}";
+            }
+            os << "\n  ]\n}\n";
+            os.precision(precision);
+        }
+
+
+        /// Writes the records as CSV with a header line, one line per record. Unavailable values are empty fields.
+        inline void write_csv(std::ostream& os, const std::vector<test_record>& records) {
+            const auto precision = os.precision(17);
+            os <<
+                "name,kind,n_tests,n_passed_tests,is_passed,"
+                "mean_ns,stddev_ns,median_ns,p90_ns,p99_ns,"
+                "reference_mean_ns,reference_stddev_ns,reference_median_ns,reference_p90_ns,reference_p99_ns,"
+                "speedup,speedup_ci_lower,speedup_ci_upper,"
+                "cycles,instructions,l1d_read_misses,llc_misses,branch_misses,"
+                "n_allocations,n_bytes_allocated,peak_live_bytes,"
+                "reference_n_allocations,reference_n_bytes_allocated,reference_peak_live_bytes\n";
+            for (const auto& r : records) {
+                detail::write_csv_field(os, r.name);
+                os << ',';
+                detail::write_csv_field(os, r.kind);
+                os << ',' << r.n_tests << ',' << r.n_passed_tests << ',' << (r.is_passed ? 1 : 0);
+                for (const auto* d : { &r.duration, &r.reference_duration }) {
+                    for (const double v : { d->mean_ns, d->stddev_ns, d->median_ns, d->p90_ns, d->p99_ns }) {
+                        os << ',';
+                        if (d->n_samples > 0) {
+                            detail::write_csv_number(os, v);
+                        }
+                    }
+                }
+                for (const double v : { r.speedup, r.speedup_ci_lower, r.speedup_ci_upper,
+                    r.counters.cycles, r.counters.instructions, r.counters.l1d_read_misses, r.counters.llc_misses, r.counters.branch_misses }) {
+                    os << ',';
+                    detail::write_csv_number(os, v);
+                }
+                for (const auto* a : { &r.allocations, &r.reference_allocations }) {
+                    os << ',' << a->n_allocations << ',' << a->n_bytes_allocated << ',' << a->peak_live_bytes;
+                }
+                os << '\n';
+            }
+            os.precision(precision);
+        }
+
+
+        /** Writes the records as a JUnit XML test suite, one test case per record, so that CI systems can display them.
+        The time of a test case is the sum of the measured invocation durations of the function.
+        @param os The output stream.
+        @param records The records.
+        @param suite_name The name of the test suite.
+        */
+        inline void write_junit_xml(std::ostream& os, const std::vector<test_record>& records, const std::string& suite_name = "barn_test") {
+            const auto seconds = [](const test_record& r) { return r.duration.n_samples * r.duration.mean_ns / 1e9; };
+
+            unsigned int n_failures = 0;
+            double total_seconds = 0;
+            for (const auto& r : records) {
+                n_failures += r.is_passed ? 0 : 1;
+                total_seconds += seconds(r);
+            }
+
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(9);
+            ss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuite name=\"";
+            detail::write_xml_text(ss, suite_name);
+            ss << "\" tests=\"" << records.size() << "\" failures=\"" << n_failures << "\" errors=\"0\" time=\"" << total_seconds << "\">\n";
+            for (const auto& r : records) {
+                ss << "  <testcase classname=\"";
+                detail::write_xml_text(ss, r.kind);
+                ss << "\" name=\"";
+                detail::write_xml_text(ss, r.name);
+                ss << "\" time=\"" << seconds(r) << "\"";
+                if (r.is_passed) {
+                    ss << "/>\n";
+                    continue;
+                }
+                ss << ">\n    <failure message=\"" << r.n_passed_tests << "/" << r.n_tests << " tests passed";
+                if (r.speedup > 0) {
+                    ss << ", speedup " << std::setprecision(3) << r.speedup << "x" << std::setprecision(9);
+                }
+                ss << "\"/>\n  </testcase>\n";
+            }
+            ss << "</testsuite>\n";
+            os << ss.str();
+        }
+
+
+        /** Writes the records in the compact binary format, which read_binary() reads.
+        All numbers are 8 bytes in little-endian byte order, so that the format does not depend on the platform.
+        Open file streams in binary mode.
+        */
+        inline void write_binary(std::ostream& os, const std::vector<test_record>& records) {
+            os.write("BARNRUN1", 8);
+            detail::write_u64(os, records.size());
+            for (const auto& r : records) {
+                detail::write_string(os, r.name);
+                detail::write_string(os, r.kind);
+                detail::write_u64(os, r.n_tests);
+                detail::write_u64(os, r.n_passed_tests);
+                detail::write_u64(os, r.is_passed ? 1 : 0);
+                detail::write_binary(os, r.duration);
+                detail::write_binary(os, r.reference_duration);
+                detail::write_f64(os, r.speedup);
+                detail::write_f64(os, r.speedup_ci_lower);
+                detail::write_f64(os, r.speedup_ci_upper);
+                detail::write_binary(os, r.counters);
+                detail::write_binary(os, r.reference_counters);
+                detail::write_binary(os, r.allocations);
+                detail::write_binary(os, r.reference_allocations);
+                detail::write_u64(os, r.error_case_indices.size());
+                for (const auto i : r.error_case_indices) {
+                    detail::write_u64(os, i);
+                }
+            }
+        }
+
+
+        /** Reads records in the binary format of write_binary().
+        @param is The input stream.
+        @param[out] out_records The records. Cleared first.
+        @return False if the input is not a run record or is truncated.
+        */
+        inline bool read_binary(std::istream& is, std::vector<test_record>& out_records) {
+            out_records.clear();
+
+            char magic[8] = {};
+            is.read(magic, 8);
+            if (!is || std::memcmp(magic, "BARNRUN1", 8) != 0) {
+                return false;
+            }
+            const std::uint64_t n_records = detail::read_u64(is);
+            for (std::uint64_t i = 0; i < n_records && is; ++i) {
+                test_record r;
+                r.name = detail::read_string(is);
+                r.kind = detail::read_string(is);
+                r.n_tests = detail::read_u64(is);
+                r.n_passed_tests = detail::read_u64(is);
+                r.is_passed = detail::read_u64(is) != 0;
+                r.duration = detail::read_distribution(is);
+                r.reference_duration = detail::read_distribution(is);
+                r.speedup = detail::read_f64(is);
+                r.speedup_ci_lower = detail::read_f64(is);
+                r.speedup_ci_upper = detail::read_f64(is);
+                r.counters = detail::read_counts(is);
+                r.reference_counters = detail::read_counts(is);
+                r.allocations = detail::read_allocations(is);
+                r.reference_allocations = detail::read_allocations(is);
+                const std::uint64_t n_error_cases = detail::read_u64(is);
+                for (std::uint64_t j = 0; j < n_error_cases && is; ++j) {
+                    r.error_case_indices.push_back(static_cast<unsigned int>(detail::read_u64(is)));
+                }
+                if (is) {
+                    out_records.push_back(std::move(r));
+                }
+            }
+            return static_cast<bool>(is);
+        }
+
+
+        /// The comparison of the invocation durations of a test in two runs.
+        struct comparison {
+            std::string name;                   ///< The name of the test.
+            std::string kind;                   ///< The tester.
+            double baseline_mean_ns = 0;        ///< The mean invocation duration in the baseline run.
+            double candidate_mean_ns = 0;       ///< The mean invocation duration in the candidate run.
+            double change_percent = 0;          ///< The change of the mean from the baseline to the candidate, in percent. Positive if slower.
+            double p_value = 1;                 ///< The one-sided p-value of Welch's t-test for the change in the observed direction.
+                                                ///< NaN if either run has less than two samples.
+            bool is_slowdown = false;           ///< Whether the candidate is significantly and relevantly slower.
+            bool is_speedup = false;            ///< Whether the candidate is significantly and relevantly faster.
+        };
+
+
+        /** Compares the invocation durations of the tests of two runs. Tests are matched by kind and name,
+        tests with the same kind and name by their order. Tests that are missing in either run are left out.
+        A change counts if Welch's t-test on the mean durations is significant and the change exceeds a threshold.
+        @param baseline The records of the baseline run.
+        @param candidate The records of the candidate run.
+        @param alpha The significance level of the one-sided test.
+        @param min_change_percent The smallest relevant change of the mean, in percent.
+        @return The comparisons in the order of the candidate records.
+        */
+        inline std::vector<comparison> compare(
+            const std::vector<test_record>& baseline,
+            const std::vector<test_record>& candidate,
+            const double alpha = 0.01,
+            const double min_change_percent = 5)
+        {
+            std::map<std::pair<std::string, std::string>, std::vector<const test_record*>> baseline_by_key;
+            for (auto it = baseline.rbegin(); it != baseline.rend(); ++it) {
+                baseline_by_key[std::make_pair(it->kind, it->name)].push_back(&*it);
+            }
+
+            std::vector<comparison> ret;
+            for (const auto& c : candidate) {
+                auto& matches = baseline_by_key[std::make_pair(c.kind, c.name)];
+                if (matches.empty()) {
+                    continue;
+                }
+                const test_record& b = *matches.back();
+                matches.pop_back();
+                if (b.duration.n_samples == 0 || c.duration.n_samples == 0) {
+                    continue;
+                }
+
+                comparison cmp;
+                cmp.name = c.name;
+                cmp.kind = c.kind;
+                cmp.baseline_mean_ns = b.duration.mean_ns;
+                cmp.candidate_mean_ns = c.duration.mean_ns;
+                cmp.change_percent = b.duration.mean_ns > 0 ? (c.duration.mean_ns / b.duration.mean_ns - 1) * 100 : 0;
+
+                if (b.duration.n_samples < 2 || c.duration.n_samples < 2) {
+                    cmp.p_value = std::numeric_limits<double>::quiet_NaN();
+                    ret.push_back(cmp);
+                    continue;
+                }
+
+                const double nb = static_cast<double>(b.duration.n_samples);
+                const double nc = static_cast<double>(c.duration.n_samples);
+                const double vb = b.duration.stddev_ns * b.duration.stddev_ns / nb;
+                const double vc = c.duration.stddev_ns * c.duration.stddev_ns / nc;
+                const double difference = std::fabs(c.duration.mean_ns - b.duration.mean_ns);
+                if (vb + vc > 0) {
+                    const double t = difference / std::sqrt(vb + vc);
+                    const double df = (vb + vc) * (vb + vc) / (vb * vb / (nb - 1) + vc * vc / (nc - 1));
+                    cmp.p_value = detail::student_t_upper_tail(t, df);
+                }
+                else {
+                    cmp.p_value = difference > 0 ? 0 : 1;
+                }
+
+                const bool is_significant = cmp.p_value < alpha && std::fabs(cmp.change_percent) >= min_change_percent;
+                cmp.is_slowdown = is_significant && cmp.change_percent > 0;
+                cmp.is_speedup = is_significant && cmp.change_percent < 0;
+                ret.push_back(cmp);
+            }
+            return ret;
+        }
+
+
+        /// Writes the comparisons as a table, one line per test.
+        inline void write_comparison(std::ostream& os, const std::vector<comparison>& comparisons) {
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(2);
+            for (const auto& cmp : comparisons) {
+                std::string output = cmp.kind + ": " + cmp.name + ": ";
+                output.resize(std::max<std::size_t>(output.size(), 50), '.');
+                ss << output << " " << cmp.baseline_mean_ns << " ns -> " << cmp.candidate_mean_ns << " ns (" << std::showpos << cmp.change_percent << std::noshowpos << "%, p ";
+                if (std::isnan(cmp.p_value)) {
+                    ss << "n/a";
+                }
+                else {
+                    ss << std::setprecision(4) << cmp.p_value << std::setprecision(2);
+                }
+                ss << ")" << (cmp.is_slowdown ? " SLOWDOWN" : cmp.is_speedup ? " SPEEDUP" : "") << "\n";
+            }
+            os << ss.str();
+        }
+
+    } // END namespace run_record
+
+} // END namespace unittest
@@ -1,16 +1,1809 @@
 /******************************************************************************
 @file Unit Tests for barn_test Module
 
+The tests are registered test series, see registry.hpp. Compile and link
+this file with barn_test_main.cpp, e.g.
+
+    g++ -std=c++17 -O2 -pthread -I. test_barn_test.cpp barn_test_main.cpp -o test_barn_test
+    ./test_barn_test --filter=registry/*
+
+The series write their files into the temporary directory.
+
 @author: langenhagen
-@version: 160128
+@version: 261015
 
 ******************************************************************************/
 
+#define UNITTEST_ALLOC_TRACKER_IMPLEMENTATION   // counts the allocations for the alloc_tracker series
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <Benchmark.hpp>
 #include <FunctionTest.hpp>
+#include <MultiVariantFunctionTest.hpp>
+#include <RandomizedFunctionTest.hpp>
+#include <alloc_tracker.hpp>
+#include <case_file.hpp>
+#include <complexity.hpp>
+#include <corpus.hpp>
+#include <formatting.hpp>
+#include <perf_counters.hpp>
+#include <process_isolation.hpp>
+#include <random_args.hpp>
+#include <reference_cache.hpp>
+#include <registry.hpp>
+#include <reporter.hpp>
+#include <run_record.hpp>
+#include <test_table.hpp>
+#include <tolerance.hpp>
+
+using namespace unittest;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HELPERS
+
+namespace {
+
+    /// Joins the given numbers with commas.
+    template <typename T>
+    std::string join(const std::vector<T>& values) {
+        std::stringstream ss;
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            ss << (i > 0 ? "," : "") << values[i];
+        }
+        return ss.str();
+    }
+
+
+    /// Returns the path of a file of a test series in the temporary directory.
+    std::string temp_path(const std::string& name) {
+        return (std::filesystem::temp_directory_path() / ("test_barn_test." + name)).string();
+    }
+
+
+    /// Returns a FunctionTest that writes to the reporter of the series.
+    template <typename ResultType, typename... ArgTypes>
+    FunctionTest<ResultType, ArgTypes...> make_tester(
+        registry::context& ctx,
+        typename FunctionTest<ResultType, ArgTypes...>::FunctionType function,
+        typename FunctionTest<ResultType, ArgTypes...>::ToStringFunctionType to_string = default_functions::stream_to_string())
+    {
+        FunctionTest<ResultType, ArgTypes...> ret(function, [](const ResultType& a, const ResultType& b) { return a == b; }, to_string);
+        ret.set_reporter(ctx.out);
+        return ret;
+    }
+
+
+    /// A function that is wrong for some arguments, and its reference.
+    int buggy_add(const int a, const int b) { return (a ^ b) % 37 == 0 ? a + b + 1 : a + b; }
+    int reference_add(const int a, const int b) { return a + b; }
+
+
+    /// Returns an argument creator of two ints in [-1000, 1000] for buggy_add() and reference_add().
+    auto add_args(const std::uint64_t seed) {
+        return random_args::make_args_creator(seed, [](random_args::case_generator& g) {
+            return std::make_tuple(g.uniform_int(-1000, 1000), g.uniform_int(-1000, 1000));
+        });
+    }
+
+
+    /// An argument creator whose only argument is the case index.
+    std::tuple<int> index_args(const unsigned int case_index) { return std::make_tuple(static_cast<int>(case_index)); }
+
+
+    /// Returns a tester of buggy_add() against reference_add() that keeps all error cases and writes nothing.
+    auto buggy_add_tester(const unsigned int n_threads, const unsigned int batch_size) {
+        auto ret = create_randomized_function_test(buggy_add, reference_add, add_args(261015));
+        ret.verbosity_level = verbosity::SILENT;
+        ret.n_threads = n_threads;
+        ret.batch_size = batch_size;
+        ret.error_policy = error_case_policy::KEEP_ALL;
+        return ret;
+    }
+
+
+    /// Returns the case indices of the given error cases in increasing order.
+    template <typename ErrorCaseType>
+    std::vector<unsigned int> case_indices(const std::vector<ErrorCaseType>& error_cases) {
+        std::vector<unsigned int> ret;
+        for (const auto& ec : error_cases) {
+            ret.push_back(ec.case_index);
+        }
+        std::sort(ret.begin(), ret.end());
+        return ret;
+    }
+
+
+    /// Returns the case indices of the error cases in the given error case file, in the order of the file.
+    std::vector<unsigned int> streamed_case_indices(const std::string& path) {
+        const std::string prefix = " ERROR CASE (case index ";
+        std::vector<unsigned int> ret;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);) {
+            if (line.compare(0, prefix.size(), prefix) == 0) {
+                ret.push_back(static_cast<unsigned int>(std::stoul(line.substr(prefix.size()))));
+            }
+        }
+        return ret;
+    }
+
+
+    /// The indices of the error cases of a test series on buggy_add() with the given settings.
+    std::vector<unsigned int> error_case_indices(const unsigned int n_threads, const unsigned int batch_size, const bool is_isolated = false) {
+        auto tester = buggy_add_tester(n_threads, batch_size);
+        tester.is_isolated = is_isolated;
+        return case_indices(tester.test("error cases", 20000).error_cases);
+    }
+
+
+    /// Compares the error cases of parallel series to those of a serial one.
+    bool test_error_cases(registry::context& ctx, const bool is_isolated) {
+        auto tester = make_tester<std::vector<unsigned int>, unsigned int, unsigned int>(ctx,
+            [is_isolated](unsigned int n_threads, unsigned int batch_size) { return error_case_indices(n_threads, batch_size, is_isolated); },
+            [](const std::vector<unsigned int>& v) { return join(v); });
+
+        const auto serial = error_case_indices(1, 1, false);
+        bool ret = !serial.empty();
+        for (const unsigned int n_threads : { 1u, 2u, 3u, 8u }) {
+            for (const unsigned int batch_size : { 1u, 16u }) {
+                ret &= tester.test(std::to_string(n_threads) + " threads, batches of " + std::to_string(batch_size), serial, n_threads, batch_size).is_passed;
+            }
+        }
+        return ret;
+    }
+
+
+    /// Counts its live instances, so that a series can verify that an arena destroys what it created.
+    struct arena_object {
+        static std::atomic<int> n_live;     ///< The number of live instances.
+        arena_object() { ++n_live; }
+        ~arena_object() { --n_live; }
+    };
+    std::atomic<int> arena_object::n_live(0);
+
+
+    /// A trivially copyable result for the reference cache.
+    struct flat_result {
+        int index;
+        double half;
+    };
+
+
+    /// A class with a member for a member pointer.
+    struct member_holder {
+        int member;
+    };
+
+
+    /** Compares the SIMD kernels of tolerance up to the instruction set of the CPU to the scalar one
+    on random arrays with few elements out of tolerance, NaN, infinities and signed zeros.
+    */
+    template <tolerance::detail::criterion C, typename T>
+    bool test_kernels(registry::context& ctx, const std::string& name) {
+        using tolerance::simd_level;
+
+        const auto make_element = [](random_args::case_generator& g) -> T {
+            switch (g.uniform_int(0, 31)) {
+                case 0: return std::numeric_limits<T>::quiet_NaN();
+                case 1: return std::numeric_limits<T>::infinity();
+                case 2: return -std::numeric_limits<T>::infinity();
+                case 3: return T(0);
+                case 4: return -T(0);
+                case 5: return std::numeric_limits<T>::denorm_min();
+                default: return g.uniform_real<T>(T(-1000), T(1000));
+            }
+        };
+        const auto args_creator = random_args::make_args_creator(261015, [make_element](random_args::case_generator& g) {
+            auto a = g.vector<T>(0, 100, make_element);
+            auto b = a;
+            for (unsigned int n_changes = g.uniform_int(0u, 2u); n_changes > 0 && !b.empty(); --n_changes) {
+                T& x = b[g.uniform_int<std::size_t>(0, b.size() - 1)];
+                switch (g.uniform_int(0, 3)) {
+                    case 0: x = make_element(g); break;
+                    case 1: x = std::nextafter(x, std::numeric_limits<T>::infinity()); break;
+                    default: x = x * (T(1) + g.uniform_real<T>(T(-1e-4), T(1e-4))) + g.uniform_real<T>(T(-1e-4), T(1e-4)); break;
+                }
+            }
+            return std::make_tuple(std::move(a), std::move(b), g.uniform_real(0.0, 1e-4), g.uniform_int<std::uint64_t>(0, 8));
+        });
+        const auto args_to_string = [](const std::tuple<std::vector<T>, std::vector<T>, double, std::uint64_t>& args) {
+            return "( [" + join(std::get<0>(args)) + "], [" + join(std::get<1>(args)) + "], " +
+                std::to_string(std::get<2>(args)) + ", " + std::to_string(std::get<3>(args)) + " )";
+        };
+        const auto scalar = [](const std::vector<T>& a, const std::vector<T>& b, double epsilon, std::uint64_t max_ulps) {
+            tolerance::detail::limits l;
+            l.epsilon = epsilon;
+            l.max_ulps = max_ulps;
+            return tolerance::detail::all_within_scalar<C>(a.data(), b.data(), a.size(), l);
+        };
+
+        bool ret = true;
+        for (int level = static_cast<int>(simd_level::SSE2); level <= static_cast<int>(tolerance::detected_level()); ++level) {
+            const auto kernel = [level](const std::vector<T>& a, const std::vector<T>& b, double epsilon, std::uint64_t max_ulps) {
+                tolerance::detail::limits l;
+                l.epsilon = epsilon;
+                l.max_ulps = max_ulps;
+                return tolerance::detail::all_within<C>(a.data(), b.data(), a.size(), l, static_cast<simd_level>(level));
+            };
+            auto tester = create_randomized_function_test(kernel, scalar, args_creator, default_functions::equal_to(), args_to_string);
+            tester.set_reporter(ctx.out);
+            tester.set_recorder(ctx.recorder);
+            ret &= tester.test(name + " " + tolerance::name(static_cast<simd_level>(level)), 20000).is_all_tests_passed();
+        }
+        return ret;
+    }
+
+
+    /// A type with a stream out operator.
+    struct streamed_point {
+        int x;
+    };
+
+    std::ostream& operator<<(std::ostream& os, const streamed_point& p) {
+        return os << "P{" << p.x << "}";
+    }
+
+
+    /// An enumeration, which is formatted as its underlying value.
+    enum class small_enum { A = 3 };
+
+
+    /// A constexpr function and a function that is not, for test tables.
+    constexpr int square(const int x) { return x * x; }
+    int runtime_square(const int x) { return x * x; }
+
+    /// Test tables of square(), one of them with a wrong row.
+    constexpr table_row<int, int> square_rows[] = { { 0, 0 }, { 4, 2 }, { 9, -3 } };
+    constexpr table_row<int, int> wrong_square_rows[] = { { 0, 0 }, { 5, 2 }, { 9, -3 } };
+
+
+    /// A result that counts how often it is copied.
+    struct copy_counter {
+        static unsigned int n_copies;       ///< The number of copies of all instances.
+        std::vector<int> values;            ///< The value.
+
+        copy_counter() = default;
+        explicit copy_counter(std::vector<int> v) : values(std::move(v)) {}
+        copy_counter(const copy_counter& other) : values(other.values) { ++n_copies; }
+        copy_counter(copy_counter&&) = default;
+        copy_counter& operator=(const copy_counter& other) { values = other.values; ++n_copies; return *this; }
+        copy_counter& operator=(copy_counter&&) = default;
+
+        bool operator==(const copy_counter& other) const { return values == other.values; }
+    };
+    unsigned int copy_counter::n_copies = 0;
+
+    std::ostream& operator<<(std::ostream& os, const copy_counter& c) {
+        return os << c.values.size() << " values";
+    }
+
+} // END namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// REGISTRY
+
+// verifies the name patterns of the filters
+static registry::registration test_filters("registry/filters", [](registry::context& ctx) {
+    auto matches = make_tester<bool, std::string, std::string>(ctx, [](std::string pattern, std::string name) { return registry::detail::matches(pattern.c_str(), name.c_str()); });
+    bool ret = true;
+    ret &= matches.test("exact", true, "math/add", "math/add").is_passed;
+    ret &= matches.test("prefix only", false, "math/add", "math/add2").is_passed;
+    ret &= matches.test("star", true, "math/*", "math/add").is_passed;
+    ret &= matches.test("star matches empty", true, "math/*", "math/").is_passed;
+    ret &= matches.test("star in the middle", true, "a*b*c", "axxbyyc").is_passed;
+    ret &= matches.test("star backtracks", false, "a*b", "ab/c").is_passed;
+    ret &= matches.test("question mark", true, "math/?dd", "math/add").is_passed;
+    ret &= matches.test("question mark needs a character", false, "math/?add", "math/add").is_passed;
+    ret &= matches.test("other module", false, "math/*", "misc/add").is_passed;
+
+    auto is_selected = make_tester<bool, std::string, std::vector<std::string>>(ctx,
+        [](std::string name, std::vector<std::string> filters) { return registry::detail::is_selected(name, filters); });
+    ret &= is_selected.test("no filters", true, "misc/x", {}).is_passed;
+    ret &= is_selected.test("included", true, "math/add", { "math/*", "-math/slow*" }).is_passed;
+    ret &= is_selected.test("excluded", false, "math/slow_add", { "math/*", "-math/slow*" }).is_passed;
+    ret &= is_selected.test("exclusion only", true, "misc/x", { "-math/*" }).is_passed;
+    ret &= is_selected.test("not included", false, "misc/x", { "math/*" }).is_passed;
+    ret &= is_selected.test("any inclusion", true, "misc/x", { "math/*", "misc/*" }).is_passed;
+    return ret;
+});
+
+
+// verifies that the shards of a run are disjoint, complete and ordered by name
+static registry::registration test_shards("registry/shards", [](registry::context& ctx) {
+    const auto names = [](const std::vector<const registry::series*>& selected) {
+        std::vector<std::string> ret;
+        for (const auto* s : selected) {
+            ret.push_back(s->name);
+        }
+        return ret;
+    };
+
+    auto shards = make_tester<bool, unsigned int>(ctx, [&names](unsigned int n_shards) {
+        registry::options opts;
+        const auto all = names(registry::select(opts));
+        if (!std::is_sorted(all.begin(), all.end())) {
+            return false;
+        }
+        std::multiset<std::string> joined;
+        for (unsigned int i = 0; i < n_shards; ++i) {
+            opts.shard_index = i;
+            opts.n_shards = n_shards;
+            const auto shard = names(registry::select(opts));
+            if (!std::is_sorted(shard.begin(), shard.end())) {
+                return false;
+            }
+            joined.insert(shard.begin(), shard.end());
+        }
+        return std::vector<std::string>(joined.begin(), joined.end()) == all;
+    });
+
+    bool ret = true;
+    for (const unsigned int n_shards : { 1u, 2u, 3u, 5u, 100u }) {
+        ret &= shards.test(std::to_string(n_shards) + " shards", true, n_shards).is_passed;
+    }
+
+    auto filtered = make_tester<std::vector<std::string>, std::vector<std::string>, unsigned int, unsigned int>(ctx,
+        [&names](std::vector<std::string> filters, unsigned int shard_index, unsigned int n_shards) {
+            registry::options opts;
+            opts.filters = filters;
+            opts.shard_index = shard_index;
+            opts.n_shards = n_shards;
+            return names(registry::select(opts));
+        },
+        [](const std::vector<std::string>& v) { return join(v); });
+    ret &= filtered.test("filter", { "registry/filters", "registry/shards" }, { "registry/*" }, 0, 1).is_passed;
+    ret &= filtered.test("filter and shard 0/2", { "registry/filters" }, { "registry/*" }, 0, 2).is_passed;
+    ret &= filtered.test("filter and shard 1/2", { "registry/shards" }, { "registry/*" }, 1, 2).is_passed;
+    ret &= filtered.test("exclusion", { "registry/shards" }, { "registry/*", "-*/filters" }, 0, 1).is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RANDOM ARGS
+
+// verifies that the arguments depend on nothing but the seed and the case index, also in batches
+static registry::registration test_random_args("random_args/determinism", [](registry::context& ctx) {
+    // the first values of a case, from 32 bit and from 64 bit ranges
+    const auto draw = [](std::uint64_t seed, unsigned int case_index) {
+        random_args::case_generator g(seed, case_index);
+        std::vector<long long> ret;
+        for (int i = 0; i < 4; ++i) {
+            ret.push_back(g.uniform_int(-5, 5));
+            ret.push_back(g.uniform_int(-(1LL << 40), 1LL << 40));
+        }
+        return ret;
+    };
+    auto is_equal = make_tester<bool, std::uint64_t, unsigned int, std::uint64_t, unsigned int>(ctx,
+        [&draw](std::uint64_t seed_a, unsigned int index_a, std::uint64_t seed_b, unsigned int index_b) { return draw(seed_a, index_a) == draw(seed_b, index_b); });
+    bool ret = true;
+    ret &= is_equal.test("same case", true, 42, 7, 42, 7).is_passed;
+    ret &= is_equal.test("other case index", false, 42, 7, 42, 8).is_passed;
+    ret &= is_equal.test("other seed", false, 42, 7, 43, 7).is_passed;
+
+    auto is_in_range = make_tester<bool, std::uint64_t>(ctx, [](std::uint64_t seed) {
+        std::set<int> seen;
+        for (unsigned int i = 0; i < 10000; ++i) {
+            random_args::case_generator g(seed, i);
+            const int x = g.uniform_int(-3, 3);
+            const double d = g.uniform_real(0.0, 1.0);
+            const float f = g.uniform_real(-1.0f, 1.0f);
+            if (x < -3 || x > 3 || d < 0 || d >= 1 || f < -1 || f >= 1) {
+                return false;
+            }
+            seen.insert(x);
+        }
+        return seen.size() == 7;
+    });
+    auto is_batch_equal = make_tester<bool, std::uint64_t>(ctx, [](std::uint64_t seed) {
+        const auto make_args = [](random_args::case_generator& g) { return std::make_tuple(g.uniform_int(0, 1000), g.string(0, 8)); };
+        const auto creator = random_args::make_args_creator(seed, make_args);
+        const auto batch = random_args::make_args_batch(seed, 100, 50, make_args);
+        for (unsigned int j = 0; j < batch.size(); ++j) {
+            if (batch[j] != creator(100 + j)) {
+                return false;
+            }
+        }
+        return batch.size() == 50;
+    });
+    auto is_fill_equal = make_tester<bool, std::uint64_t>(ctx, [](std::uint64_t seed) {
+        int ints[64];
+        float floats[64];
+        random_args::fill_uniform_int(seed, 1000, ints, 64, -50, 50);
+        random_args::fill_uniform_real(seed, 1000, floats, 64, 0.0f, 2.0f);
+        for (unsigned int j = 0; j < 64; ++j) {
+            if (ints[j] != random_args::case_generator(seed, 1000 + j).uniform_int(-50, 50) ||
+                floats[j] != random_args::case_generator(seed, 1000 + j).uniform_real(0.0f, 2.0f))
+            {
+                return false;
+            }
+        }
+        return true;
+    });
+    for (const std::uint64_t seed : { std::uint64_t(0), std::uint64_t(42), std::numeric_limits<std::uint64_t>::max() }) {
+        const std::string suffix = ", seed " + std::to_string(seed);
+        ret &= is_in_range.test("in range" + suffix, true, seed).is_passed;
+        ret &= is_batch_equal.test("batch" + suffix, true, seed).is_passed;
+        ret &= is_fill_equal.test("fill" + suffix, true, seed).is_passed;
+    }
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RANDOMIZED FUNCTION TEST
+
+// verifies that parallel test series find the same error cases as a serial one
+static registry::registration test_parallel_error_cases("RandomizedFunctionTest/parallel_error_cases", [](registry::context& ctx) {
+    return test_error_cases(ctx, false);
+});
+
+
+// verifies that test series whose names do not fit into the output line still write their header and their verdict
+static registry::registration test_long_test_name("RandomizedFunctionTest/long_test_name", [](registry::context& ctx) {
+    auto is_written = make_tester<bool, unsigned int, unsigned int>(ctx, [](unsigned int name_length, unsigned int n_threads) {
+        const std::string name(name_length, 'x');
+        std::stringstream ss;
+        auto tester = create_randomized_function_test(reference_add, reference_add, add_args(1));
+        tester.set_reporter(std::make_shared<ostream_reporter>(ss));
+        tester.n_threads = n_threads;
+        const bool is_passed = tester.test(name, 1000).is_all_tests_passed();
+        const std::string output = ss.str();
+        return is_passed && output.compare(0, 26 + name_length, "RandomizedFunctionTest: " + name + ": ") == 0 && output.find(" OK (1000/1000)") != std::string::npos;
+    });
+    bool ret = true;
+    for (const unsigned int name_length : { 10u, 24u, 25u, 200u }) {
+        for (const unsigned int n_threads : { 1u, 2u }) {
+            ret &= is_written.test(std::to_string(name_length) + " characters, " + std::to_string(n_threads) + " threads", true, name_length, n_threads).is_passed;
+        }
+    }
+    return ret;
+});
+
+
+// verifies that a required speedup needs both the per-case geometric mean and the ratio of the total durations
+static registry::registration test_speedup_gate("RandomizedFunctionTest/speedup_gate", [](registry::context& ctx) {
+    // the reference durations come from a cache, 100 us per case. The function is fast, but sleeps for 20 ms
+    // on the last case, so that the geometric mean of the speedups is high and the total speedup below 0.5
+    const unsigned int n_tests = 100;
+    const auto path = temp_path("speedup_gate.cache");
+    std::remove(path.c_str());
+    const auto cache = std::make_shared<reference_cache<int>>(path, "index + 1");
+    cache->prepare(n_tests);
+    for (unsigned int i = 0; i < n_tests; ++i) {
+        cache->store(i, static_cast<int>(i) + 1, 1e5);
+    }
+    cache->commit();
+
+    auto verdicts = make_tester<std::string, double>(ctx, [&cache, n_tests](double required_speedup_percent) {
+        auto tester = create_randomized_function_test(
+            [n_tests](int i) {
+                if (i + 1 == static_cast<int>(n_tests)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }
+                return i + 1;
+            },
+            [](int i) { return i + 1; },
+            index_args);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.set_reference_cache(cache);
+        tester.is_speedup_required = true;
+        tester.required_speedup_percent = required_speedup_percent;
+        const auto r = tester.test("speedup", n_tests);
+        const double required_speedup = 1 + required_speedup_percent / 100;
+        return std::string(r.n_cached_reference_results == n_tests ? "cached" : "not cached") +
+            (r.speedup_ci_lower >= required_speedup ? ", geometric mean sufficient" : ", geometric mean insufficient") +
+            (r.total_speedup >= required_speedup ? ", total sufficient" : ", total insufficient") +
+            (r.is_speedup_sufficient ? ", passed" : ", failed");
+    });
+    bool ret = true;
+    ret &= verdicts.test("both sufficient", std::string("cached, geometric mean sufficient, total sufficient, passed"), -99).is_passed;
+    ret &= verdicts.test("total insufficient", std::string("cached, geometric mean sufficient, total insufficient, failed"), 100).is_passed;
+    std::remove(path.c_str());
+    return ret;
+});
+
+
+// verifies that batched test series find the same error cases as unbatched ones, also with a partial last batch
+static registry::registration test_batched_error_cases("RandomizedFunctionTest/batched_error_cases", [](registry::context& ctx) {
+    auto tester = make_tester<std::vector<unsigned int>, unsigned int>(ctx,
+        [](unsigned int batch_size) { return error_case_indices(1, batch_size); },
+        [](const std::vector<unsigned int>& v) { return join(v); });
+
+    const auto unbatched = error_case_indices(1, 1);
+    bool ret = !unbatched.empty();
+    for (const unsigned int batch_size : { 7u, 64u, 1000u, 20000u, 30000u }) {
+        ret &= tester.test("batches of " + std::to_string(batch_size), unbatched, batch_size).is_passed;
+    }
+    return ret;
+});
+
+
+// verifies that the testers store the callables by value with their own types, including stateful ones
+static registry::registration test_callables_by_value("RandomizedFunctionTest/callables_by_value", [](registry::context& ctx) {
+    const auto n_calls = std::make_shared<unsigned int>(0);
+    const auto counting_add = [n_calls](int a, int b) { ++*n_calls; return a + b; };
+    auto randomized_tester = create_randomized_function_test(counting_add, reference_add, add_args(6));
+    auto function_tester = create_function_test<int, int>(counting_add);
+    static_assert(std::is_same<decltype(randomized_tester)::FunctionType, std::decay_t<decltype(counting_add)>>::value, "RandomizedFunctionTest stores the function with its own type");
+    static_assert(std::is_same<decltype(function_tester)::FunctionType, std::decay_t<decltype(counting_add)>>::value, "FunctionTest stores the function with its own type");
+    randomized_tester.verbosity_level = verbosity::SILENT;
+    function_tester.verbosity_level = verbosity::SILENT;
+
+    auto counted = make_tester<std::string, unsigned int>(ctx, [&](unsigned int n_tests) {
+        *n_calls = 0;
+        const bool is_passed = randomized_tester.test("counted", n_tests).is_all_tests_passed() && function_tester.test("counted", 3, 1, 2).is_passed;
+        return std::string(is_passed ? "passed" : "failed") + ", " + std::to_string(*n_calls) + " calls, " + std::to_string(n_calls.use_count() - 1) + " copies";
+    });
+    auto stateful = make_tester<bool, unsigned int>(ctx, [](unsigned int n_tests) {
+        auto tester = create_randomized_function_test([n = 0](int a, int b) mutable { return ++n > 0 ? a + b : 0; }, reference_add, add_args(6));
+        tester.verbosity_level = verbosity::SILENT;
+        return tester.test("stateful", n_tests).is_all_tests_passed();
+    });
+    bool ret = true;
+    ret &= counted.test("counted", std::string("passed, 1001 calls, 3 copies"), 1000).is_passed;
+    ret &= stateful.test("mutable lambda", true, 1000).is_passed;
+    return ret;
+});
+
+
+// verifies that the arguments and results of error cases stay alive in the arenas and that the arenas destroy their objects
+static registry::registration test_arena("RandomizedFunctionTest/arena", [](registry::context& ctx) {
+    using ResultType = std::tuple<int, int*>;
+    auto error_cases = make_tester<std::string, unsigned int, unsigned int>(ctx, [](unsigned int n_threads, unsigned int batch_size) {
+        auto tester = create_randomized_function_test(
+            [](int* i) {
+                arena::current()->create<arena_object>();
+                return ResultType(*i, arena::current()->create<int>(*i % 7 == 0 ? -*i : *i));
+            },
+            [](int* i) { return ResultType(*i, arena::current()->create<int>(*i)); },
+            [](unsigned int case_index) { return std::make_tuple(arena::current()->create<int>(static_cast<int>(case_index))); },
+            [](const ResultType& a, const ResultType& b) { return std::get<0>(a) == std::get<0>(b) && *std::get<1>(a) == *std::get<1>(b); },
+            [](const std::tuple<int*>& args) { return std::to_string(*std::get<0>(args)); },
+            [](const ResultType& r) { return std::to_string(*std::get<1>(r)); });
+        tester.verbosity_level = verbosity::SILENT;
+        tester.use_arena = true;
+        tester.n_threads = n_threads;
+        tester.batch_size = batch_size;
+
+        std::string ret;
+        {
+            const auto r = tester.test("arena", 2000);
+            for (const auto& ec : r.error_cases) {
+                ret += std::to_string(*std::get<0>(ec.args)) + ":" + std::to_string(*std::get<1>(ec.erroneous_result)) + ",";
+            }
+            ret += r.arenas.empty() ? " no arenas" : " arenas";
+        }
+        return ret + (arena_object::n_live == 0 ? ", destroyed" : ", alive");
+    });
+
+    std::string expected;
+    for (int i = 7; i < 2000; i += 7) {
+        expected += std::to_string(i) + ":" + std::to_string(-i) + ",";
+    }
+    expected += " arenas, destroyed";
+
+    bool ret = true;
+    for (const unsigned int n_threads : { 1u, 4u }) {
+        for (const unsigned int batch_size : { 1u, 16u }) {
+            ret &= error_cases.test(std::to_string(n_threads) + " threads, batches of " + std::to_string(batch_size), expected, n_threads, batch_size).is_passed;
+        }
+    }
+    return ret;
+});
+
+
+// verifies which error cases the policies keep, and that STREAM writes every error case exactly once
+static registry::registration test_error_case_policies("RandomizedFunctionTest/error_case_policies", [](registry::context& ctx) {
+    const auto path = temp_path("error_case_policies.txt");
+    auto kept = make_tester<std::vector<unsigned int>, error_case_policy, unsigned int, unsigned int>(ctx,
+        [&path](error_case_policy policy, unsigned int n_threads, unsigned int batch_size) {
+            auto tester = buggy_add_tester(n_threads, batch_size);
+            tester.error_policy = policy;
+            tester.max_error_cases = 5;
+            tester.error_case_file_path = path;
+            return case_indices(tester.test("policies", 20000).error_cases);
+        },
+        [](const std::vector<unsigned int>& v) { return join(v); });
+    auto streamed = make_tester<std::vector<unsigned int>, unsigned int, unsigned int>(ctx,
+        [&path](unsigned int n_threads, unsigned int batch_size) {
+            auto tester = buggy_add_tester(n_threads, batch_size);
+            tester.error_policy = error_case_policy::STREAM;
+            tester.max_error_cases = 5;
+            tester.error_case_file_path = path;
+            tester.test("streamed", 20000);
+            auto ret = streamed_case_indices(path);
+            std::sort(ret.begin(), ret.end());
+            return ret;
+        },
+        [](const std::vector<unsigned int>& v) { return join(v); });
+
+    // the sample of RESERVOIR: the error cases with the smallest hashes of their case indices
+    const auto all = error_case_indices(1, 1);
+    const std::vector<unsigned int> first(all.begin(), all.begin() + std::min<std::size_t>(5, all.size()));
+    auto sample = all;
+    std::sort(sample.begin(), sample.end(), [](unsigned int a, unsigned int b) {
+        return random_args::case_generator(0, a).next_u64() < random_args::case_generator(0, b).next_u64();
+    });
+    sample.resize(std::min<std::size_t>(5, sample.size()));
+    std::sort(sample.begin(), sample.end());
+
+    bool ret = all.size() > 5;
+    for (const unsigned int n_threads : { 1u, 3u }) {
+        for (const unsigned int batch_size : { 1u, 16u }) {
+            const std::string suffix = ", " + std::to_string(n_threads) + " threads, batches of " + std::to_string(batch_size);
+            ret &= kept.test("KEEP_FIRST" + suffix, first, error_case_policy::KEEP_FIRST, n_threads, batch_size).is_passed;
+            ret &= kept.test("RESERVOIR" + suffix, sample, error_case_policy::RESERVOIR, n_threads, batch_size).is_passed;
+            ret &= kept.test("STREAM" + suffix, first, error_case_policy::STREAM, n_threads, batch_size).is_passed;
+            ret &= streamed.test("STREAM file" + suffix, all, n_threads, batch_size).is_passed;
+        }
+    }
+
+    // a case that throws in a parallel test series must not write the error cases before it twice
+    auto aborted = make_tester<std::string, unsigned int>(ctx, [&path](unsigned int n_threads) {
+        auto tester = create_randomized_function_test(
+            [](int i) {
+                if (i == 15000) {
+                    throw std::runtime_error("case 15000");
+                }
+                return i % 7 == 0 ? -1 : i;
+            },
+            [](int i) { return i; },
+            index_args);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.n_threads = n_threads;
+        tester.error_policy = error_case_policy::STREAM;
+        tester.error_case_file_path = path;
+        const bool is_aborted = tester.test("aborted", 20000).is_aborted;
+
+        const auto indices = streamed_case_indices(path);
+        const std::set<unsigned int> unique(indices.begin(), indices.end());
+        bool is_complete = true;
+        for (unsigned int i = 0; i < 15000; i += 7) {
+            is_complete &= unique.count(i) == 1;
+        }
+        return std::string(is_aborted ? "aborted" : "not aborted") + (unique.size() == indices.size() ? ", once each" : ", duplicates") + (is_complete ? ", complete" : ", incomplete");
+    });
+    for (const unsigned int n_threads : { 1u, 4u }) {
+        ret &= aborted.test("throwing case, " + std::to_string(n_threads) + " threads", std::string("aborted, once each, complete"), n_threads).is_passed;
+    }
+    std::remove(path.c_str());
+    return ret;
+});
+
+
+// verifies that test series in worker processes find the same error cases as a serial one
+static registry::registration test_isolated_error_cases("RandomizedFunctionTest/isolated_error_cases", [](registry::context& ctx) {
+    return !process_isolation::is_supported() || test_error_cases(ctx, true);
+}, true);
+
+
+// verifies that a case that crashes its worker process fails on its own, also in batches and with several workers
+static registry::registration test_crashed_cases("RandomizedFunctionTest/crashed_cases", [](registry::context& ctx) {
+    if (!process_isolation::is_supported()) {
+        return true;
+    }
+    auto crashed = make_tester<std::string, unsigned int, unsigned int>(ctx, [](unsigned int n_threads, unsigned int batch_size) {
+        auto tester = create_randomized_function_test(
+            [](int i) {
+                if (i == 500) {
+                    std::raise(SIGSEGV);
+                }
+                return i;
+            },
+            [](int i) { return i; },
+            index_args);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.is_isolated = true;
+        tester.n_threads = n_threads;
+        tester.batch_size = batch_size;
+        const auto r = tester.test("crashes", 2000);
+        std::string ret = std::to_string(r.n_passed_tests) + "/" + std::to_string(r.n_tests) + " passed";
+        for (const auto& cc : r.crashed_cases) {
+            ret += ", case " + std::to_string(cc.case_index) + " " + process_isolation::signal_name(cc.signal);
+        }
+        return ret;
+    });
+    const std::string expected = "1999/2000 passed, case 500 " + process_isolation::signal_name(SIGSEGV);
+    bool ret = true;
+    for (const unsigned int n_threads : { 1u, 3u }) {
+        for (const unsigned int batch_size : { 1u, 16u }) {
+            ret &= crashed.test(std::to_string(n_threads) + " workers, batches of " + std::to_string(batch_size), expected, n_threads, batch_size).is_passed;
+        }
+    }
+    return ret;
+}, true);
+
+
+// verifies that worker processes stream every error case exactly once and keep the same ones as in-process test series
+static registry::registration test_isolated_stream("RandomizedFunctionTest/isolated_stream", [](registry::context& ctx) {
+    if (!process_isolation::is_supported()) {
+        return true;
+    }
+    const auto path = temp_path("isolated_stream.txt");
+    auto streamed = make_tester<std::string, unsigned int, unsigned int>(ctx, [&path](unsigned int n_threads, unsigned int batch_size) {
+        auto tester = buggy_add_tester(n_threads, batch_size);
+        tester.is_isolated = true;
+        tester.error_policy = error_case_policy::STREAM;
+        tester.max_error_cases = 5;
+        tester.error_case_file_path = path;
+        const auto kept = case_indices(tester.test("isolated stream", 20000).error_cases);
+        auto indices = streamed_case_indices(path);
+        std::sort(indices.begin(), indices.end());
+        return join(kept) + "; " + join(indices);
+    });
+    const auto all = error_case_indices(1, 1);
+    const std::vector<unsigned int> first(all.begin(), all.begin() + std::min<std::size_t>(5, all.size()));
+    bool ret = true;
+    for (const unsigned int n_threads : { 1u, 3u }) {
+        for (const unsigned int batch_size : { 1u, 16u }) {
+            ret &= streamed.test(std::to_string(n_threads) + " workers, batches of " + std::to_string(batch_size), join(first) + "; " + join(all), n_threads, batch_size).is_passed;
+        }
+    }
+    std::remove(path.c_str());
+    return ret;
+}, true);
+
+
+// verifies that cases past case_timeout fail with their case index and that series_budget ends a test series early
+static registry::registration test_timeouts("RandomizedFunctionTest/timeouts", [](registry::context& ctx) {
+    auto timed_out = make_tester<std::string, unsigned int, unsigned int>(ctx, [](unsigned int n_threads, unsigned int batch_size) {
+        auto tester = create_randomized_function_test(
+            [](int i) {
+                if (i == 300 || i == 1700) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                }
+                return i;
+            },
+            [](int i) { return i; },
+            index_args);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.n_threads = n_threads;
+        tester.batch_size = batch_size;
+        tester.case_timeout = std::chrono::milliseconds(50);
+        const auto r = tester.test("timeouts", 2000);
+        std::string ret = std::to_string(r.n_passed_tests) + "/" + std::to_string(r.n_tests) + " passed";
+        for (const auto& tc : r.timed_out_cases) {
+            ret += ", case " + std::to_string(tc.case_index);
+        }
+        return ret;
+    });
+    auto budget = make_tester<std::string, unsigned int>(ctx, [](unsigned int n_threads) {
+        auto tester = create_randomized_function_test(reference_add, reference_add, add_args(17));
+        tester.verbosity_level = verbosity::SILENT;
+        tester.n_threads = n_threads;
+        const auto r = tester.test_for("budget", std::chrono::milliseconds(100));
+        return std::string(r.is_budget_exhausted ? "exhausted" : "not exhausted") + (r.n_tests > 0 && r.is_all_tests_passed() ? ", passed" : ", failed");
+    });
+    bool ret = true;
+    ret &= timed_out.test("1 thread", std::string("1998/2000 passed, case 300, case 1700"), 1, 1).is_passed;
+    ret &= timed_out.test("3 threads", std::string("1998/2000 passed, case 300, case 1700"), 3, 1).is_passed;
+    for (const unsigned int n_threads : { 1u, 3u }) {
+        ret &= budget.test("test_for(), " + std::to_string(n_threads) + " threads", std::string("exhausted, passed"), n_threads).is_passed;
+    }
+    return ret;
+});
+
+
+// verifies that hanging cases in worker processes and in FunctionTest are ended after case_timeout and fail on their own
+static registry::registration test_isolated_timeouts("RandomizedFunctionTest/isolated_timeouts", [](registry::context& ctx) {
+    if (!process_isolation::is_supported()) {
+        return true;
+    }
+    const auto hang = [](int i) {
+        while (i == 500) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+        return i;
+    };
+    auto timed_out = make_tester<std::string, unsigned int, unsigned int>(ctx, [&hang](unsigned int n_threads, unsigned int batch_size) {
+        auto tester = create_randomized_function_test(hang, [](int i) { return i; }, index_args);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.is_isolated = true;
+        tester.n_threads = n_threads;
+        tester.batch_size = batch_size;
+        tester.case_timeout = std::chrono::milliseconds(50);
+        const auto r = tester.test("hangs", 2000);
+        std::string ret = std::to_string(r.n_passed_tests) + "/" + std::to_string(r.n_tests) + " passed";
+        for (const auto& tc : r.timed_out_cases) {
+            ret += ", case " + std::to_string(tc.case_index);
+        }
+        return ret;
+    });
+    auto function_timed_out = make_tester<std::string, int>(ctx, [&hang](int i) {
+        auto tester = create_function_test<int>(hang);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.is_isolated = true;
+        tester.case_timeout = std::chrono::milliseconds(50);
+        const auto r = tester.test("hangs", i, i);
+        return std::string(r.is_passed ? "passed" : "failed") + (r.is_timed_out ? ", timed out" : "");
+    });
+    bool ret = true;
+    for (const unsigned int n_threads : { 1u, 3u }) {
+        for (const unsigned int batch_size : { 1u, 16u }) {
+            ret &= timed_out.test(std::to_string(n_threads) + " workers, batches of " + std::to_string(batch_size), std::string("1999/2000 passed, case 500"), n_threads, batch_size).is_passed;
+        }
+    }
+    ret &= function_timed_out.test("FunctionTest", std::string("passed"), 499).is_passed;
+    ret &= function_timed_out.test("FunctionTest hangs", std::string("failed, timed out"), 500).is_passed;
+    return ret;
+}, true);
+
+
+// verifies that stress series find the error cases and exceptions of every thread count
+static registry::registration test_stress("RandomizedFunctionTest/stress", [](registry::context& ctx) {
+    auto stressed = make_tester<std::string, std::string>(ctx, [](std::string kind) {
+        const bool is_wrong = kind == "wrong";
+        const bool is_throwing = kind == "throwing";
+        auto tester = create_randomized_function_test(
+            [is_wrong, is_throwing](int i) {
+                if (is_throwing && i == 150) {
+                    throw std::runtime_error("case 150");
+                }
+                return is_wrong && i % 100 == 7 ? -1 : i;
+            },
+            [](int i) { return i; },
+            index_args);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.max_error_cases = 3;
+        const auto r = tester.test_stress("stress", 100, 4);
+        std::string ret;
+        for (const auto& l : r.levels) {
+            ret += std::to_string(l.n_threads) + " threads: ";
+            ret += l.is_aborted ? std::string("aborted") : std::to_string(l.n_passed_tests) + "/" + std::to_string(l.n_tests);
+            ret += l.error_cases.empty() ? "; " : " [" + join(case_indices(l.error_cases)) + "]; ";
+        }
+        return ret + (r.is_all_tests_passed() ? "passed" : "failed");
+    });
+    bool ret = true;
+    ret &= stressed.test("correct", std::string("1 threads: 100/100; 2 threads: 200/200; 4 threads: 400/400; passed"), "correct").is_passed;
+    ret &= stressed.test("wrong", std::string("1 threads: 99/100 [7]; 2 threads: 198/200 [7,107]; 4 threads: 396/400 [7,107,207]; failed"), "wrong").is_passed;
+    ret &= stressed.test("throwing", std::string("1 threads: 100/100; 2 threads: aborted; failed"), "throwing").is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FUNCTION TEST
+
+// verifies that isolated tests report crashes and early exits of the function and send its result back
+static registry::registration test_function_test_isolated("FunctionTest/isolated", [](registry::context& ctx) {
+    if (!process_isolation::is_supported()) {
+        return true;
+    }
+    auto isolated = make_tester<std::string, std::string>(ctx, [](std::string outcome) {
+        auto tester = create_function_test<std::string>([](const std::string& s) {
+            if (s == "crash") {
+                std::raise(SIGSEGV);
+            }
+            if (s == "exit") {
+                std::_Exit(4);
+            }
+            return s + "!";
+        });
+        tester.verbosity_level = verbosity::SILENT;
+        tester.is_isolated = true;
+        const auto r = tester.test("isolated", outcome + "!", outcome);
+        return std::string(r.is_passed ? "passed" : "failed") + ", signal " + std::to_string(r.crash_signal) + ", exit status " + std::to_string(r.exit_status) + ", result " + r.result;
+    });
+    bool ret = true;
+    ret &= isolated.test("returns", std::string("passed, signal 0, exit status 0, result return!"), "return").is_passed;
+    ret &= isolated.test("crashes", "failed, signal " + std::to_string(SIGSEGV) + ", exit status 0, result ", "crash").is_passed;
+    ret &= isolated.test("exits", std::string("failed, signal 0, exit status 4, result "), "exit").is_passed;
+    return ret;
+}, true);
+
+
+// verifies that move-only results work and that large results are moved instead of copied
+static registry::registration test_move_only_results("FunctionTest/move_only_results", [](registry::context& ctx) {
+    auto unique = make_tester<std::string, int>(ctx, [](int i) {
+        auto tester = create_function_test<int>(
+            [](int n) { return std::make_unique<int>(n); },
+            [](const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) { return *a == *b; });
+        tester.verbosity_level = verbosity::SILENT;
+        const auto r = tester.test("unique_ptr", std::make_unique<int>(i), i);
+        return std::string(r.is_passed ? "passed" : "failed") + ", result " + std::to_string(*r.result) + (tester.last_test_result() ? ", retained" : ", not retained");
+    });
+    auto n_copies = make_tester<unsigned int, bool>(ctx, [](bool retain_last_result) {
+        auto tester = create_function_test<int>([](int n) { return copy_counter(std::vector<int>(n, 1)); });
+        tester.verbosity_level = verbosity::SILENT;
+        tester.retain_last_result = retain_last_result;
+        copy_counter::n_copies = 0;
+        tester.test("copies", copy_counter(std::vector<int>(1000, 1)), 1000);
+        return copy_counter::n_copies;
+    });
+    auto randomized = make_tester<std::string, unsigned int>(ctx, [](unsigned int batch_size) {
+        auto unique_tester = create_randomized_function_test(
+            [](int n) { return std::make_unique<int>(n % 7 == 0 ? -n : n); },
+            [](int n) { return std::make_unique<int>(n); },
+            index_args,
+            [](const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) { return *a == *b; },
+            default_functions::tuple_to_string(),
+            [](const std::unique_ptr<int>& r) { return std::to_string(*r); });
+        auto copying_tester = create_randomized_function_test(
+            [](int n) { return copy_counter(std::vector<int>(1000, n % 5 == 0 ? 0 : 1)); },
+            [](int) { return copy_counter(std::vector<int>(1000, 1)); },
+            index_args);
+        unique_tester.verbosity_level = verbosity::SILENT;
+        copying_tester.verbosity_level = verbosity::SILENT;
+        unique_tester.batch_size = batch_size;
+        copying_tester.batch_size = batch_size;
+
+        const auto r = unique_tester.test("unique_ptr", 100);
+        copy_counter::n_copies = 0;
+        const auto n_copying_error_cases = copying_tester.test("copies", 100).error_cases.size();
+        return std::to_string(r.error_cases.size()) + " error cases, first " + std::to_string(*r.error_cases.at(0).erroneous_result) + "/" + std::to_string(*r.error_cases.at(0).reference_result) +
+            "; " + std::to_string(n_copying_error_cases) + " error cases, " + std::to_string(copy_counter::n_copies) + " copies";
+    });
+    bool ret = true;
+    ret &= unique.test("unique_ptr", std::string("passed, result 3, not retained"), 3).is_passed;
+    ret &= n_copies.test("retained", 1u, true).is_passed;
+    ret &= n_copies.test("not retained", 0u, false).is_passed;
+    for (const unsigned int batch_size : { 1u, 8u }) {
+        ret &= randomized.test("RandomizedFunctionTest, batches of " + std::to_string(batch_size), std::string("14 error cases, first -7/7; 20 error cases, 0 copies"), batch_size).is_passed;
+    }
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MULTI-VARIANT FUNCTION TEST
+
+// verifies the counts and the ranking of the variants, serially and in parallel
+static registry::registration test_multi_variant("MultiVariantFunctionTest/ranking", [](registry::context& ctx) {
+    auto outcome = make_tester<std::string, unsigned int>(ctx, [](unsigned int n_threads) {
+        MultiVariantFunctionTest<int, int> tester([](int i) { return 2 * i; }, index_args);
+        tester.add_variant("wrong", [](int i) { return i % 10 == 3 ? -1 : 2 * i; })
+            .add_variant("correct", [](int i) { return i + i; })
+            .add_variant("throwing", [](int i) {
+                if (i == 500) {
+                    throw std::runtime_error("case 500");
+                }
+                return 2 * i;
+            });
+        tester.verbosity_level = verbosity::SILENT;
+        tester.n_threads = n_threads;
+        tester.max_error_cases = 2;
+        const auto r = tester.test("variants", 1000);
+        std::string ret = std::to_string(r.n_tests) + " tests";
+        for (const auto& v : r.variants) {
+            ret += ", " + v.name + " " + std::to_string(v.n_passed_tests) + "/" + std::to_string(v.n_tests) + " [" + join(case_indices(v.error_cases)) + "]";
+        }
+        return ret + ", best " + r.variants[r.ranking.at(0)].name + (r.variants[2].error_cases.at(0).exception.empty() ? "" : ", exception");
+    });
+    auto aborted = make_tester<bool, unsigned int>(ctx, [](unsigned int n_threads) {
+        MultiVariantFunctionTest<int, int> tester(
+            [](int i) {
+                if (i == 500) {
+                    throw std::logic_error("reference");
+                }
+                return i;
+            },
+            index_args);
+        tester.add_variant("identity", [](int i) { return i; });
+        tester.verbosity_level = verbosity::SILENT;
+        tester.n_threads = n_threads;
+        const auto r = tester.test("aborted", 1000);
+        return r.is_aborted && !r.exception_description.empty();
+    });
+    const std::string expected = "1000 tests, wrong 900/1000 [3,13], correct 1000/1000 [], throwing 999/1000 [500], best correct, exception";
+    bool ret = true;
+    for (const unsigned int n_threads : { 1u, 3u }) {
+        ret &= outcome.test(std::to_string(n_threads) + " threads", expected, n_threads).is_passed;
+        ret &= aborted.test("reference throws, " + std::to_string(n_threads) + " threads", true, n_threads).is_passed;
+    }
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BENCHMARK
+
+// verifies the statistics of a benchmark and that it invokes the function it stores by value
+static registry::registration test_benchmark("Benchmark/statistics", [](registry::context& ctx) {
+    unsigned long long n_invocations = 0;
+    const auto counting_add = [&n_invocations](int a, int b) { ++n_invocations; return a + b; };
+    auto bench = create_benchmark<int, int>(counting_add);
+    static_assert(std::is_same<decltype(bench)::FunctionType, std::decay_t<decltype(counting_add)>>::value, "create_benchmark() stores the function with its own type");
+    bench.set_reporter(ctx.out);
+    bench.set_recorder(ctx.recorder);
+    bench.warmup_duration_ns = 1e5;
+    bench.min_sample_duration_ns = 1e4;
+    bench.n_samples = 7;
+
+    auto is_consistent = make_tester<bool, timing::statistics, unsigned long long, unsigned long long>(ctx,
+        [](timing::statistics s, unsigned long long n_iterations_per_sample, unsigned long long n_invocations) {
+            return s.n_samples == 7 && n_iterations_per_sample >= 1 && n_invocations >= 7 * n_iterations_per_sample &&
+                s.min <= s.median && s.median <= s.p90 && s.p90 <= s.p99 && s.p99 <= s.max && s.min <= s.mean && s.mean <= s.max && s.stddev >= 0;
+        });
+    bool ret = true;
+    const auto single = bench.run("single", 1, 2);
+    ret &= is_consistent.test("single arguments", true, single.invocation_duration_ns, single.n_iterations_per_sample, n_invocations).is_passed;
+    n_invocations = 0;
+    const auto series = bench.run_series("series", { std::make_tuple(1, 2), std::make_tuple(1000, -7) });
+    ret &= is_consistent.test("series of arguments", true, series.invocation_duration_ns, series.n_iterations_per_sample, n_invocations).is_passed;
+    const auto empty = bench.run_series("no arguments", {});
+    ret &= is_consistent.test("no arguments", false, empty.invocation_duration_ns, empty.n_iterations_per_sample, n_invocations).is_passed;
+
+    Benchmark<int, int, int> typed_bench(reference_add);
+    typed_bench.set_reporter(ctx.out);
+    typed_bench.warmup_duration_ns = 1e5;
+    typed_bench.min_sample_duration_ns = 1e4;
+    typed_bench.n_samples = 7;
+    const auto typed = typed_bench.run("Benchmark", 1, 2);
+    ret &= is_consistent.test("Benchmark", true, typed.invocation_duration_ns, typed.n_iterations_per_sample, std::numeric_limits<unsigned long long>::max()).is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// REPORTER
+
+// verifies that the messages of concurrent producers stay whole and in order, that flush() waits for them,
+// and that the testers format no messages above their verbosity level
+static registry::registration test_async_reporter("reporter/async_reporter", [](registry::context& ctx) {
+    auto is_whole = make_tester<bool, std::size_t>(ctx, [](std::size_t capacity) {
+        std::stringstream ss;
+        {
+            async_reporter r(ss, capacity);
+            std::vector<std::thread> producers;
+            for (int t = 0; t < 3; ++t) {
+                producers.emplace_back([&r, t]() {
+                    for (int i = 0; i < 500; ++i) {
+                        r.report(deferred_message([t, i](std::ostream& os) { os << t << " " << i << "\n"; }));
+                    }
+                });
+            }
+            for (auto& p : producers) {
+                p.join();
+            }
+        }
+        int next[3] = {};
+        int t, i;
+        while (ss >> t >> i) {
+            if (t < 0 || t > 2 || i != next[t]++) {
+                return false;
+            }
+        }
+        return next[0] == 500 && next[1] == 500 && next[2] == 500;
+    });
+    auto is_flushed = make_tester<bool, std::size_t>(ctx, [](std::size_t capacity) {
+        std::stringstream ss;
+        async_reporter r(ss, capacity);
+        for (int i = 0; i < 200; ++i) {
+            r.report(deferred_message([i](std::ostream& os) { os << "<" << i << ">"; }));
+            r.flush();
+            const std::string expected = "<" + std::to_string(i) + ">";
+            const std::string output = ss.str();
+            if (output.size() < expected.size() || output.compare(output.size() - expected.size(), expected.size(), expected) != 0) {
+                return false;
+            }
+        }
+        return true;
+    });
+    auto is_formatted = make_tester<bool, verbosity>(ctx, [](verbosity level) {
+        unsigned int n_formatted = 0;
+        const auto to_string = [&n_formatted](const int& r) { ++n_formatted; return std::to_string(r); };
+        std::stringstream ss;
+        const auto sink = std::make_shared<ostream_reporter>(ss);
+
+        FunctionTest<int, int, int> function_tester(reference_add, default_functions::equal_to(), to_string);
+        function_tester.set_reporter(sink);
+        function_tester.verbosity_level = level;
+        function_tester.test("failed", 4, 1, 2);
+
+        auto randomized_tester = create_randomized_function_test(buggy_add, reference_add, add_args(9), default_functions::equal_to(), default_functions::tuple_to_string(), to_string);
+        randomized_tester.set_reporter(sink);
+        randomized_tester.verbosity_level = level;
+        randomized_tester.test("failed", 1000);
+        return n_formatted > 0;
+    });
+    bool ret = true;
+    for (const std::size_t capacity : { std::size_t(2), std::size_t(16), std::size_t(4096) }) {
+        ret &= is_whole.test("whole, capacity " + std::to_string(capacity), true, capacity).is_passed;
+        ret &= is_flushed.test("flushed, capacity " + std::to_string(capacity), true, capacity).is_passed;
+    }
+    ret &= is_formatted.test("SILENT", false, verbosity::SILENT).is_passed;
+    ret &= is_formatted.test("NORMAL", false, verbosity::NORMAL).is_passed;
+    ret &= is_formatted.test("VERBOSE", true, verbosity::VERBOSE).is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PERF COUNTERS
+
+// verifies that the testers measure hardware counters where they are available, on every thread, and report NaN otherwise
+static registry::registration test_perf_counters("perf_counters/counts", [](registry::context& ctx) {
+    const bool is_available = perf_counters::counter_group().is_available();
+
+    auto randomized = make_tester<bool, unsigned int, unsigned int>(ctx, [is_available](unsigned int n_threads, unsigned int batch_size) {
+        auto tester = create_randomized_function_test(reference_add, reference_add, add_args(10));
+        tester.verbosity_level = verbosity::SILENT;
+        tester.measure_hardware_counters = true;
+        tester.n_threads = n_threads;
+        tester.batch_size = batch_size;
+        const auto r = tester.test("counters", 1000);
+        return r.is_all_tests_passed() && r.average_counters.is_available() == is_available && r.reference_average_counters.is_available() == is_available;
+    });
+
+    auto function_tester = create_function_test<int, int>(reference_add);
+    function_tester.verbosity_level = verbosity::SILENT;
+    function_tester.measure_hardware_counters = true;
+    auto single = make_tester<bool, bool>(ctx, [&function_tester, is_available](bool is_on_other_thread) {
+        const auto measure = [&function_tester, is_available]() {
+            const auto r = function_tester.test("counters", 3, 1, 2);
+            return r.is_passed && r.counters.is_available() == is_available && (!is_available || r.counters.instructions > 0);
+        };
+        if (!is_on_other_thread) {
+            return measure();
+        }
+        bool ret = false;
+        std::thread([&ret, &measure]() { ret = measure(); }).join();
+        return ret;
+    });
+
+    auto written = make_tester<std::string, double>(ctx, [](double n) {
+        perf_counters::counts c;
+        c.cycles = 10;
+        c.instructions = 20;
+        c += c;
+        std::stringstream ss;
+        if (n > 0) {
+            ss << c / n;
+        }
+        else {
+            ss << perf_counters::unavailable();
+        }
+        return ss.str();
+    });
+
+    bool ret = true;
+    for (const unsigned int n_threads : { 1u, 3u }) {
+        for (const unsigned int batch_size : { 1u, 64u }) {
+            ret &= randomized.test(std::to_string(n_threads) + " threads, batches of " + std::to_string(batch_size), true, n_threads, batch_size).is_passed;
+        }
+    }
+    ret &= single.test("FunctionTest", true, false).is_passed;
+    ret &= single.test("FunctionTest on another thread", true, true).is_passed;
+    ret &= single.test("FunctionTest again", true, false).is_passed;
+    ret &= written.test("average", std::string("5.0 cycles, 10.0 instructions, 0.0 L1D read misses, 0.0 LLC misses, 0.0 branch misses"), 4).is_passed;
+    ret &= written.test("unavailable", std::string("n/a cycles, n/a instructions, n/a L1D read misses, n/a LLC misses, n/a branch misses"), 0).is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ALLOC TRACKER
+
+// verifies the allocation counts of FunctionTest, nested measurements and the allocation parity of RandomizedFunctionTest
+static registry::registration test_alloc_tracker("alloc_tracker/counts", [](registry::context& ctx) {
+    auto counted = make_tester<std::string, unsigned int>(ctx, [](unsigned int n_ints) {
+        auto tester = create_function_test<unsigned int>([](unsigned int n) {
+            const std::vector<int> v(n);
+            timing::do_not_optimize(v);
+            return static_cast<unsigned int>(v.size());
+        });
+        tester.verbosity_level = verbosity::SILENT;
+        tester.measure_allocations = true;
+        const auto a = tester.test("allocations", n_ints, n_ints).allocations;
+        return std::to_string(a.n_allocations) + " allocations, " + std::to_string(a.n_deallocations) + " deallocations, " +
+            std::to_string(a.n_bytes_allocated) + " bytes, peak " + std::to_string(a.peak_live_bytes);
+    });
+    auto nested = make_tester<std::string, std::size_t>(ctx, [](std::size_t n_bytes) {
+        const auto outer = alloc_tracker::start();
+        alloc_tracker::counts inner_counts;
+        {
+            const auto inner = alloc_tracker::start();
+            const std::unique_ptr<char[]> p(new char[n_bytes]);
+            timing::do_not_optimize(p);
+            inner_counts = alloc_tracker::stop(inner);
+        }
+        const std::unique_ptr<char[]> q(new char[10]);
+        timing::do_not_optimize(q);
+        const auto outer_counts = alloc_tracker::stop(outer);
+        return "inner peak " + std::to_string(inner_counts.peak_live_bytes) + ", outer peak " + std::to_string(outer_counts.peak_live_bytes) +
+            ", " + std::to_string(outer_counts.n_allocations) + " allocations";
+    });
+    auto parity = make_tester<bool, bool, unsigned int>(ctx, [](bool is_allocating, unsigned int n_threads) {
+        auto tester = create_randomized_function_test(
+            [is_allocating](int a, int b) {
+                if (is_allocating) {
+                    const std::string s(100, 'x');
+                    timing::do_not_optimize(s);
+                }
+                return a + b;
+            },
+            reference_add, add_args(11));
+        tester.verbosity_level = verbosity::SILENT;
+        tester.measure_allocations = true;
+        tester.is_allocation_parity_required = true;
+        tester.n_threads = n_threads;
+        return tester.test("parity", 1000).is_allocation_within_reference;
+    });
+
+    bool ret = alloc_tracker::is_installed();
+    ret &= counted.test("vector of 10 ints", "1 allocations, 1 deallocations, " + std::to_string(10 * sizeof(int)) + " bytes, peak " + std::to_string(10 * sizeof(int)), 10).is_passed;
+    ret &= counted.test("empty vector", std::string("0 allocations, 0 deallocations, 0 bytes, peak 0"), 0).is_passed;
+    ret &= nested.test("nested", std::string("inner peak 100, outer peak 100, 2 allocations"), 100).is_passed;
+    for (const unsigned int n_threads : { 1u, 3u }) {
+        ret &= parity.test("allocating, " + std::to_string(n_threads) + " threads", false, true, n_threads).is_passed;
+        ret &= parity.test("not allocating, " + std::to_string(n_threads) + " threads", true, false, n_threads).is_passed;
+    }
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RUN RECORD
+
+// verifies that the binary format keeps every field that the JSON format writes
+static registry::registration test_run_record_round_trip("run_record/round_trip", [](registry::context& ctx) {
+    const auto recorder = std::make_shared<run_record::recorder>();
+    {
+        auto function_tester = create_function_test<int, int>(reference_add);
+        function_tester.verbosity_level = verbosity::SILENT;
+        function_tester.set_recorder(recorder);
+        function_tester.test("passed", 3, 1, 2);
+        function_tester.test("failed", 4, 1, 2);
+
+        auto randomized_tester = create_randomized_function_test(buggy_add, reference_add, add_args(1));
+        randomized_tester.verbosity_level = verbosity::SILENT;
+        randomized_tester.set_recorder(recorder);
+        randomized_tester.test("randomized \"quoted\"\nname", 5000);
+    }
+    auto records = recorder->records();
+    run_record::test_record special;
+    special.name = "special \\ \"values\"\t";
+    special.kind = "handmade";
+    special.speedup = std::numeric_limits<double>::infinity();
+    special.counters = perf_counters::unavailable();
+    special.duration.histogram = { 0, 1, std::numeric_limits<unsigned long long>::max() };
+    special.error_case_indices = { 0, 7, std::numeric_limits<unsigned int>::max() };
+    records.push_back(special);
+
+    const auto to_json = [](const std::vector<run_record::test_record>& r) {
+        std::stringstream ss;
+        run_record::write_json(ss, r);
+        return ss.str();
+    };
+    std::stringstream binary;
+    run_record::write_binary(binary, records);
+    const std::string bytes = binary.str();
+
+    auto round_trip = make_tester<std::string, std::string>(ctx, [&to_json](std::string b) {
+        std::stringstream ss(b);
+        std::vector<run_record::test_record> read;
+        return run_record::read_binary(ss, read) ? to_json(read) : std::string("malformed");
+    });
+    bool ret = records.size() == 4;
+    ret &= round_trip.test("binary to JSON", to_json(records), bytes).is_passed;
+    ret &= round_trip.test("no magic", std::string("malformed"), "BARNRUN2" + bytes.substr(8)).is_passed;
+    for (const std::size_t size : { std::size_t(0), std::size_t(4), std::size_t(16), bytes.size() / 2, bytes.size() - 1 }) {
+        ret &= round_trip.test("truncated to " + std::to_string(size) + " bytes", std::string("malformed"), bytes.substr(0, size)).is_passed;
+    }
+    return ret;
+});
+
+
+// verifies that the comparison of two runs flags changes of the mean duration that are significant and relevant only
+static registry::registration test_run_record_compare("run_record/compare", [](registry::context& ctx) {
+    const auto make_record = [](const std::string& name, double mean_ns, unsigned long long n_samples) {
+        run_record::test_record ret;
+        ret.name = name;
+        ret.kind = "handmade";
+        ret.duration.n_samples = n_samples;
+        ret.duration.mean_ns = mean_ns;
+        ret.duration.stddev_ns = 5;
+        return ret;
+    };
+    auto verdict = make_tester<std::string, double, unsigned long long>(ctx, [&make_record](double candidate_mean_ns, unsigned long long n_samples) {
+        const auto comparisons = run_record::compare(
+            { make_record("a", 100, 1000) },
+            { make_record("a", candidate_mean_ns, n_samples), make_record("only in the candidate", 100, 1000) });
+        if (comparisons.size() != 1) {
+            return std::string("unmatched");
+        }
+        const auto& c = comparisons[0];
+        return std::string(c.is_slowdown ? "slowdown" : c.is_speedup ? "speedup" : std::isnan(c.p_value) ? "not comparable" : "unchanged");
+    });
+    bool ret = true;
+    ret &= verdict.test("slower", std::string("slowdown"), 120, 1000).is_passed;
+    ret &= verdict.test("faster", std::string("speedup"), 80, 1000).is_passed;
+    ret &= verdict.test("irrelevant change", std::string("unchanged"), 101, 1000).is_passed;
+    ret &= verdict.test("single sample", std::string("not comparable"), 120, 1).is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// REFERENCE CACHE
+
+// verifies that the cache keeps results and durations across instances and that a tester reads them instead of calling the reference function
+static registry::registration test_reference_cache("reference_cache/round_trip", [](registry::context& ctx) {
+    const auto flat_path = temp_path("reference_cache.flat");
+    const auto encoded_path = temp_path("reference_cache.encoded");
+    std::remove(flat_path.c_str());
+    std::remove(encoded_path.c_str());
+
+    auto flat = make_tester<std::string, std::string>(ctx, [&flat_path](std::string version_tag) {
+        {
+            reference_cache<flat_result> cache(flat_path, "v1");
+            cache.prepare(1000);
+            for (unsigned int i = 0; i < 1000; ++i) {
+                cache.store(i, flat_result{ static_cast<int>(i), i * 0.5 }, i);
+            }
+            cache.commit();
+            cache.prepare(2000);
+            for (unsigned int i = 1000; i < 1500; ++i) {
+                cache.store(i, flat_result{ static_cast<int>(i), i * 0.5 }, i);
+            }
+            cache.commit();
+        }
+        const reference_cache<flat_result> cache(flat_path, version_tag);
+        bool is_equal = true;
+        for (unsigned int i = 0; i < cache.n_cases(); ++i) {
+            is_equal &= cache.visit(i, [i](const flat_result& r) { return r.index == static_cast<int>(i) && r.half == i * 0.5; }) && cache.duration_ns(i) == i;
+        }
+        return std::to_string(cache.n_cases()) + " cases" + (is_equal ? ", equal" : ", different");
+    });
+    auto encoded = make_tester<bool, unsigned int>(ctx, [&encoded_path](unsigned int n_cases) {
+        const auto encoder = [](const std::string& s, std::string& out) { out.append(s); };
+        const auto decoder = [](const char* p, std::size_t n) { return std::string(p, n); };
+        {
+            reference_cache<std::string> cache(encoded_path, "v1", encoder, decoder);
+            cache.prepare(n_cases);
+            for (unsigned int i = 0; i < n_cases; ++i) {
+                cache.store(i, std::string(i % 13, 'x'), 1);
+            }
+            cache.commit();
+        }
+        const reference_cache<std::string> cache(encoded_path, "v1", encoder, decoder);
+        bool ret = cache.n_cases() == n_cases;
+        for (unsigned int i = 0; i < cache.n_cases(); ++i) {
+            ret &= cache.visit(i, [i](const std::string& s) { return s == std::string(i % 13, 'x'); });
+        }
+        return ret;
+    });
+    auto cached = make_tester<std::string, unsigned int, unsigned int>(ctx, [](unsigned int n_threads, unsigned int batch_size) {
+        const auto path = temp_path("reference_cache." + std::to_string(n_threads) + "." + std::to_string(batch_size));
+        std::remove(path.c_str());
+        const auto n_reference_calls = std::make_shared<std::atomic<unsigned int>>(0);
+        auto tester = create_randomized_function_test(buggy_add, [n_reference_calls](int a, int b) { ++*n_reference_calls; return a + b; }, add_args(13));
+        tester.verbosity_level = verbosity::SILENT;
+        tester.n_threads = n_threads;
+        tester.batch_size = batch_size;
+        tester.set_reference_cache(std::make_shared<reference_cache<int>>(path, "reference_add, seed 13"));
+        std::string ret;
+        for (const unsigned int n_tests : { 2000u, 2000u, 3000u }) {
+            *n_reference_calls = 0;
+            const auto r = tester.test("cached", n_tests);
+            // a batch that reaches past the cached cases calls the reference function on all of its cases
+            const unsigned int n_cached = r.n_cached_reference_results;
+            ret += std::string(*n_reference_calls + n_cached == n_tests ? "complete" : "incomplete") +
+                (n_cached == 0 ? ", not cached, " : n_cached == n_tests ? ", cached, " : ", partly cached, ") + std::to_string(r.n_tests - r.n_passed_tests) + " failed; ";
+        }
+        std::remove(path.c_str());
+        return ret;
+    });
+
+    // the failed cases among the first n ones, without a cache
+    const auto n_failed = [](unsigned int n_tests) {
+        const auto creator = add_args(13);
+        unsigned int ret = 0;
+        for (unsigned int i = 0; i < n_tests; ++i) {
+            const auto args = creator(i);
+            ret += buggy_add(std::get<0>(args), std::get<1>(args)) != reference_add(std::get<0>(args), std::get<1>(args));
+        }
+        return std::to_string(ret);
+    };
+    const std::string expected =
+        "complete, not cached, " + n_failed(2000) + " failed; " +
+        "complete, cached, " + n_failed(2000) + " failed; " +
+        "complete, partly cached, " + n_failed(3000) + " failed; ";
+
+    bool ret = true;
+    ret &= flat.test("same version tag", std::string("1500 cases, equal"), "v1").is_passed;
+    ret &= flat.test("other version tag", std::string("0 cases, equal"), "v2").is_passed;
+    ret &= encoded.test("encoded, 1 case", true, 1).is_passed;
+    ret &= encoded.test("encoded, 100 cases", true, 100).is_passed;
+    for (const unsigned int n_threads : { 1u, 4u }) {
+        for (const unsigned int batch_size : { 1u, 16u }) {
+            ret &= cached.test(std::to_string(n_threads) + " threads, batches of " + std::to_string(batch_size), expected, n_threads, batch_size).is_passed;
+        }
+    }
+    std::remove(flat_path.c_str());
+    std::remove(encoded_path.c_str());
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CORPUS
+
+// pointers and member pointers refer to the memory of the recording run, so they are only stored encoded
+static_assert(is_flat_tuple<std::tuple<int, float, char>>::value, "trivially copyable tuples are read in place");
+static_assert(!is_flat_tuple<std::tuple<int, int*>>::value, "tuples with pointers are not read in place");
+static_assert(!is_flat_tuple<std::tuple<int member_holder::*>>::value, "tuples with member pointers are not read in place");
+static_assert(!is_flat_tuple<std::tuple<std::string>>::value, "tuples that are not trivially copyable are not read in place");
+
+
+// verifies that recorded arguments replay the same error cases, bypass the reference cache, and round-trip encoded
+static registry::registration test_corpus_replay("corpus/replay", [](registry::context& ctx) {
+    const auto path = temp_path("corpus.flat");
+    const auto encoded_path = temp_path("corpus.encoded");
+    const auto cache_path = temp_path("corpus.cache");
+    std::remove(cache_path.c_str());
+
+    const auto recorded = buggy_add_tester(1, 1).test("record", 20000);
+    {
+        corpus_writer<std::tuple<int, int>> writer(path);
+        for (const auto& ec : recorded.error_cases) {
+            writer.add(ec.args);
+        }
+        writer.close();
+    }
+    const auto failing = std::make_shared<corpus<std::tuple<int, int>>>(path);
+
+    auto replayed = make_tester<std::string, unsigned int, unsigned int>(ctx, [&failing](unsigned int n_threads, unsigned int batch_size) {
+        auto tester = buggy_add_tester(n_threads, batch_size);
+        tester.set_corpus(failing);
+        const auto r = tester.test("replay", 100000);
+        bool is_equal = r.error_cases.size() == failing->size();
+        for (const auto& ec : r.error_cases) {
+            is_equal &= failing->visit(ec.case_index, [&ec](const std::tuple<int, int>& args) { return args == ec.args; });
+        }
+        return std::to_string(r.n_tests) + " tests, " + std::to_string(r.n_tests - r.n_passed_tests) + " failed" + (is_equal ? ", same arguments" : ", other arguments");
+    });
+    auto with_cache = make_tester<std::string, unsigned int>(ctx, [&failing, &cache_path](unsigned int batch_size) {
+        auto tester = create_randomized_function_test(reference_add, reference_add, add_args(14));
+        tester.verbosity_level = verbosity::SILENT;
+        tester.batch_size = batch_size;
+        const auto cache = std::make_shared<reference_cache<int>>(cache_path, "reference_add, seed 14");
+        tester.set_reference_cache(cache);
+        tester.test("fill", 100);
+        tester.set_corpus(failing);
+        const auto r = tester.test("replay", 100000);
+        return std::to_string(r.n_passed_tests) + "/" + std::to_string(r.n_tests) + " passed, " + std::to_string(r.n_cached_reference_results) + " cached, cache of " + std::to_string(cache->n_cases()) + " cases";
+    });
+    auto encoded = make_tester<std::string, unsigned int>(ctx, [&encoded_path](unsigned int n_tuples) {
+        {
+            corpus_writer<std::tuple<std::string>> writer(encoded_path, [](const std::tuple<std::string>& t, std::string& out) { out += std::get<0>(t); });
+            for (unsigned int i = 0; i < n_tuples; ++i) {
+                writer.add(std::make_tuple(std::string(i % 5, 'a')));
+            }
+            writer.close();
+        }
+        const corpus<std::tuple<std::string>> c(encoded_path, [](const char* p, std::size_t n) { return std::make_tuple(std::string(p, n)); });
+        std::string ret;
+        for (std::size_t i = 0; i < c.size(); ++i) {
+            ret += c.visit(i, [](const std::tuple<std::string>& t) { return std::get<0>(t); }) + ",";
+        }
+        return ret;
+    });
+    auto n_tuples = make_tester<std::size_t, std::string>(ctx, [](std::string p) { return corpus<std::tuple<int, int>>(p).size(); });
+
+    const std::string n_recorded = std::to_string(recorded.error_cases.size());
+    bool ret = !recorded.error_cases.empty();
+    for (const unsigned int n_threads : { 1u, 4u }) {
+        for (const unsigned int batch_size : { 1u, 8u }) {
+            ret &= replayed.test(std::to_string(n_threads) + " threads, batches of " + std::to_string(batch_size), n_recorded + " tests, " + n_recorded + " failed, same arguments", n_threads, batch_size).is_passed;
+        }
+    }
+    for (const unsigned int batch_size : { 1u, 4u }) {
+        ret &= with_cache.test("reference cache, batches of " + std::to_string(batch_size), n_recorded + "/" + n_recorded + " passed, 0 cached, cache of 100 cases", batch_size).is_passed;
+    }
+    ret &= encoded.test("encoded", std::string(",a,aa,aaa,aaaa,,"), 6).is_passed;
+    ret &= n_tuples.test("flat", recorded.error_cases.size(), path).is_passed;
+    ret &= n_tuples.test("encoded file read flat", std::size_t(0), encoded_path).is_passed;
+    ret &= n_tuples.test("no file", std::size_t(0), temp_path("corpus.missing")).is_passed;
+    std::remove(path.c_str());
+    std::remove(encoded_path.c_str());
+    std::remove(cache_path.c_str());
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PROCESS ISOLATION
+
+// verifies how probe() reports children that return, crash, exit, let an exception escape or hang
+static registry::registration test_probe("process_isolation/probe", [](registry::context& ctx) {
+    if (!process_isolation::is_supported()) {
+        return true;
+    }
+    auto probed = make_tester<std::string, std::string>(ctx, [](std::string outcome) {
+        const auto r = process_isolation::probe([outcome](std::string& reply) {
+            if (outcome == "abort") {
+                std::raise(SIGABRT);
+            }
+            else if (outcome == "exit") {
+                std::_Exit(3);
+            }
+            else if (outcome == "throw") {
+                throw std::runtime_error("escaped");
+            }
+            else if (outcome == "hang") {
+                for (;;) {
+                    std::this_thread::sleep_for(std::chrono::seconds(1));
+                }
+            }
+            reply = "done";
+        }, std::chrono::milliseconds(outcome == "hang" ? 100 : 10000));
+        return std::string(r.is_completed() ? "completed" : "not completed") + (r.signal != 0 ? ", " + process_isolation::signal_name(r.signal) : "") +
+            ", exit status " + std::to_string(r.exit_status) + (r.is_timed_out ? ", timed out" : "") + (r.is_completed() ? ", reply " + r.reply : "");
+    });
+    bool ret = true;
+    ret &= probed.test("returns", std::string("completed, exit status 0, reply done"), "return").is_passed;
+    ret &= probed.test("aborts", "not completed, " + process_isolation::signal_name(SIGABRT) + ", exit status 0", "abort").is_passed;
+    ret &= probed.test("exits", std::string("not completed, exit status 3"), "exit").is_passed;
+    ret &= probed.test("throws", "not completed, exit status " + std::to_string(process_isolation::probe_failure_exit_status), "throw").is_passed;
+    ret &= probed.test("hangs", "not completed, " + process_isolation::signal_name(SIGKILL) + ", exit status 0, timed out", "hang").is_passed;
+    return ret;
+}, true);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// COMPLEXITY
+
+// verifies that the fits recognize the growth models of exact durations, the sizes of scaling series and their failed sizes
+static registry::registration test_complexity("complexity/fit", [](registry::context& ctx) {
+    auto growth = make_tester<std::string, complexity::model>(ctx, [](complexity::model m) {
+        const auto sizes = complexity::geometric_sizes(16, 1 << 16, 2);
+        std::vector<double> s, d;
+        for (const unsigned int n : sizes) {
+            s.push_back(n);
+            d.push_back(3 * complexity::evaluate(m, n));
+        }
+        return std::string(complexity::name(complexity::best_fit(s, d).growth));
+    });
+    auto sizes = make_tester<std::vector<unsigned int>, unsigned int, unsigned int, double>(ctx,
+        [](unsigned int min_size, unsigned int max_size, double factor) { return complexity::geometric_sizes(min_size, max_size, factor); },
+        [](const std::vector<unsigned int>& v) { return join(v); });
+    auto failed_sizes = make_tester<std::vector<unsigned int>, unsigned int>(ctx,
+        [](unsigned int wrong_size) {
+            auto tester = create_randomized_function_test(
+                [wrong_size](const std::vector<int>& v) { return v.size() == wrong_size ? -1L : std::accumulate(v.begin(), v.end(), 0L); },
+                [](const std::vector<int>& v) {
+                    long ret = 0;
+                    for (const int x : v) {
+                        ret += x;
+                    }
+                    return ret;
+                },
+                [](unsigned int n) { return std::make_tuple(std::vector<int>(n, 1)); });
+            tester.verbosity_level = verbosity::SILENT;
+            return tester.test_scaling("scaling", 16, 1024, 2, 1).failed_sizes;
+        },
+        [](const std::vector<unsigned int>& v) { return join(v); });
+
+    bool ret = true;
+    for (const auto m : complexity::all_models) {
+        ret &= growth.test(complexity::name(m), std::string(complexity::name(m)), m).is_passed;
+    }
+    ret &= sizes.test("doubling", { 1, 2, 4, 8, 16, 32, 64 }, 1, 100, 2).is_passed;
+    ret &= sizes.test("small factor", { 10, 11, 12 }, 10, 12, 1.01).is_passed;
+    ret &= sizes.test("empty", {}, 5, 4, 2).is_passed;
+    ret &= failed_sizes.test("wrong at 64", { 64 }, 64).is_passed;
+    ret &= failed_sizes.test("correct", {}, 100).is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TOLERANCE
+
+// verifies the comparators on special values, and their descriptions of the worst mismatch
+static registry::registration test_tolerance_comparators("tolerance/comparators", [](registry::context& ctx) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    auto absolute = make_tester<bool, double, double>(ctx, [](double a, double b) { return tolerance::absolute(1e-3)(a, b); });
+    auto relative = make_tester<bool, double, double>(ctx, [](double a, double b) { return tolerance::relative(1e-3)(a, b); });
+    auto ulps = make_tester<bool, float, unsigned int>(ctx, [](float a, unsigned int n_steps) {
+        float b = a;
+        for (unsigned int i = 0; i < n_steps; ++i) {
+            b = std::nextafter(b, std::numeric_limits<float>::infinity());
+        }
+        return tolerance::ulps(1)(a, b);
+    });
+    auto described = make_tester<std::string, std::vector<float>, std::vector<float>>(ctx, [](std::vector<float> a, std::vector<float> b) {
+        const tolerance::absolute comp(0.5);
+        return comp.describe(a, b) + (comp(a, b) ? ", within" : ", outside");
+    });
+
+    bool ret = true;
+    ret &= absolute.test("absolute within", true, 1.0, 1.0005).is_passed;
+    ret &= absolute.test("absolute outside", false, 1.0, 1.002).is_passed;
+    ret &= absolute.test("NaN equals NaN", true, nan, nan).is_passed;
+    ret &= absolute.test("NaN and a number", false, nan, 1.0).is_passed;
+    ret &= absolute.test("signed zeros", true, 0.0, -0.0).is_passed;
+    ret &= absolute.test("same infinity", true, inf, inf).is_passed;
+    ret &= absolute.test("opposite infinities", false, inf, -inf).is_passed;
+    ret &= relative.test("relative within", true, 1000.0, 1000.9).is_passed;
+    ret &= relative.test("relative outside", false, 1e-9, 2e-9).is_passed;
+    ret &= relative.test("relative zeros", true, 0.0, -0.0).is_passed;
+    ret &= ulps.test("same float", true, 1.0f, 0).is_passed;
+    ret &= ulps.test("next float", true, 1.0f, 1).is_passed;
+    ret &= ulps.test("two floats apart", false, 1.0f, 2).is_passed;
+    ret &= ulps.test("across zero", true, -std::numeric_limits<float>::denorm_min(), 1).is_passed;
+    ret &= described.test("worst element", std::string("worst mismatch at index 2: 1 (absolute, tolerance 0.5), outside"), { 1, 2, 3 }, { 1, 2.25f, 4 }).is_passed;
+    ret &= described.test("different sizes", std::string("sizes differ: 2 vs 1, outside"), { 1, 2 }, { 1 }).is_passed;
+    return ret;
+});
+
+
+// verifies the SSE2, AVX2 and AVX-512 kernels against the scalar one, as far as the CPU supports them
+static registry::registration test_simd_kernels("tolerance/simd_kernels", [](registry::context& ctx) {
+    using tolerance::detail::criterion;
+    bool ret = true;
+    ret &= test_kernels<criterion::ABSOLUTE, float>(ctx, "absolute float");
+    ret &= test_kernels<criterion::ABSOLUTE, double>(ctx, "absolute double");
+    ret &= test_kernels<criterion::RELATIVE, float>(ctx, "relative float");
+    ret &= test_kernels<criterion::RELATIVE, double>(ctx, "relative double");
+    ret &= test_kernels<criterion::ULPS, float>(ctx, "ulps float");
+    ret &= test_kernels<criterion::ULPS, double>(ctx, "ulps double");
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FORMATTING
+
+// verifies the text of the values, and that silent tests allocate nothing for their output
+static registry::registration test_formatting("formatting/to_string", [](registry::context& ctx) {
+    auto formatted = make_tester<std::string, std::string>(ctx, [](std::string text) { return text; });
+    auto n_allocations = make_tester<unsigned long long, bool>(ctx, [](bool is_passed) {
+        auto tester = create_function_test<int, int>(reference_add);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.test(is_passed ? 3 : 4, 1, 2);
+        const auto start = alloc_tracker::start();
+        for (int i = 0; i < 100; ++i) {
+            tester.test(is_passed ? 3 : 4, 1, 2);
+        }
+        return alloc_tracker::stop(start).n_allocations;
+    });
+
+    const double inf = std::numeric_limits<double>::infinity();
+    bool ret = true;
+    ret &= formatted.test("integers", std::string("( 1, -2, 18446744073709551615, c, 1 )"), formatting::to_string(std::make_tuple(1, -2LL, ~0ULL, 'c', true))).is_passed;
+    ret &= formatted.test("floating point", std::string("( 0.1, 0.3333333333333333, 2.5, 1e+300 )"), formatting::to_string(std::make_tuple(0.1, 1.0 / 3, 2.5f, 1e300))).is_passed;
+    ret &= formatted.test("infinities", std::string("( inf, -inf )"), formatting::to_string(std::make_tuple(inf, -inf))).is_passed;
+    ret &= formatted.test("strings", std::string("( hi, str, sv )"), formatting::to_string(std::make_tuple("hi", std::string("str"), std::string_view("sv")))).is_passed;
+    ret &= formatted.test("stream operator and enumeration", std::string("( P{7}, 3 )"), formatting::to_string(std::make_tuple(streamed_point{ 7 }, small_enum::A))).is_passed;
+    ret &= formatted.test("nested", std::string("( ( 1, 2 ), (  ) )"), formatting::to_string(std::make_tuple(std::make_pair(1u, 2.0), std::make_tuple()))).is_passed;
+    ret &= formatted.test("null pointer", std::string("nullptr"), formatting::to_string(nullptr)).is_passed;
+    ret &= formatted.test("long string", std::string(1000, 'x'), formatting::to_string(std::string(1000, 'x'))).is_passed;
+    ret &= n_allocations.test("silent passed tests", 0ULL, true).is_passed;
+    ret &= n_allocations.test("silent failed tests", 0ULL, false).is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TEST TABLE
+
+static_assert(first_failed_row(square, square_rows) == 3, "first_failed_row() is a constant expression");
+static_assert(first_failed_row(square, wrong_square_rows) == 1, "first_failed_row() finds the wrong row");
+
+
+// verifies that constexpr tables are checked at compile time and others at runtime, with the same outcome
+static registry::registration test_check_table("test_table/check_table", [](registry::context& ctx) {
+    const auto describe = [](const table_result& r) {
+        return std::to_string(r.n_passed_rows) + "/" + std::to_string(r.n_rows) + " rows, first failed " + std::to_string(r.first_failed_row) + (r.is_compile_time ? ", compile time" : ", runtime");
+    };
+    auto checked = make_tester<std::string, std::string>(ctx, [&describe](std::string table) {
+        if (table == "constexpr") {
+            return describe(check_table<square, square_rows>());
+        }
+        if (table == "runtime") {
+            return describe(check_table<runtime_square, square_rows>());
+        }
+        if (table == "FunctionTest") {
+            auto tester = create_function_test<int>(runtime_square);
+            tester.verbosity_level = verbosity::SILENT;
+            return describe(tester.test_table("squares", wrong_square_rows));
+        }
+        return describe(check_table<runtime_square, wrong_square_rows>());
+    });
+    bool ret = true;
+    ret &= checked.test("constexpr", std::string("3/3 rows, first failed 3, compile time"), "constexpr").is_passed;
+    ret &= checked.test("runtime", std::string("3/3 rows, first failed 3, runtime"), "runtime").is_passed;
+    ret &= checked.test("runtime, wrong row", std::string("2/3 rows, first failed 1, runtime"), "wrong").is_passed;
+    ret &= checked.test("FunctionTest, wrong row", std::string("2/3 rows, first failed 1, runtime"), "FunctionTest").is_passed;
+    return ret;
+});
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CASE FILE
+
+// verifies the counts and the locations of the failed cases of CSV and binary case files, serially and in parallel
+static registry::registration test_case_files("case_file/csv_and_binary", [](registry::context& ctx) {
+    const auto csv_path = temp_path("case_file.csv");
+    const auto binary_path = temp_path("case_file.cases");
+    const auto strings_path = temp_path("case_file.strings.csv");
+    {
+        std::ofstream file(csv_path);
+        file << "expected,x,y\r\n";
+        for (int i = 0; i < 10000; ++i) {
+            if (i == 5000) {
+                file << "# a comment, an empty line and a row without y\n\n1,2\n";
+            }
+            file << (i == 7777 ? 0 : 3 * i) << "," << i << ", " << 2 * i << "\n";
+        }
+        std::ofstream strings(strings_path);
+        strings << "\"a\"\"b\",\"a\"\"b\",1\nxxx,x,3\nx,\"x\",1\n\"unterminated,1\n";
+    }
 
+    auto tested = make_tester<std::string, std::string, unsigned int>(ctx, [&](std::string format, unsigned int n_threads) {
+        auto tester = create_function_test<int, int>(reference_add);
+        tester.verbosity_level = verbosity::SILENT;
+        tester.n_threads = n_threads;
+        const auto r = format == "csv" ?
+            tester.test_cases("csv", csv_case_file<int, int, int>(csv_path)) :
+            tester.test_cases("binary", binary_case_file<int, int, int>(binary_path));
+        std::string ret = std::to_string(r.n_passed_cases) + "/" + std::to_string(r.n_cases) + " passed";
+        for (const auto& fc : r.failed_cases) {
+            ret += ", " + fc.location;
+        }
+        return ret;
+    });
+    auto converted = make_tester<std::size_t, std::string, std::string>(ctx, [](std::string from, std::string to) {
+        binary_case_writer<int, int, int> writer(to);
+        const auto ret = convert_case_file(csv_case_file<int, int, int>(from), writer);
+        writer.close();
+        return ret;
+    });
+    auto strings = make_tester<std::string, unsigned int>(ctx, [&strings_path](unsigned int n_threads) {
+        auto tester = create_function_test<std::string, int>([](const std::string& s, int n) {
+            std::string ret;
+            for (int i = 0; i < n; ++i) {
+                ret += s;
+            }
+            return ret;
+        });
+        tester.verbosity_level = verbosity::SILENT;
+        tester.n_threads = n_threads;
+        const auto r = tester.test_cases("strings", csv_case_file<std::string, std::string, int>(strings_path, false));
+        std::string ret = std::to_string(r.n_passed_cases) + "/" + std::to_string(r.n_cases) + " passed";
+        for (const auto& fc : r.failed_cases) {
+            ret += ", " + fc.location;
+        }
+        return ret;
+    });
 
-// verifies the validity of FunctionTest
-void test_function_test() {
-    
-    // TODO
-}
\ No newline at end of file
+    bool ret = true;
+    ret &= converted.test("convert", std::size_t(10000), csv_path, binary_path).is_passed;
+    for (const unsigned int n_threads : { 1u, 4u }) {
+        const std::string suffix = ", " + std::to_string(n_threads) + " threads";
+        ret &= tested.test("csv" + suffix, std::string("9999/10001 passed, line 5004, line 7782"), "csv", n_threads).is_passed;
+        ret &= tested.test("binary" + suffix, std::string("9999/10000 passed, case 7777"), "binary", n_threads).is_passed;
+        ret &= strings.test("quoted strings" + suffix, std::string("3/4 passed, line 4"), n_threads).is_passed;
+    }
+    std::remove(csv_path.c_str());
+    std::remove(binary_path.c_str());
+    std::remove(strings_path.c_str());
+    return ret;
+});
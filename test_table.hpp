@@ -0,0 +1,165 @@
+/******************************************************************************
+/* @file Contains test tables: lists of rows of an expected result and the
+/*       arguments that produce it, for table-driven tests of functions.
+/*
+/* check_table() checks a function on a table at compile time with
+/* static_assert if the function and the table are constant expressions, so
+/* that the check costs nothing at runtime. Otherwise, it falls back to a
+/* loop over the table at runtime, without clock reads or output.
+/* BasicFunctionTest::test_table() checks the function of a tester on a table
+/* at runtime and reports the table as a whole.
+/*
+/* The rows take the expected result by its exact type, like
+/* BasicFunctionTest::test(): a row { 4.5, 2 } of a table of int results
+/* does not compile instead of being truncated to { 4, 2 }.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+constexpr int square(int x) { return x * x; }
+
+constexpr table_row<int, int> square_rows[] = {
+    { 0, 0 },
+    { 4, 2 },
+    { 9, -3 },
+};
+
+check_table<square, square_rows>();     // compile-time: a failing row is a compile error naming its index
+
+constexpr auto next = [](int x) { return x + 1; };
+check_table<+next, next_rows>();        // lambdas as function pointers
+
+auto r = check_table<runtime_fun, runtime_rows>();     // not constexpr: a loop at runtime
+// r.n_rows, r.n_passed_rows, r.first_failed_row, r.is_compile_time
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    /** A row of a test table: the expected result of the function invoked with the arguments.
+    @tparam ResultType Return type of the function.
+    @tparam ArgTypes Argument types of the function.
+    */
+    template <typename ResultType, typename... ArgTypes>
+    struct table_row {
+
+        ResultType expected;                ///< The expected result.
+        std::tuple<ArgTypes...> args;       ///< The arguments.
+
+        /// Constructor.
+        constexpr table_row(const ResultType& expected_result, const ArgTypes&... arguments)
+            :
+            expected(expected_result),
+            args(arguments...)
+        {}
+
+        /** This deleted constructor prevents expected results of the wrong type, like
+        double to int truncation, see BasicFunctionTest::test().
+        */
+        template <typename T>
+        table_row(const T&, const ArgTypes&...) = delete;
+
+    }; // END struct table_row
+
+
+    /// The result of a check of a function on a test table.
+    struct table_result {
+        std::size_t n_rows = 0;             ///< The number of rows.
+        std::size_t n_passed_rows = 0;      ///< The number of rows whose expected result the function returned.
+        std::size_t first_failed_row = 0;   ///< The index of the first failed row, n_rows if none failed.
+        bool is_compile_time = false;       ///< Whether the table was checked at compile time.
+
+        /// Indicates whether the function returned the expected result of every row.
+        constexpr bool is_all_rows_passed() const { return n_passed_rows == n_rows; }
+    };
+
+
+    /** Returns the index of the first row whose expected result the given function does not return,
+    or N if there is none. Compares with ==. A constant expression if the function and the rows are.
+    @param function The function.
+    @param rows The test table.
+    */
+    template <typename F, typename Row, std::size_t N>
+    constexpr std::size_t first_failed_row(const F& function, const Row (&rows)[N]) {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (!(std::apply(function, rows[i].args) == rows[i].expected)) {
+                return i;
+            }
+        }
+        return N;
+    }
+
+
+    /// Implementation details, clients never use these directly.
+    namespace detail {
+
+        template <auto Function, const auto& Rows, typename = void>
+        struct is_constant_table : std::false_type {};
+
+        /// Whether the check of Function on Rows is a constant expression.
+        template <auto Function, const auto& Rows>
+        struct is_constant_table<Function, Rows, std::void_t<std::integral_constant<std::size_t, first_failed_row(Function, Rows)>>> : std::true_type {};
+
+        /// Fails the compilation. The compiler names the template argument, i.e. the index of the failed row.
+        template <std::size_t FailedRow>
+        constexpr void fail_table_row() {
+            static_assert(FailedRow != FailedRow, "the function does not return the expected result of the row FailedRow of the test table");
+        }
+
+    } // END namespace detail
+
+
+    /** Checks a function on a test table.
+    If the function is constexpr and the table a constant expression, the check happens at compile time:
+    a failed row is a compile error that names its index, and nothing is left to do at runtime.
+    Otherwise, the function is invoked on every row at runtime.
+    @tparam Function A pointer to the function. For captureless lambdas, pass +lambda.
+    @tparam Rows A test table of static storage duration, e.g. a constexpr array of table_row.
+    @return The result of the check.
+    */
+    template <auto Function, const auto& Rows>
+    table_result check_table() {
+        constexpr std::size_t n_rows = std::extent<typename std::remove_reference<decltype(Rows)>::type>::value;
+
+        table_result ret;
+        ret.n_rows = n_rows;
+        if constexpr (detail::is_constant_table<Function, Rows>::value) {
+            constexpr std::size_t failed_row = first_failed_row(Function, Rows);
+            if constexpr (failed_row != n_rows) {
+                detail::fail_table_row<failed_row>();
+            }
+            ret.n_passed_rows = n_rows;
+            ret.first_failed_row = n_rows;
+            ret.is_compile_time = true;
+        }
+        else {
+            ret.first_failed_row = n_rows;
+            for (std::size_t i = 0; i < n_rows; ++i) {
+                if (std::apply(Function, Rows[i].args) == Rows[i].expected) {
+                    ++ret.n_passed_rows;
+                }
+                else if (ret.first_failed_row == n_rows) {
+                    ret.first_failed_row = i;
+                }
+            }
+        }
+        return ret;
+    }
+
+} // END namespace unittest
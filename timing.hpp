@@ -0,0 +1,295 @@
+/******************************************************************************
+/* @file Contains timing tools for micro-benchmarks: fine grained clocks,
+/*       guards that keep the compiler from optimizing benchmarked code
+/*       away and descriptive statistics on timing samples.
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace timing {
+
+        /// The clocks that can be used for measurements.
+        enum class clock {
+            STEADY = 0,     ///< std::chrono::steady_clock, with nanosecond resolution on common platforms.
+            TSC = 1,        ///< The x86 time stamp counter, converted to nanoseconds. Falls back to STEADY on other platforms.
+        };
+
+
+        /** Keeps the compiler from optimizing away the computation of the given value,
+        e.g. the result of a benchmarked function that is never used otherwise.
+        */
+        template <typename T>
+        inline void do_not_optimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : "r,m"(value) : "memory");
+#else
+            static const void* volatile sink;
+            sink = &value;
+            _ReadWriteBarrier();
+#endif
+        }
+
+
+        /** Keeps the compiler from reordering memory accesses across this call or from
+        assuming that memory is unchanged after it, so that writes of a benchmarked function are not elided.
+        */
+        inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : : "memory");
+#else
+            _ReadWriteBarrier();
+#endif
+        }
+
+
+        /// Returns whether the time stamp counter can be read on this platform.
+        constexpr bool is_tsc_available() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)) || defined(__x86_64__) || defined(__i386__)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+
+        /// Returns the value of the time stamp counter, or 0 if it is not available.
+        inline std::uint64_t read_tsc() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)) || defined(__x86_64__) || defined(__i386__)
+            _mm_lfence();
+            const std::uint64_t ret = __rdtsc();
+            _mm_lfence();
+            return ret;
+#else
+            return 0;
+#endif
+        }
+
+
+        /** Returns the number of time stamp counter ticks per nanosecond.
+        Calibrated once against the steady clock over about 20 milliseconds.
+        */
+        inline double tsc_ticks_per_ns() {
+            static const double ticks_per_ns = []() {
+                using namespace std::chrono;
+                const auto clock_start = steady_clock::now();
+                const auto tsc_start = read_tsc();
+                while (steady_clock::now() - clock_start < milliseconds(20)) {}
+                const auto tsc_end = read_tsc();
+                const auto ns = duration_cast<nanoseconds>(steady_clock::now() - clock_start).count();
+                return ns > 0 && tsc_end > tsc_start ? static_cast<double>(tsc_end - tsc_start) / ns : 1.0;
+            }();
+            return ticks_per_ns;
+        }
+
+
+        /// A running time measurement on one of the clocks.
+        class stopwatch {
+
+        private: // vars
+
+            clock clock_;                                           ///< The clock that is read.
+            std::chrono::steady_clock::time_point steady_start_;    ///< The start time on the steady clock.
+            std::uint64_t tsc_start_ = 0;                           ///< The start time on the time stamp counter.
+
+        public: // constructors
+
+            /// Constructor that starts the measurement.
+            explicit stopwatch(const clock c = clock::STEADY)
+                :
+                clock_(c == clock::TSC && is_tsc_available() ? clock::TSC : clock::STEADY)
+            {
+                if (clock_ == clock::TSC) {
+                    tsc_ticks_per_ns(); // calibrate before the first measurement
+                    tsc_start_ = read_tsc();
+                }
+                else {
+                    steady_start_ = std::chrono::steady_clock::now();
+                }
+            }
+
+        public: // methods
+
+            /// Returns the nanoseconds elapsed since the construction.
+            double elapsed_ns() const {
+                if (clock_ == clock::TSC) {
+                    return static_cast<double>(read_tsc() - tsc_start_) / tsc_ticks_per_ns();
+                }
+                return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - steady_start_).count());
+            }
+
+        }; // END class stopwatch
+
+
+        /// Descriptive statistics of a set of samples.
+        struct statistics {
+            unsigned int n_samples  = 0;    ///< The number of samples.
+            double min              = 0;    ///< The smallest sample.
+            double max              = 0;    ///< The largest sample.
+            double mean             = 0;    ///< The arithmetic mean.
+            double median           = 0;    ///< The 50th percentile.
+            double p90              = 0;    ///< The 90th percentile.
+            double p99              = 0;    ///< The 99th percentile.
+            double stddev           = 0;    ///< The sample standard deviation.
+        };
+
+
+        /** Running mean and variance of a stream of samples after Welford.
+        Two running_stats of disjoint sample streams can be merged.
+        */
+        struct running_stats {
+            unsigned long long n = 0;       ///< The number of samples.
+            double mean = 0;                ///< The arithmetic mean.
+            double m2 = 0;                  ///< The sum of the squared differences to the mean.
+
+            /// Adds a sample.
+            void add(const double x) {
+                ++n;
+                const double delta = x - mean;
+                mean += delta / n;
+                m2 += delta * (x - mean);
+            }
+
+            /// Adds all samples of another stream.
+            void merge(const running_stats& other) {
+                if (other.n == 0) {
+                    return;
+                }
+                const double n_total = static_cast<double>(n + other.n);
+                const double delta = other.mean - mean;
+                mean += delta * other.n / n_total;
+                m2 += other.m2 + delta * delta * n * other.n / n_total;
+                n += other.n;
+            }
+
+            /// Returns the sample variance.
+            double variance() const { return n > 1 ? m2 / (n - 1) : 0; }
+
+            /// Returns the sample standard deviation.
+            double stddev() const { return std::sqrt(variance()); }
+
+            /// Returns the standard error of the mean.
+            double standard_error() const { return n > 0 ? std::sqrt(variance() / n) : 0; }
+        };
+
+
+        /** Histogram of durations in nanoseconds with logarithmic buckets of a quarter octave each,
+        i.e. with a relative resolution of about 19%. Two histograms of disjoint sample streams can be merged.
+        */
+        struct log_histogram {
+            static constexpr unsigned int n_buckets = 128;      ///< The number of buckets. The last one also holds all longer durations.
+
+            std::array<unsigned long long, n_buckets> counts{}; ///< The number of samples per bucket. Bucket 0 holds durations below 1 ns,
+                                                                ///< bucket b > 0 holds durations in [2^((b-1)/4), 2^(b/4)) ns.
+            unsigned long long n = 0;                           ///< The number of samples.
+
+            /// Returns the index of the bucket of the given duration.
+            static unsigned int bucket(const double ns) {
+                if (!(ns >= 1)) {
+                    return 0;
+                }
+                const double b = 4 * std::log2(ns) + 1;
+                return b < n_buckets - 1 ? static_cast<unsigned int>(b) : n_buckets - 1;
+            }
+
+            /// Returns a representative duration of the given bucket, the geometric center of its bounds.
+            static double bucket_center(const unsigned int b) {
+                return b == 0 ? 0.5 : std::exp2((b - 0.5) / 4);
+            }
+
+            /// Adds a sample.
+            void add(const double ns) {
+                ++counts[bucket(ns)];
+                ++n;
+            }
+
+            /// Adds all samples of another histogram.
+            void merge(const log_histogram& other) {
+                for (unsigned int b = 0; b < n_buckets; ++b) {
+                    counts[b] += other.counts[b];
+                }
+                n += other.n;
+            }
+
+            /// Returns the given percentile, determined with the nearest-rank method, at the resolution of the buckets. 0 if there are no samples.
+            double percentile(const double p) const {
+                if (n == 0) {
+                    return 0;
+                }
+                const auto rank = std::max<unsigned long long>(static_cast<unsigned long long>(std::ceil(p / 100.0 * n)), 1);
+                unsigned long long n_below = 0;
+                for (unsigned int b = 0; b < n_buckets; ++b) {
+                    n_below += counts[b];
+                    if (n_below >= rank) {
+                        return bucket_center(b);
+                    }
+                }
+                return bucket_center(n_buckets - 1);
+            }
+        };
+
+
+        /** Computes descriptive statistics of the given samples.
+        The percentiles are determined with the nearest-rank method.
+        @param samples The samples. Taken by value since they have to be sorted.
+        @return The statistics of the samples. All zero if there are no samples.
+        */
+        inline statistics compute_statistics(std::vector<double> samples) {
+            statistics ret;
+            if (samples.empty()) {
+                return ret;
+            }
+            std::sort(samples.begin(), samples.end());
+
+            const auto n = samples.size();
+            const auto percentile = [&](const double p) {
+                const auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * n));
+                return samples[rank > 0 ? rank - 1 : 0];
+            };
+
+            double sum = 0;
+            for (const auto s : samples) {
+                sum += s;
+            }
+
+            ret.n_samples = static_cast<unsigned int>(n);
+            ret.min = samples.front();
+            ret.max = samples.back();
+            ret.mean = sum / n;
+            ret.median = percentile(50);
+            ret.p90 = percentile(90);
+            ret.p99 = percentile(99);
+
+            if (n > 1) {
+                double sum_squares = 0;
+                for (const auto s : samples) {
+                    sum_squares += (s - ret.mean) * (s - ret.mean);
+                }
+                ret.stddev = std::sqrt(sum_squares / (n - 1));
+            }
+            return ret;
+        }
+
+    } // END namespace timing
+
+} // END namespace unittest
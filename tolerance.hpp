@@ -0,0 +1,628 @@
+/******************************************************************************
+/* @file Contains comparators that accept results within a tolerance: an
+/*       absolute or relative epsilon or a distance in units in the last place.
+/*       They compare floating point numbers as well as contiguous ranges of
+/*       them, like std::vector<float> or std::array<double, N>.
+/*
+/* Ranges of float and double are checked with SSE2, AVX2 or AVX-512 kernels,
+/* whichever is the best that the CPU supports at runtime. The kernels only
+/* decide whether all elements are within the tolerance. When a result is
+/* not, worst() and describe() find the index and the magnitude of the worst
+/* mismatch with a scalar scan, which the testers only do for failed tests.
+/*
+/* NaN equals NaN, +0 equals -0 and an infinity equals the same infinity.
+/* Ranges of different sizes are never equal.
+/*
+/* The SIMD kernels require GCC or Clang on x86-64. Elsewhere the comparators
+/* use the scalar code.
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+RandomizedFunctionTest<vector<float>, vector<float>> tester(fast_fft, reference_fft, arg_creator, tolerance::relative(1e-5));
+
+// the testers that store the comparator by value also report the worst mismatch of every error case
+auto sqrt_tester = create_function_test<double>(fast_sqrt, tolerance::ulps(2));
+
+tolerance::absolute comp(1e-6);
+auto m = comp.worst(a, b);                              // m.index, m.magnitude, m.is_within
+cout << comp.describe(a, b) << "\n";                    // worst mismatch at index 17: 3.2e-05 (absolute, tolerance 1e-06)
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    #define UNITTEST_TOLERANCE_SIMD 1
+    #include <immintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace tolerance {
+
+        /// The instruction sets of the kernels, ordered by their width.
+        enum class simd_level {
+            SCALAR = 0,     ///< No SIMD.
+            SSE2 = 1,       ///< 128 bit, absolute and relative tolerances only.
+            AVX2 = 2,       ///< 256 bit.
+            AVX512 = 3,     ///< 512 bit, AVX-512F.
+        };
+
+
+        /// Returns the name of the given instruction set, e.g. "AVX2".
+        inline const char* name(const simd_level level) {
+            switch (level) {
+                case simd_level::SCALAR:    return "scalar";
+                case simd_level::SSE2:      return "SSE2";
+                case simd_level::AVX2:      return "AVX2";
+                case simd_level::AVX512:    return "AVX-512";
+            }
+            return "?";
+        }
+
+
+        /// Returns the best instruction set that both the compiler and the CPU support. Detected once.
+        inline simd_level detected_level() {
+#if defined(UNITTEST_TOLERANCE_SIMD)
+            static const simd_level ret = []() {
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx512f")) {
+                    return simd_level::AVX512;
+                }
+                if (__builtin_cpu_supports("avx2")) {
+                    return simd_level::AVX2;
+                }
+                return simd_level::SSE2;
+            }();
+            return ret;
+#else
+            return simd_level::SCALAR;
+#endif
+        }
+
+
+        /// The worst mismatch between two results.
+        struct mismatch {
+            std::size_t index = 0;      ///< The index of the worst element, 0 for scalars. The smaller size if the sizes differ.
+            double magnitude = 0;       ///< The absolute difference, relative difference or ULP distance. Infinite for NaN against a number or for different sizes.
+            bool is_within = true;      ///< Whether all elements are within the tolerance.
+        };
+
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// The kinds of tolerance.
+            enum class criterion { ABSOLUTE, RELATIVE, ULPS };
+
+            /// The tolerance of a comparator.
+            struct limits {
+                double epsilon = 0;             ///< The absolute or relative epsilon.
+                std::uint64_t max_ulps = 0;     ///< The maximum distance in units in the last place.
+            };
+
+
+            /// Returns the name of the given criterion.
+            inline const char* name(const criterion c) {
+                switch (c) {
+                    case criterion::ABSOLUTE:   return "absolute";
+                    case criterion::RELATIVE:   return "relative";
+                    case criterion::ULPS:       return "ulps";
+                }
+                return "?";
+            }
+
+
+            /** Returns the distance of two finite or infinite numbers in units in the last place.
+            Maps the sign and magnitude representation to two's complement, so that +0 and -0 are 0 apart.
+            */
+            template <typename T>
+            std::uint64_t ulp_distance(const T a, const T b) {
+                static_assert(std::is_floating_point<T>::value && (sizeof(T) == 4 || sizeof(T) == 8), "ULP distances require float or double");
+                using BitsType = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+                constexpr BitsType sign = BitsType(1) << (sizeof(T) * 8 - 1);
+
+                const auto to_signed = [](const T x) {
+                    BitsType bits;
+                    std::memcpy(&bits, &x, sizeof(T));
+                    const auto magnitude = static_cast<std::int64_t>(bits & ~sign);
+                    return (bits & sign) ? -magnitude : magnitude;
+                };
+                const std::int64_t sa = to_signed(a);
+                const std::int64_t sb = to_signed(b);
+                return sa > sb ? static_cast<std::uint64_t>(sa) - static_cast<std::uint64_t>(sb) : static_cast<std::uint64_t>(sb) - static_cast<std::uint64_t>(sa);
+            }
+
+
+            /// Indicates whether two numbers are within the tolerance. The reference for the SIMD kernels.
+            template <criterion C, typename T>
+            bool is_within(const T a, const T b, const limits& l) {
+                if constexpr (!std::is_floating_point<T>::value) {
+                    static_assert(C != criterion::ULPS, "ULP distances require float or double");
+                    return is_within<C>(static_cast<double>(a), static_cast<double>(b), l);
+                }
+                else {
+                    if (a == b || (a != a && b != b)) {
+                        return true;
+                    }
+                    if constexpr (C == criterion::ABSOLUTE) {
+                        return std::abs(a - b) <= static_cast<T>(l.epsilon);
+                    }
+                    else if constexpr (C == criterion::RELATIVE) {
+                        const T d = std::abs(a - b);
+                        return d <= static_cast<T>(l.epsilon) * std::max(std::abs(a), std::abs(b)) && d < std::numeric_limits<T>::infinity();
+                    }
+                    else {
+                        return a == a && b == b && ulp_distance(a, b) <= l.max_ulps;
+                    }
+                }
+            }
+
+
+            /// Returns the magnitude of the mismatch between two numbers, see mismatch::magnitude.
+            template <criterion C, typename T>
+            double magnitude(const T a, const T b) {
+                if constexpr (!std::is_floating_point<T>::value) {
+                    return magnitude<C>(static_cast<double>(a), static_cast<double>(b));
+                }
+                else {
+                    constexpr double inf = std::numeric_limits<double>::infinity();
+                    if (a == b || (a != a && b != b)) {
+                        return 0;
+                    }
+                    if (a != a || b != b) {
+                        return inf;
+                    }
+                    if constexpr (C == criterion::ABSOLUTE) {
+                        return std::abs(static_cast<double>(a) - static_cast<double>(b));
+                    }
+                    else if constexpr (C == criterion::RELATIVE) {
+                        const double ret = std::abs(static_cast<double>(a) - static_cast<double>(b)) / std::max(std::abs(static_cast<double>(a)), std::abs(static_cast<double>(b)));
+                        return ret == ret ? ret : inf;
+                    }
+                    else {
+                        return static_cast<double>(ulp_distance(a, b));
+                    }
+                }
+            }
+
+
+            /// Indicates whether all n elements of two arrays are within the tolerance, without SIMD.
+            template <criterion C, typename T>
+            bool all_within_scalar(const T* a, const T* b, const std::size_t n, const limits& l) {
+                for (std::size_t i = 0; i < n; ++i) {
+                    if (!is_within<C>(a[i], b[i], l)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+#if defined(UNITTEST_TOLERANCE_SIMD)
+
+            /// SSE2 kernel for float, absolute and relative tolerances.
+            template <criterion C>
+            inline bool all_within_sse2(const float* a, const float* b, const std::size_t n, const limits& l) {
+                static_assert(C != criterion::ULPS, "the SSE2 kernels have no integer compares for ULPs");
+                const __m128 sign = _mm_set1_ps(-0.0f);
+                const __m128 eps = _mm_set1_ps(static_cast<float>(l.epsilon));
+                const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+                std::size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    const __m128 va = _mm_loadu_ps(a + i);
+                    const __m128 vb = _mm_loadu_ps(b + i);
+                    const __m128 d = _mm_andnot_ps(sign, _mm_sub_ps(va, vb));
+                    __m128 ok = _mm_or_ps(_mm_cmpeq_ps(va, vb), _mm_and_ps(_mm_cmpunord_ps(va, va), _mm_cmpunord_ps(vb, vb)));
+                    if constexpr (C == criterion::ABSOLUTE) {
+                        ok = _mm_or_ps(ok, _mm_cmple_ps(d, eps));
+                    }
+                    else {
+                        const __m128 m = _mm_max_ps(_mm_andnot_ps(sign, va), _mm_andnot_ps(sign, vb));
+                        ok = _mm_or_ps(ok, _mm_and_ps(_mm_cmple_ps(d, _mm_mul_ps(eps, m)), _mm_cmplt_ps(d, inf)));
+                    }
+                    if (_mm_movemask_ps(ok) != 0xF) {
+                        return false;
+                    }
+                }
+                return all_within_scalar<C>(a + i, b + i, n - i, l);
+            }
+
+
+            /// SSE2 kernel for double, absolute and relative tolerances.
+            template <criterion C>
+            inline bool all_within_sse2(const double* a, const double* b, const std::size_t n, const limits& l) {
+                static_assert(C != criterion::ULPS, "the SSE2 kernels have no integer compares for ULPs");
+                const __m128d sign = _mm_set1_pd(-0.0);
+                const __m128d eps = _mm_set1_pd(l.epsilon);
+                const __m128d inf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+                std::size_t i = 0;
+                for (; i + 2 <= n; i += 2) {
+                    const __m128d va = _mm_loadu_pd(a + i);
+                    const __m128d vb = _mm_loadu_pd(b + i);
+                    const __m128d d = _mm_andnot_pd(sign, _mm_sub_pd(va, vb));
+                    __m128d ok = _mm_or_pd(_mm_cmpeq_pd(va, vb), _mm_and_pd(_mm_cmpunord_pd(va, va), _mm_cmpunord_pd(vb, vb)));
+                    if constexpr (C == criterion::ABSOLUTE) {
+                        ok = _mm_or_pd(ok, _mm_cmple_pd(d, eps));
+                    }
+                    else {
+                        const __m128d m = _mm_max_pd(_mm_andnot_pd(sign, va), _mm_andnot_pd(sign, vb));
+                        ok = _mm_or_pd(ok, _mm_and_pd(_mm_cmple_pd(d, _mm_mul_pd(eps, m)), _mm_cmplt_pd(d, inf)));
+                    }
+                    if (_mm_movemask_pd(ok) != 0x3) {
+                        return false;
+                    }
+                }
+                return all_within_scalar<C>(a + i, b + i, n - i, l);
+            }
+
+
+            /// AVX2 kernel for float.
+            template <criterion C>
+            __attribute__((target("avx2")))
+            bool all_within_avx2(const float* a, const float* b, const std::size_t n, const limits& l) {
+                const __m256 sign = _mm256_set1_ps(-0.0f);
+                const __m256 eps = _mm256_set1_ps(static_cast<float>(l.epsilon));
+                const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+                const __m256i abs_mask = _mm256_set1_epi32(0x7fffffff);
+                const __m256i max_ulps = _mm256_set1_epi32(static_cast<int>(std::min<std::uint64_t>(l.max_ulps, 0xffffffffu)));
+                const __m256i zero = _mm256_setzero_si256();
+                std::size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    const __m256 va = _mm256_loadu_ps(a + i);
+                    const __m256 vb = _mm256_loadu_ps(b + i);
+                    const __m256 both_nan = _mm256_and_ps(_mm256_cmp_ps(va, va, _CMP_UNORD_Q), _mm256_cmp_ps(vb, vb, _CMP_UNORD_Q));
+                    __m256 ok = _mm256_or_ps(_mm256_cmp_ps(va, vb, _CMP_EQ_OQ), both_nan);
+                    if constexpr (C == criterion::ABSOLUTE) {
+                        const __m256 d = _mm256_andnot_ps(sign, _mm256_sub_ps(va, vb));
+                        ok = _mm256_or_ps(ok, _mm256_cmp_ps(d, eps, _CMP_LE_OQ));
+                    }
+                    else if constexpr (C == criterion::RELATIVE) {
+                        const __m256 d = _mm256_andnot_ps(sign, _mm256_sub_ps(va, vb));
+                        const __m256 m = _mm256_max_ps(_mm256_andnot_ps(sign, va), _mm256_andnot_ps(sign, vb));
+                        ok = _mm256_or_ps(ok, _mm256_and_ps(_mm256_cmp_ps(d, _mm256_mul_ps(eps, m), _CMP_LE_OQ), _mm256_cmp_ps(d, inf, _CMP_LT_OQ)));
+                    }
+                    else {
+                        // sign and magnitude to two's complement, then the unsigned distance
+                        const __m256i x = _mm256_castps_si256(va);
+                        const __m256i y = _mm256_castps_si256(vb);
+                        const __m256i mx = _mm256_and_si256(x, abs_mask);
+                        const __m256i my = _mm256_and_si256(y, abs_mask);
+                        const __m256i sx = _mm256_blendv_epi8(mx, _mm256_sub_epi32(zero, mx), _mm256_srai_epi32(x, 31));
+                        const __m256i sy = _mm256_blendv_epi8(my, _mm256_sub_epi32(zero, my), _mm256_srai_epi32(y, 31));
+                        const __m256i d = _mm256_sub_epi32(_mm256_max_epi32(sx, sy), _mm256_min_epi32(sx, sy));
+                        const __m256 is_close = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_max_epu32(d, max_ulps), max_ulps));
+                        const __m256 is_nan = _mm256_or_ps(_mm256_cmp_ps(va, va, _CMP_UNORD_Q), _mm256_cmp_ps(vb, vb, _CMP_UNORD_Q));
+                        ok = _mm256_or_ps(ok, _mm256_andnot_ps(is_nan, is_close));
+                    }
+                    if (_mm256_movemask_ps(ok) != 0xFF) {
+                        return false;
+                    }
+                }
+                return all_within_scalar<C>(a + i, b + i, n - i, l);
+            }
+
+
+            /// AVX2 kernel for double.
+            template <criterion C>
+            __attribute__((target("avx2")))
+            bool all_within_avx2(const double* a, const double* b, const std::size_t n, const limits& l) {
+                const __m256d sign = _mm256_set1_pd(-0.0);
+                const __m256d eps = _mm256_set1_pd(l.epsilon);
+                const __m256d inf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+                const __m256i abs_mask = _mm256_set1_epi64x(0x7fffffffffffffffll);
+                const __m256i bias = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+                const __m256i biased_max_ulps = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(l.max_ulps)), bias);
+                const __m256i zero = _mm256_setzero_si256();
+                std::size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    const __m256d va = _mm256_loadu_pd(a + i);
+                    const __m256d vb = _mm256_loadu_pd(b + i);
+                    const __m256d both_nan = _mm256_and_pd(_mm256_cmp_pd(va, va, _CMP_UNORD_Q), _mm256_cmp_pd(vb, vb, _CMP_UNORD_Q));
+                    __m256d ok = _mm256_or_pd(_mm256_cmp_pd(va, vb, _CMP_EQ_OQ), both_nan);
+                    if constexpr (C == criterion::ABSOLUTE) {
+                        const __m256d d = _mm256_andnot_pd(sign, _mm256_sub_pd(va, vb));
+                        ok = _mm256_or_pd(ok, _mm256_cmp_pd(d, eps, _CMP_LE_OQ));
+                    }
+                    else if constexpr (C == criterion::RELATIVE) {
+                        const __m256d d = _mm256_andnot_pd(sign, _mm256_sub_pd(va, vb));
+                        const __m256d m = _mm256_max_pd(_mm256_andnot_pd(sign, va), _mm256_andnot_pd(sign, vb));
+                        ok = _mm256_or_pd(ok, _mm256_and_pd(_mm256_cmp_pd(d, _mm256_mul_pd(eps, m), _CMP_LE_OQ), _mm256_cmp_pd(d, inf, _CMP_LT_OQ)));
+                    }
+                    else {
+                        // as for float, but AVX2 has neither 64 bit min, max nor unsigned compares
+                        const __m256i x = _mm256_castpd_si256(va);
+                        const __m256i y = _mm256_castpd_si256(vb);
+                        const __m256i mx = _mm256_and_si256(x, abs_mask);
+                        const __m256i my = _mm256_and_si256(y, abs_mask);
+                        const __m256i sx = _mm256_blendv_epi8(mx, _mm256_sub_epi64(zero, mx), _mm256_cmpgt_epi64(zero, x));
+                        const __m256i sy = _mm256_blendv_epi8(my, _mm256_sub_epi64(zero, my), _mm256_cmpgt_epi64(zero, y));
+                        const __m256i d = _mm256_blendv_epi8(_mm256_sub_epi64(sy, sx), _mm256_sub_epi64(sx, sy), _mm256_cmpgt_epi64(sx, sy));
+                        const __m256d is_far = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_xor_si256(d, bias), biased_max_ulps));
+                        const __m256d is_nan = _mm256_or_pd(_mm256_cmp_pd(va, va, _CMP_UNORD_Q), _mm256_cmp_pd(vb, vb, _CMP_UNORD_Q));
+                        ok = _mm256_or_pd(ok, _mm256_andnot_pd(_mm256_or_pd(is_nan, is_far), _mm256_castsi256_pd(_mm256_cmpeq_epi64(zero, zero))));
+                    }
+                    if (_mm256_movemask_pd(ok) != 0xF) {
+                        return false;
+                    }
+                }
+                return all_within_scalar<C>(a + i, b + i, n - i, l);
+            }
+
+
+            // the AVX-512 intrinsics of GCC start from deliberately undefined vectors
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+            /// AVX-512F kernel for float.
+            template <criterion C>
+            __attribute__((target("avx512f")))
+            bool all_within_avx512(const float* a, const float* b, const std::size_t n, const limits& l) {
+                const __m512 eps = _mm512_set1_ps(static_cast<float>(l.epsilon));
+                const __m512 inf = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+                const __m512i abs_mask = _mm512_set1_epi32(0x7fffffff);
+                const __m512i max_ulps = _mm512_set1_epi32(static_cast<int>(std::min<std::uint64_t>(l.max_ulps, 0xffffffffu)));
+                const __m512i zero = _mm512_setzero_si512();
+                std::size_t i = 0;
+                for (; i + 16 <= n; i += 16) {
+                    const __m512 va = _mm512_loadu_ps(a + i);
+                    const __m512 vb = _mm512_loadu_ps(b + i);
+                    const __mmask16 nan_a = _mm512_cmp_ps_mask(va, va, _CMP_UNORD_Q);
+                    const __mmask16 nan_b = _mm512_cmp_ps_mask(vb, vb, _CMP_UNORD_Q);
+                    __mmask16 ok = _mm512_cmp_ps_mask(va, vb, _CMP_EQ_OQ) | (nan_a & nan_b);
+                    if constexpr (C == criterion::ABSOLUTE) {
+                        const __m512 d = _mm512_abs_ps(_mm512_sub_ps(va, vb));
+                        ok |= _mm512_cmp_ps_mask(d, eps, _CMP_LE_OQ);
+                    }
+                    else if constexpr (C == criterion::RELATIVE) {
+                        const __m512 d = _mm512_abs_ps(_mm512_sub_ps(va, vb));
+                        const __m512 m = _mm512_max_ps(_mm512_abs_ps(va), _mm512_abs_ps(vb));
+                        ok |= _mm512_cmp_ps_mask(d, _mm512_mul_ps(eps, m), _CMP_LE_OQ) & _mm512_cmp_ps_mask(d, inf, _CMP_LT_OQ);
+                    }
+                    else {
+                        const __m512i x = _mm512_castps_si512(va);
+                        const __m512i y = _mm512_castps_si512(vb);
+                        const __m512i mx = _mm512_and_si512(x, abs_mask);
+                        const __m512i my = _mm512_and_si512(y, abs_mask);
+                        const __m512i sx = _mm512_mask_sub_epi32(mx, _mm512_cmplt_epi32_mask(x, zero), zero, mx);
+                        const __m512i sy = _mm512_mask_sub_epi32(my, _mm512_cmplt_epi32_mask(y, zero), zero, my);
+                        const __m512i d = _mm512_sub_epi32(_mm512_max_epi32(sx, sy), _mm512_min_epi32(sx, sy));
+                        ok |= _mm512_cmp_epu32_mask(d, max_ulps, _MM_CMPINT_LE) & static_cast<__mmask16>(~(nan_a | nan_b));
+                    }
+                    if (ok != 0xFFFF) {
+                        return false;
+                    }
+                }
+                return all_within_scalar<C>(a + i, b + i, n - i, l);
+            }
+
+
+            /// AVX-512F kernel for double.
+            template <criterion C>
+            __attribute__((target("avx512f")))
+            bool all_within_avx512(const double* a, const double* b, const std::size_t n, const limits& l) {
+                const __m512d eps = _mm512_set1_pd(l.epsilon);
+                const __m512d inf = _mm512_set1_pd(std::numeric_limits<double>::infinity());
+                const __m512i abs_mask = _mm512_set1_epi64(0x7fffffffffffffffll);
+                const __m512i max_ulps = _mm512_set1_epi64(static_cast<long long>(l.max_ulps));
+                const __m512i zero = _mm512_setzero_si512();
+                std::size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    const __m512d va = _mm512_loadu_pd(a + i);
+                    const __m512d vb = _mm512_loadu_pd(b + i);
+                    const __mmask8 nan_a = _mm512_cmp_pd_mask(va, va, _CMP_UNORD_Q);
+                    const __mmask8 nan_b = _mm512_cmp_pd_mask(vb, vb, _CMP_UNORD_Q);
+                    __mmask8 ok = _mm512_cmp_pd_mask(va, vb, _CMP_EQ_OQ) | (nan_a & nan_b);
+                    if constexpr (C == criterion::ABSOLUTE) {
+                        const __m512d d = _mm512_abs_pd(_mm512_sub_pd(va, vb));
+                        ok |= _mm512_cmp_pd_mask(d, eps, _CMP_LE_OQ);
+                    }
+                    else if constexpr (C == criterion::RELATIVE) {
+                        const __m512d d = _mm512_abs_pd(_mm512_sub_pd(va, vb));
+                        const __m512d m = _mm512_max_pd(_mm512_abs_pd(va), _mm512_abs_pd(vb));
+                        ok |= _mm512_cmp_pd_mask(d, _mm512_mul_pd(eps, m), _CMP_LE_OQ) & _mm512_cmp_pd_mask(d, inf, _CMP_LT_OQ);
+                    }
+                    else {
+                        const __m512i x = _mm512_castpd_si512(va);
+                        const __m512i y = _mm512_castpd_si512(vb);
+                        const __m512i mx = _mm512_and_si512(x, abs_mask);
+                        const __m512i my = _mm512_and_si512(y, abs_mask);
+                        const __m512i sx = _mm512_mask_sub_epi64(mx, _mm512_cmplt_epi64_mask(x, zero), zero, mx);
+                        const __m512i sy = _mm512_mask_sub_epi64(my, _mm512_cmplt_epi64_mask(y, zero), zero, my);
+                        const __m512i d = _mm512_sub_epi64(_mm512_max_epi64(sx, sy), _mm512_min_epi64(sx, sy));
+                        ok |= _mm512_cmp_epu64_mask(d, max_ulps, _MM_CMPINT_LE) & static_cast<__mmask8>(~(nan_a | nan_b));
+                    }
+                    if (ok != 0xFF) {
+                        return false;
+                    }
+                }
+                return all_within_scalar<C>(a + i, b + i, n - i, l);
+            }
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#endif // defined(UNITTEST_TOLERANCE_SIMD)
+
+            /** Indicates whether all n elements of two arrays are within the tolerance.
+            Uses the widest kernel up to the given instruction set.
+            */
+            template <criterion C, typename T>
+            bool all_within(const T* a, const T* b, const std::size_t n, const limits& l, const simd_level level) {
+#if defined(UNITTEST_TOLERANCE_SIMD)
+                if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value) {
+                    if (level >= simd_level::AVX512) {
+                        return all_within_avx512<C>(a, b, n, l);
+                    }
+                    if (level >= simd_level::AVX2) {
+                        return all_within_avx2<C>(a, b, n, l);
+                    }
+                    if constexpr (C != criterion::ULPS) {
+                        if (level >= simd_level::SSE2) {
+                            return all_within_sse2<C>(a, b, n, l);
+                        }
+                    }
+                }
+#else
+                (void)level;
+#endif
+                return all_within_scalar<C>(a, b, n, l);
+            }
+
+
+            /// Finds the worst mismatch of the n elements of two arrays with a scalar scan.
+            template <criterion C, typename T>
+            mismatch worst(const T* a, const T* b, const std::size_t n, const limits& l) {
+                mismatch ret;
+                for (std::size_t i = 0; i < n; ++i) {
+                    ret.is_within = is_within<C>(a[i], b[i], l) && ret.is_within;
+                    const double m = magnitude<C>(a[i], b[i]);
+                    if (m > ret.magnitude) {
+                        ret.index = i;
+                        ret.magnitude = m;
+                    }
+                }
+                return ret;
+            }
+
+
+            /// Whether T is a contiguous range of numbers, i.e. has data() and size(), like std::vector<float>.
+            template <typename T, typename = void>
+            struct is_contiguous_range : std::false_type {};
+
+            template <typename T>
+            struct is_contiguous_range<T, decltype(void(std::declval<const T&>().size()), void(*std::declval<const T&>().data()))>
+                : std::is_arithmetic<typename std::remove_cv<typename std::remove_reference<decltype(*std::declval<const T&>().data())>::type>::type> {};
+
+
+            /** The comparator of a kind of tolerance.
+            @tparam C The kind of tolerance.
+            */
+            template <criterion C>
+            class comparator {
+
+            public: // vars
+
+                simd_level level = detected_level();    ///< The widest instruction set that the comparator uses. Lower it to compare the kernels.
+
+            protected: // vars
+
+                limits limits_;     ///< The tolerance.
+
+            public: // methods
+
+                /** Compares two numbers or two contiguous ranges of numbers.
+                @return True if the sizes agree and all elements are within the tolerance.
+                */
+                template <typename T>
+                bool operator()(const T& a, const T& b) const {
+                    if constexpr (std::is_arithmetic<T>::value) {
+                        return is_within<C>(a, b, limits_);
+                    }
+                    else {
+                        static_assert(is_contiguous_range<T>::value, "tolerance comparators compare numbers and contiguous ranges of numbers");
+                        return a.size() == b.size() && all_within<C>(a.data(), b.data(), a.size(), limits_, level);
+                    }
+                }
+
+
+                /// Finds the worst mismatch between two numbers or two contiguous ranges of numbers.
+                template <typename T>
+                mismatch worst(const T& a, const T& b) const {
+                    if constexpr (std::is_arithmetic<T>::value) {
+                        return detail::worst<C>(&a, &b, 1, limits_);
+                    }
+                    else {
+                        static_assert(is_contiguous_range<T>::value, "tolerance comparators compare numbers and contiguous ranges of numbers");
+                        if (a.size() != b.size()) {
+                            mismatch ret;
+                            ret.index = std::min<std::size_t>(a.size(), b.size());
+                            ret.magnitude = std::numeric_limits<double>::infinity();
+                            ret.is_within = false;
+                            return ret;
+                        }
+                        return detail::worst<C>(a.data(), b.data(), a.size(), limits_);
+                    }
+                }
+
+
+                /** Describes the worst mismatch between two results for the reports of the testers,
+                e.g. "worst mismatch at index 17: 3.2e-05 (relative, tolerance 1e-05)".
+                */
+                template <typename T>
+                std::string describe(const T& a, const T& b) const {
+                    std::stringstream ss;
+                    if constexpr (!std::is_arithmetic<T>::value) {
+                        if (a.size() != b.size()) {
+                            ss << "sizes differ: " << a.size() << " vs " << b.size();
+                            return ss.str();
+                        }
+                    }
+                    const mismatch m = worst(a, b);
+                    ss << "worst mismatch";
+                    if constexpr (!std::is_arithmetic<T>::value) {
+                        ss << " at index " << m.index;
+                    }
+                    ss << ": " << m.magnitude << " (" << name(C) << ", tolerance ";
+                    if (C == criterion::ULPS)   ss << limits_.max_ulps << ")";
+                    else                        ss << limits_.epsilon << ")";
+                    return ss.str();
+                }
+
+            }; // END class comparator
+
+        } // END namespace detail
+
+
+        /// Accepts numbers whose difference is at most epsilon.
+        class absolute : public detail::comparator<detail::criterion::ABSOLUTE> {
+        public: // constructors
+            /// Constructor. @param epsilon The greatest accepted difference.
+            explicit absolute(const double epsilon) { limits_.epsilon = epsilon; }
+        };
+
+
+        /** Accepts numbers whose difference is at most epsilon times the greater of their magnitudes.
+        Note that only equal numbers are within a relative tolerance of 0.
+        */
+        class relative : public detail::comparator<detail::criterion::RELATIVE> {
+        public: // constructors
+            /// Constructor. @param epsilon The greatest accepted difference, relative to the greater magnitude.
+            explicit relative(const double epsilon) { limits_.epsilon = epsilon; }
+        };
+
+
+        /// Accepts floats or doubles that are at most max_ulps representable numbers apart.
+        class ulps : public detail::comparator<detail::criterion::ULPS> {
+        public: // constructors
+            /// Constructor. @param max_ulps The greatest accepted distance in units in the last place.
+            explicit ulps(const std::uint64_t max_ulps) { limits_.max_ulps = max_ulps; }
+        };
+
+    } // END namespace tolerance
+
+} // END namespace unittest
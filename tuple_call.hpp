@@ -0,0 +1,106 @@
+/******************************************************************************
+/* @file Contains a tool to call a function with the elements of a std::tuple
+/*       as arguments, optionally measuring the duration of the invocation.
+/*
+/* - based on recursive index generation.
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace tuple_call {
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// Recursive implementation of the call structure which is used to unpack tuples into function parameters.
+            template <typename F, typename Tuple, bool Done, int Total, int... N>
+            struct call_impl {
+
+                /// Recursively calls the recursive call_impl::call function until The the last tuple element was unpacked.
+                constexpr static decltype(auto) call(F&& f, Tuple&& t) {
+                    return call_impl<F, Tuple, Total == 1 + sizeof...(N), Total, N..., sizeof...(N)>::call(std::forward<F>(f), std::forward<Tuple>(t));
+                }
+
+                /// Recursively calls the recursive call_impl::call function until The the last tuple element was unpacked.
+                template <typename Duration>
+                constexpr static auto call(F&& f, Tuple&& t, Duration& out_duration) {
+                    return call_impl<F, Tuple, Total == 1 + sizeof...(N), Total, N..., sizeof...(N)>::call(std::forward<F>(f), std::forward<Tuple>(t), out_duration);
+                }
+            };
+
+            /// Final recursive implementation of the call structure.
+            template <typename F, typename Tuple, int Total, int... N>
+            struct call_impl<F, Tuple, true, Total, N...> {
+
+                /// Final recursive call to the actual function with all arguments unpacked.
+                constexpr static decltype(auto) call(F&& f, Tuple&& t) {
+                    return std::forward<F>(f)(std::get<N>(std::forward<Tuple>(t))...);
+                }
+
+                /// Final recursive call to the actual function with all arguments unpacked.
+                /// Measures the duration of the invocation on the steady clock.
+                template <typename Duration>
+                static auto call(F&& f, Tuple&& t, Duration& out_duration) {
+                    using namespace std::chrono;
+
+                    const auto clock_start = steady_clock::now();
+                    auto ret = std::forward<F>(f)(std::get<N>(std::forward<Tuple>(t))...);
+                    out_duration = duration_cast<Duration>(steady_clock::now() - clock_start);
+
+                    return ret;
+                }
+            };
+
+            /// The call structure for the given function and tuple type.
+            template <typename F, typename Tuple>
+            using call_impl_for = call_impl<F, Tuple,
+                0 == std::tuple_size<typename std::decay<Tuple>::type>::value,
+                std::tuple_size<typename std::decay<Tuple>::type>::value>;
+
+        } // END namespace detail
+
+
+        /** Calls the given function f with the parameters found in the given tuple and,
+        if f returns a value, also returns this value.
+        @param f A function.
+        @param t A tuple containing the parameters for the invocation of f.
+        If f takes no arguments, pass std::tuple<>().
+        @return Returns the return value of f.
+        If f's result type would be void, the return type of this function would also be void.
+        */
+        template <typename F, typename Tuple>
+        constexpr decltype(auto) call(F&& f, Tuple&& t) {
+            return detail::call_impl_for<F, Tuple>::call(std::forward<F>(f), std::forward<Tuple>(t));
+        }
+
+
+        /** Calls the given function f with the parameters found in the given tuple,
+        measures the duration of the invocation and returns the return value of f.
+        @param f A function with a non-void return type.
+        @param t A tuple containing the parameters for the invocation of f.
+        If f takes no arguments, pass std::tuple<>().
+        @param[out] out_duration A reference to a std::chrono::duration object to which the execution time
+        of the function will be written.
+        @return Returns the return value of f.
+        */
+        template <typename F, typename Tuple, typename Duration>
+        constexpr auto call(F&& f, Tuple&& t, Duration& out_duration) {
+            return detail::call_impl_for<F, Tuple>::call(std::forward<F>(f), std::forward<Tuple>(t), out_duration);
+        }
+
+    } // END namespace tuple_call
+
+} // END namespace unittest
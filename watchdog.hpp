@@ -0,0 +1,242 @@
+/******************************************************************************
+/* @file Contains class watchdog, which detects test cases that run past
+/*       their deadline and test series that run past their time budget.
+/*
+/* Every worker owns a progress slot into which it stores the index of the
+/* case that it is about to conduct, and watchdog::idle when it has nothing
+/* to do. This costs a single relaxed store per case. The watchdog looks at
+/* the slots from time to time: a slot whose case index did not change for
+/* longer than the timeout belongs to a case that runs past its deadline.
+/* Cases are therefore detected with a delay of at most one period.
+/*
+/* The watchdog either runs on a thread of its own, see start(), or is
+/* checked by a thread that waits anyway, see check().
+/*
+/*
+/* An example:
+###################################################################################################
+
+using namespace unittest;
+
+watchdog dog(n_workers, std::chrono::milliseconds(100), std::chrono::seconds(10));
+dog.start(
+    [](unsigned int worker, unsigned int case_index) { std::cerr << "case " << case_index << " hangs\n"; },
+    []() { std::cerr << "out of time\n"; });
+
+// on worker w:
+for (unsigned int i = begin; i < end && !dog.is_budget_exhausted(); ++i) {
+    dog.slot(w).store(i, std::memory_order_relaxed);
+    // ...
+}
+dog.slot(w).store(watchdog::idle, std::memory_order_relaxed);
+
+###################################################################################################
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    /** Observes the progress slots of several workers and the time budget of a test series.
+    A zero timeout or budget disables the respective check.
+    */
+    class watchdog {
+
+    public: // types
+
+        using ClockType     = std::chrono::steady_clock;
+        using DurationType  = std::chrono::nanoseconds;
+
+    private: // inner classes
+
+        /// What the watchdog knows about a slot.
+        struct ObservationType {
+            unsigned int case_index = 0;                ///< The last seen case index.
+            ClockType::time_point since;                ///< When the case index was seen first.
+            bool is_reported = false;                   ///< Whether the case was reported as timed out.
+        };
+
+    public: // static vars
+
+        static constexpr unsigned int idle = ~0u;      ///< The value of a slot whose worker conducts no case.
+
+    private: // vars
+
+        std::unique_ptr<std::atomic<unsigned int>[]> own_slots_;   ///< The slots, if the watchdog owns them.
+        std::atomic<unsigned int>* slots_;                          ///< The slots.
+        std::size_t n_slots_;                                       ///< The number of slots.
+        DurationType timeout_;                                      ///< The deadline of a case, 0 if cases have none.
+        DurationType budget_;                                       ///< The time budget of the series, 0 if it has none.
+        ClockType::time_point start_;                               ///< When the series began.
+        std::vector<ObservationType> observations_;                 ///< What the watchdog knows about each slot.
+        std::atomic<bool> is_budget_exhausted_{ false };            ///< Whether the budget is exhausted.
+
+        std::mutex wake_mutex_;                                     ///< The mutex of wake_.
+        std::condition_variable wake_;                              ///< Wakes the thread up for stop().
+        bool is_stopping_ = false;                                  ///< Tells the thread to exit.
+        std::thread thread_;                                        ///< The thread, if started.
+
+    public: // constructors
+
+        /** Constructor. Owns the slots, which are idle at first. The budget begins now.
+        @param n_slots The number of slots, i.e. of workers.
+        @param timeout The deadline of a case, 0 for none.
+        @param budget The time budget of the series, 0 for none.
+        */
+        watchdog(const std::size_t n_slots, const DurationType timeout, const DurationType budget)
+            :
+            own_slots_(new std::atomic<unsigned int>[n_slots]),
+            slots_(own_slots_.get()),
+            n_slots_(n_slots),
+            timeout_(timeout),
+            budget_(budget),
+            start_(ClockType::now()),
+            observations_(n_slots)
+        {
+            for (std::size_t i = 0; i < n_slots; ++i) {
+                slots_[i].store(idle, std::memory_order_relaxed);
+                reset(i);
+            }
+        }
+
+        /** Constructor for slots that live elsewhere, e.g. in memory that is shared with other processes.
+        The budget begins now.
+        @param slots The slots. Must outlive the watchdog.
+        @param n_slots The number of slots.
+        @param timeout The deadline of a case, 0 for none.
+        @param budget The time budget of the series, 0 for none.
+        */
+        watchdog(std::atomic<unsigned int>* slots, const std::size_t n_slots, const DurationType timeout, const DurationType budget)
+            :
+            slots_(slots),
+            n_slots_(n_slots),
+            timeout_(timeout),
+            budget_(budget),
+            start_(ClockType::now()),
+            observations_(n_slots)
+        {
+            for (std::size_t i = 0; i < n_slots; ++i) {
+                reset(i);
+            }
+        }
+
+        watchdog(const watchdog&) = delete;
+        watchdog& operator=(const watchdog&) = delete;
+
+        /// Destructor. Stops the thread.
+        ~watchdog() {
+            stop();
+        }
+
+    public: // methods
+
+        /** Looks at the slots and the budget once. Not thread-safe, use either check() or start().
+        @param on_timeout A function void(unsigned int slot, unsigned int case_index) that is called once
+        for every case that runs past its deadline.
+        */
+        template <typename F>
+        void check(F&& on_timeout) {
+            const auto now = ClockType::now();
+            if (budget_.count() > 0 && now - start_ >= budget_) {
+                is_budget_exhausted_.store(true, std::memory_order_relaxed);
+            }
+            if (timeout_.count() <= 0) {
+                return;
+            }
+            for (std::size_t i = 0; i < n_slots_; ++i) {
+                auto& o = observations_[i];
+                const unsigned int case_index = slots_[i].load(std::memory_order_relaxed);
+                if (case_index != o.case_index) {
+                    o.case_index = case_index;
+                    o.since = now;
+                    o.is_reported = false;
+                }
+                else if (case_index != idle && !o.is_reported && now - o.since > timeout_) {
+                    o.is_reported = true;
+                    on_timeout(static_cast<unsigned int>(i), case_index);
+                }
+            }
+        }
+
+
+        /** Starts a thread that calls check() once per period() until stop().
+        @param on_timeout A function void(unsigned int slot, unsigned int case_index), see check().
+        Called on the thread of the watchdog.
+        @param on_budget_exhausted A function void() that is called once when the budget is exhausted.
+        */
+        void start(std::function<void(unsigned int, unsigned int)> on_timeout, std::function<void()> on_budget_exhausted) {
+            thread_ = std::thread([this, on_timeout = std::move(on_timeout), on_budget_exhausted = std::move(on_budget_exhausted)]() {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                bool was_budget_exhausted = false;
+                while (!wake_.wait_for(lock, period(), [this]() { return is_stopping_; })) {
+                    check(on_timeout);
+                    if (!was_budget_exhausted && is_budget_exhausted()) {
+                        was_budget_exhausted = true;
+                        if (on_budget_exhausted) {
+                            on_budget_exhausted();
+                        }
+                    }
+                }
+            });
+        }
+
+
+        /// Stops the thread of start(), if any.
+        void stop() {
+            if (!thread_.joinable()) {
+                return;
+            }
+            {
+                const std::lock_guard<std::mutex> lock(wake_mutex_);
+                is_stopping_ = true;
+            }
+            wake_.notify_one();
+            thread_.join();
+        }
+
+
+        /// Forgets what the watchdog knows about a slot, e.g. after its worker was replaced.
+        void reset(const std::size_t slot) {
+            observations_[slot] = ObservationType{ slots_[slot].load(std::memory_order_relaxed), ClockType::now(), false };
+        }
+
+    public: // getters
+
+        /// Returns the progress slot of the given worker.
+        inline std::atomic<unsigned int>& slot(const std::size_t i) const { return slots_[i]; }
+
+        /// Indicates whether the time budget of the series is exhausted. Thread-safe.
+        inline bool is_budget_exhausted() const { return is_budget_exhausted_.load(std::memory_order_relaxed); }
+
+        /// Returns how often the watchdog looks at the slots: a quarter of the timeout or the budget, within [1 ms, 100 ms].
+        DurationType period() const {
+            DurationType ret = std::chrono::milliseconds(100);
+            if (timeout_.count() > 0) {
+                ret = std::min(ret, timeout_ / 4);
+            }
+            if (budget_.count() > 0) {
+                ret = std::min(ret, budget_ / 4);
+            }
+            return std::max<DurationType>(ret, std::chrono::milliseconds(1));
+        }
+
+    }; // END class watchdog
+
+} // END namespace unittest
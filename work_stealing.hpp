@@ -0,0 +1,161 @@
+/******************************************************************************
+/* @file Contains a small work-stealing scheduler that spreads a range
+/*       of indices over several worker threads.
+/*
+/* Every worker owns a contiguous part of the index range and processes it
+/* from the front in chunks. A worker that runs out of indices steals the
+/* back half of the largest range that is left over at another worker.
+/*
+/*
+/* @author langenhagen
+/* @version 261015
+/*****************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE, CONSTANTS, TYPE DECLARATIONS/IMPLEMENTATIONS and FUNCTIONS
+
+namespace unittest {
+
+    namespace work_stealing {
+
+        /// Implementation details, clients never use these directly.
+        namespace detail {
+
+            /// A range of indices [begin, end) that is owned by one worker.
+            /// The owner takes chunks from the front, thieves split off the back.
+            struct range {
+                std::mutex mutex;
+                std::size_t begin = 0;
+                std::size_t end = 0;
+            };
+
+            /// Takes the next chunk of at most chunk_size indices from the front of the given range.
+            inline bool pop_front(range& r, const std::size_t chunk_size, std::size_t& out_begin, std::size_t& out_end) {
+                std::lock_guard<std::mutex> lock(r.mutex);
+                if (r.begin == r.end) {
+                    return false;
+                }
+                out_begin = r.begin;
+                out_end = r.end - r.begin > chunk_size ? r.begin + chunk_size : r.end;
+                r.begin = out_end;
+                return true;
+            }
+
+            /// Moves the back half of the largest foreign range into the range of the given thief.
+            inline bool steal(std::vector<range>& ranges, const std::size_t thief) {
+                std::size_t victim = thief;
+                std::size_t victim_size = 1;
+                for (std::size_t i = 0; i < ranges.size(); ++i) {
+                    if (i == thief) {
+                        continue;
+                    }
+                    std::lock_guard<std::mutex> lock(ranges[i].mutex);
+                    const auto size = ranges[i].end - ranges[i].begin;
+                    if (size > victim_size) {
+                        victim = i;
+                        victim_size = size;
+                    }
+                }
+                if (victim == thief) {
+                    return false;
+                }
+
+                std::size_t stolen_begin, stolen_end;
+                {
+                    std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+                    const auto size = ranges[victim].end - ranges[victim].begin;
+                    if (size < 2) {
+                        return true; // the victim finished in between, simply try again
+                    }
+                    stolen_end = ranges[victim].end;
+                    stolen_begin = stolen_end - size / 2;
+                    ranges[victim].end = stolen_begin;
+                }
+
+                std::lock_guard<std::mutex> lock(ranges[thief].mutex);
+                ranges[thief].begin = stolen_begin;
+                ranges[thief].end = stolen_end;
+                return true;
+            }
+
+        } // END namespace detail
+
+
+        /** Resolves the number of workers to be used.
+        @param n_workers The requested number of workers. 0 means one worker per hardware thread.
+        @return The given number of workers or, if it is 0, the number of hardware threads, but at least 1.
+        */
+        inline unsigned int resolve_n_workers(const unsigned int n_workers) {
+            if (n_workers != 0) {
+                return n_workers;
+            }
+            const auto n_hardware_threads = std::thread::hardware_concurrency();
+            return n_hardware_threads != 0 ? n_hardware_threads : 1;
+        }
+
+
+        /** Invokes fun(worker_index, chunk_begin, chunk_end) for disjoint chunks that together cover [0, n).
+        The calling thread serves as worker 0, the other workers are started as new threads.
+        Every chunk is processed by exactly one worker, but chunks are not processed in order.
+        If fun throws, the first exception is rethrown on the calling thread after all workers have finished.
+        @param n The number of indices.
+        @param n_workers The number of workers. 0 means one worker per hardware thread.
+        @param chunk_size The maximum number of indices that are handed to fun at once.
+        @param fun A thread-safe function of the form void(unsigned int, std::size_t, std::size_t).
+        */
+        template <typename F>
+        void parallel_for(const std::size_t n, const unsigned int n_workers, const std::size_t chunk_size, F&& fun) {
+            const auto n_threads = resolve_n_workers(n_workers);
+            const auto chunk = chunk_size > 0 ? chunk_size : 1;
+
+            std::vector<detail::range> ranges(n_threads);
+            for (std::size_t i = 0; i < n_threads; ++i) {
+                ranges[i].begin = n * i / n_threads;
+                ranges[i].end = n * (i + 1) / n_threads;
+            }
+
+            std::mutex exception_mutex;
+            std::exception_ptr exception;
+
+            auto work = [&](const unsigned int worker) {
+                try {
+                    std::size_t begin, end;
+                    do {
+                        while (detail::pop_front(ranges[worker], chunk, begin, end)) {
+                            fun(worker, begin, end);
+                        }
+                    } while (detail::steal(ranges, worker));
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(exception_mutex);
+                    if (!exception) {
+                        exception = std::current_exception();
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(n_threads - 1);
+            for (unsigned int worker = 1; worker < n_threads; ++worker) {
+                threads.emplace_back(work, worker);
+            }
+            work(0);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+
+    } // END namespace work_stealing
+
+} // END namespace unittest